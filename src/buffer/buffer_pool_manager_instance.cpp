@@ -0,0 +1,474 @@
+#include "buffer/buffer_pool_manager_instance.h"
+
+#include "glog/logging.h"
+
+BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
+                                                     ReplacerType replacer_type)
+    : pool_size_(pool_size), disk_manager_(disk_manager), frame_states_(pool_size, FrameState::kFree),
+      prefetched_(pool_size, false) {
+  pages_ = new Page[pool_size_];
+  frame_cvs_ = new std::condition_variable[pool_size_];
+  switch (replacer_type) {
+    case ReplacerType::kClock:
+      replacer_ = new CLOCKReplacer(pool_size_);
+      break;
+    case ReplacerType::kLRUK:
+      replacer_ = new LRUKReplacer(pool_size_);
+      break;
+    default:
+      replacer_ = new LRUReplacer(pool_size_);
+      break;
+  }
+  for (size_t i = 0; i < pool_size_; i++) {
+    free_list_.emplace_back(i);
+  }
+}
+
+BufferPoolManagerInstance::~BufferPoolManagerInstance() {
+  FlushAllPages();
+  delete[] pages_;
+  delete[] frame_cvs_;
+  delete replacer_;
+}
+
+frame_id_t BufferPoolManagerInstance::TryToFindFreePage(page_id_t *dirty_page_id, BufferRing *ring) {
+  frame_id_t frame_id = INVALID_FRAME_ID;
+  *dirty_page_id = INVALID_PAGE_ID;
+
+  // 0. Recycle the ring's next frame, unless the page it loaded there has been pinned or evicted meanwhile.
+  if (ring != nullptr) {
+    page_id_t ring_page_id;
+    frame_id = ring->GetCurrent(&ring_page_id);
+    if (frame_id != INVALID_FRAME_ID && pages_[frame_id].GetPageId() == ring_page_id &&
+        pages_[frame_id].GetPinCount() == 0 && frame_states_[frame_id] == FrameState::kReady) {
+      replacer_->Forget(frame_id);
+      if (pages_[frame_id].IsDirty()) {
+        *dirty_page_id = ring_page_id;
+      }
+      page_table_.erase(ring_page_id);
+      return frame_id;
+    }
+    frame_id = INVALID_FRAME_ID;
+  }
+
+  // 1. Try to get a frame from the free list
+  if (!free_list_.empty()) {
+    frame_id = free_list_.front();
+    free_list_.pop_front();
+    // The page in this frame should already be reset or was never used.
+    // Its pin_count should be 0.
+    return frame_id;
+  }
+
+  // 2. If free list is empty, try to get a victim from the replacer
+  while (replacer_->Victim(&frame_id)) {
+    // A victim frame was found
+    Page *victim_page = &pages_[frame_id];
+    // Frames being flushed are pinned without leaving the replacer, they are put back once the write completes.
+    if (victim_page->GetPinCount() > 0) {
+      continue;
+    }
+    page_id_t old_page_id = victim_page->GetPageId();
+
+    // If the victim page is dirty, the caller writes it back once the latch is released
+    if (victim_page->IsDirty()) {
+      *dirty_page_id = old_page_id;
+    }
+
+    // Remove the mapping of the old page from the page table
+    page_table_.erase(old_page_id);
+    return frame_id;
+  }
+
+  // 3. No frame available from free list or replacer
+  return INVALID_FRAME_ID;  // Indicates no frame could be found
+}
+
+frame_id_t BufferPoolManagerInstance::WaitForPage(page_id_t page_id, std::unique_lock<std::mutex> &lock) {
+  while (true) {
+    auto it = page_table_.find(page_id);
+    if (it != page_table_.end()) {
+      if (frame_states_[it->second] != FrameState::kLoading) {
+        return it->second;
+      }
+      // Another thread is filling the frame, the frame may hold a different page once we wake up.
+      frame_cvs_[it->second].wait(lock);
+      continue;
+    }
+    auto writing = writing_back_.find(page_id);
+    if (writing == writing_back_.end()) {
+      return INVALID_FRAME_ID;
+    }
+    // The page was just evicted, reading it before the write completes would return stale content.
+    frame_cvs_[writing->second].wait(lock);
+  }
+}
+
+Page *BufferPoolManagerInstance::LoadPage(page_id_t page_id, bool read_from_disk, std::unique_lock<std::mutex> &lock,
+                                          BufferRing *ring, std::vector<DiskIORequest> *reads) {
+  page_id_t dirty_page_id;
+  frame_id_t frame_id = TryToFindFreePage(&dirty_page_id, ring);
+  if (frame_id == INVALID_FRAME_ID) {
+    // No frame is available (free list empty and no victim found)
+    return nullptr;
+  }
+  if (ring != nullptr) {
+    ring->Advance(frame_id, page_id);
+  }
+  if (prefetched_[frame_id]) {
+    prefetched_[frame_id] = false;
+    wasted_prefetch_count_++;
+  }
+
+  // Publish the incoming page as loading, so that concurrent fetchers of it wait on this frame.
+  Page *page = &pages_[frame_id];
+  page_table_[page_id] = frame_id;
+  frame_states_[frame_id] = FrameState::kLoading;
+  if (dirty_page_id != INVALID_PAGE_ID) {
+    writing_back_[dirty_page_id] = frame_id;
+  }
+  page->page_id_ = page_id;
+  page->pin_count_ = 1;
+  page->is_dirty_ = !read_from_disk;  // New content (zeros) is different from uninitialized disk page
+  replacer_->Pin(frame_id);
+  if (reads == nullptr) {
+    // Read-ahead is not an access, the scan records one when it fetches the page.
+    replacer_->RecordAccess(frame_id);
+  }
+
+  lock.unlock();
+  bool written = true;
+  bool read = true;
+  if (dirty_page_id != INVALID_PAGE_ID) {
+    written = disk_manager_->WritePage(dirty_page_id, page->GetData());
+    sync_write_count_++;
+  }
+  if (!written) {
+    // The frame still holds the old page, which is kept instead of losing its changes.
+  } else if (reads != nullptr) {
+    reads->push_back({false, page_id, page->GetData(), [this, frame_id](bool success) {
+                        FinishPrefetch(frame_id, success);
+                      }});
+  } else if (read_from_disk) {
+    read = disk_manager_->ReadPage(page_id, page->GetData());
+  } else {
+    page->ResetMemory();
+  }
+  lock.lock();
+
+  if (dirty_page_id != INVALID_PAGE_ID) {
+    writing_back_.erase(dirty_page_id);
+  }
+  if (!written || !read) {
+    // Fetchers of the incoming page waiting on the frame find it unmapped and try to load it themselves.
+    page_table_.erase(page_id);
+    page->pin_count_ = 0;
+    replacer_->Forget(frame_id);
+    if (!written) {
+      page->page_id_ = dirty_page_id;
+      page->is_dirty_ = true;
+      page_table_[dirty_page_id] = frame_id;
+      frame_states_[frame_id] = FrameState::kReady;
+      replacer_->Unpin(frame_id);
+    } else {
+      page->page_id_ = INVALID_PAGE_ID;
+      page->is_dirty_ = false;
+      frame_states_[frame_id] = FrameState::kFree;
+      free_list_.push_back(frame_id);
+    }
+    frame_cvs_[frame_id].notify_all();
+    return nullptr;
+  }
+  if (reads != nullptr) {
+    return page;  // The frame stays loading until its read completes.
+  }
+  frame_states_[frame_id] = FrameState::kReady;
+  frame_cvs_[frame_id].notify_all();
+  return page;
+}
+
+Page *BufferPoolManagerInstance::FetchPage(page_id_t page_id, BufferRing *ring) {
+  std::unique_lock<std::mutex> lock(latch_);
+
+  if (page_id == INVALID_PAGE_ID) {
+    return nullptr;  // Cannot fetch an invalid page ID
+  }
+
+  // 1. Search the page table for the requested page (P).
+  frame_id_t frame_id = WaitForPage(page_id, lock);
+  if (frame_id != INVALID_FRAME_ID) {
+    // 1.1 If P exists, pin it and return it immediately.
+    Page *page = &pages_[frame_id];
+    page->pin_count_++;
+    // If the page was in the replacer (pin_count was 0), Pin it to remove.
+    replacer_->Pin(frame_id);
+    replacer_->RecordAccess(frame_id);
+    if (prefetched_[frame_id]) {
+      prefetched_[frame_id] = false;
+      prefetch_hit_count_++;
+    }
+    return page;
+  }
+
+  // 2. If P does not exist, find a replacement frame and read P into it.
+  return LoadPage(page_id, true, lock, ring);
+}
+
+bool BufferPoolManagerInstance::PrefetchPage(page_id_t page_id, std::vector<DiskIORequest> *reads, BufferRing *ring) {
+  std::unique_lock<std::mutex> lock(latch_);
+
+  // Read-ahead never waits, a page that is resident or on the move is left alone.
+  if (page_table_.count(page_id) > 0 || writing_back_.count(page_id) > 0) {
+    return false;
+  }
+  return LoadPage(page_id, true, lock, ring, reads) != nullptr;
+}
+
+void BufferPoolManagerInstance::FinishPrefetch(frame_id_t frame_id, bool success) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  Page *page = &pages_[frame_id];
+  page->pin_count_ = 0;
+  if (success) {
+    prefetched_[frame_id] = true;
+    frame_states_[frame_id] = FrameState::kReady;
+    replacer_->Unpin(frame_id);
+  } else {
+    page_table_.erase(page->page_id_);
+    replacer_->Forget(frame_id);
+    page->page_id_ = INVALID_PAGE_ID;
+    frame_states_[frame_id] = FrameState::kFree;
+    free_list_.push_back(frame_id);
+  }
+  frame_cvs_[frame_id].notify_all();
+}
+
+Page *BufferPoolManagerInstance::NewPage(page_id_t page_id) {
+  std::unique_lock<std::mutex> lock(latch_);
+
+  // A freshly allocated page may still be in flight from a previous life, wait for it to settle.
+  frame_id_t frame_id = WaitForPage(page_id, lock);
+  if (frame_id != INVALID_FRAME_ID) {
+    Page *page = &pages_[frame_id];
+    if (page->GetPinCount() > 0) {
+      LOG(ERROR) << "New page " << page_id << " is already pinned in the buffer pool.";
+      return nullptr;
+    }
+    page->pin_count_ = 1;
+    page->is_dirty_ = true;
+    page->ResetMemory();
+    prefetched_[frame_id] = false;
+    replacer_->Pin(frame_id);
+    replacer_->RecordAccess(frame_id);
+    return page;
+  }
+
+  // If all the pages in the buffer pool are pinned (no frame found), return nullptr.
+  return LoadPage(page_id, false, lock);
+}
+
+bool BufferPoolManagerInstance::DeletePage(page_id_t page_id) {
+  std::unique_lock<std::mutex> lock(latch_);
+
+  // 1. Search the page table for the requested page (P).
+  frame_id_t frame_id = WaitForPage(page_id, lock);
+  if (frame_id == INVALID_FRAME_ID) {
+    // 1.1 If P does not exist in buffer pool, there is nothing to drop.
+    return true;
+  }
+
+  // P exists in the buffer pool.
+  Page *page_to_delete = &pages_[frame_id];
+
+  // 2. If P exists, but has a non-zero pin-count, return false.
+  if (page_to_delete->GetPinCount() > 0) {
+    return false;  // Someone is using the page.
+  }
+
+  // 3. Otherwise, P can be deleted. (pin_count is 0)
+  // Remove P from the page table.
+  page_table_.erase(page_id);
+
+  // Since pin_count is 0, it should be in the replacer. Remove it, along with the accesses of the page.
+  replacer_->Forget(frame_id);
+
+  // Reset its metadata.
+  page_to_delete->page_id_ = INVALID_PAGE_ID;
+  page_to_delete->pin_count_ = 0;
+  page_to_delete->is_dirty_ = false;  // Content is being discarded, no need to flush
+  page_to_delete->ResetMemory();
+  if (prefetched_[frame_id]) {
+    prefetched_[frame_id] = false;
+    wasted_prefetch_count_++;
+  }
+
+  // Return it to the free list.
+  frame_states_[frame_id] = FrameState::kFree;
+  free_list_.push_back(frame_id);
+  return true;
+}
+
+bool BufferPoolManagerInstance::UnpinPage(page_id_t page_id, bool is_dirty) {
+  std::unique_lock<std::mutex> lock(latch_);
+
+  auto it = page_table_.find(page_id);
+  if (it == page_table_.end()) {
+    // Page not found in buffer pool.
+    return false;
+  }
+
+  frame_id_t frame_id = it->second;
+  Page *page = &pages_[frame_id];
+
+  if (page->GetPinCount() <= 0) {
+    // Cannot unpin a page with pin_count <= 0.
+    return false;
+  }
+
+  page->pin_count_--;
+
+  if (is_dirty) {
+    page->is_dirty_ = true;
+  }
+
+  if (page->GetPinCount() == 0) {
+    // If pin_count reaches 0, the page becomes a candidate for replacement.
+    replacer_->Unpin(frame_id);
+  }
+
+  return true;
+}
+
+bool BufferPoolManagerInstance::FlushPage(page_id_t page_id) {
+  std::unique_lock<std::mutex> lock(latch_);
+
+  frame_id_t frame_id;
+  while (true) {
+    frame_id = WaitForPage(page_id, lock);
+    if (frame_id == INVALID_FRAME_ID) {
+      // Page not found in buffer pool.
+      return false;
+    }
+    if (frame_states_[frame_id] != FrameState::kFlushing) {
+      break;
+    }
+    // Writes of the same page must not overtake each other.
+    frame_cvs_[frame_id].wait(lock);
+  }
+
+  // Pin the page so it can not be evicted while it is written without the latch. The dirty flag is cleared
+  // up front, a concurrent modification marks the page dirty again when it is unpinned.
+  Page *page = &pages_[frame_id];
+  frame_states_[frame_id] = FrameState::kFlushing;
+  page->pin_count_++;
+  page->is_dirty_ = false;
+
+  lock.unlock();
+  bool success = disk_manager_->WritePage(page_id, page->GetData());
+  lock.lock();
+
+  if (!success) {
+    page->is_dirty_ = true;
+  }
+  if (--page->pin_count_ == 0) {
+    replacer_->Unpin(frame_id);
+  }
+  frame_states_[frame_id] = FrameState::kReady;
+  frame_cvs_[frame_id].notify_all();
+  return success;
+}
+
+void BufferPoolManagerInstance::FlushAllPages() {
+  std::vector<page_id_t> page_ids;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    for (auto page : page_table_) {
+      if (pages_[page.second].IsDirty()) {
+        page_ids.push_back(page.first);
+      }
+    }
+  }
+  for (auto page_id : page_ids) {
+    FlushPage(page_id);
+  }
+}
+
+size_t BufferPoolManagerInstance::CleanPages(size_t max_pages, double dirty_ratio, double clean_reserve_ratio) {
+  std::unique_lock<std::mutex> lock(latch_);
+
+  size_t dirty_count = 0;
+  for (size_t i = 0; i < pool_size_; i++) {
+    dirty_count += pages_[i].IsDirty() ? 1 : 0;
+  }
+  size_t scan_count = dirty_count > dirty_ratio * pool_size_ ? pool_size_ : clean_reserve_ratio * pool_size_;
+  std::vector<frame_id_t> candidates;
+  replacer_->PeekVictims(&candidates, scan_count);
+
+  // Unpinned pages are not being modified, so a copy taken under the latch is consistent. The pin keeps the frame
+  // from being evicted until the copy is on disk, but leaves its position in the replacer untouched.
+  std::vector<frame_id_t> frame_ids;
+  std::vector<page_id_t> page_ids;
+  for (auto frame_id : candidates) {
+    if (frame_ids.size() >= max_pages) {
+      break;
+    }
+    Page *page = &pages_[frame_id];
+    if (page->IsDirty() && page->GetPinCount() == 0 && frame_states_[frame_id] == FrameState::kReady) {
+      frame_ids.push_back(frame_id);
+      page_ids.push_back(page->GetPageId());
+    }
+  }
+  std::vector<char> buffer(frame_ids.size() * PAGE_SIZE);
+  for (size_t i = 0; i < frame_ids.size(); i++) {
+    Page *page = &pages_[frame_ids[i]];
+    frame_states_[frame_ids[i]] = FrameState::kFlushing;
+    page->pin_count_++;
+    page->is_dirty_ = false;
+    memcpy(buffer.data() + i * PAGE_SIZE, page->GetData(), PAGE_SIZE);
+  }
+
+  lock.unlock();
+
+  // Write the copies as one batch, every frame is handed back as soon as its own write completes.
+  std::vector<DiskIORequest> requests;
+  for (size_t i = 0; i < frame_ids.size(); i++) {
+    frame_id_t frame_id = frame_ids[i];
+    requests.push_back({true, page_ids[i], buffer.data() + i * PAGE_SIZE, [this, frame_id](bool success) {
+                          std::scoped_lock<std::mutex> frame_lock(latch_);
+                          Page *page = &pages_[frame_id];
+                          if (!success) {
+                            page->is_dirty_ = true;
+                          }
+                          if (--page->pin_count_ == 0) {
+                            replacer_->Unpin(frame_id);
+                          }
+                          frame_states_[frame_id] = FrameState::kReady;
+                          frame_cvs_[frame_id].notify_all();
+                        }});
+  }
+  disk_manager_->Submit(requests);
+  return frame_ids.size();
+}
+
+size_t BufferPoolManagerInstance::GetDirtyPageCount() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  size_t dirty_count = 0;
+  for (size_t i = 0; i < pool_size_; i++) {
+    dirty_count += pages_[i].IsDirty() ? 1 : 0;
+  }
+  return dirty_count;
+}
+
+// Only used for debug
+bool BufferPoolManagerInstance::CheckAllUnpinned() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  bool res = true;
+  for (size_t i = 0; i < pool_size_; i++) {
+    // A frame being flushed holds one pin of the flusher, which goes away by itself.
+    int flusher_pins = frame_states_[i] == FrameState::kFlushing ? 1 : 0;
+    if (pages_[i].pin_count_ != flusher_pins) {
+      res = false;
+      LOG(ERROR) << "page " << pages_[i].page_id_ << " pin count:" << pages_[i].pin_count_ << endl;
+    }
+  }
+  return res;
+}
@@ -96,4 +96,19 @@ void CLOCKReplacer::Unpin(frame_id_t frame_id) {
 size_t CLOCKReplacer::Size() {
   // The size of the replacer is the number of frames it currently holds.
   return clock_list.size();
-}
\ No newline at end of file
+}
+void CLOCKReplacer::PeekVictims(std::vector<frame_id_t> *frame_ids, size_t max_count) {
+  // Unreferenced frames are taken by the next sweep of the hand, referenced ones only by the sweep after.
+  for (int referenced = 0; referenced <= 1; referenced++) {
+    auto it = clock_hand_;
+    for (size_t i = 0; i < clock_list.size() && frame_ids->size() < max_count; i++) {
+      if (it == clock_list.end()) {
+        it = clock_list.begin();
+      }
+      if (clock_status[*it] == referenced) {
+        frame_ids->push_back(*it);
+      }
+      ++it;
+    }
+  }
+}
@@ -0,0 +1,92 @@
+#include "buffer/lru_k_replacer.h"
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k, size_t correlation_window)
+    : k_(k),
+      correlation_window_(correlation_window),
+      history_(num_pages),
+      last_access_(num_pages, 0),
+      evictable_(num_pages, false) {}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+std::set<LRUKReplacer::Entry> &LRUKReplacer::GetSet(frame_id_t frame_id) {
+  return history_[frame_id].size() < k_ ? infinite_distance_ : finite_distance_;
+}
+
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+  std::lock_guard<std::mutex> lock(latch_);
+  auto &victims = infinite_distance_.empty() ? finite_distance_ : infinite_distance_;
+  if (victims.empty()) {
+    return false;
+  }
+  *frame_id = victims.begin()->second;
+  victims.erase(victims.begin());
+  evictable_[*frame_id] = false;
+  // The frame will hold another page, forget the access history of the old one. Until the new page is accessed,
+  // the frame is ordered by the time it got the page.
+  history_[*frame_id].clear();
+  last_access_[*frame_id] = current_timestamp_;
+  return true;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> lock(latch_);
+  if (!evictable_[frame_id]) {
+    return;
+  }
+  GetSet(frame_id).erase(GetEntry(frame_id));
+  evictable_[frame_id] = false;
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> lock(latch_);
+  if (evictable_[frame_id]) {
+    return;
+  }
+  GetSet(frame_id).insert(GetEntry(frame_id));
+  evictable_[frame_id] = true;
+}
+
+void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> lock(latch_);
+  // An evictable frame has to be re-keyed, its oldest remembered access changes.
+  if (evictable_[frame_id]) {
+    GetSet(frame_id).erase(GetEntry(frame_id));
+  }
+  auto &history = history_[frame_id];
+  size_t timestamp = current_timestamp_++;
+  if (history.empty() || timestamp - last_access_[frame_id] > correlation_window_) {
+    history.push_back(timestamp);
+    if (history.size() > k_) {
+      history.pop_front();
+    }
+  }
+  last_access_[frame_id] = timestamp;
+  if (evictable_[frame_id]) {
+    GetSet(frame_id).insert(GetEntry(frame_id));
+  }
+}
+
+void LRUKReplacer::Forget(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> lock(latch_);
+  if (evictable_[frame_id]) {
+    GetSet(frame_id).erase(GetEntry(frame_id));
+    evictable_[frame_id] = false;
+  }
+  history_[frame_id].clear();
+  last_access_[frame_id] = current_timestamp_;
+}
+
+size_t LRUKReplacer::Size() {
+  std::lock_guard<std::mutex> lock(latch_);
+  return infinite_distance_.size() + finite_distance_.size();
+}
+
+void LRUKReplacer::PeekVictims(std::vector<frame_id_t> *frame_ids, size_t max_count) {
+  std::lock_guard<std::mutex> lock(latch_);
+  for (auto victims : {&infinite_distance_, &finite_distance_}) {
+    for (auto it = victims->begin(); it != victims->end() && frame_ids->size() < max_count; ++it) {
+      frame_ids->push_back(it->second);
+    }
+  }
+}
@@ -67,3 +67,11 @@ size_t LRUReplacer::Size() {
   // The size is the number of frames currently in our lru_list_.
   return lru_list_.size();
 }
+
+void LRUReplacer::PeekVictims(std::vector<frame_id_t> *frame_ids, size_t max_count) {
+  std::lock_guard<std::mutex> lock(latch_);
+  // Walk from the LRU end towards the MRU end.
+  for (auto it = lru_list_.rbegin(); it != lru_list_.rend() && frame_ids->size() < max_count; ++it) {
+    frame_ids->push_back(*it);
+  }
+}
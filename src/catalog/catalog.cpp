@@ -112,7 +112,8 @@ dberr_t CatalogManager::CreateTable(const string &table_name, TableSchema *schem
   TableSchema *schema_copy = Schema::DeepCopySchema(schema);
   table_id_t table_id = next_table_id_.fetch_add(1);// CatalogManager拥有Schema的拷贝
   TableHeap *table_heap = TableHeap::Create(buffer_pool_manager_, schema_copy, txn, log_manager_, lock_manager_);
-  TableMetadata *table_meta = TableMetadata::Create(table_id, table_name, page_id, schema_copy);
+  TableMetadata *table_meta = TableMetadata::Create(table_id, table_name, table_heap->GetFirstPageId(),
+                                                    table_heap->GetFreeSpaceMapPageId(), schema_copy);
   table_meta->SerializeTo(page->GetData());
   buffer_pool_manager_->UnpinPage(page_id, true);
 
@@ -175,13 +176,16 @@ dberr_t CatalogManager::CreateIndex(const std::string &table_name, const string
     else return DB_COLUMN_NAME_NOT_EXIST;
   }
   if (key_map.empty()) return DB_FAILED;
+  // The executor names the default structure "btree".
+  std::string structure = index_type == "btree" ? "bptree" : index_type;
+  if (structure != "bptree" && structure != "hash") return DB_FAILED;
 
   page_id_t page_id;
   Page* page = buffer_pool_manager_->NewPage(page_id);
   if (page == nullptr) return DB_FAILED;
 
   index_id_t new_index_id = next_index_id_.fetch_add(1);
-  IndexMetadata *index_meta = IndexMetadata::Create(new_index_id, index_name, table_info->GetTableId(), key_map);
+  IndexMetadata *index_meta = IndexMetadata::Create(new_index_id, index_name, table_info->GetTableId(), key_map, structure);
   if (index_meta == nullptr) {
       buffer_pool_manager_->UnpinPage(page_id, false);
       buffer_pool_manager_->DeletePage(page_id);
@@ -189,6 +193,29 @@ dberr_t CatalogManager::CreateIndex(const std::string &table_name, const string
   }
   index_info = IndexInfo::Create();
   index_info->Init(index_meta, table_info, buffer_pool_manager_);
+  // Backfill the rows already in the table.
+  TableHeap *table_heap = table_info->GetTableHeap();
+  IndexSchema *key_schema = index_info->GetIndexKeySchema();
+  auto iter = table_heap->Begin(txn);
+  auto end = table_heap->End();
+  dberr_t backfill = index_info->GetIndex()->BulkLoad(
+      [&](Row &key, RowId &row_id) {
+        if (iter == end) return false;
+        iter->GetKeyFromRow(table_schema, key_schema, key);
+        row_id = iter->GetRowId();
+        ++iter;
+        return true;
+      },
+      txn);
+  if (backfill != DB_SUCCESS) {
+    // Most likely a duplicate key in the table, or the sort of the keys failed.
+    index_info->GetIndex()->Destroy();
+    delete index_info;
+    index_info = nullptr;
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    buffer_pool_manager_->DeletePage(page_id);
+    return DB_FAILED;
+  }
   index_meta->SerializeTo(page->GetData());
   buffer_pool_manager_->UnpinPage(page_id, true);
 
@@ -267,6 +294,7 @@ dberr_t CatalogManager::DropIndex(const string &table_name, const string &index_
   catalog_meta_->index_meta_pages_.erase(index_id);
   buffer_pool_manager_->DeletePage(index_meta_page_id);
 
+  indexes_[index_id]->GetIndex()->Destroy();
   delete indexes_[index_id];
   indexes_.erase(index_id);
   index_names_[table_name].erase(index_name);
@@ -300,7 +328,17 @@ dberr_t CatalogManager::LoadTable(const table_id_t table_id, const page_id_t pag
   if (table == nullptr) return DB_FAILED;
 
   TableSchema *schema = table->GetSchema();
-  TableHeap *heap = TableHeap::Create(buffer_pool_manager_, table->GetFirstPageId(), schema, log_manager_, lock_manager_);
+  TableHeap *heap = TableHeap::Create(buffer_pool_manager_, table->GetFirstPageId(), table->GetFreeSpaceMapPageId(),
+                                      schema, log_manager_, lock_manager_);
+  if (heap->GetFreeSpaceMapPageId() != table->GetFreeSpaceMapPageId()) {
+    // The free space map has been rebuilt, remember its new pages so that the next open does not rebuild it again.
+    table->SetFreeSpaceMapPageId(heap->GetFreeSpaceMapPageId());
+    table_meta_page = buffer_pool_manager_->FetchPage(page_id);
+    if (table_meta_page != nullptr) {
+      table->SerializeTo(table_meta_page->GetData());
+      buffer_pool_manager_->UnpinPage(page_id, true);
+    }
+  }
 
   TableInfo *table_info = TableInfo::Create();
   table_info->Init(table, heap);
@@ -323,9 +361,7 @@ dberr_t CatalogManager::LoadIndex(const index_id_t index_id, const page_id_t pag
   if (index == nullptr) return DB_FAILED;
 
   IndexInfo *index_info = IndexInfo::Create();
-  IndexMetadata *index_meta = nullptr;
-  IndexMetadata::DeserializeFrom(index_meta_page->GetData(), index_meta);
-  TableInfo *table_info = tables_[index_meta->GetIndexId()];
+  TableInfo *table_info = tables_[index->GetTableId()];
   index_info->Init(index, table_info, buffer_pool_manager_);
 
   indexes_[index_id] = index_info;
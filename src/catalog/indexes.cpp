@@ -1,12 +1,12 @@
 #include "catalog/indexes.h"
 
 IndexMetadata::IndexMetadata(const index_id_t index_id, const std::string &index_name, const table_id_t table_id,
-                             const std::vector<uint32_t> &key_map)
-    : index_id_(index_id), index_name_(index_name), table_id_(table_id), key_map_(key_map) {}
+                             const std::vector<uint32_t> &key_map, const std::string &index_type)
+    : index_id_(index_id), index_name_(index_name), table_id_(table_id), key_map_(key_map), index_type_(index_type) {}
 
 IndexMetadata *IndexMetadata::Create(const index_id_t index_id, const string &index_name, const table_id_t table_id,
-                                     const vector<uint32_t> &key_map) {
-  return new IndexMetadata(index_id, index_name, table_id, key_map);
+                                     const vector<uint32_t> &key_map, const std::string &index_type) {
+  return new IndexMetadata(index_id, index_name, table_id, key_map, index_type);
 }
 
 uint32_t IndexMetadata::SerializeTo(char *buf) const {
@@ -35,6 +35,11 @@ uint32_t IndexMetadata::SerializeTo(char *buf) const {
     MACH_WRITE_UINT32(buf, col_index);
     buf += 4;
   }
+  // index type
+  MACH_WRITE_UINT32(buf, index_type_.length());
+  buf += 4;
+  MACH_WRITE_STRING(buf, index_type_);
+  buf += index_type_.length();
   ASSERT(buf - p == ofs, "Unexpected serialize size.");
   return ofs;
 }
@@ -51,6 +56,8 @@ uint32_t IndexMetadata::GetSerializedSize() const {
   size += sizeof(table_id_t);
   size += sizeof(uint32_t);
   size += key_map_.size() * sizeof(uint32_t);
+  size += sizeof(uint32_t);
+  size += index_type_.length();
   return size;
 }
 
@@ -62,7 +69,7 @@ uint32_t IndexMetadata::DeserializeFrom(char *buf, IndexMetadata *&index_meta) {
   // magic num
   uint32_t magic_num = MACH_READ_UINT32(buf);
   buf += 4;
-  ASSERT(magic_num == INDEX_METADATA_MAGIC_NUM, "Failed to deserialize index info.");
+  ASSERT(magic_num == INDEX_METADATA_MAGIC_NUM, "Failed to deserialize index info, it may have an older layout.");
   // index id
   index_id_t index_id = MACH_READ_FROM(index_id_t, buf);
   buf += 4;
@@ -84,25 +91,21 @@ uint32_t IndexMetadata::DeserializeFrom(char *buf, IndexMetadata *&index_meta) {
     buf += 4;
     key_map.push_back(key_index);
   }
+  // index type
+  len = MACH_READ_UINT32(buf);
+  buf += 4;
+  std::string index_type(buf, len);
+  buf += len;
   // allocate space for index meta data
-  index_meta = new IndexMetadata(index_id, index_name, table_id, key_map);
+  index_meta = new IndexMetadata(index_id, index_name, table_id, key_map, index_type);
   return buf - p;
 }
 
 Index *IndexInfo::CreateIndex(BufferPoolManager *buffer_pool_manager, const string &index_type) {
-  size_t max_size = 0;
-  uint32_t column_cnt = key_schema_->GetColumns().size();
-  size_t size_bitmap = (column_cnt % 8) ? column_cnt / 8 + 1 : column_cnt / 8;
-  // column_cnt + bitmap
-  max_size += 4 + sizeof(unsigned char) * size_bitmap;
-  for (auto col : key_schema_->GetColumns()) {
-    // length of char column
-    if(col->GetType() == TypeId::kTypeChar)
-      max_size += 4;
-    max_size += col->GetLength();
-  }
+  // size of the memcmp-comparable key encoding
+  size_t max_size = KeyManager::GetEncodedSize(key_schema_);
 
-  if (index_type == "bptree") {
+  if (index_type == "bptree" || index_type == "hash") {
     if (max_size <= 8)
       max_size = 16;
     else if (max_size <= 24)
@@ -113,6 +116,8 @@ Index *IndexInfo::CreateIndex(BufferPoolManager *buffer_pool_manager, const stri
       max_size = 128;
     else if (max_size <= 248)
       max_size = 256;
+    else if (max_size <= 504)
+      max_size = 512;
     else {
       LOG(ERROR) << "GenericKey size is too large";
       return nullptr;
@@ -120,5 +125,13 @@ Index *IndexInfo::CreateIndex(BufferPoolManager *buffer_pool_manager, const stri
   } else {
     return nullptr;
   }
-  return new BPlusTreeIndex(meta_data_->index_id_, key_schema_, max_size, buffer_pool_manager);
+  // A key that contains a unique column is unique itself.
+  bool unique = false;
+  for (auto column : key_schema_->GetColumns()) {
+    unique = unique || column->IsUnique();
+  }
+  if (index_type == "hash") {
+    return new HashIndex(meta_data_->index_id_, key_schema_, max_size, buffer_pool_manager, unique);
+  }
+  return new BPlusTreeIndex(meta_data_->index_id_, key_schema_, max_size, buffer_pool_manager, unique);
 }
@@ -4,6 +4,7 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include <algorithm>
 #include <chrono>
 
 #include "common/result_writer.h"
@@ -129,11 +130,15 @@ dberr_t ExecuteEngine::ExecutePlan(const AbstractPlanNodeRef &plan, std::vector<
 
   try {
     executor->Init();
-    RowId rid{};
-    Row row{};
-    while (executor->Next(&row, &rid)) {
-      if (result_set != nullptr) {
-        result_set->push_back(row);
+    RowBatch batch(executor->GetOutputSchema());
+    while (executor->NextBatch(&batch)) {
+      if (result_set == nullptr) {
+        continue;
+      }
+      // Rows are only materialized for the result set.
+      for (auto i : batch.GetSelection()) {
+        result_set->emplace_back();
+        batch.GetRow(i, &result_set->back());
       }
     }
   } catch (const exception &ex) {
@@ -152,7 +157,10 @@ dberr_t ExecuteEngine::Execute(pSyntaxNode ast) {
   }
   auto start_time = std::chrono::system_clock::now();
   unique_ptr<ExecuteContext> context(nullptr);
-  if (!current_db_.empty()) context = dbs_[current_db_]->MakeExecuteContext(nullptr);
+  if (!current_db_.empty()) {
+    context = dbs_[current_db_]->MakeExecuteContext(nullptr);
+    context->SetScanParallelism(scan_parallelism_);
+  }
   switch (ast->type_) {
     case kNodeCreateDB:
       return ExecuteCreateDatabase(ast, context.get());
@@ -683,7 +691,7 @@ dberr_t ExecuteEngine::ExecuteShowIndexes(pSyntaxNode ast, ExecuteContext *conte
       IndexDisplayInfo display_info;
       display_info.table_name = table_name;
       display_info.index_name = index_info->GetIndexName();
-      display_info.index_type = "btree";
+      display_info.index_type = index_info->GetIndexType() == "hash" ? "hash" : "btree";
 
       // Format the key column names into a single comma-separated string.
       std::string key_cols_str;
@@ -802,7 +810,17 @@ dberr_t ExecuteEngine::ExecuteCreateIndex(pSyntaxNode ast, ExecuteContext *conte
   IndexInfo *index_info = nullptr; // This is an output parameter for the CreateIndex method.
   CatalogManager *catalog = context->GetCatalog();
 
+  // USING <type> is optional, "btree" by default.
   std::string index_type = "btree";
+  pSyntaxNode index_type_node = column_list_node->next_;
+  if (index_type_node != nullptr && index_type_node->type_ == kNodeIndexType && index_type_node->child_ != nullptr) {
+    index_type = index_type_node->child_->val_;
+    std::transform(index_type.begin(), index_type.end(), index_type.begin(), ::tolower);
+    if (index_type != "btree" && index_type != "hash") {
+      std::cout << "Unknown index type '" << index_type_node->child_->val_ << "'." << std::endl;
+      return DB_FAILED;
+    }
+  }
   dberr_t result = catalog->CreateIndex(table_name, index_name, index_keys, context->GetTransaction(),
                                       index_info, index_type);
 
@@ -1,18 +1,121 @@
 #include "executor/executors/index_scan_executor.h"
 
-class RowidCompare {
- public:
-  bool operator()(RowId rid1, RowId rid2) { return rid1.Get() < rid2.Get(); }
-};
+#include <algorithm>
+
+#include "record/field_compare.h"
 
 IndexScanExecutor::IndexScanExecutor(ExecuteContext *exec_ctx, const IndexScanPlanNode *plan)
     : AbstractExecutor(exec_ctx), plan_(plan) {}
 
 void IndexScanExecutor::Init() {
   exec_ctx_->GetCatalog()->GetTable(plan_->GetTableName(), table_info_);
-  auto first_row = table_info_->GetTableHeap()->Begin(nullptr);
-  result_ = IndexScan(plan_->GetPredicate());
+  std::vector<KeyRange> ranges;
+  bool covered = CollectRanges(plan_->GetPredicate(), ranges);
+  // Scan the range of a single index, preferably a single key, then one bounded on both sides, and check the other
+  // conditions on the rows it yields.
+  auto rank = [](const KeyRange &range) {
+    if (range.lower == nullptr || range.upper == nullptr) {
+      return 1;
+    }
+    bool point = range.lower_inclusive && range.upper_inclusive &&
+                 range.lower->GetField(0)->CompareEquals(*range.upper->GetField(0)) == CmpBool::kTrue;
+    return point ? 3 : 2;
+  };
+  auto chosen = std::max_element(ranges.begin(), ranges.end(),
+                                 [&rank](const KeyRange &a, const KeyRange &b) { return rank(a) < rank(b); });
+  need_filter_ = plan_->need_filter_ || !covered || ranges.size() != 1;
+  iter_ = IndexIterator();
+  result_.clear();
+  cursor_ = 0;
+  // The planner only scans indexes when one of them serves a conjunct of the predicate.
+  ASSERT(chosen != ranges.end(), "No index serves the predicate.");
+  OpenRange(*chosen);
   is_schema_same_ = SchemaEqual(table_info_->GetSchema(), plan_->OutputSchema());
+  scan_batch_ = std::make_unique<RowBatch>(table_info_->GetSchema());
+  columns_.clear();
+  for (const auto column : plan_->OutputSchema()->GetColumns()) {
+    columns_.push_back(column->GetTableInd());
+  }
+}
+
+bool IndexScanExecutor::CollectRanges(const AbstractExpressionRef &predicate, std::vector<KeyRange> &ranges) {
+  if (predicate->GetType() == ExpressionType::LogicExpression) {
+    // The planner only scans indexes for conjunctions.
+    bool lhs = CollectRanges(predicate->GetChildAt(0), ranges);
+    bool rhs = CollectRanges(predicate->GetChildAt(1), ranges);
+    return lhs && rhs;
+  }
+  // Comparisons no index can answer, such as <>, are checked on the rows.
+  IndexInfo *index = nullptr;
+  for (auto info : plan_->indexes_) {
+    if (IndexScanPlanNode::CanServe(info, predicate)) {
+      index = info;
+      break;
+    }
+  }
+  if (index == nullptr) {
+    return false;
+  }
+  std::string type = dynamic_pointer_cast<ComparisonExpression>(predicate)->GetComparisonType();
+  auto range = std::find_if(ranges.begin(), ranges.end(), [index](const KeyRange &r) { return r.index == index; });
+  if (range == ranges.end()) {
+    ranges.emplace_back();
+    range = ranges.end() - 1;
+    range->index = index;
+  }
+  std::vector<Field> fields{predicate->GetChildAt(1)->Evaluate(nullptr)};
+  FieldCompareFunc compare = GetFieldComparator(fields[0].GetTypeId());
+  // Keep the tighter of two bounds, a bound equal to the current one can only make it exclusive.
+  auto narrow = [&fields, compare](std::unique_ptr<Row> &bound, bool &inclusive, bool now_inclusive, bool is_lower) {
+    if (bound != nullptr && !fields[0].IsNull() && !bound->GetField(0)->IsNull()) {
+      int order = compare(fields[0], *bound->GetField(0));
+      if (is_lower ? order < 0 : order > 0) return;
+      if (order == 0) {
+        inclusive = inclusive && now_inclusive;
+        return;
+      }
+    }
+    bound = std::make_unique<Row>(fields);
+    inclusive = now_inclusive;
+  };
+  if (type == "=" || type == ">" || type == ">=") {
+    narrow(range->lower, range->lower_inclusive, type != ">", true);
+  }
+  if (type == "=" || type == "<" || type == "<=") {
+    narrow(range->upper, range->upper_inclusive, type != "<", false);
+  }
+  return true;
+}
+
+void IndexScanExecutor::OpenRange(KeyRange &range) {
+  auto *tree = dynamic_cast<BPlusTreeIndex *>(range.index->GetIndex());
+  if (tree != nullptr) {
+    iter_ = tree->GetRangeIterator(range.lower.get(), range.lower_inclusive, range.upper.get(), range.upper_inclusive);
+    return;
+  }
+  // Other indexes only answer one comparison at a time, the rows are filtered by the whole predicate then.
+  need_filter_ = true;
+  if (range.lower != nullptr) {
+    bool point = range.upper != nullptr && range.lower->GetField(0)->CompareEquals(*range.upper->GetField(0)) ==
+                                               CmpBool::kTrue;
+    range.index->GetIndex()->ScanKey(*range.lower, result_, nullptr,
+                                     point ? "=" : (range.lower_inclusive ? ">=" : ">"));
+  } else if (range.upper != nullptr) {
+    range.index->GetIndex()->ScanKey(*range.upper, result_, nullptr, range.upper_inclusive ? "<=" : "<");
+  }
+}
+
+bool IndexScanExecutor::NextRowId(RowId *rid) {
+  if (iter_ != IndexIterator()) {
+    *rid = (*iter_).second;
+    ++iter_;
+    return true;
+  }
+  if (cursor_ < result_.size()) {
+    *rid = result_[cursor_++];
+    return true;
+  }
+  return false;
 }
 
 bool IndexScanExecutor::SchemaEqual(const Schema *table_schema, const Schema *output_schema) {
@@ -44,66 +147,53 @@ void IndexScanExecutor::TupleTransfer(const Schema *table_schema, const Schema *
   *output_row = Row(dest_row);
 }
 
-vector<RowId> IndexScanExecutor::IndexScan(AbstractExpressionRef predicate) {
-  switch (predicate->GetType()) {
-    case ExpressionType::LogicExpression: {
-      vector<RowId> lhs = IndexScan(predicate->GetChildAt(0));
-      vector<RowId> rhs = IndexScan(predicate->GetChildAt(1));
-      // The function cannot differentiate between the case where the number of rows that
-      // meet the criteria in the indexed column is zero and the case where the column is
-      // not indexed. Writing it this way will ignore the filtering effect brought about
-      // by having zero rows that meet the criteria in the indexed column.
-      if (plan_->need_filter_) {
-        if (lhs.empty()) return rhs;
-        if (rhs.empty()) return lhs;
-      }
-      sort(lhs.begin(), lhs.end(), RowidCompare());
-      sort(rhs.begin(), rhs.end(), RowidCompare());
-      vector<RowId> result;
-      set_intersection(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), back_inserter(result), RowidCompare());
-      return result;
+bool IndexScanExecutor::Next(Row *row, RowId *rid) {
+  auto program = plan_->GetProgram();
+  auto table_schema = table_info_->GetSchema();
+  RowId next_rid;
+  while (NextRowId(&next_rid)) {
+    Row fetched(next_rid);
+    table_info_->GetTableHeap()->GetTuple(&fetched, nullptr);
+    if (need_filter_ && !program->Evaluate(fetched)) {
+      continue;
     }
-    case ExpressionType::ComparisonExpression: {
-      std::vector<RowId> ret;
-      std::vector<Field> fields{predicate->GetChildAt(1)->Evaluate(nullptr)};
-      Row key(fields);
-      for (auto index : plan_->indexes_) {
-        uint32_t col_idx = dynamic_pointer_cast<ColumnValueExpression>(predicate->GetChildAt(0))->GetColIdx();
-        if (col_idx == index->GetIndexKeySchema()->GetColumn(0)->GetTableInd()) {
-          index->GetIndex()->ScanKey(key, ret, nullptr,
-                                     dynamic_pointer_cast<ComparisonExpression>(predicate)->GetComparisonType());
-          break;
-        }
-      }
-      return ret;
+    *rid = next_rid;
+    if (!is_schema_same_) {
+      TupleTransfer(table_schema, plan_->OutputSchema(), &fetched, row);
+    } else {
+      *row = fetched;
     }
-    default:
-      break;
+    return true;
   }
+  return false;
 }
 
-bool IndexScanExecutor::Next(Row *row, RowId *rid) {
-  auto predicate = plan_->GetPredicate();
-  auto table_schema = table_info_->GetSchema();
-  while (cursor_ < result_.size()) {
-    auto p_row = new Row(result_[cursor_]);
-    table_info_->GetTableHeap()->GetTuple(p_row, nullptr);
-    if (plan_->need_filter_) {
-      if (!predicate->Evaluate(p_row).CompareEquals(Field(kTypeInt, 1))) {
-        cursor_++;
-        delete p_row;
-        continue;
+bool IndexScanExecutor::NextBatch(RowBatch *batch) {
+  auto program = plan_->GetProgram();
+  auto heap = table_info_->GetTableHeap();
+  // Without projection the rows are decoded into the batch of the caller.
+  RowBatch *scan_batch = is_schema_same_ ? batch : scan_batch_.get();
+  RowId next_rid;
+  bool exhausted = false;
+  while (!exhausted) {
+    scan_batch->Clear();
+    while (!scan_batch->IsFull()) {
+      if (!NextRowId(&next_rid)) {
+        exhausted = true;
+        break;
       }
+      heap->GetTuple(next_rid, scan_batch, nullptr);
     }
-    *rid = result_[cursor_];
-    if (!is_schema_same_) {
-      TupleTransfer(table_schema, plan_->OutputSchema(), p_row, row);
-    } else {
-      *row = *p_row;
+    if (need_filter_) {
+      program->Filter(*scan_batch, &scan_batch->GetSelection());
+    }
+    if (!scan_batch->GetSelection().empty()) {
+      if (!is_schema_same_) {
+        batch->Project(*scan_batch, columns_);
+      }
+      return true;
     }
-    delete p_row;
-    cursor_++;
-    return true;
   }
+  batch->Clear();
   return false;
 }
@@ -23,7 +23,7 @@ bool InsertExecutor::Next([[maybe_unused]] Row *row, RowId *rid) {
             Row key_row;
             insert_row.GetKeyFromRow(table_info_->GetSchema(), info->GetIndexKeySchema(), key_row);
             std::vector<RowId> result;
-            if (!key_row.GetFields().empty() &&
+            if (!key_row.GetFields().empty() && info->GetIndex()->IsUnique() &&
                 info->GetIndex()->ScanKey(key_row, result, exec_ctx_->GetTransaction()) == DB_SUCCESS) {
                 std::cout << "key already exists" << std::endl;
                 return false;
@@ -3,6 +3,8 @@
 //
 #include "executor/executors/seq_scan_executor.h"
 
+#include <algorithm>
+
 SeqScanExecutor::SeqScanExecutor(ExecuteContext *exec_ctx, const SeqScanPlanNode *plan)
     : AbstractExecutor(exec_ctx),
       plan_(plan),
@@ -44,18 +46,40 @@ void SeqScanExecutor::Init() {
   iterator_ = (table_info_->GetTableHeap()->Begin(exec_ctx_->GetTransaction()));
   schema_ = plan_->OutputSchema();
   is_schema_same_ = SchemaEqual(table_info_->GetSchema(), schema_);
+  scan_batch_ = std::make_unique<RowBatch>(table_info_->GetSchema());
+  columns_.clear();
+  for (const auto column : schema_->GetColumns()) {
+    columns_.push_back(column->GetTableInd());
+  }
+  auto num_pages = table_info_->GetTableHeap()->GetPageIds().size();
+  parallel_ = exec_ctx_->GetScanParallelism() > 1 && num_pages > SCAN_MORSEL_PAGES;
+  worker_batches_.clear();
+  worker_strategies_.clear();
+  if (parallel_) {
+    // Every worker decodes into a batch of its own, and reads through a ring of its own if the table is large.
+    auto buffer_pool_manager = exec_ctx_->GetBufferPoolManager();
+    pool_ = std::make_unique<WorkStealingPool>(exec_ctx_->GetScanParallelism());
+    for (size_t worker = 0; worker < pool_->GetWorkerCount(); worker++) {
+      worker_batches_.push_back(std::make_unique<RowBatch>(table_info_->GetSchema()));
+      worker_strategies_.push_back(buffer_pool_manager->IsBulkRead(num_pages)
+                                       ? buffer_pool_manager->GetBulkReadStrategy()
+                                       : nullptr);
+    }
+  }
+  next_morsel_ = 0;
+  morsel_batches_.clear();
+  morsel_cursor_ = 0;
+  batch_cursor_ = 0;
 }
 
 bool SeqScanExecutor::Next(Row *row, RowId *rid) {
-  auto predicate = plan_->GetPredicate();
+  auto program = plan_->GetProgram();
   auto table_schema = table_info_->GetSchema();
   while (iterator_ != table_info_->GetTableHeap()->End()) {
     auto p_row = &(*iterator_);
-    if (predicate != nullptr) {
-      if (!predicate->Evaluate(p_row).CompareEquals(Field(kTypeInt, 1))) {
-        iterator_++;
-        continue;
-      }
+    if (program != nullptr && !program->Evaluate(*p_row)) {
+      iterator_++;
+      continue;
     }
     *rid = iterator_->GetRowId();
     if (!is_schema_same_) {
@@ -68,3 +92,84 @@ bool SeqScanExecutor::Next(Row *row, RowId *rid) {
   }
   return false;
 }
+
+bool SeqScanExecutor::NextBatch(RowBatch *batch) {
+  if (parallel_) {
+    do {
+      for (; morsel_cursor_ < morsel_batches_.size(); morsel_cursor_++, batch_cursor_ = 0) {
+        auto &batches = morsel_batches_[morsel_cursor_];
+        if (batch_cursor_ < batches.size()) {
+          *batch = std::move(*batches[batch_cursor_]);
+          batches[batch_cursor_++].reset();
+          return true;
+        }
+      }
+    } while (ScanWindow());
+    batch->Clear();
+    return false;
+  }
+  auto program = plan_->GetProgram();
+  // Without projection the rows are decoded into the batch of the caller.
+  RowBatch *scan_batch = is_schema_same_ ? batch : scan_batch_.get();
+  while (iterator_ != table_info_->GetTableHeap()->End()) {
+    scan_batch->Clear();
+    iterator_.NextBatch(scan_batch);
+    if (program != nullptr) {
+      program->Filter(*scan_batch, &scan_batch->GetSelection());
+    }
+    if (scan_batch->GetSelection().empty()) {
+      continue;
+    }
+    if (!is_schema_same_) {
+      batch->Project(*scan_batch, columns_);
+    }
+    return true;
+  }
+  batch->Clear();
+  return false;
+}
+
+bool SeqScanExecutor::ScanWindow() {
+  auto heap = table_info_->GetTableHeap();
+  auto program = plan_->GetProgram();
+  const auto &page_ids = heap->GetPageIds();
+  size_t num_morsels = (page_ids.size() + SCAN_MORSEL_PAGES - 1) / SCAN_MORSEL_PAGES;
+  if (next_morsel_ >= num_morsels) {
+    return false;
+  }
+  size_t first_morsel = next_morsel_;
+  size_t window = std::min(num_morsels - first_morsel, pool_->GetWorkerCount() * SCAN_WINDOW_MORSELS);
+  next_morsel_ += window;
+  // The output of the previous window has been yielded, its batches are released here.
+  morsel_batches_.clear();
+  morsel_batches_.resize(window);
+  morsel_cursor_ = 0;
+  batch_cursor_ = 0;
+  pool_->Run(window, [&](size_t worker, size_t task) {
+    RowBatch *scan_batch = worker_batches_[worker].get();
+    auto &output = morsel_batches_[task];
+    auto flush = [&]() {
+      if (program != nullptr) {
+        program->Filter(*scan_batch, &scan_batch->GetSelection());
+      }
+      if (!scan_batch->GetSelection().empty()) {
+        output.push_back(std::make_unique<RowBatch>(schema_, scan_batch->GetSelection().size()));
+        output.back()->Project(*scan_batch, columns_);
+      }
+      scan_batch->Clear();
+    };
+    size_t morsel = first_morsel + task;
+    size_t end = std::min(page_ids.size(), (morsel + 1) * SCAN_MORSEL_PAGES);
+    for (size_t i = morsel * SCAN_MORSEL_PAGES; i < end; i++) {
+      RowId next_rid(page_ids[i], 0);
+      do {
+        if (scan_batch->IsFull()) {
+          flush();
+        }
+        heap->GetTuples(page_ids[i], next_rid.GetSlotNum(), scan_batch, &next_rid, worker_strategies_[worker].get());
+      } while (next_rid.GetPageId() != INVALID_PAGE_ID);
+    }
+    flush();
+  });
+  return true;
+}
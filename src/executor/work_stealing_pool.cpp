@@ -0,0 +1,68 @@
+#include "executor/work_stealing_pool.h"
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+
+WorkStealingPool::WorkStealingPool(size_t num_workers) : queues_(std::max<size_t>(num_workers, 1)) {}
+
+void WorkStealingPool::Run(size_t num_tasks, const std::function<void(size_t, size_t)> &task) {
+  size_t num_workers = queues_.size();
+  // Contiguous ranges keep neighbouring morsels on one worker as long as nobody steals them.
+  for (size_t worker = 0; worker < num_workers; worker++) {
+    auto &queue = queues_[worker];
+    queue.tasks_.clear();
+    for (size_t i = num_tasks * worker / num_workers; i < num_tasks * (worker + 1) / num_workers; i++) {
+      queue.tasks_.push_back(i);
+    }
+  }
+  std::mutex error_latch;
+  std::exception_ptr error;
+  auto work = [&](size_t worker) {
+    size_t i;
+    while (TakeTask(worker, &i)) {
+      try {
+        task(worker, i);
+      } catch (...) {
+        std::lock_guard<std::mutex> guard(error_latch);
+        if (error == nullptr) {
+          error = std::current_exception();
+        }
+      }
+    }
+  };
+  // The calling thread is worker 0.
+  std::vector<std::thread> threads;
+  for (size_t worker = 1; worker < num_workers; worker++) {
+    threads.emplace_back(work, worker);
+  }
+  work(0);
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  if (error != nullptr) {
+    std::rethrow_exception(error);
+  }
+}
+
+bool WorkStealingPool::TakeTask(size_t worker, size_t *task) {
+  {
+    auto &own = queues_[worker];
+    std::lock_guard<std::mutex> guard(own.latch_);
+    if (!own.tasks_.empty()) {
+      *task = own.tasks_.front();
+      own.tasks_.pop_front();
+      return true;
+    }
+  }
+  for (size_t k = 1; k < queues_.size(); k++) {
+    auto &victim = queues_[(worker + k) % queues_.size()];
+    std::lock_guard<std::mutex> guard(victim.latch_);
+    if (!victim.tasks_.empty()) {
+      *task = victim.tasks_.back();
+      victim.tasks_.pop_back();
+      return true;
+    }
+  }
+  return false;
+}
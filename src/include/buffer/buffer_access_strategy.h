@@ -0,0 +1,60 @@
+#ifndef MINISQL_BUFFER_ACCESS_STRATEGY_H
+#define MINISQL_BUFFER_ACCESS_STRATEGY_H
+
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+
+/**
+ * A small ring of frames of one buffer pool instance. Pages read through the ring are loaded into the frame at the
+ * current position, as long as that frame still holds the page the ring put there and nobody has it pinned.
+ */
+class BufferRing {
+ public:
+  explicit BufferRing(size_t size) : slots_(size, {INVALID_FRAME_ID, INVALID_PAGE_ID}) {}
+
+  /**
+   * @param[out] page_id page the ring loaded into the current frame
+   * @return the frame at the current position, INVALID_FRAME_ID if the ring has not been filled that far
+   */
+  inline frame_id_t GetCurrent(page_id_t *page_id) const {
+    *page_id = slots_[current_].second;
+    return slots_[current_].first;
+  }
+
+  /**
+   * Remember that page_id was loaded into frame_id at the current position, and move to the next one.
+   */
+  inline void Advance(frame_id_t frame_id, page_id_t page_id) {
+    slots_[current_] = {frame_id, page_id};
+    current_ = (current_ + 1) % slots_.size();
+  }
+
+ private:
+  std::vector<std::pair<frame_id_t, page_id_t>> slots_;
+  size_t current_{0};
+};
+
+/**
+ * Access strategy of a bulk read, such as a sequential scan over a table larger than a fraction of the buffer pool.
+ * Pages that miss are recycled through a private ring of frames instead of evicting the shared pool, while resident
+ * pages are used in place. There is one ring per buffer pool instance, since a frame belongs to exactly one of them.
+ *
+ * Every scan should use its own strategy. A ring is only touched under the latch of its instance, so a scan may share
+ * its strategy with the read-ahead working for it.
+ */
+class BufferAccessStrategy {
+ public:
+  BufferAccessStrategy(size_t num_instances, size_t ring_size) {
+    size_t instance_ring_size = (ring_size + num_instances - 1) / num_instances;
+    rings_.assign(num_instances, BufferRing(instance_ring_size > 0 ? instance_ring_size : 1));
+  }
+
+  inline BufferRing *GetRing(size_t instance_index) { return &rings_[instance_index]; }
+
+ private:
+  std::vector<BufferRing> rings_;
+};
+
+#endif  // MINISQL_BUFFER_ACCESS_STRATEGY_H
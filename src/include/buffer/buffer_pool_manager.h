@@ -1,37 +1,128 @@
 #ifndef MINISQL_BUFFER_POOL_MANAGER_H
 #define MINISQL_BUFFER_POOL_MANAGER_H
 
+#include <condition_variable>
 #include <list>
+#include <memory>
 #include <mutex>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
+#include "buffer/buffer_pool_manager_instance.h"
 #include "buffer/lru_replacer.h"
+#include "buffer/page_run.h"
 #include "page/disk_file_meta_page.h"
 #include "page/page.h"
 #include "storage/disk_manager.h"
 
 using namespace std;
 
+class ReadAheadEngine;
+
+/**
+ * Options of the background page cleaner.
+ */
+struct PageCleanerOptions {
+  uint32_t interval_ms{DEFAULT_CLEANER_INTERVAL_MS};
+  size_t pages_per_second{DEFAULT_CLEANER_PAGES_PER_SECOND};
+  double dirty_ratio{DEFAULT_CLEANER_DIRTY_RATIO};
+  double clean_reserve_ratio{DEFAULT_CLEANER_CLEAN_RESERVE_RATIO};
+};
+
+/**
+ * BufferPoolManager partitions the buffer pool into several BufferPoolManagerInstance. Each page id is hashed to
+ * exactly one instance, so that accesses to different pages usually take different latches.
+ */
 class BufferPoolManager {
  public:
-  explicit BufferPoolManager(size_t pool_size, DiskManager *disk_manager);
+  explicit BufferPoolManager(size_t pool_size, DiskManager *disk_manager, size_t num_instances = 1,
+                             ReplacerType replacer_type = ReplacerType::kLRU);
 
   ~BufferPoolManager();
 
   Page *FetchPage(page_id_t page_id);
 
+  /**
+   * Fetch a page on behalf of a bulk read, see BufferAccessStrategy.
+   */
+  Page *FetchPage(page_id_t page_id, BufferAccessStrategy *strategy);
+
+  /**
+   * Read pages on behalf of read-ahead as one batch of disk requests, and return once all of them have completed.
+   * Pages that are resident or on the move already are skipped. See BufferPoolManagerInstance::PrefetchPage.
+   * @return the number of pages read
+   */
+  size_t PrefetchPages(const std::vector<page_id_t> &page_ids, BufferAccessStrategy *strategy = nullptr);
+
   bool UnpinPage(page_id_t page_id, bool is_dirty);
 
   bool FlushPage(page_id_t page_id);
 
   Page *NewPage(page_id_t &page_id);
 
+  /**
+   * Create a new page taken from run, reserving a new run of PAGE_RUN_SIZE pages when it is used up. A null run
+   * allocates a single page like NewPage(page_id).
+   */
+  Page *NewPage(page_id_t &page_id, PageRun *run);
+
   bool DeletePage(page_id_t page_id);
 
+  /**
+   * Delete a set of pages, releasing contiguous ones on disk in a single call. Pages that are pinned are skipped.
+   * @param[out] busy if not null, receives the pages that were skipped
+   * @return false if some page is pinned
+   */
+  bool DeletePages(std::vector<page_id_t> page_ids, std::vector<page_id_t> *busy = nullptr);
+
+  /**
+   * Give the pages of run that have not been handed out back to the disk manager.
+   */
+  void ReleasePageRun(PageRun *run);
+
   bool IsPageFree(page_id_t page_id);
 
   bool CheckAllUnpinned();
 
+  /**
+   * Start a background thread that writes dirty unpinned pages in eviction order, so that evictions rarely have to
+   * write synchronously. A running cleaner is restarted with the new options.
+   */
+  void StartPageCleaner(const PageCleanerOptions &options = PageCleanerOptions());
+
+  void StopPageCleaner();
+
+  /**
+   * @return a fresh strategy for a scan that would otherwise flush the pool
+   */
+  std::shared_ptr<BufferAccessStrategy> GetBulkReadStrategy();
+
+  /**
+   * @return whether reading page_count pages in one pass should go through a bulk read strategy
+   */
+  inline bool IsBulkRead(size_t page_count) const { return page_count > pool_size_ / BULK_READ_POOL_FRACTION; }
+
+  size_t GetDirtyPageCount();
+
+  /** @return the number of dirty victims written back by foreground evictions */
+  size_t GetSyncWriteCount();
+
+  /** @return the number of fetches served by a page brought in by read-ahead */
+  size_t GetPrefetchHitCount();
+
+  /** @return the number of pages brought in by read-ahead that left the pool without being fetched */
+  size_t GetWastedPrefetchCount();
+
+  /**
+   * @return the read-ahead shared by all scans over this pool
+   */
+  inline ReadAheadEngine *GetReadAheadEngine() { return read_ahead_.get(); }
+
+  inline size_t GetPoolSize() const { return pool_size_; }
+
+  inline size_t GetNumInstances() const { return instances_.size(); }
+
  private:
   /**
    * Allocate new page (operations like create index/table) For now just keep an increasing counter
@@ -43,16 +134,24 @@ class BufferPoolManager {
    */
   void DeallocatePage(page_id_t page_id);
 
-  frame_id_t TryToFindFreePage();
+  /**
+   * @return the instance responsible for page_id
+   */
+  inline size_t GetInstanceIndex(page_id_t page_id) const { return static_cast<uint32_t>(page_id) % instances_.size(); }
+
+  inline BufferPoolManagerInstance *GetInstance(page_id_t page_id) { return instances_[GetInstanceIndex(page_id)]; }
+
+  void RunPageCleaner(PageCleanerOptions options);
 
  private:
-  size_t pool_size_;                                 // number of pages in buffer pool
-  Page *pages_;                                      // array of pages
-  DiskManager *disk_manager_;                        // pointer to the disk manager.
-  unordered_map<page_id_t, frame_id_t> page_table_;  // to keep track of pages
-  Replacer *replacer_;                               // to find an unpinned page for replacement
-  list<frame_id_t> free_list_;                       // to find a free page for replacement
-  recursive_mutex latch_;                            // to protect shared data structure
+  size_t pool_size_;                                    // number of pages in buffer pool
+  DiskManager *disk_manager_;                           // pointer to the disk manager.
+  std::vector<BufferPoolManagerInstance *> instances_;  // shards of the buffer pool
+  std::unique_ptr<ReadAheadEngine> read_ahead_;         // prefetches pages for table scans
+  std::thread cleaner_thread_;                          // background page cleaner
+  std::mutex cleaner_latch_;                            // to protect cleaner_running_
+  std::condition_variable cleaner_cv_;                  // to wake up the cleaner when it is stopped
+  bool cleaner_running_{false};
 };
 
 #endif  // MINISQL_BUFFER_POOL_MANAGER_H
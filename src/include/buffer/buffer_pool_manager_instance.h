@@ -0,0 +1,143 @@
+#ifndef MINISQL_BUFFER_POOL_MANAGER_INSTANCE_H
+#define MINISQL_BUFFER_POOL_MANAGER_INSTANCE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "page/page.h"
+#include "storage/disk_manager.h"
+
+/**
+ * One shard of the buffer pool. Every instance owns its frames, page table, replacer and free list, and is
+ * protected by its own latch, so that instances never contend with each other. Page allocation on disk is
+ * done by BufferPoolManager, which routes every page id to exactly one instance.
+ *
+ * Disk I/O is never done while holding the latch. A frame being refilled is put into the loading state and stays in
+ * the page table, so that fetchers of the incoming page wait on that frame's condition variable only. The page
+ * leaving the frame is recorded in writing_back_ until its write completes, so that it is not read back stale.
+ * A resident page being flushed is in the flushing state; it can still be fetched, and holds a pin that keeps it
+ * from being evicted without moving it in the replacer.
+ */
+class BufferPoolManagerInstance {
+ public:
+  explicit BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
+                                     ReplacerType replacer_type = ReplacerType::kLRU);
+
+  ~BufferPoolManagerInstance();
+
+  /**
+   * @param ring if not null, a miss is loaded into the ring's next frame when it can be recycled, resident pages are
+   * used in place
+   */
+  Page *FetchPage(page_id_t page_id, BufferRing *ring = nullptr);
+
+  /**
+   * Start reading a page on behalf of read-ahead. Unless the page is resident or on the move already, it is mapped
+   * into a frame in the loading state and the read filling the frame is appended to reads; the frame becomes ready
+   * once that read completes. The page is marked as prefetched until it is fetched (a prefetch hit) or leaves the
+   * pool unused (a wasted prefetch). Read-ahead does not count as an access of the page.
+   * @return whether a read was appended
+   */
+  bool PrefetchPage(page_id_t page_id, std::vector<DiskIORequest> *reads, BufferRing *ring = nullptr);
+
+  bool UnpinPage(page_id_t page_id, bool is_dirty);
+
+  /**
+   * @return false if the page is not resident or could not be written, it stays dirty then
+   */
+  bool FlushPage(page_id_t page_id);
+
+  /**
+   * Bring a page which has just been allocated on disk into the pool.
+   * @return nullptr if all frames are pinned
+   */
+  Page *NewPage(page_id_t page_id);
+
+  /**
+   * Drop a page from the pool. Deallocating it on disk is left to the caller.
+   * @return false if the page is pinned
+   */
+  bool DeletePage(page_id_t page_id);
+
+  /**
+   * Flush every dirty page in the pool.
+   */
+  void FlushAllPages();
+
+  /**
+   * Write back dirty unpinned pages in eviction order, used by the page cleaner. Pages near the eviction end are
+   * always cleaned up to clean_reserve_ratio of the pool; once more than dirty_ratio of the pool is dirty, the cleaner
+   * goes further down the replacer's order.
+   * @return the number of pages written
+   */
+  size_t CleanPages(size_t max_pages, double dirty_ratio, double clean_reserve_ratio);
+
+  size_t GetDirtyPageCount();
+
+  /** @return the number of dirty victims written back by foreground evictions */
+  inline size_t GetSyncWriteCount() const { return sync_write_count_; }
+
+  inline size_t GetPrefetchHitCount() const { return prefetch_hit_count_; }
+
+  inline size_t GetWastedPrefetchCount() const { return wasted_prefetch_count_; }
+
+  bool CheckAllUnpinned();
+
+  inline size_t GetPoolSize() const { return pool_size_; }
+
+ private:
+  enum class FrameState { kFree, kLoading, kReady, kFlushing };
+
+  /**
+   * Pick a frame from the ring, the free list or the replacer and unmap the page it holds.
+   * @param[out] dirty_page_id page that must be written back before the frame is reused, INVALID_PAGE_ID if none
+   */
+  frame_id_t TryToFindFreePage(page_id_t *dirty_page_id, BufferRing *ring);
+
+  /**
+   * Wait until page_id is neither loading nor being written back.
+   * @return the frame holding page_id, INVALID_FRAME_ID if it is not resident
+   */
+  frame_id_t WaitForPage(page_id_t page_id, std::unique_lock<std::mutex> &lock);
+
+  /**
+   * Map page_id into a free frame, write back the old page and fill the frame with the latch released.
+   * @param read_from_disk whether to read the page content, otherwise the frame is zeroed
+   * @param reads if not null, the read is appended there instead of being done, see PrefetchPage
+   * @return nullptr if no frame is available or the I/O failed, a frame whose old page could not be written back
+   * keeps holding it
+   */
+  Page *LoadPage(page_id_t page_id, bool read_from_disk, std::unique_lock<std::mutex> &lock,
+                 BufferRing *ring = nullptr, std::vector<DiskIORequest> *reads = nullptr);
+
+  /**
+   * Completion of a read issued by PrefetchPage, publishes the frame or gives it back to the free list.
+   */
+  void FinishPrefetch(frame_id_t frame_id, bool success);
+
+ private:
+  size_t pool_size_;                                   // number of pages in buffer pool
+  Page *pages_;                                        // array of pages
+  DiskManager *disk_manager_;                          // pointer to the disk manager.
+  unordered_map<page_id_t, frame_id_t> page_table_;    // to keep track of pages
+  Replacer *replacer_;                                 // to find an unpinned page for replacement
+  list<frame_id_t> free_list_;                         // to find a free page for replacement
+  std::vector<FrameState> frame_states_;               // state of each frame
+  std::condition_variable *frame_cvs_;                 // signaled when a frame finishes loading
+  unordered_map<page_id_t, frame_id_t> writing_back_;  // evicted pages whose write is in flight
+  std::vector<bool> prefetched_;                       // frames read by read-ahead and not fetched since
+  std::atomic<size_t> sync_write_count_{0};            // dirty victims written by evictions
+  std::atomic<size_t> prefetch_hit_count_{0};          // fetches served by a prefetched frame
+  std::atomic<size_t> wasted_prefetch_count_{0};       // prefetched frames dropped before being fetched
+  std::mutex latch_;                                   // to protect shared data structure
+};
+
+#endif  // MINISQL_BUFFER_POOL_MANAGER_INSTANCE_H
@@ -38,6 +38,8 @@ class CLOCKReplacer : public Replacer {
 
   size_t Size() override;
 
+  void PeekVictims(std::vector<frame_id_t> *frame_ids, size_t max_count) override;
+
  private:
   size_t capacity;
   list<frame_id_t> clock_list;               // replacer中可以被替换的数据页
@@ -0,0 +1,73 @@
+#ifndef MINISQL_LRU_K_REPLACER_H
+#define MINISQL_LRU_K_REPLACER_H
+
+#include <deque>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy.
+ *
+ * The victim is the evictable frame whose K-th most recent access is the oldest, i.e. with the largest backward
+ * K-distance. Frames with fewer than K accesses have an infinite backward K-distance and are evicted first, least
+ * recently accessed first. A page touched once by a sequential scan therefore never pushes out pages that are
+ * accessed repeatedly.
+ *
+ * Accesses to a frame that follow its previous access within the correlation window, counted in accesses to the
+ * replacer, are correlated and count as one: a scan touches every page several times in a row, once per tuple and
+ * once more to read it, which must not make the page look hot.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k number of accesses remembered per frame
+   * @param correlation_window accesses to the replacer within which accesses to the same frame count as one
+   */
+  explicit LRUKReplacer(size_t num_pages, size_t k = LRUK_REPLACER_K,
+                        size_t correlation_window = LRUK_CORRELATION_WINDOW);
+
+  ~LRUKReplacer() override;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void RecordAccess(frame_id_t frame_id) override;
+
+  void Forget(frame_id_t frame_id) override;
+
+  size_t Size() override;
+
+  void PeekVictims(std::vector<frame_id_t> *frame_ids, size_t max_count) override;
+
+ private:
+  using Entry = std::pair<size_t, frame_id_t>;  // (K-th most recent access, or the last one below K, frame)
+
+  /** @return the set the frame belongs to while it is evictable */
+  std::set<Entry> &GetSet(frame_id_t frame_id);
+
+  inline Entry GetEntry(frame_id_t frame_id) {
+    return {history_[frame_id].size() < k_ ? last_access_[frame_id] : history_[frame_id].front(), frame_id};
+  }
+
+ private:
+  std::mutex latch_;
+  size_t k_;
+  size_t correlation_window_;
+  size_t current_timestamp_{0};
+  std::vector<std::deque<size_t>> history_;  // last k uncorrelated access timestamps of each frame
+  std::vector<size_t> last_access_;          // timestamp of the last access of each frame, correlated or not
+  std::vector<bool> evictable_;
+  std::set<Entry> infinite_distance_;  // evictable frames with less than k accesses
+  std::set<Entry> finite_distance_;    // evictable frames with k accesses
+};
+
+#endif  // MINISQL_LRU_K_REPLACER_H
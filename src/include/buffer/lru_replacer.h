@@ -36,6 +36,8 @@ public:
 
   size_t Size() override;
 
+  void PeekVictims(std::vector<frame_id_t> *frame_ids, size_t max_count) override;
+
 private:
   // add your own private member variables here
   // Mutex to protect shared data structures: lru_list_ and lru_map_.
@@ -0,0 +1,22 @@
+#ifndef MINISQL_PAGE_RUN_H
+#define MINISQL_PAGE_RUN_H
+
+#include <mutex>
+
+#include "common/config.h"
+
+/**
+ * A run of contiguous pages reserved on disk by one table or index. New pages of the owner are handed out from the
+ * run in order, so that they end up next to each other in the file and can be released in bulk. The part of the run
+ * not handed out yet has to be given back with BufferPoolManager::ReleasePageRun.
+ */
+class PageRun {
+  friend class BufferPoolManager;
+
+ private:
+  page_id_t next_{INVALID_PAGE_ID};  // next page to hand out
+  page_id_t end_{INVALID_PAGE_ID};   // one past the last page of the run
+  std::mutex latch_;                 // to protect next_ and end_
+};
+
+#endif  // MINISQL_PAGE_RUN_H
@@ -2,9 +2,15 @@
 #define MINISQL_REPLACER_H
 
 #include <cstdio>
+#include <vector>
 
 #include "common/config.h"
 
+/**
+ * Replacement policies the buffer pool can be configured with.
+ */
+enum class ReplacerType { kLRU, kClock, kLRUK };
+
 /**
  * Replacer is an abstract class that tracks page usage.
  */
@@ -33,8 +39,29 @@ class Replacer {
    */
   virtual void Unpin(frame_id_t frame_id) = 0;
 
+  /**
+   * Record an access to the page held by a frame. Policies that only look at pin and unpin order ignore it.
+   * @param frame_id the id of the frame that was accessed
+   */
+  virtual void RecordAccess(__attribute__((unused)) frame_id_t frame_id) {}
+
+  /**
+   * Forget the accesses recorded for a frame, which is about to hold another page or none. The frame is not
+   * evictable afterwards.
+   * @param frame_id the id of the frame whose page leaves the pool
+   */
+  virtual void Forget(frame_id_t frame_id) { Pin(frame_id); }
+
   /** @return the number of elements in the replacer that can be victimized */
   virtual size_t Size() = 0;
+
+  /**
+   * List the frames that would be victimized next, in eviction order, without removing them.
+   * @param[out] frame_ids the candidate frames
+   * @param max_count maximum number of frames to return
+   */
+  virtual void PeekVictims(__attribute__((unused)) std::vector<frame_id_t> *frame_ids,
+                           __attribute__((unused)) size_t max_count) {}
 };
 
 #endif  // MINISQL_REPLACER_H
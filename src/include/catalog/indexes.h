@@ -7,6 +7,7 @@
 #include "common/macros.h"
 #include "common/rowid.h"
 #include "index/b_plus_tree_index.h"
+#include "index/hash_index.h"
 #include "index/generic_key.h"
 #include "record/schema.h"
 
@@ -15,7 +16,7 @@ class IndexMetadata {
 
  public:
   static IndexMetadata *Create(const index_id_t index_id, const std::string &index_name, const table_id_t table_id,
-                               const std::vector<uint32_t> &key_map);
+                               const std::vector<uint32_t> &key_map, const std::string &index_type = "bptree");
 
   uint32_t SerializeTo(char *buf) const;
 
@@ -33,18 +34,24 @@ class IndexMetadata {
 
   inline index_id_t GetIndexId() const { return index_id_; }
 
+  /** @return the structure of the index, "bptree" or "hash" */
+  inline const std::string &GetIndexType() const { return index_type_; }
+
  private:
   IndexMetadata() = delete;
 
   explicit IndexMetadata(const index_id_t index_id, const std::string &index_name, const table_id_t table_id,
-                         const std::vector<uint32_t> &key_map);
+                         const std::vector<uint32_t> &key_map, const std::string &index_type);
 
  private:
-  static constexpr uint32_t INDEX_METADATA_MAGIC_NUM = 344528;
+  // Changes with the serialized layout, so that metadata of an older layout is not misread. 344530 added the index
+  // type.
+  static constexpr uint32_t INDEX_METADATA_MAGIC_NUM = 344530;
   index_id_t index_id_;
   std::string index_name_;
   table_id_t table_id_;
   std::vector<uint32_t> key_map_; /** The mapping of index key to tuple key */
+  std::string index_type_;
 };
 
 /**
@@ -69,13 +76,15 @@ class IndexInfo {
     // Step3: call CreateIndex to create the index
     this->meta_data_ = meta_data;
     key_schema_ = table_info->GetSchema()->ShallowCopySchema(table_info->GetSchema(), meta_data->GetKeyMapping());
-    index_ = CreateIndex(buffer_pool_manager, "bptree");
+    index_ = CreateIndex(buffer_pool_manager, meta_data->GetIndexType());
   }
 
   inline Index *GetIndex() { return index_; }
 
   std::string GetIndexName() { return meta_data_->GetIndexName(); }
 
+  std::string GetIndexType() { return meta_data_->GetIndexType(); }
+
   IndexSchema *GetIndexKeySchema() { return key_schema_; }
 
  private:
@@ -15,6 +15,32 @@ static constexpr int INDEX_ROOTS_PAGE_ID = 1;   // logical page id of the index
 
 static constexpr int PAGE_SIZE = 4096;                  // size of a data page in byte
 static constexpr int DEFAULT_BUFFER_POOL_SIZE = 20480;  // default size of buffer pool
+static constexpr int DEFAULT_BUFFER_POOL_INSTANCES = 8;  // default number of buffer pool shards
+
+static constexpr size_t LRUK_REPLACER_K = 2;           // number of accesses remembered by the LRU-K replacer
+static constexpr size_t LRUK_CORRELATION_WINDOW = 32;  // accesses of a replacer after which a page is accessed anew
+
+static constexpr size_t BULK_READ_RING_SIZE = 32;       // frames recycled by a bulk read access strategy
+static constexpr size_t BULK_READ_POOL_FRACTION = 4;    // scans over more than pool_size / 4 pages use a ring
+static constexpr size_t DEFAULT_READ_AHEAD_PAGES = 16;  // pages a table scan reads ahead of its position
+
+static constexpr int DEFAULT_CLEANER_INTERVAL_MS = 10;              // page cleaner wakes up this often
+static constexpr int DEFAULT_CLEANER_PAGES_PER_SECOND = 20000;      // page cleaner write rate limit
+static constexpr double DEFAULT_CLEANER_DIRTY_RATIO = 0.25;         // dirty fraction of the pool to stay under
+static constexpr double DEFAULT_CLEANER_CLEAN_RESERVE_RATIO = 0.1;  // clean fraction at the eviction end
+
+static constexpr unsigned IO_URING_QUEUE_DEPTH = 64;          // submission queue entries of every io_uring
+static constexpr uint32_t PAGE_RUN_SIZE = 64;                 // contiguous pages reserved at once by a table or index
+static constexpr int OPTIMISTIC_DESCENT_RETRIES = 8;          // b+ tree descents without latches before latch crabbing
+static constexpr double DEFAULT_BULK_LOAD_FILL_FACTOR = 0.9;  // fraction of a b+ tree page filled by bulk loading
+
+static constexpr size_t DEFAULT_SORT_MEMORY_BUDGET = 64 << 20;  // bytes an external sort buffers before spilling
+static constexpr size_t DEFAULT_SORT_THREADS = 4;               // threads sorting the buffer of an external sort
+
+static constexpr uint32_t ROW_BATCH_SIZE = 1024;        // rows an executor yields per batch
+static constexpr size_t DEFAULT_SCAN_PARALLELISM = 1;  // worker threads of a sequential scan, 1 scans serially
+static constexpr size_t SCAN_MORSEL_PAGES = 16;        // table pages a parallel scan hands to a worker at once
+static constexpr size_t SCAN_WINDOW_MORSELS = 4;       // morsels per worker a parallel scan buffers the output of
 
 static constexpr uint32_t FIELD_NULL_LEN = UINT32_MAX;
 static constexpr uint32_t VARCHAR_MAX_LEN = PAGE_SIZE / 2;  // max length of varchar
@@ -36,6 +36,19 @@ class ReaderWriterLatch {
     }
   }
 
+  /**
+   * Acquire a write latch only if nobody holds the latch.
+   * @return whether the latch was acquired
+   */
+  bool TryWLock() {
+    std::lock_guard<mutex_t> guard(mutex_);
+    if (writer_entered_ || reader_count_ > 0) {
+      return false;
+    }
+    writer_entered_ = true;
+    return true;
+  }
+
   /**
    * Release a write latch.
    */
@@ -5,6 +5,8 @@
 #ifndef MINISQL_EXECUTE_CONTEXT_H
 #define MINISQL_EXECUTE_CONTEXT_H
 
+#include <algorithm>
+
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/catalog.h"
 #include "common/macros.h"
@@ -34,6 +36,12 @@ class ExecuteContext {
   /** @return the buffer pool manager */
   BufferPoolManager *GetBufferPoolManager() { return bpm_; }
 
+  /** @return the number of worker threads a sequential scan may use */
+  size_t GetScanParallelism() const { return scan_parallelism_; }
+
+  /** Set the number of worker threads a sequential scan may use, 1 scans serially */
+  void SetScanParallelism(size_t scan_parallelism) { scan_parallelism_ = std::max<size_t>(scan_parallelism, 1); }
+
  private:
   /** The recovery context associated with this executor context */
   Txn *transaction_;
@@ -41,6 +49,8 @@ class ExecuteContext {
   CatalogManager *catalog_;
   /** The buffer pool manager associated with this executor context */
   BufferPoolManager *bpm_;
+  /** The number of worker threads a sequential scan may use */
+  size_t scan_parallelism_{DEFAULT_SCAN_PARALLELISM};
 };
 
 #endif  // MINISQL_EXECUTE_CONTEXT_H
@@ -1,6 +1,7 @@
 #ifndef MINISQL_EXECUTE_ENGINE_H
 #define MINISQL_EXECUTE_ENGINE_H
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -40,6 +41,11 @@ class ExecuteEngine {
 
   void ExecuteInformation(dberr_t result);
 
+  /**
+   * Set the number of worker threads the sequential scans of this session may use, 1 scans serially.
+   */
+  void SetScanParallelism(size_t scan_parallelism) { scan_parallelism_ = std::max<size_t>(scan_parallelism, 1); }
+
  private:
   static std::unique_ptr<AbstractExecutor> CreateExecutor(ExecuteContext *exec_ctx, const AbstractPlanNodeRef &plan);
 
@@ -76,6 +82,7 @@ class ExecuteEngine {
  private:
   std::unordered_map<std::string, DBStorageEngine *> dbs_; /** all opened databases */
   std::string current_db_;                                 /** current database */
+  size_t scan_parallelism_{DEFAULT_SCAN_PARALLELISM};      /** worker threads of a sequential scan */
 };
 
 #endif  // MINISQL_EXECUTE_ENGINE_H
@@ -2,8 +2,11 @@
 #define MINISQL_ABSTRACT_EXECUTOR_H
 
 #include "executor/execute_context.h"
+#include "record/row_batch.h"
+
 /**
- * The AbstractExecutor implements the Volcano row-at-a-time iterator model.
+ * The AbstractExecutor implements the Volcano row-at-a-time iterator model, and yields batches of rows through
+ * NextBatch.
  * This is the base class from which all executors in the execution engine
  * inherit, and defines the minimal interface that all executors support.
  */
@@ -32,6 +35,26 @@ class AbstractExecutor {
    */
   virtual bool Next(Row *row, RowId *rid) = 0;
 
+  /**
+   * Yield the next rows from this executor as a batch. Executors that have not been converted to batches are
+   * adapted here by calling Next until the batch is full.
+   * @param[out] batch The rows produced by this executor, a batch of the output schema whose previous rows are dropped
+   * @return `true` if some row was selected in the batch, `false` if there are no more rows
+   */
+  virtual bool NextBatch(RowBatch *batch) {
+    batch->Clear();
+    while (!batch->IsFull()) {
+      Row row;
+      RowId rid;
+      if (!Next(&row, &rid)) {
+        break;
+      }
+      row.SetRowId(rid);
+      batch->AppendRow(row);
+    }
+    return !batch->GetSelection().empty();
+  }
+
   /** @return The schema of the rows that this executor produces */
   virtual const Schema *GetOutputSchema() const = 0;
 
@@ -1,10 +1,12 @@
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include "executor/execute_context.h"
 #include "executor/executors/abstract_executor.h"
 #include "executor/plans/index_scan_plan.h"
+#include "index/index_iterator.h"
 #include "planner/expressions/column_value_expression.h"
 #include "planner/expressions/comparison_expression.h"
 
@@ -31,6 +33,12 @@ class IndexScanExecutor : public AbstractExecutor {
    */
   bool Next(Row *row, RowId *rid) override;
 
+  /**
+   * Yield the next rows from the index scan. The rows of a batch of row ids are decoded straight into the columns of
+   * a batch of the table, which the predicate narrows if needed and the output schema projects.
+   */
+  bool NextBatch(RowBatch *batch) override;
+
   /** @return The output schema for the sequential scan */
   const Schema *GetOutputSchema() const override { return plan_->OutputSchema(); }
 
@@ -39,12 +47,38 @@ class IndexScanExecutor : public AbstractExecutor {
   void TupleTransfer(const Schema *table_schema, const Schema *output_schema, const Row *row, Row *output_row);
 
  private:
-  vector<RowId> IndexScan(AbstractExpressionRef predicate);
+  /**
+   * Keys of an indexed column that satisfy the comparisons of the predicate on it, nullptr bounds are open.
+   */
+  struct KeyRange {
+    IndexInfo *index{nullptr};
+    std::unique_ptr<Row> lower;
+    std::unique_ptr<Row> upper;
+    bool lower_inclusive{true};
+    bool upper_inclusive{true};
+  };
+
+  /**
+   * Narrow the key ranges by the comparisons of a conjunction.
+   * @return false if some part of the predicate is not covered by the ranges
+   */
+  bool CollectRanges(const AbstractExpressionRef &predicate, std::vector<KeyRange> &ranges);
+
+  /**
+   * Start the scan of the index of range, lazily through a range iterator if the index supports it.
+   */
+  void OpenRange(KeyRange &range);
+
+  bool NextRowId(RowId *rid);
 
   /** The sequential scan plan node to be executed */
   const IndexScanPlanNode *plan_;
   TableInfo *table_info_{};
-  vector<RowId> result_;
+  IndexIterator iter_;      // entries of the range being scanned
+  vector<RowId> result_;    // row ids of the range, for indexes without range iterators
   size_t cursor_ = 0;
+  bool need_filter_{true};  // whether the rows of the range are checked against the predicate
   bool is_schema_same_;
+  std::unique_ptr<RowBatch> scan_batch_;  // rows of the table before the projection
+  std::vector<uint32_t> columns_;         // column of the table of each output column
 };
\ No newline at end of file
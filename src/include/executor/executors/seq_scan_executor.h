@@ -5,11 +5,13 @@
 #ifndef MINISQL_SEQ_SCAN_EXECUTOR_H
 #define MINISQL_SEQ_SCAN_EXECUTOR_H
 
+#include <memory>
 #include <vector>
 
 #include "executor/execute_context.h"
 #include "executor/executors/abstract_executor.h"
 #include "executor/plans/seq_scan_plan.h"
+#include "executor/work_stealing_pool.h"
 
 /**
  * The SeqScanExecutor executor executes a sequential table scan.
@@ -34,6 +36,13 @@ class SeqScanExecutor : public AbstractExecutor {
    */
   bool Next(Row *row, RowId *rid) override;
 
+  /**
+   * Yield the next rows from the sequential scan. Pages are decoded straight into the columns of a batch of the
+   * table, which the predicate narrows and the output schema projects. With a scan parallelism above 1, tables of
+   * more than one morsel are scanned by a pool of workers a window of morsels at a time, see ScanWindow.
+   */
+  bool NextBatch(RowBatch *batch) override;
+
   /** @return The output schema for the sequential scan */
   const Schema *GetOutputSchema() const override { return plan_->OutputSchema(); }
 
@@ -42,12 +51,30 @@ class SeqScanExecutor : public AbstractExecutor {
   void TupleTransfer(const Schema *table_schema, const Schema *output_schema, const Row *row, Row *output_row);
 
  private:
+  /**
+   * Scan the next SCAN_WINDOW_MORSELS morsels per worker of the table on the work stealing pool, a morsel being
+   * SCAN_MORSEL_PAGES pages. Every worker filters and projects the rows of its morsels, the batches are kept in morsel
+   * order so that the rows come out in the order of a serial scan. Only one window is buffered at a time.
+   * @return false if every morsel has been scanned already
+   */
+  bool ScanWindow();
+
   /** The sequential scan plan node to be executed */
   const SeqScanPlanNode *plan_;
   TableInfo *table_info_{};
   TableIterator iterator_;
   const Schema *schema_{};
   bool is_schema_same_;
+  std::unique_ptr<RowBatch> scan_batch_;  // rows of the table before the projection
+  std::vector<uint32_t> columns_;         // column of the table of each output column
+  bool parallel_{false};                  // whether NextBatch scans in parallel
+  std::unique_ptr<WorkStealingPool> pool_;
+  std::vector<std::unique_ptr<RowBatch>> worker_batches_;                  // rows of the table per worker
+  std::vector<std::shared_ptr<BufferAccessStrategy>> worker_strategies_;  // ring of each worker for large tables
+  size_t next_morsel_{0};                                                  // first morsel of the next window
+  std::vector<std::vector<std::unique_ptr<RowBatch>>> morsel_batches_;    // output of the window per morsel
+  size_t morsel_cursor_{0};
+  size_t batch_cursor_{0};
 };
 
 #endif  // MINISQL_SEQ_SCAN_EXECUTOR_H
@@ -6,6 +6,9 @@
 #include "abstract_plan.h"
 #include "catalog/catalog.h"
 #include "planner/expressions/abstract_expression.h"
+#include "planner/expressions/column_value_expression.h"
+#include "planner/expressions/comparison_expression.h"
+#include "planner/expressions/predicate_program.h"
 
 /**
  * IndexScanPlanNode identifies a table that should be scanned with an optional predicate.
@@ -16,6 +19,7 @@ class IndexScanPlanNode : public AbstractPlanNode {
    * Creates a new index scan plan node.
    * @param output the output format of this scan plan node
    * @param table_name The identifier of table to be scanned
+   * @param filter_predicate The predicate, compiled into a program here
    */
   IndexScanPlanNode(const Schema *output, std::string table_name, std::vector<IndexInfo *> indexes, bool need_filter,
                     AbstractExpressionRef filter_predicate = nullptr)
@@ -23,7 +27,8 @@ class IndexScanPlanNode : public AbstractPlanNode {
         table_name_(std::move(table_name)),
         indexes_(std::move(indexes)),
         need_filter_(need_filter),
-        filter_predicate_(std::move(filter_predicate)) {}
+        filter_predicate_(std::move(filter_predicate)),
+        program_(filter_predicate_ == nullptr ? nullptr : std::make_unique<PredicateProgram>(filter_predicate_)) {}
 
   /** @return The type of the plan node */
   PlanType GetType() const override { return PlanType::IndexScan; }
@@ -33,6 +38,31 @@ class IndexScanPlanNode : public AbstractPlanNode {
 
   AbstractExpressionRef GetPredicate() const { return filter_predicate_; }
 
+  /** @return The compiled predicate, nullptr if there is no predicate */
+  const PredicateProgram *GetProgram() const { return program_.get(); }
+
+  /**
+   * @return whether the index can bound a scan for predicate, which must compare its key column with a constant. A
+   * hash index keeps no key order, it only serves equality.
+   */
+  static bool CanServe(IndexInfo *index, const AbstractExpressionRef &predicate) {
+    if (predicate->GetType() != ExpressionType::ComparisonExpression ||
+        predicate->GetChildAt(0)->GetType() != ExpressionType::ColumnExpression ||
+        predicate->GetChildAt(1)->GetType() != ExpressionType::ConstantExpression) {
+      return false;
+    }
+    uint32_t col_idx = dynamic_pointer_cast<ColumnValueExpression>(predicate->GetChildAt(0))->GetColIdx();
+    if (col_idx != index->GetIndexKeySchema()->GetColumn(0)->GetTableInd()) {
+      return false;
+    }
+    std::string type = dynamic_pointer_cast<ComparisonExpression>(predicate)->GetComparisonType();
+    if (type == "=") {
+      return true;
+    }
+    bool ordered = dynamic_cast<BPlusTreeIndex *>(index->GetIndex()) != nullptr;
+    return ordered && (type == ">" || type == ">=" || type == "<" || type == "<=");
+  }
+
   /** The table name */
   std::string table_name_;
 
@@ -44,4 +74,7 @@ class IndexScanPlanNode : public AbstractPlanNode {
 
   /** The predicate to filter in IndexScan.*/
   AbstractExpressionRef filter_predicate_;
+
+  /** The compiled predicate.*/
+  std::unique_ptr<const PredicateProgram> program_;
 };
\ No newline at end of file
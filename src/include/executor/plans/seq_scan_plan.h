@@ -8,6 +8,7 @@
 #include "abstract_plan.h"
 #include "catalog/catalog.h"
 #include "planner/expressions/abstract_expression.h"
+#include "planner/expressions/predicate_program.h"
 
 class SeqScanPlanNode : public AbstractPlanNode {
  public:
@@ -15,11 +16,13 @@ class SeqScanPlanNode : public AbstractPlanNode {
    * Construct a new SeqScanPlanNode instance.
    * @param output The output schema of this sequential scan plan node
    * @param table_name The identifier of table to be scanned
+   * @param filter_predicate The predicate, compiled into a program here
    */
   SeqScanPlanNode(const Schema *output, std::string table_name, AbstractExpressionRef filter_predicate = nullptr)
       : AbstractPlanNode(output, {}),
         table_name_(std::move(table_name)),
-        filter_predicate_(std::move(filter_predicate)) {}
+        filter_predicate_(std::move(filter_predicate)),
+        program_(filter_predicate_ == nullptr ? nullptr : std::make_unique<PredicateProgram>(filter_predicate_)) {}
 
   /** @return The type of the plan node */
   PlanType GetType() const override { return PlanType::SeqScan; }
@@ -29,11 +32,17 @@ class SeqScanPlanNode : public AbstractPlanNode {
 
   AbstractExpressionRef GetPredicate() const { return filter_predicate_; }
 
+  /** @return The compiled predicate, nullptr if there is no predicate */
+  const PredicateProgram *GetProgram() const { return program_.get(); }
+
   /** The table name */
   std::string table_name_;
 
   /** The predicate to filter in SeqScan.*/
   AbstractExpressionRef filter_predicate_;
+
+  /** The compiled predicate.*/
+  std::unique_ptr<const PredicateProgram> program_;
 };
 
 #endif  // MINISQL_SEQ_SCAN_PLAN_H
@@ -0,0 +1,42 @@
+#ifndef MINISQL_WORK_STEALING_POOL_H
+#define MINISQL_WORK_STEALING_POOL_H
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+/**
+ * Runs a fixed number of tasks, such as the morsels of a parallel scan, on a set of worker threads.
+ *
+ * Tasks are dealt out to per worker queues in contiguous ranges up front. A worker takes tasks from the front of its
+ * own queue, and once that runs dry steals from the back of the others, so that workers that got cheap tasks help
+ * out the ones that got expensive ones. No tasks are added while the pool runs, so a worker that finds every queue
+ * empty is done.
+ */
+class WorkStealingPool {
+ public:
+  explicit WorkStealingPool(size_t num_workers);
+
+  inline size_t GetWorkerCount() const { return queues_.size(); }
+
+  /**
+   * Run task(worker, i) for every i in [0, num_tasks) and wait for all of them. The first exception a task throws
+   * is rethrown here once the workers have stopped.
+   * @param task the worker index identifies state private to the thread running the task
+   */
+  void Run(size_t num_tasks, const std::function<void(size_t, size_t)> &task);
+
+ private:
+  struct TaskQueue {
+    std::mutex latch_;
+    std::deque<size_t> tasks_;
+  };
+
+  /** @return whether a task was found, from the front of the own queue or the back of another one */
+  bool TakeTask(size_t worker, size_t *task);
+
+  std::vector<TaskQueue> queues_;
+};
+
+#endif  // MINISQL_WORK_STEALING_POOL_H
@@ -1,10 +1,16 @@
 #ifndef MINISQL_B_PLUS_TREE_H
 #define MINISQL_B_PLUS_TREE_H
 
+#include <atomic>
+#include <deque>
+#include <fstream>
+#include <functional>
 #include <queue>
 #include <string>
 #include <vector>
 
+#include "buffer/page_run.h"
+#include "common/rwlatch.h"
 #include "concurrency/txn.h"
 #include "index/index_iterator.h"
 #include "page/b_plus_tree_internal_page.h"
@@ -16,10 +22,19 @@
  *
  * Implementation of simple b+ tree data structure where internal pages direct
  * the search and leaf pages contain actual data.
- * (1) We only support unique key
+ * (1) We only support unique key, a non-unique index makes its keys unique by appending the row id
  * (2) support insert & remove
  * (3) The structure should shrink and grow dynamically
  * (4) Implement index iterator for range scan
+ * (5) Concurrent access through latch crabbing: lookups read latch pages top down, inserts and removes write latch
+ *     them and release the ancestors of every page that cannot split or underflow. root_page_id_ is protected by a
+ *     latch that acts as the parent of the root page.
+ * (6) Optimistic lock coupling: descents first go down without latching inner pages, validating the page versions
+ *     instead, and only latch the leaf. Inserts and removes that cannot change the structure are done that way too,
+ *     the others and descents that keep running into writers fall back to latch crabbing.
+ * (7) Keys are stored at their actual length with the prefix of a page stored once, so pages split and merge by the
+ *     bytes their keys take. Separators pushed up from leaves are cut to the shortest key that still separates them.
+ * (8) Pages split at the right edge of the tree by an append keep all they can, so increasing keys fill them up.
  */
 class BPlusTree {
   using InternalPage = BPlusTreeInternalPage;
@@ -29,12 +44,23 @@ class BPlusTree {
   explicit BPlusTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager, const KeyManager &comparator,
                      int leaf_max_size = UNDEFINED_SIZE, int internal_max_size = UNDEFINED_SIZE);
 
+  ~BPlusTree() { buffer_pool_manager_->ReleasePageRun(&page_run_); }
+
   // Returns true if this B+ tree has no keys and values.
   bool IsEmpty() const;
 
   // Insert a key-value pair into this B+ tree.
   bool Insert(GenericKey *key, const RowId &value, Txn *transaction = nullptr);
 
+  /**
+   * Build the empty tree bottom up from pairs in strictly ascending key order, packing pages to fill_factor of their
+   * capacity and writing every page once.
+   * @param next fills in the next pair and returns true, or returns false at the end of the input
+   * @return false if the tree is not empty or the input is not in order, the tree is left empty then
+   */
+  bool BulkLoad(const std::function<bool(GenericKey *key, RowId *value)> &next,
+                double fill_factor = DEFAULT_BULK_LOAD_FILL_FACTOR);
+
   // Remove a key and its value from this B+ tree.
   void Remove(const GenericKey *key, Txn *transaction = nullptr);
 
@@ -47,13 +73,13 @@ class BPlusTree {
 
   IndexIterator End();
 
-  // expose for test purpose
+  // expose for test purpose, the leaf is returned pinned but not latched
   Page *FindLeafPage(const GenericKey *key, page_id_t page_id = INVALID_PAGE_ID, bool leftMost = false);
 
   // used to check whether all pages are unpinned
   bool Check();
 
-  // destroy the b plus tree
+  // destroy the subtree rooted at current_page_id, or the whole b plus tree and its root record if it is invalid
   void Destroy(page_id_t current_page_id = INVALID_PAGE_ID);
 
   void PrintTree(std::ofstream &out, Schema *schema) {
@@ -68,30 +94,118 @@ class BPlusTree {
   }
 
  private:
+  enum class Operation { kRead, kInsert, kRemove };
+
+  /**
+   * Pages write latched by an insert or remove, from the highest one that may still change down to the leaf.
+   */
+  struct WriteSet {
+    bool root_locked{false};  // whether root_latch_ is held
+    std::vector<Page *> pages;
+  };
+
+  /**
+   * Bytes a run of consecutive keys of a bulk load level takes in a page, kept up to date as keys are added.
+   */
+  struct KeyRun {
+    int begin{0};          // index of the first key of the run in its level
+    int count{0};          // number of keys
+    int prefix_size{0};    // bytes the stored keys have in common
+    int stripped_size{0};  // bytes of the stored keys without trailing zeros
+    int max_stripped_size{0};
+  };
+
+  /**
+   * Pairs of one level of a bulk load that are not written to a page yet, values are row ids on the leaf level and
+   * page ids above.
+   */
+  struct BulkLoadLevel {
+    std::vector<char> keys;
+    std::vector<int64_t> values;
+    KeyRun head;                              // pairs written to the next page
+    KeyRun tail;                              // pairs after the head, once the head is full
+    bool head_full{false};
+    int num_pages{0};                         // pages written so far
+    page_id_t last_page_id{INVALID_PAGE_ID};  // to link leaves
+    std::vector<char> last_key;               // last key of the last page, to cut separators
+  };
+
+  void BulkLoadAppend(std::deque<BulkLoadLevel> &levels, size_t level, const char *key, int64_t value,
+                      double fill_factor, std::vector<page_id_t> &built);
+
+  void BulkLoadFlush(std::deque<BulkLoadLevel> &levels, size_t level, int count, double fill_factor,
+                     std::vector<page_id_t> &built);
+
+  // add the next key of a level to one of its runs
+  void ExtendRun(KeyRun &run, const BulkLoadLevel &current, bool leaf) const;
+
+  // fraction of a page a run fills, by entries or by space, whichever is more
+  double RunFill(const KeyRun &run, bool leaf) const;
+
+  /**
+   * Choose where to split sorted entries into two pages: both halves must fit, and the fuller one is filled as
+   * little as possible.
+   * @param append the last entry is appended at the right edge of the tree, the left page is filled as much as possible
+   * @return number of entries of the left page, 0 if there is no such split
+   */
+  int SplitPoint(const char *keys, int count, bool leaf, bool append) const;
+
+  /**
+   * The shortest key that is greater than left and not greater than right: right cut after the first byte they
+   * differ in.
+   */
+  void ShortestSeparator(const char *left, const char *right, char *separator) const;
+
+  bool IsSafe(BPlusTreePage *node, Operation op, const GenericKey *key) const;
+
+  bool FindLeafPageOptimistic(const GenericKey *key, bool leftMost, bool exclusive, Page **leaf);
+
+  Page *FindLeafPageRead(const GenericKey *key, bool leftMost);
+
+  Page *FindLeafPageWrite(const GenericKey *key, Operation op, WriteSet &write_set);
+
+  void ReleaseWriteSet(WriteSet &write_set, bool is_dirty);
+
+  void ReleaseAncestors(WriteSet &write_set);
+
   void StartNewTree(GenericKey *key, const RowId &value);
 
-  bool InsertIntoLeaf(GenericKey *key, const RowId &value, Txn *transaction = nullptr);
+  bool InsertIntoLeaf(LeafPage *leaf_page, GenericKey *key, const RowId &value, Txn *transaction = nullptr);
+
+  void InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlusTreePage *new_node, bool append,
+                        Txn *transaction = nullptr);
 
-  void InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlusTreePage *new_node, Txn *transaction = nullptr);
+  /**
+   * Split the entries of node, with the new one included, between node and a new sibling.
+   * @param append the new entry is the last one of the tree, see SplitPoint
+   * @param[out] separator key of the sibling in the parent
+   */
+  LeafPage *Split(LeafPage *node, const std::vector<char> &keys, const std::vector<RowId> &values, bool append,
+                  char *separator, Txn *transaction);
 
-  LeafPage *Split(LeafPage *node, Txn *transaction);
+  InternalPage *Split(InternalPage *node, const std::vector<char> &keys, const std::vector<page_id_t> &values,
+                      bool append, char *separator, Txn *transaction);
 
-  InternalPage *Split(InternalPage *node, Txn *transaction);
+  bool TryRemove(const GenericKey *key, Txn *transaction);
 
   template <typename N>
-  bool CoalesceOrRedistribute(N *&node, Txn *transaction = nullptr);
+  bool CoalesceOrRedistribute(N *neighbor_node, N *node, InternalPage *parent, int index,
+                              std::vector<page_id_t> &deleted);
 
-  bool Coalesce(InternalPage *&neighbor_node, InternalPage *&node, InternalPage *&parent, int index,
-                Txn *transaction = nullptr);
+  void Coalesce(InternalPage *left, InternalPage *right, const std::vector<char> &keys,
+                const std::vector<page_id_t> &values, InternalPage *parent, int index,
+                std::vector<page_id_t> &deleted);
 
-  bool Coalesce(LeafPage *&neighbor_node, LeafPage *&node, InternalPage *&parent, int index,
-                Txn *transaction = nullptr);
+  void Coalesce(LeafPage *left, LeafPage *right, const std::vector<char> &keys, const std::vector<RowId> &values,
+                InternalPage *parent, int index, std::vector<page_id_t> &deleted);
 
-  void Redistribute(LeafPage *neighbor_node, LeafPage *node, int index);
+  void Redistribute(LeafPage *left, LeafPage *right, const std::vector<char> &keys, const std::vector<RowId> &values,
+                    InternalPage *parent, int index);
 
-  void Redistribute(InternalPage *neighbor_node, InternalPage *node, int index);
+  void Redistribute(InternalPage *left, InternalPage *right, const std::vector<char> &keys,
+                    const std::vector<page_id_t> &values, InternalPage *parent, int index);
 
-  bool AdjustRoot(BPlusTreePage *node);
+  bool AdjustRoot(BPlusTreePage *node, std::vector<page_id_t> &deleted);
 
   void UpdateRootPageId(int insert_record = 0);
 
@@ -102,8 +216,10 @@ class BPlusTree {
 
   // member variable
   index_id_t index_id_;
-  page_id_t root_page_id_{INVALID_PAGE_ID};
+  std::atomic<page_id_t> root_page_id_{INVALID_PAGE_ID};  // written under root_latch_, read without by descents
+  ReaderWriterLatch root_latch_;                            // to protect root_page_id_
   BufferPoolManager *buffer_pool_manager_;
+  PageRun page_run_;  // pages reserved for the nodes of the tree
   KeyManager processor_;
   int leaf_max_size_;
   int internal_max_size_;
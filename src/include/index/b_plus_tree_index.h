@@ -5,9 +5,15 @@
 #include "index/generic_key.h"
 #include "index/index.h"
 
+/**
+ * Index on a B+ tree. The tree only holds unique keys, so a non-unique index appends the row id to the encoded key:
+ * the row ids of a key form a run of adjacent entries sorted by row id, which may span several leaves. The row id
+ * follows the encoded bytes right away, no encoding is a prefix of another one, so short keys stay short.
+ */
 class BPlusTreeIndex : public Index {
  public:
-  BPlusTreeIndex(index_id_t index_id, IndexSchema *key_schema, size_t key_size, BufferPoolManager *buffer_pool_manager);
+  BPlusTreeIndex(index_id_t index_id, IndexSchema *key_schema, size_t key_size, BufferPoolManager *buffer_pool_manager,
+                 bool unique = true);
 
   dberr_t InsertEntry(const Row &key, RowId row_id, Txn *txn) override;
 
@@ -17,13 +23,42 @@ class BPlusTreeIndex : public Index {
 
   dberr_t Destroy() override;
 
+  /**
+   * Sort the entries with an external merge sort and build the tree bottom up, if the tree is empty.
+   */
+  dberr_t BulkLoad(const std::function<bool(Row &key, RowId &row_id)> &next, Txn *txn) override;
+
   IndexIterator GetBeginIterator();
 
   IndexIterator GetBeginIterator(GenericKey *key);
 
   IndexIterator GetEndIterator();
 
+  /**
+   * Iterator over the entries with keys between lower and upper. It seeks to the lower bound once and becomes equal
+   * to the end iterator at the upper bound, reading the entries only as it is advanced.
+   * @param lower the lower bound, nullptr if the range is not bounded below
+   * @param upper the upper bound, nullptr if the range is not bounded above
+   */
+  IndexIterator GetRangeIterator(const Row *lower, bool lower_inclusive, const Row *upper, bool upper_inclusive);
+
+ protected:
+  /**
+   * Encode key into index_key, followed by the row id if the index is not unique.
+   * @return the size of the encoded key, without the row id
+   */
+  uint32_t SerializeFromKey(GenericKey *index_key, const Row &key, RowId row_id) const;
+
+  /**
+   * Compare two tree keys by the encoded index key of rhs only, ignoring the row id.
+   */
+  inline int CompareIndexKeys(const GenericKey *lhs, const GenericKey *rhs, uint32_t encoded_size) const {
+    return memcmp(lhs, rhs, encoded_size);
+  }
+
  protected:
+  // largest size of the encoded index key, tree keys are longer if the row id is appended
+  size_t key_size_;
   // comparator for key
   KeyManager processor_;
   // container
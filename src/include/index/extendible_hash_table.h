@@ -0,0 +1,140 @@
+#ifndef MINISQL_EXTENDIBLE_HASH_TABLE_H
+#define MINISQL_EXTENDIBLE_HASH_TABLE_H
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/page_run.h"
+#include "common/rwlatch.h"
+#include "index/generic_key.h"
+#include "page/hash_table_bucket_page.h"
+#include "page/hash_table_directory_page.h"
+
+/**
+ * Disk resident extendible hash table mapping keys to row ids, for equality lookups in a bounded number of page
+ * fetches: the directory page and the bucket.
+ *
+ * (1) The directory page id is kept in the index roots page like the root of a B+ tree, the directory is created on
+ *     the first insert and never moves.
+ * (2) A full bucket is split, doubling the directory if needed. Keys that agree on all the bits the directory can
+ *     use go to overflow pages of the bucket instead. An emptied bucket is merged into its split image, and the
+ *     directory halves once no bucket needs its highest bit.
+ * (3) A unique table holds a key at most once, otherwise a key may map to any number of different row ids.
+ * (4) Lookups and inserts or removes that stay within their bucket hold the table latch shared and latch the first
+ *     page of the bucket, which protects the overflow pages as well. Splits and merges hold the table latch
+ *     exclusively.
+ */
+class ExtendibleHashTable {
+  using DirectoryPage = HashTableDirectoryPage;
+  using BucketPage = HashTableBucketPage;
+
+ public:
+  explicit ExtendibleHashTable(index_id_t index_id, BufferPoolManager *buffer_pool_manager, const KeyManager &km,
+                               bool unique = true);
+
+  ~ExtendibleHashTable() { buffer_pool_manager_->ReleasePageRun(&page_run_); }
+
+  /**
+   * @return false if the key is in a unique table already, or the pair is in the table already
+   */
+  bool Insert(const GenericKey *key, const RowId &value);
+
+  /**
+   * Remove the key, or only its pair with value if the table is not unique.
+   */
+  void Remove(const GenericKey *key, const RowId &value);
+
+  /**
+   * Append the row ids of key to result.
+   * @return whether the key was found
+   */
+  bool GetValue(const GenericKey *key, std::vector<RowId> &result);
+
+  /**
+   * Call visit for every pair of the table, in no particular order.
+   */
+  void ForEach(const std::function<void(GenericKey *key, const RowId &value)> &visit);
+
+  // destroy the table and its root record
+  void Destroy();
+
+  // expose for test purpose
+  uint32_t GetGlobalDepth();
+
+  // used to check whether all pages are unpinned
+  bool Check();
+
+ private:
+  /**
+   * Hash of the key bytes, its lowest bits select the directory slot.
+   */
+  uint32_t Hash(const GenericKey *key) const;
+
+  /**
+   * Fetch a page of the table pinned, throws if the buffer pool has no frame for it.
+   */
+  Page *FetchPage(page_id_t page_id);
+
+  /**
+   * Allocate a page for the table pinned, throws if the buffer pool has no frame for it.
+   */
+  Page *NewPage(page_id_t &page_id);
+
+  /**
+   * Whether value goes with key in the table, comparing values only if the table is not unique.
+   */
+  bool Matches(BucketPage *page, int index, const GenericKey *key, const RowId &value) const;
+
+  /**
+   * Add the pair to the bucket starting at bucket if one of its pages has room, the caller holds the latch of the
+   * bucket.
+   * @return 1 if inserted, 0 if the key or pair is in the bucket already, -1 if the bucket is full
+   */
+  int InsertIntoBucket(BucketPage *bucket, const GenericKey *key, const RowId &value);
+
+  /**
+   * Add the pair to the first page of the bucket with room, adding an overflow page if there is none.
+   */
+  void AppendToBucket(BucketPage *bucket, const GenericKey *key, const RowId &value);
+
+  /**
+   * Insert with the table latch held exclusively, splitting buckets until the pair fits.
+   */
+  bool InsertExclusive(const GenericKey *key, const RowId &value);
+
+  /**
+   * @return whether splitting the bucket down to the maximum depth would move any of its keys away from hash
+   */
+  bool SplitSeparates(BucketPage *bucket, uint32_t hash);
+
+  /**
+   * Split the bucket of slot into two buckets of the next local depth.
+   */
+  void SplitBucket(DirectoryPage *directory, uint32_t slot, BucketPage *bucket);
+
+  /**
+   * Merge the bucket of slot into its split image while it is empty, and shrink the directory, with the table latch
+   * held exclusively.
+   */
+  void MergeEmptyBuckets(const GenericKey *key);
+
+  /**
+   * Collect the page ids of the bucket starting at bucket_page_id, its first page included.
+   */
+  void CollectBucketPages(page_id_t bucket_page_id, std::vector<page_id_t> &page_ids);
+
+  void UpdateRootPageId(int insert_record = 0);
+
+  // member variable
+  index_id_t index_id_;
+  std::atomic<page_id_t> directory_page_id_{INVALID_PAGE_ID};
+  ReaderWriterLatch table_latch_;
+  BufferPoolManager *buffer_pool_manager_;
+  PageRun page_run_;  // pages reserved for the buckets of the table
+  KeyManager processor_;
+  bool unique_;
+};
+
+#endif  // MINISQL_EXTENDIBLE_HASH_TABLE_H
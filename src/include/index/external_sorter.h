@@ -0,0 +1,116 @@
+#ifndef MINISQL_EXTERNAL_SORTER_H
+#define MINISQL_EXTERNAL_SORTER_H
+
+#include <cstdio>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "common/rowid.h"
+#include "index/generic_key.h"
+
+/**
+ * External merge sort of (key, row id) pairs, ordered by the memcmp order of the encoded keys and then by row id.
+ *
+ * Pairs are gathered in a buffer of the memory budget. A full buffer is cut into slices that are sorted by separate
+ * threads, merged and written to a temporary file as one sorted run. Once all pairs are in, the runs, or the slices
+ * of the buffer if nothing had to be written out, are merged in a single pass while the caller reads the pairs.
+ */
+class ExternalSorter {
+ public:
+  explicit ExternalSorter(size_t key_size, size_t memory_budget = DEFAULT_SORT_MEMORY_BUDGET,
+                          size_t num_threads = DEFAULT_SORT_THREADS);
+
+  ~ExternalSorter();
+
+  DISALLOW_COPY(ExternalSorter);
+
+  void Add(const GenericKey *key, RowId row_id);
+
+  /**
+   * Finish adding pairs, they can be read with Next afterwards.
+   */
+  void Sort();
+
+  /**
+   * @return false once all pairs have been read, or once the sort has failed
+   */
+  bool Next(GenericKey *key, RowId *row_id);
+
+  /**
+   * @return whether writing or reading a run has failed, pairs are missing from the output then. The error is sticky,
+   * callers check it once Next returns false.
+   */
+  inline bool IsFailed() const { return failed_; }
+
+  /** @return the number of runs written to disk */
+  inline size_t GetNumRuns() const { return runs_.size(); }
+
+ private:
+  /**
+   * Sorted sequence of records to merge, a slice of the buffer or a run on disk read through a buffer of its own.
+   */
+  struct Source {
+    const char *current{nullptr};        // record at the head, nullptr once exhausted
+    const uint32_t *order{nullptr};      // slice: positions of its records in the buffer, in order
+    const uint32_t *order_end{nullptr};  // slice: end of the positions
+    std::vector<char> buffer;            // run: records read from disk
+    const char *end{nullptr};            // run: end of the records in the buffer
+    size_t file_offset{0};               // run: next byte to read
+    size_t file_end{0};                  // run: end of the run in the file
+  };
+
+  inline const char *RecordAt(uint32_t index) const { return buffer_.data() + index * record_size_; }
+
+  /**
+   * Order of two records, by key bytes and then by row id.
+   */
+  bool Less(const char *lhs, const char *rhs) const;
+
+  /**
+   * Sort the buffered records slice by slice, in parallel.
+   * @return the sources of the sorted slices
+   */
+  std::vector<Source> SortSlices();
+
+  /**
+   * Sort the buffered records and append them to the temporary file as a run.
+   */
+  void SpillRun();
+
+  void Advance(Source &source);
+
+  /**
+   * Read the next part of a run into its buffer.
+   */
+  void Refill(Source &source);
+
+  /**
+   * Remove the smallest record from the merge, and copy it to record.
+   */
+  void PopMin(char *record);
+
+  /**
+   * Start merging sources_, building the heap of their heads.
+   */
+  void StartMerge();
+
+ private:
+  size_t key_size_;
+  size_t record_size_;  // key followed by the row id
+  size_t memory_budget_;
+  size_t num_threads_;
+  size_t buffer_capacity_;       // records that fit into the memory budget
+  std::vector<char> buffer_;     // records not sorted yet
+  std::vector<uint32_t> order_;  // sorted positions of the records in the buffer
+  std::FILE *file_{nullptr};     // temporary file holding the runs
+  size_t file_size_{0};
+  std::vector<std::pair<size_t, size_t>> runs_;  // offset and size of every run in the file
+  std::vector<Source> sources_;                  // sorted sequences being merged
+  std::vector<Source *> heap_;                   // sources by their head, the smallest on top
+  std::vector<char> record_;                     // record being returned by Next
+  bool sorted_{false};
+  bool failed_{false};
+};
+
+#endif  // MINISQL_EXTERNAL_SORTER_H
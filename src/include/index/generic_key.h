@@ -17,45 +17,31 @@ class KeyManager {
     return (GenericKey *)malloc(key_size_);  // remember delete
   }
 
-  inline void SerializeFromKey(GenericKey *key_buf, const Row &key, Schema *schema) const {
-    // initialize to 0
-    [[maybe_unused]] uint32_t size = key.GetSerializedSize(schema);
-    ASSERT(key.GetFieldCount() == schema->GetColumnCount(), "field nums not match.");
-    ASSERT(size <= (uint32_t)key_size_, "Index key size exceed max key size.");
-    memset(key_buf->data, 0, key_size_);
-    key.SerializeTo(key_buf->data, schema);
-  }
-
-  inline void DeserializeToKey(const GenericKey *key_buf, Row &key, Schema *schema) const {
-    [[maybe_unused]] uint32_t ofs = key.DeserializeFrom(const_cast<char *>(key_buf->data), schema);
-    ASSERT(ofs <= (uint32_t)key_size_, "Index key size exceed max key size.");
-  }
+  /**
+   * Encode key into key_buf in a binary format whose byte order is the key order, so that keys are compared with a
+   * single memcmp. Every column starts with a null marker byte (nulls sort first and have no payload), followed by
+   * the payload of a value:
+   * - int: big endian with the sign bit flipped
+   * - float: IEEE bits with the sign bit flipped for positive values and all bits flipped for negative ones
+   * - char: the bytes with every zero byte escaped as 0x00 0xff, terminated by 0x00 0x00
+   * No encoding is a prefix of another one, and the rest of the buffer is zeroed, so that B+ tree pages can leave
+   * out the trailing zeros of short keys.
+   * @return the number of bytes written, keys that are equal up to that many bytes encode the same value
+   */
+  uint32_t SerializeFromKey(GenericKey *key_buf, const Row &key, Schema *schema) const;
+
+  void DeserializeToKey(const GenericKey *key_buf, Row &key, Schema *schema) const;
 
   // compare
   [[nodiscard]] inline int CompareKeys(const GenericKey *lhs, const GenericKey *rhs) const {
-    //    ASSERT(malloc_usable_size((void *)&lhs) == malloc_usable_size((void *)&rhs), "key size not match.");
-    uint32_t column_count = key_schema_->GetColumnCount();
-    Row lhs_key(INVALID_ROWID);
-    Row rhs_key(INVALID_ROWID);
-    DeserializeToKey(lhs, lhs_key, key_schema_);
-    DeserializeToKey(rhs, rhs_key, key_schema_);
-
-    for (uint32_t i = 0; i < column_count; i++) {
-      Field *lhs_value = lhs_key.GetField(i);
-      Field *rhs_value = rhs_key.GetField(i);
-
-      if (lhs_value->CompareLessThan(*rhs_value) == CmpBool::kTrue) {
-        return -1;
-      }
-
-      if (lhs_value->CompareGreaterThan(*rhs_value) == CmpBool::kTrue) {
-        return 1;
-      }
-    }
-    // equals
-    return 0;
+    return memcmp(lhs->data, rhs->data, key_size_);
   }
 
+  /**
+   * @return the largest number of bytes SerializeFromKey writes for keys of schema
+   */
+  static uint32_t GetEncodedSize(const Schema *schema);
+
   inline int GetKeySize() const { return key_size_; }
 
   KeyManager(const KeyManager &other) {
@@ -0,0 +1,32 @@
+#ifndef MINISQL_HASH_INDEX_H
+#define MINISQL_HASH_INDEX_H
+
+#include "index/extendible_hash_table.h"
+#include "index/generic_key.h"
+#include "index/index.h"
+
+/**
+ * Index on an extendible hash table. Equality lookups read a single bucket, the other comparisons have to scan the
+ * whole table, which keeps no order.
+ */
+class HashIndex : public Index {
+ public:
+  HashIndex(index_id_t index_id, IndexSchema *key_schema, size_t key_size, BufferPoolManager *buffer_pool_manager,
+            bool unique = true);
+
+  dberr_t InsertEntry(const Row &key, RowId row_id, Txn *txn) override;
+
+  dberr_t RemoveEntry(const Row &key, RowId row_id, Txn *txn) override;
+
+  dberr_t ScanKey(const Row &key, std::vector<RowId> &result, Txn *txn, string compare_operator = "=") override;
+
+  dberr_t Destroy() override;
+
+ protected:
+  // comparator for key
+  KeyManager processor_;
+  // container
+  ExtendibleHashTable container_;
+};
+
+#endif  // MINISQL_HASH_INDEX_H
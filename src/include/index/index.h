@@ -1,6 +1,7 @@
 #ifndef MINISQL_INDEX_H
 #define MINISQL_INDEX_H
 
+#include <functional>
 #include <memory>
 
 #include "common/dberr.h"
@@ -9,7 +10,8 @@
 
 class Index {
  public:
-  explicit Index(index_id_t index_id, IndexSchema *key_schema) : index_id_(index_id), key_schema_(key_schema) {}
+  explicit Index(index_id_t index_id, IndexSchema *key_schema, bool unique = true)
+      : index_id_(index_id), key_schema_(key_schema), unique_(unique) {}
 
   virtual ~Index() {}
 
@@ -21,9 +23,29 @@ class Index {
 
   virtual dberr_t Destroy() = 0;
 
+  /** @return whether a key may be in the index at most once, otherwise it can map to many row ids */
+  inline bool IsUnique() const { return unique_; }
+
+  /**
+   * Insert the entries produced by next, used to build an index over existing rows.
+   * @param next fills in the next key and row id and returns true, or returns false at the end
+   */
+  virtual dberr_t BulkLoad(const std::function<bool(Row &key, RowId &row_id)> &next, Txn *txn) {
+    Row key;
+    RowId row_id;
+    while (next(key, row_id)) {
+      dberr_t result = InsertEntry(key, row_id, txn);
+      if (result != DB_SUCCESS) {
+        return result;
+      }
+    }
+    return DB_SUCCESS;
+  }
+
  protected:
   index_id_t index_id_;
   IndexSchema *key_schema_;
+  bool unique_;
 };
 
 #endif  // MINISQL_INDEX_H
@@ -1,8 +1,16 @@
 #ifndef MINISQL_INDEX_ITERATOR_H
 #define MINISQL_INDEX_ITERATOR_H
 
+#include <vector>
+
 #include "page/b_plus_tree_leaf_page.h"
 
+/**
+ * Iterator over the leaves of a B+ tree. The leaf the iterator is positioned on stays pinned and read latched, and
+ * the iterator moves to the next leaf by latching it before letting go of the current one. Writers therefore never
+ * change the entries an iterator is looking at, but the iterator must not outlive a modification of the same tree by
+ * its own thread.
+ */
 class IndexIterator {
   using LeafPage = BPlusTreeLeafPage;
 
@@ -10,11 +18,22 @@ class IndexIterator {
   // you may define your own constructor based on your member variables
   explicit IndexIterator();
 
-  explicit IndexIterator(page_id_t page_id, BufferPoolManager *bpm, int index = 0);
+  /**
+   * @param page leaf to start from, pinned and read latched, the iterator takes over both
+   */
+  explicit IndexIterator(Page *page, BufferPoolManager *bpm, int index = 0);
+
+  IndexIterator(IndexIterator &&other) noexcept;
+
+  IndexIterator &operator=(IndexIterator &&other) noexcept;
+
+  IndexIterator(const IndexIterator &other) = delete;
+
+  IndexIterator &operator=(const IndexIterator &other) = delete;
 
   ~IndexIterator();
 
-  /** Return the key/value pair this iterator is currently pointing at. */
+  /** Return the key/value pair this iterator is currently pointing at, the key stays valid until the next call. */
   std::pair<GenericKey *, RowId> operator*();
 
   /** Move to the next key/value pair.*/
@@ -26,12 +45,35 @@ class IndexIterator {
   /** Return whether two iterators are not equal. */
   bool operator!=(const IndexIterator &itr) const;
 
+  /**
+   * End the iteration at the first key past key, so that the iterator equals the end iterator from there on.
+   * @param compare_size number of leading key bytes compared with key
+   * @param inclusive whether keys equal to key are still iterated
+   */
+  void SetUpperBound(const GenericKey *key, int compare_size, bool inclusive);
+
+ private:
+  /**
+   * Skip to the following leaves until item_index is within a leaf, or the end is reached.
+   */
+  void SkipExhaustedLeaves();
+
+  /**
+   * Move to the end if the current key is past the upper bound.
+   */
+  void CheckUpperBound();
+
+  void Release();
+
  private:
   page_id_t current_page_id{INVALID_PAGE_ID};
+  Page *raw_page{nullptr};
   LeafPage *page{nullptr};
   int item_index{0};
   BufferPoolManager *buffer_pool_manager{nullptr};
-  // add your own private member variables here
+  std::vector<char> key_buffer;   // the current key, pages keep keys compressed
+  std::vector<char> upper_bound;  // empty if the iteration is not bounded
+  bool upper_inclusive{true};
 };
 
 #endif  // MINISQL_INDEX_ITERATOR_H
@@ -4,23 +4,25 @@
 #include <string.h>
 
 #include <queue>
+#include <vector>
 
 #include "index/generic_key.h"
 #include "page/b_plus_tree_page.h"
 
-#define INTERNAL_PAGE_HEADER_SIZE 28
+#define INTERNAL_PAGE_HEADER_SIZE 36
+#define INTERNAL_PAGE_SLOT_SIZE (BPLUS_TREE_SLOT_KEY_SIZE + sizeof(page_id_t))
 /**
  * Store n indexed keys and n+1 child pointers (page_id) within internal page.
  * Pointer PAGE_ID(i) points to a subtree in which all keys K satisfy:
  * K(i) <= K < K(i+1).
  * NOTE: since the number of keys does not equal to number of child pointers,
  * the first key always remains invalid. That is to say, any search/lookup
- * should ignore the first key.
+ * should ignore the first key. It is not stored and takes no part in the prefix.
  *
- * Internal page format (keys are stored in increasing order):
- *  --------------------------------------------------------------------------
- * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
- *  --------------------------------------------------------------------------
+ * Internal page format (keys are stored in increasing order, see b_plus_tree_page.h for the slotted data area):
+ *  ------------------------------------------------------------------------------------------------------
+ * | HEADER | OFFSET(1) + LENGTH(1) + PAGE_ID(1) | ... | OFFSET(n) + LENGTH(n) + PAGE_ID(n) | ... | KEYS |
+ *  ------------------------------------------------------------------------------------------------------
  */
 class BPlusTreeInternalPage : public BPlusTreePage {
  public:
@@ -28,48 +30,45 @@ class BPlusTreeInternalPage : public BPlusTreePage {
   void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int key_size = UNDEFINED_SIZE,
             int max_size = UNDEFINED_SIZE);
 
-  GenericKey *KeyAt(int index);
-
-  void SetKeyAt(int index, GenericKey *key);
-
   int ValueIndex(const page_id_t &value) const;
 
   page_id_t ValueAt(int index) const;
 
   void SetValueAt(int index, page_id_t value);
 
-  void *PairPtrAt(int index);
-
-  void PairCopy(void *dest, void *src, int pair_num = 1);
-
   page_id_t Lookup(const GenericKey *key, const KeyManager &KP);
 
   void PopulateNewRoot(const page_id_t &old_value, GenericKey *new_key, const page_id_t &new_value);
 
+  // whether a child can be added with new_key without splitting the page
+  bool HasRoomFor(const GenericKey *new_key) const;
+
+  // bytes of the data area a new child with any key may need at most
+  int MaxInsertSpace() const;
+
   int InsertNodeAfter(const page_id_t &old_value, GenericKey *new_key, const page_id_t &new_value);
 
+  // whether the key of an entry can be replaced by new_key without running out of space
+  bool CanReplaceKeyAt(int index, const GenericKey *new_key) const;
+
+  void SetKeyAt(int index, const GenericKey *new_key);
+
   void Remove(int index);
 
   page_id_t RemoveAndReturnOnlyChild();
 
   // Split and Merge utility methods
-  void MoveAllTo(BPlusTreeInternalPage *recipient, GenericKey *middle_key, BufferPoolManager *buffer_pool_manager);
-
-  void MoveHalfTo(BPlusTreeInternalPage *recipient, BufferPoolManager *buffer_pool_manager);
+  void CopyOut(int begin, int end, std::vector<char> &keys, std::vector<page_id_t> &values) const;
 
-  void MoveFirstToEndOf(BPlusTreeInternalPage *recipient, GenericKey *middle_key,
-                        BufferPoolManager *buffer_pool_manager);
+  /**
+   * Replace the children of the page, they must fit. The first key is ignored.
+   * Children that were not children of the page before are adopted through buffer_pool_manager.
+   */
+  void Rebuild(const char *keys, const page_id_t *values, int count, BufferPoolManager *buffer_pool_manager);
 
-  void MoveLastToFrontOf(BPlusTreeInternalPage *recipient, GenericKey *middle_key,
-                         BufferPoolManager *buffer_pool_manager);
+  static int RequiredSpace(const char *keys, int count, int key_size);
 
  private:
-  void CopyNFrom(void *src, int size, BufferPoolManager *buffer_pool_manager);
-
-  void CopyLastFrom(GenericKey *key, page_id_t value, BufferPoolManager *buffer_pool_manager);
-
-  void CopyFirstFrom(page_id_t value, BufferPoolManager *buffer_pool_manager);
-
   char data_[PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE];
 };
 
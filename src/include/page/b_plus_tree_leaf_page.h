@@ -8,18 +8,15 @@
  * see include/common/rid.h for detailed implementation) together within leaf
  * page. Only support unique key.
 
- * Leaf page format (keys are stored in order):
- *  ----------------------------------------------------------------------
- * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
- *  ----------------------------------------------------------------------
+ * Leaf page format (keys are stored in order, see b_plus_tree_page.h for the slotted data area):
+ *  ----------------------------------------------------------------------------------------------
+ * | HEADER | OFFSET(1) + LENGTH(1) + RID(1) | ... | OFFSET(n) + LENGTH(n) + RID(n) | ... | KEYS |
+ *  ----------------------------------------------------------------------------------------------
  *
- *  Header format (size in byte, 24 bytes in total):
+ *  Header format (size in byte, 40 bytes in total):
  *  ---------------------------------------------------------------------
- * | PageType (4) | CurrentSize (4) | MaxSize (4) | ParentPageId (4) |
+ * | BPlusTreePage header (36) | NextPageId (4)
  *  ---------------------------------------------------------------------
- *  ------------------------------
- * | PageId (4) | NextPageId (4)
- *  ------------------------------
  */
 #include <utility>
 #include <vector>
@@ -27,7 +24,8 @@
 #include "index/generic_key.h"
 #include "page/b_plus_tree_page.h"
 
-#define LEAF_PAGE_HEADER_SIZE 32
+#define LEAF_PAGE_HEADER_SIZE 40
+#define LEAF_PAGE_SLOT_SIZE (BPLUS_TREE_SLOT_KEY_SIZE + sizeof(RowId))
 
 class BPlusTreeLeafPage : public BPlusTreePage {
  public:
@@ -41,21 +39,14 @@ class BPlusTreeLeafPage : public BPlusTreePage {
 
   void SetNextPageId(page_id_t next_page_id);
 
-  GenericKey *KeyAt(int index);
-
-  void SetKeyAt(int index, GenericKey *key);
-
   RowId ValueAt(int index) const;
 
   void SetValueAt(int index, RowId value);
 
   int KeyIndex(const GenericKey *key, const KeyManager &comparator);
 
-  void *PairPtrAt(int index);
-
-  void PairCopy(void *dest, void *src, int pair_num = 1);
-
-  std::pair<GenericKey *, RowId> GetItem(int index);
+  // whether key can be inserted without splitting the page
+  bool HasRoomFor(const GenericKey *key) const;
 
   // insert and delete methods
   int Insert(GenericKey *key, const RowId &value, const KeyManager &comparator);
@@ -65,21 +56,14 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   int RemoveAndDeleteRecord(const GenericKey *key, const KeyManager &comparator);
 
   // Split and Merge utility methods
-  void MoveHalfTo(BPlusTreeLeafPage *recipient);
+  void CopyOut(int begin, int end, std::vector<char> &keys, std::vector<RowId> &values) const;
 
-  void MoveAllTo(BPlusTreeLeafPage *recipient);
+  // replace the pairs of the page, they must fit
+  void Rebuild(const char *keys, const RowId *values, int count);
 
-  void MoveFirstToEndOf(BPlusTreeLeafPage *recipient);
-
-  void MoveLastToFrontOf(BPlusTreeLeafPage *recipient);
+  static int RequiredSpace(const char *keys, int count, int key_size);
 
  private:
-  void CopyNFrom(void *src, int size);
-
-  void CopyLastFrom(GenericKey *key, const RowId value);
-
-  void CopyFirstFrom(GenericKey *key, const RowId value);
-
   page_id_t next_page_id_{INVALID_PAGE_ID};
 
   char data_[PAGE_SIZE - LEAF_PAGE_HEADER_SIZE];
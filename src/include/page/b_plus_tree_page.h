@@ -7,23 +7,37 @@
 #include <string>
 
 #include "buffer/buffer_pool_manager.h"
+#include "index/generic_key.h"
 
 // define page type enum
 enum class IndexPageType { INVALID_INDEX_PAGE = 0, LEAF_PAGE, INTERNAL_PAGE };
 
 #define UNDEFINED_SIZE 0
+#define BPLUS_TREE_SLOT_KEY_SIZE 4  // offset and length of the key bytes of an entry, or the key bytes themselves
+
 /**
  * Both internal and leaf page are inherited from this page.
  *
  * It actually serves as a header part for each B+ tree page and
  * contains information shared by both leaf page and internal page.
  *
- * Header format (size in byte, 28 bytes in total):
+ * Header format (size in byte, 36 bytes in total):
  * ----------------------------------------------------------------------------
  * | PageType (4) | KeySize (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
  * ----------------------------------------------------------------------------
- * | ParentPageId (4) | PageId(4) |
+ * | ParentPageId (4) | PageId(4) | PrefixSize (2) | HeapBegin (2) | GarbageSize (2) | InlineKeys (2) |
  * ----------------------------------------------------------------------------
+ *
+ * The data area after the header of both page types is slotted, so that keys take only as many bytes as they need:
+ *  ------------------------------------------------------------------------------------------
+ * | SLOT(0) | SLOT(1) | ... | SLOT(n-1) | free space | key bytes of the entries | PREFIX |
+ *  ------------------------------------------------------------------------------------------
+ * A slot holds the offset and length of the key bytes of its entry (2 bytes each) and the value. The bytes all keys
+ * of the page start with are kept once at the end of the data area, an entry stores what follows them up to its last
+ * non zero byte: keys are zero padded to the key size. Key bytes grow down from the prefix, and the bytes of removed
+ * entries stay garbage until the page is compacted.
+ * If no entry stores more than 4 bytes, as with int and float keys, the page has inline keys: the slots hold the key
+ * bytes, zero padded, in place of their offset and length. Searches compare them as big endian integers then.
  */
 class BPlusTreePage {
  public:
@@ -59,6 +73,109 @@ class BPlusTreePage {
 
   void SetLSN(lsn_t lsn = INVALID_LSN);
 
+  // size of the data area after the header
+  int GetDataSize() const;
+
+  // bytes all keys of the page start with, stored once
+  int GetPrefixSize() const;
+
+  // bytes of the data area in use, not counting garbage
+  int GetUsedSpace() const;
+
+  int GetFreeSpace() const;
+
+  /**
+   * Whether the page is less than half full both by entries and by space, so that it should be merged with a sibling.
+   * @param removed_index entry to leave out, if not negative
+   */
+  bool IsUnderflow(int removed_index = -1) const;
+
+  // copy the key of an entry, zero padded to the key size
+  void CopyKeyAt(int index, GenericKey *key) const;
+
+  /**
+   * Compare the key of an entry with key, looking at the first compare_size bytes only.
+   * @return less than, equal to or greater than zero if the entry is less than, equal to or greater than key
+   */
+  int CompareKeyAt(int index, const GenericKey *key, int compare_size) const;
+
+  // number of bytes left once the trailing zeros of key are cut
+  static int StrippedSize(const char *key, int size);
+
+  // number of leading bytes two keys have in common
+  static int CommonPrefixSize(const char *lhs, const char *rhs, int size);
+
+  /**
+   * Bytes of the data area a page needs for entries with the given keys in ascending order.
+   * @param first_key_stored false for internal pages, whose first key is not stored
+   */
+  static int RequiredSpace(const char *keys, int count, int key_size, int slot_size, bool first_key_stored);
+
+  /**
+   * Bytes of the data area besides the slots that count stored keys take.
+   * @param stripped_size sum of the sizes of the keys without trailing zeros
+   * @param max_stripped_size size of the longest key without trailing zeros
+   */
+  static int KeySpace(int count, int prefix_size, int stripped_size, int max_stripped_size);
+
+ protected:
+  void InitKeyStorage();
+
+  int GetHeaderSize() const;
+
+  int GetSlotSize() const;
+
+  bool HasInlineKeys() const;
+
+  char *SlotAt(int index);
+
+  const char *SlotAt(int index) const;
+
+  // key bytes stored by an entry after the prefix, clamped to the data area for readers without a latch
+  const char *KeySuffixAt(int index, int *length) const;
+
+  // bytes of the data area the key of an entry takes besides its slot
+  int StoredSizeAt(int index) const;
+
+  // the first bytes of a key suffix as a big endian integer, as inline keys are compared
+  static uint32_t InlineKeyOf(const char *suffix, int suffix_size);
+
+  // first entry in [begin, end) whose inline key is not less than key, the page must have inline keys
+  int LowerBoundInline(uint64_t key, int begin, int end) const;
+
+  /**
+   * Compare an entry with a key whose prefix is known to match the page prefix.
+   * @param suffix bytes of the key after the page prefix, cut after its last non zero byte
+   */
+  int CompareSuffixAt(int index, const char *suffix, int suffix_size) const;
+
+  // bytes of the data area inserting key takes, or replacing the key of an entry with it
+  int InsertSpace(const GenericKey *key) const;
+
+  int ReplaceSpace(int index, const GenericKey *key) const;
+
+  /**
+   * Bytes besides the slots the stored keys of a page with inline keys take at most once it is rebuilt with a new key.
+   * @param stripped size of the new key without trailing zeros
+   * @param prefix_size prefix the page keeps at least
+   * @param replaced_index entry the new key replaces, or a negative number if it is added
+   */
+  int InlineRebuildSpace(int stripped, int prefix_size, int replaced_index) const;
+
+  // insert an entry before index, the page must have room for it
+  void InsertAt(int index, const GenericKey *key, const char *value);
+
+  void RemoveAt(int index);
+
+  // replace the key of an entry, the page must have room for it
+  void ReplaceKeyAt(int index, const GenericKey *key);
+
+  // copy the full keys and the values of the entries [begin, end)
+  void CopyEntries(int begin, int end, char *keys, char *values) const;
+
+  // replace all entries of the page, they must fit
+  void Rebuild(const char *keys, const char *values, int count);
+
  private:
   // member variable, attributes that both internal and leaf page share
   [[maybe_unused]] IndexPageType page_type_;
@@ -68,6 +185,10 @@ class BPlusTreePage {
   [[maybe_unused]] int max_size_;
   [[maybe_unused]] page_id_t parent_page_id_;
   [[maybe_unused]] page_id_t page_id_;
+  uint16_t prefix_size_;
+  uint16_t heap_begin_;  // offset of the lowest key byte in the data area
+  uint16_t garbage_size_;
+  uint16_t inline_keys_;  // whether the key bytes are kept in the slots
 };
 
 #endif  // MINISQL_B_PLUS_TREE_PAGE_H
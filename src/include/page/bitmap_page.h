@@ -15,16 +15,30 @@ class BitmapPage {
   static constexpr size_t GetMaxSupportedSize() { return 8 * MAX_CHARS; }
 
   /**
+   * Allocate the first free page at or after the next-fit hint, wrapping around to the start of the extent.
    * @param page_offset Index in extent of the page allocated.
    * @return true if successfully allocate a page.
    */
   bool AllocatePage(uint32_t &page_offset);
 
+  /**
+   * Allocate run_size consecutive pages aligned to run_size, which must be a power of two no larger than 64.
+   * @param page_offset Index in extent of the first page of the run.
+   * @return true if a free run was found.
+   */
+  bool AllocateRun(uint32_t run_size, uint32_t &page_offset);
+
   /**
    * @return true if successfully de-allocate a page.
    */
   bool DeAllocatePage(uint32_t page_offset);
 
+  /**
+   * De-allocate count pages starting at page_offset.
+   * @return false if any of them is out of the extent or already free, nothing is changed then.
+   */
+  bool DeAllocateRun(uint32_t page_offset, uint32_t count);
+
   /**
    * @return whether a page in the extent is free
    */
@@ -42,6 +56,10 @@ class BitmapPage {
 
   /** Note: need to update if modify page structure. */
   static constexpr size_t MAX_CHARS = PageSize - 2 * sizeof(uint32_t);
+  /** AllocatePage scans the bitmap a 64-bit word at a time. */
+  static constexpr size_t MAX_WORDS = MAX_CHARS / sizeof(uint64_t);
+  static_assert(MAX_CHARS % sizeof(uint64_t) == 0, "Bitmap must consist of whole 64-bit words.");
+  static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "Word scan assumes little endian byte order.");
 
  private:
   /** The space occupied by all members of the class should be equal to the PageSize */
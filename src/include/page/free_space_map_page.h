@@ -0,0 +1,64 @@
+#ifndef MINISQL_FREE_SPACE_MAP_PAGE_H
+#define MINISQL_FREE_SPACE_MAP_PAGE_H
+
+#include <cstdint>
+
+#include "common/config.h"
+
+/**
+ * One page of a table heap's free space map. Each entry records a table page id together with a coarse
+ * free space category of that page (free bytes / FREE_SPACE_STEP, rounded down). Entries are appended in
+ * the same order as the pages of the heap chain, and map pages are chained through NextPageId.
+ *
+ * Format (size in byte):
+ *  ---------------------------------------------------------------------------------------------------------
+ * | NextPageId (4) | EntryCount (4) | PageId_1 (4) | ... | PageId_n (4) | Category_1 (1) | ... | Category_n (1) |
+ *  ---------------------------------------------------------------------------------------------------------
+ */
+class FreeSpaceMapPage {
+ public:
+  static constexpr uint32_t MAX_ENTRY_COUNT = (PAGE_SIZE - 8) / (sizeof(page_id_t) + sizeof(uint8_t));
+  static constexpr uint32_t FREE_SPACE_STEP = PAGE_SIZE / 256;
+
+  void Init() {
+    next_page_id_ = INVALID_PAGE_ID;
+    entry_count_ = 0;
+  }
+
+  /**
+   * @return Largest category whose free space is guaranteed to be available, i.e. free_bytes rounded down.
+   */
+  static uint8_t ToCategory(uint32_t free_bytes);
+
+  /**
+   * @return Smallest category that can hold required_bytes, i.e. required_bytes rounded up.
+   */
+  static uint8_t ToRequiredCategory(uint32_t required_bytes);
+
+  /**
+   * @return false if the page is full
+   */
+  bool Append(page_id_t table_page_id, uint8_t category);
+
+  inline page_id_t GetNextPageId() const { return next_page_id_; }
+
+  inline void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  inline uint32_t GetEntryCount() const { return entry_count_; }
+
+  inline page_id_t GetTablePageId(uint32_t slot) const { return page_ids_[slot]; }
+
+  inline uint8_t GetCategory(uint32_t slot) const { return categories_[slot]; }
+
+  inline void SetCategory(uint32_t slot, uint8_t category) { categories_[slot] = category; }
+
+ private:
+  page_id_t next_page_id_;
+  uint32_t entry_count_;
+  page_id_t page_ids_[MAX_ENTRY_COUNT];
+  uint8_t categories_[MAX_ENTRY_COUNT];
+};
+
+static_assert(sizeof(FreeSpaceMapPage) <= PAGE_SIZE, "Free space map page exceeds page size.");
+
+#endif  // MINISQL_FREE_SPACE_MAP_PAGE_H
@@ -0,0 +1,61 @@
+#ifndef MINISQL_HASH_TABLE_BUCKET_PAGE_H
+#define MINISQL_HASH_TABLE_BUCKET_PAGE_H
+
+#include "common/config.h"
+#include "common/rowid.h"
+#include "index/generic_key.h"
+
+#define HASH_TABLE_BUCKET_PAGE_HEADER_SIZE 16
+
+/**
+ * Bucket of an extendible hash table, storing key and row id pairs in no particular order. A bucket whose keys
+ * cannot be told apart by splitting it continues in overflow pages of the same format, linked by NextPageId.
+ *
+ * Bucket page format:
+ *  ----------------------------------------------------------------------------------------------------
+ * | PageId (4) | KeySize (4) | CurrentSize (4) | NextPageId (4) | KEY(1) + RID(1) | ... | KEY(n) + RID(n) |
+ *  ----------------------------------------------------------------------------------------------------
+ */
+class HashTableBucketPage {
+ public:
+  // After creating a new bucket page from buffer pool, must call initialize method to set default values
+  void Init(page_id_t page_id, int key_size);
+
+  page_id_t GetPageId() const { return page_id_; }
+
+  int GetSize() const { return size_; }
+
+  /** @return the number of pairs that fit into a page */
+  int GetMaxSize() const { return (PAGE_SIZE - HASH_TABLE_BUCKET_PAGE_HEADER_SIZE) / (key_size_ + sizeof(RowId)); }
+
+  bool IsFull() const { return size_ >= GetMaxSize(); }
+
+  page_id_t GetNextPageId() const { return next_page_id_; }
+
+  void SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
+
+  GenericKey *KeyAt(int index);
+
+  RowId ValueAt(int index) const;
+
+  /**
+   * Add a pair at the end, the page must not be full.
+   */
+  void Append(const GenericKey *key, const RowId &value);
+
+  /**
+   * Overwrite a pair with the last pair of another page of the bucket, and drop that one.
+   */
+  void ReplaceWithLastOf(int index, HashTableBucketPage *last);
+
+  void Clear() { size_ = 0; }
+
+ private:
+  page_id_t page_id_;
+  int key_size_;
+  int size_;
+  page_id_t next_page_id_;
+  char data_[PAGE_SIZE - HASH_TABLE_BUCKET_PAGE_HEADER_SIZE];
+};
+
+#endif  // MINISQL_HASH_TABLE_BUCKET_PAGE_H
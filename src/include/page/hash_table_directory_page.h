@@ -0,0 +1,71 @@
+#ifndef MINISQL_HASH_TABLE_DIRECTORY_PAGE_H
+#define MINISQL_HASH_TABLE_DIRECTORY_PAGE_H
+
+#include <cstdint>
+
+#include "common/config.h"
+
+#define HASH_TABLE_DIRECTORY_MAX_DEPTH 9
+#define HASH_TABLE_DIRECTORY_ARRAY_SIZE (1 << HASH_TABLE_DIRECTORY_MAX_DEPTH)
+
+/**
+ * Directory of an extendible hash table. Slot i holds the bucket of the keys whose hash ends in the global depth
+ * lowest bits of i. A bucket with local depth d is shared by the slots that agree on their d lowest bits.
+ *
+ * Directory page format:
+ *  ---------------------------------------------------------------------------------------------
+ * | PageId (4) | GlobalDepth (4) | LocalDepth (1) x 512 | BucketPageId (4) x 512 |
+ *  ---------------------------------------------------------------------------------------------
+ */
+class HashTableDirectoryPage {
+ public:
+  // After creating a new directory page from buffer pool, must call initialize method to set default values
+  void Init(page_id_t page_id, page_id_t bucket_page_id);
+
+  page_id_t GetPageId() const { return page_id_; }
+
+  uint32_t GetGlobalDepth() const { return global_depth_; }
+
+  /** @return the mask of the global depth lowest bits of a hash */
+  uint32_t GetGlobalDepthMask() const { return (1u << global_depth_) - 1; }
+
+  /** @return the number of slots in use */
+  uint32_t Size() const { return 1u << global_depth_; }
+
+  uint32_t HashToSlot(uint32_t hash) const { return hash & GetGlobalDepthMask(); }
+
+  page_id_t GetBucketPageId(uint32_t slot) const { return bucket_page_ids_[slot]; }
+
+  void SetBucketPageId(uint32_t slot, page_id_t bucket_page_id) { bucket_page_ids_[slot] = bucket_page_id; }
+
+  uint32_t GetLocalDepth(uint32_t slot) const { return local_depths_[slot]; }
+
+  void SetLocalDepth(uint32_t slot, uint32_t local_depth) { local_depths_[slot] = static_cast<uint8_t>(local_depth); }
+
+  /**
+   * @return the slot of the bucket a bucket was split from or into, the one differing in the highest local depth bit
+   */
+  uint32_t GetSplitImageSlot(uint32_t slot) const;
+
+  /**
+   * Double the directory, the new slots share the buckets of the slots they mirror.
+   * @return false if the directory is at its maximum depth
+   */
+  bool IncrGlobalDepth();
+
+  /**
+   * Halve the directory if no bucket needs the highest bit of the global depth.
+   * @return whether the directory was halved
+   */
+  bool TryDecrGlobalDepth();
+
+ private:
+  page_id_t page_id_;
+  uint32_t global_depth_;
+  uint8_t local_depths_[HASH_TABLE_DIRECTORY_ARRAY_SIZE];
+  page_id_t bucket_page_ids_[HASH_TABLE_DIRECTORY_ARRAY_SIZE];
+};
+
+static_assert(sizeof(HashTableDirectoryPage) <= PAGE_SIZE, "Hash table directory does not fit into a page.");
+
+#endif  // MINISQL_HASH_TABLE_DIRECTORY_PAGE_H
@@ -1,6 +1,7 @@
 #ifndef MINISQL_PAGE_H
 #define MINISQL_PAGE_H
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
 #include <shared_mutex>
@@ -16,6 +17,7 @@
 class Page {
   // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
   friend class BufferPoolManager;
+  friend class BufferPoolManagerInstance;
 
  public:
   DISALLOW_COPY(Page)
@@ -39,10 +41,25 @@ class Page {
   inline bool IsDirty() { return is_dirty_; }
 
   /** Acquire the page write latch. */
-  inline void WLatch() { rwlatch_.WLock(); }
+  inline void WLatch() {
+    rwlatch_.WLock();
+    BeginWrite();
+  }
+
+  /** Acquire the page write latch if it is free. @return whether the latch was acquired */
+  inline bool TryWLatch() {
+    if (!rwlatch_.TryWLock()) {
+      return false;
+    }
+    BeginWrite();
+    return true;
+  }
 
   /** Release the page write latch. */
-  inline void WUnlatch() { rwlatch_.WUnlock(); }
+  inline void WUnlatch() {
+    version_.fetch_add(1, std::memory_order_release);
+    rwlatch_.WUnlock();
+  }
 
   /** Acquire the page read latch. */
   inline void RLatch() { rwlatch_.RLock(); }
@@ -50,6 +67,22 @@ class Page {
   /** Release the page read latch. */
   inline void RUnlatch() { rwlatch_.RUnlock(); }
 
+  /**
+   * @return the version of the frame, to read the page without a latch. The version is odd while the page is write
+   * latched and grows every time the write latch is taken or released. The frame must stay pinned.
+   */
+  inline uint64_t GetVersion() const { return version_.load(std::memory_order_acquire); }
+
+  /** @return whether the page is write latched at the given version */
+  static inline bool IsWriteLatched(uint64_t version) { return (version & 1) != 0; }
+
+  /** @return whether nobody has write latched the page since GetVersion returned version */
+  inline bool ValidateVersion(uint64_t version) const {
+    // Keep the reads of the page data from moving below the version check.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return version_.load(std::memory_order_relaxed) == version;
+  }
+
   /** @return the page LSN. */
   inline lsn_t GetLSN() { return *reinterpret_cast<lsn_t *>(GetData() + OFFSET_LSN); }
 
@@ -65,6 +98,12 @@ class Page {
   static constexpr size_t OFFSET_LSN = 4;
 
  private:
+  inline void BeginWrite() {
+    version_.fetch_add(1, std::memory_order_relaxed);
+    // Keep the writes of the page data from moving above the version change.
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
   /** Zeroes out the data that is held within the page. */
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }
 
@@ -78,6 +117,8 @@ class Page {
   bool is_dirty_ = false;
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
+  /** Version of the frame for optimistic readers, never reset so that a reused frame cannot repeat a version. */
+  std::atomic<uint64_t> version_{0};
 };
 
 #endif  // MINISQL_PAGE_H
@@ -8,6 +8,7 @@
 #include <utility>
 
 #include "abstract_expression.h"
+#include "record/field_compare.h"
 #include "record/schema.h"
 
 /**
@@ -16,9 +17,27 @@
 class ComparisonExpression : public AbstractExpression {
  public:
   /** Creates a new comparison expression representing (left comp_type right). */
-  ComparisonExpression(AbstractExpressionRef left, AbstractExpressionRef right, string comp_type)
+  ComparisonExpression(AbstractExpressionRef left, AbstractExpressionRef right, std::string comp_type)
       : AbstractExpression({std::move(left), std::move(right)}, TypeId::kTypeInt, ExpressionType::ComparisonExpression),
-        comp_type_{std::move(comp_type)} {}
+        comp_type_{std::move(comp_type)} {
+    // The kernel of the type of both sides is selected once instead of dispatching on the type and operator per row.
+    TypeId type = GetChildAt(0)->GetReturnType();
+    if (type != GetChildAt(1)->GetReturnType()) {
+      return;
+    }
+    if (comp_type_ == "=")
+      test_ = GetFieldTest(type, CompareOp::kEqual);
+    else if (comp_type_ == "<>")
+      test_ = GetFieldTest(type, CompareOp::kNotEqual);
+    else if (comp_type_ == "<")
+      test_ = GetFieldTest(type, CompareOp::kLessThan);
+    else if (comp_type_ == "<=")
+      test_ = GetFieldTest(type, CompareOp::kLessThanEquals);
+    else if (comp_type_ == ">")
+      test_ = GetFieldTest(type, CompareOp::kGreaterThan);
+    else if (comp_type_ == ">=")
+      test_ = GetFieldTest(type, CompareOp::kGreaterThanEquals);
+  }
 
   /** e.g. evaluate the result of id = 1 */
   Field Evaluate(const Row *row) const override {
@@ -37,6 +56,8 @@ class ComparisonExpression : public AbstractExpression {
 
  private:
   CmpBool PerformComparison(const Field &lhs, const Field &rhs) const {
+    if (test_ != nullptr)
+      return test_(lhs, rhs);
     if (comp_type_ == "=")
       return lhs.CompareEquals(rhs);
     else if (comp_type_ == "<>")
@@ -58,6 +79,7 @@ class ComparisonExpression : public AbstractExpression {
   }
 
   std::string comp_type_;
+  FieldTestFunc test_{nullptr};
 };
 
 #endif  // MINISQL_COMPARISON_EXPRESSION_H
@@ -0,0 +1,113 @@
+#ifndef MINISQL_PREDICATE_PROGRAM_H
+#define MINISQL_PREDICATE_PROGRAM_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "planner/expressions/abstract_expression.h"
+#include "record/field_compare.h"
+#include "record/row.h"
+#include "record/row_batch.h"
+
+/**
+ * A predicate compiled into a flat program for a register machine, so that scans do not walk the expression tree
+ * with virtual calls and string compares for every row.
+ *
+ * Every instruction writes one boolean register: a comparison of a column with a constant, with the column index,
+ * the operator and the type of the values resolved when compiling, or a conjunction or disjunction of two registers.
+ * Comparisons of constants are folded and so are the logic operations they decide, a comparison with null is false.
+ * The result is in register 0. Expressions of other shapes are kept as an instruction that evaluates their tree.
+ *
+ * A row passes the predicate iff the expression evaluates to true on it. Null comparisons never pass and only make a
+ * conjunction or disjunction pass if the other side decides it, so registers need not tell null from false.
+ */
+class PredicateProgram {
+ public:
+  explicit PredicateProgram(const AbstractExpressionRef &predicate);
+
+  /** @return whether the row passes the predicate */
+  bool Evaluate(const Row &row) const;
+
+  /**
+   * Narrow the selection of a batch to the rows that pass the predicate. Every instruction runs over all the selected
+   * rows at once, with its operator chosen once per batch.
+   * @param selection positions of rows of the batch in increasing order, the order is kept
+   */
+  void Filter(const RowBatch &batch, std::vector<uint32_t> *selection) const;
+
+  inline size_t GetInstructionCount() const { return instructions_.size(); }
+
+  inline uint32_t GetRegisterCount() const { return register_count_; }
+
+  /** @return the instructions one per line, for debugging */
+  std::string ToString() const;
+
+ private:
+  enum class Opcode : uint8_t {
+    kConst,      // dst = operand
+    kIsNull,     // dst = column is null
+    kIsNotNull,  // dst = column is not null
+    kCmpInt,     // dst = column cmp ints_[operand]
+    kCmpFloat,   // dst = column cmp floats_[operand]
+    kCmpChar,    // dst = column cmp chars_[operand]
+    kAnd,        // dst = lhs and rhs
+    kOr,         // dst = lhs or rhs
+    kEval,       // dst = expressions_[operand] evaluates to true
+  };
+
+  struct Instruction {
+    Opcode op_;
+    CompareOp cmp_{CompareOp::kEqual};
+    uint16_t dst_{0};
+    uint16_t lhs_{0};
+    uint16_t rhs_{0};
+    uint32_t column_{0};
+    uint32_t operand_{0};
+  };
+
+  /** Registers up to this count live on the stack when evaluating a row. */
+  static constexpr uint32_t kInlineRegisters = 16;
+
+  /** Marks a subexpression that was folded into a constant instead of a register. */
+  static constexpr int kFolded = -1;
+
+  /**
+   * Emit the instructions of an expression.
+   * @param[out] folded the value of the expression if it is constant
+   * @return the register holding the value, or kFolded
+   */
+  int Compile(const AbstractExpressionRef &expr, bool *folded);
+
+  int CompileLogic(const AbstractExpressionRef &expr, bool *folded);
+
+  int CompileComparison(const AbstractExpressionRef &expr, bool *folded);
+
+  /** Emit an instruction writing a new register. */
+  int Emit(Instruction instruction);
+
+  /** Emit an instruction that evaluates the tree of an expression row by row. */
+  int EmitEval(const AbstractExpressionRef &expr);
+
+  /** Run the program on a row with the given registers. */
+  bool Run(const Row &row, uint8_t *registers) const;
+
+  /** @return whether the field is not null and compares to the constant as cmp says */
+  template <TypeId kType>
+  static bool CompareField(CompareOp cmp, const Field &field, const typename FieldTraits<kType>::ValueType &constant);
+
+  /** dst[i] = the value of rows[i] is not null and compares to the constant as cmp says, for i < count. */
+  template <typename Value, typename T>
+  static void CompareColumn(CompareOp cmp, const uint8_t *nulls, const Value &value, const T &constant,
+                            const uint32_t *rows, size_t count, uint8_t *dst);
+
+  std::vector<Instruction> instructions_;
+  uint32_t next_register_{0};
+  uint32_t register_count_{0};
+  std::vector<int32_t> ints_;
+  std::vector<float> floats_;
+  std::vector<std::string> chars_;
+  std::vector<AbstractExpressionRef> expressions_;
+};
+
+#endif  // MINISQL_PREDICATE_PROGRAM_H
@@ -18,6 +18,11 @@ class Field {
 
   friend class TypeFloat;
 
+  friend class RowBatch;
+
+  template <TypeId kType>
+  friend struct FieldTraits;
+
  public:
   explicit Field(const TypeId type) : type_id_(type), len_(FIELD_NULL_LEN), is_null_(true) {}
 
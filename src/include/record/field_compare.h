@@ -0,0 +1,89 @@
+#ifndef MINISQL_FIELD_COMPARE_H
+#define MINISQL_FIELD_COMPARE_H
+
+#include <string_view>
+
+#include "record/field.h"
+
+/**
+ * Comparison kernels specialized per TypeId at compile time. Code that compares many fields of a column
+ * selects the kernel of its type once, e.g. with GetFieldComparator, and calls it directly instead of dispatching
+ * through the virtual methods of Type for every comparison.
+ */
+
+enum class CompareOp { kEqual, kNotEqual, kLessThan, kLessThanEquals, kGreaterThan, kGreaterThanEquals };
+
+/** The value of a non null field of a type, chars are viewed in place. */
+template <TypeId kType>
+struct FieldTraits;
+
+template <>
+struct FieldTraits<kTypeInt> {
+  using ValueType = int32_t;
+  static inline ValueType Get(const Field &field) { return field.value_.integer_; }
+};
+
+template <>
+struct FieldTraits<kTypeFloat> {
+  using ValueType = float;
+  static inline ValueType Get(const Field &field) { return field.value_.float_; }
+};
+
+template <>
+struct FieldTraits<kTypeChar> {
+  using ValueType = std::string_view;
+  static inline ValueType Get(const Field &field) { return ValueType(field.value_.chars_, field.len_); }
+};
+
+/** @return lhs op rhs, chars compare bytewise as unsigned with a proper prefix first, like Type does */
+template <CompareOp op, typename T>
+inline bool ApplyCompareOp(const T &lhs, const T &rhs) {
+  if constexpr (op == CompareOp::kEqual) {
+    return lhs == rhs;
+  } else if constexpr (op == CompareOp::kNotEqual) {
+    return lhs != rhs;
+  } else if constexpr (op == CompareOp::kLessThan) {
+    return lhs < rhs;
+  } else if constexpr (op == CompareOp::kLessThanEquals) {
+    return lhs <= rhs;
+  } else if constexpr (op == CompareOp::kGreaterThan) {
+    return lhs > rhs;
+  } else {
+    return lhs >= rhs;
+  }
+}
+
+template <TypeId kType>
+struct FieldComparator {
+  using Traits = FieldTraits<kType>;
+
+  /** @return lhs op rhs as Field::CompareXxx gives it, kNull if either side is null */
+  template <CompareOp op>
+  static CmpBool Test(const Field &lhs, const Field &rhs) {
+    if (lhs.IsNull() || rhs.IsNull()) {
+      return CmpBool::kNull;
+    }
+    return GetCmpBool(ApplyCompareOp<op>(Traits::Get(lhs), Traits::Get(rhs)));
+  }
+
+  /** @return the order of two fields, negative if lhs comes first, nulls come before any value */
+  static int Compare(const Field &lhs, const Field &rhs) {
+    if (lhs.IsNull() || rhs.IsNull()) {
+      return static_cast<int>(rhs.IsNull()) - static_cast<int>(lhs.IsNull());
+    }
+    auto l = Traits::Get(lhs);
+    auto r = Traits::Get(rhs);
+    return static_cast<int>(r < l) - static_cast<int>(l < r);
+  }
+};
+
+using FieldCompareFunc = int (*)(const Field &, const Field &);
+using FieldTestFunc = CmpBool (*)(const Field &, const Field &);
+
+/** @return FieldComparator<type>::Compare, nullptr for an invalid type */
+FieldCompareFunc GetFieldComparator(TypeId type);
+
+/** @return FieldComparator<type>::Test<op>, nullptr for an invalid type */
+FieldTestFunc GetFieldTest(TypeId type, CompareOp op);
+
+#endif  // MINISQL_FIELD_COMPARE_H
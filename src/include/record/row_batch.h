@@ -0,0 +1,111 @@
+#ifndef MINISQL_ROW_BATCH_H
+#define MINISQL_ROW_BATCH_H
+
+#include <vector>
+
+#include "common/config.h"
+#include "common/rowid.h"
+#include "record/row.h"
+#include "record/schema.h"
+
+/**
+ * A batch of rows stored column by column, which executors pass along instead of one row at a time.
+ *
+ * Every column keeps its values in a typed array: integers and floats inline, chars as offsets into a byte arena,
+ * next to a null flag per row. The selection vector lists the positions of the rows of the batch that are still
+ * part of the result in increasing order, filters narrow it instead of moving the values.
+ */
+class RowBatch {
+ public:
+  /**
+   * A batch without schema has no columns and only counts rows, as yielded by the executors that modify tables.
+   */
+  explicit RowBatch(const Schema *schema, uint32_t capacity = ROW_BATCH_SIZE);
+
+  /** Drop the rows of the batch, the memory of the columns is kept for the next rows. */
+  void Clear();
+
+  inline const Schema *GetSchema() const { return schema_; }
+
+  inline uint32_t GetColumnCount() const { return static_cast<uint32_t>(columns_.size()); }
+
+  inline uint32_t GetRowCount() const { return static_cast<uint32_t>(rids_.size()); }
+
+  inline uint32_t GetCapacity() const { return capacity_; }
+
+  inline bool IsFull() const { return rids_.size() >= capacity_; }
+
+  /** @return the positions of the selected rows, in increasing order */
+  inline std::vector<uint32_t> &GetSelection() { return selection_; }
+
+  inline const std::vector<uint32_t> &GetSelection() const { return selection_; }
+
+  inline RowId GetRowId(uint32_t row) const { return rids_[row]; }
+
+  inline TypeId GetColumnType(uint32_t column) const { return columns_[column].type_; }
+
+  inline bool IsNull(uint32_t column, uint32_t row) const { return columns_[column].nulls_[row] != 0; }
+
+  /** @return the null flags of a column, one byte per row */
+  inline const uint8_t *GetNulls(uint32_t column) const { return columns_[column].nulls_.data(); }
+
+  /** @return the values of an integer column, null rows hold 0 */
+  inline const int32_t *GetInts(uint32_t column) const { return columns_[column].ints_.data(); }
+
+  /** @return the values of a float column, null rows hold 0 */
+  inline const float *GetFloats(uint32_t column) const { return columns_[column].floats_.data(); }
+
+  inline const char *GetChars(uint32_t column, uint32_t row) const {
+    return columns_[column].chars_.data() + columns_[column].offsets_[row];
+  }
+
+  inline uint32_t GetCharLength(uint32_t column, uint32_t row) const { return columns_[column].lengths_[row]; }
+
+  /**
+   * Append a row and select it. A row without fields is appended as nulls.
+   */
+  void AppendRow(const Row &row);
+
+  /**
+   * Append a row from its serialized form and select it, see Row::SerializeTo.
+   * @return the number of bytes read
+   */
+  uint32_t AppendTuple(const char *buf, RowId rid);
+
+  /**
+   * Replace the rows of the batch by the selected rows of source, column i of the batch taken from column
+   * columns[i] of source.
+   */
+  void Project(const RowBatch &source, const std::vector<uint32_t> &columns);
+
+  /**
+   * Materialize a row of the batch into row, which is cleared first.
+   */
+  void GetRow(uint32_t row_index, Row *row) const;
+
+  /** @return the field of a row of the batch */
+  Field GetField(uint32_t column, uint32_t row) const;
+
+ private:
+  struct ColumnVector {
+    TypeId type_{kTypeInvalid};
+    std::vector<uint8_t> nulls_;
+    std::vector<int32_t> ints_;
+    std::vector<float> floats_;
+    std::vector<uint32_t> offsets_;  // chars of row i start at chars_[offsets_[i]]
+    std::vector<uint32_t> lengths_;
+    std::vector<char> chars_;
+  };
+
+  void AppendNull(ColumnVector &column);
+
+  void AppendChars(ColumnVector &column, const char *data, uint32_t len);
+
+  const Schema *schema_;
+  uint32_t capacity_;
+  std::vector<ColumnVector> columns_;
+  std::vector<RowId> rids_;
+  std::vector<uint32_t> selection_;
+};
+
+#endif  // MINISQL_ROW_BATCH_H
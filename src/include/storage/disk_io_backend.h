@@ -0,0 +1,94 @@
+#ifndef MINISQL_DISK_IO_BACKEND_H
+#define MINISQL_DISK_IO_BACKEND_H
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "common/config.h"
+
+enum class DiskIOBackendType { kPosix, kIOUring };
+
+/**
+ * One page read or write. The callback, if any, is invoked once the request has completed, with whether it
+ * succeeded. A read beyond the end of the file succeeds and fills the missing part with zeros.
+ */
+struct DiskIORequest {
+  bool is_write{false};
+  page_id_t page_id{INVALID_PAGE_ID};  // physical page id in the backend, logical page id in DiskManager::Submit
+  char *data{nullptr};
+  std::function<void(bool)> callback;
+};
+
+/**
+ * Pluggable page I/O of DiskManager. Backends use positional I/O only, so they can be called from several
+ * threads at once without a file cursor to protect.
+ */
+class DiskIOBackend {
+ public:
+  virtual ~DiskIOBackend() = default;
+
+  /**
+   * Issue a batch of requests and return once all of them have completed. Requests of a batch may complete in
+   * any order, and must not touch overlapping pages.
+   */
+  virtual void Submit(std::vector<DiskIORequest> &requests) = 0;
+
+  /**
+   * @return a backend of the given type on fd, falling back to the POSIX backend if io_uring is unavailable
+   */
+  static std::unique_ptr<DiskIOBackend> Create(DiskIOBackendType type, int fd);
+};
+
+/**
+ * pread/pwrite backend, requests of a batch are issued one after the other.
+ */
+class PosixIOBackend : public DiskIOBackend {
+ public:
+  explicit PosixIOBackend(int fd) : fd_(fd) {}
+
+  void Submit(std::vector<DiskIORequest> &requests) override;
+
+ private:
+  int fd_;
+};
+
+/**
+ * io_uring backend talking to the kernel through raw system calls. A batch goes out with a single io_uring_enter
+ * and its completions are reaped by the submitting thread. Every concurrent submitter takes a ring of its own
+ * from a pool, so that rings are never shared between threads.
+ */
+class IOUringBackend : public DiskIOBackend {
+ public:
+  /**
+   * @return nullptr if io_uring is not supported by the build or the kernel, which is probed for the read and write
+   * opcodes and with a test read of the first page of fd
+   */
+  static std::unique_ptr<IOUringBackend> Create(int fd);
+
+  ~IOUringBackend() override;
+
+  void Submit(std::vector<DiskIORequest> &requests) override;
+
+ private:
+  struct Ring;
+
+  explicit IOUringBackend(int fd) : fd_(fd), fallback_(fd) {}
+
+  /**
+   * @return a ring nobody else is using, nullptr if no new ring can be set up
+   */
+  Ring *AcquireRing();
+
+  void ReleaseRing(Ring *ring);
+
+ private:
+  int fd_;
+  PosixIOBackend fallback_;         // used when no ring can be set up
+  std::vector<Ring *> rings_;       // all rings, owned by the backend
+  std::vector<Ring *> free_rings_;  // rings not used by any submitter
+  std::mutex latch_;                // to protect rings_ and free_rings_
+};
+
+#endif  // MINISQL_DISK_IO_BACKEND_H
@@ -2,15 +2,17 @@
 #define DISK_MGR_H
 
 #include <atomic>
-#include <fstream>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include "common/config.h"
 #include "common/macros.h"
 #include "page/bitmap_page.h"
 #include "page/disk_file_meta_page.h"
+#include "storage/disk_io_backend.h"
 
 /**
  * DiskManager takes care of the allocation and de allocation of pages within a database. It performs the reading and
@@ -19,10 +21,14 @@
  * Disk page storage format: (Free Page BitMap Size = PAGE_SIZE * 8, we note it as N)
  * | Meta Page | Free Page BitMap 1 | Page 1 | Page 2 | ....
  *      | Page N | Free Page BitMap 2 | Page N+1 | ... | Page 2N | ... |
+ *
+ * Page I/O goes through a DiskIOBackend. Reads and writes of data pages are positional and take no latch, only
+ * the allocation state (meta page and bitmaps) is serialized. Bitmap pages are cached in memory and, like the meta
+ * page, written back on Close.
  */
 class DiskManager {
  public:
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, DiskIOBackendType backend_type = DiskIOBackendType::kPosix);
 
   ~DiskManager() {
     if (!closed) {
@@ -33,14 +39,22 @@ class DiskManager {
   /**
    * Read page from specific page_id
    * Note: page_id = 0 is reserved for free page bit map
+   * @return false if the read failed, the content of page_data is undefined then
    */
-  void ReadPage(page_id_t logical_page_id, char *page_data);
+  bool ReadPage(page_id_t logical_page_id, char *page_data);
 
   /**
    * Write data to specific page
    * Note: page_id = 0 is reserved for free page bit map
+   * @return false if the write failed
+   */
+  bool WritePage(page_id_t logical_page_id, const char *page_data);
+
+  /**
+   * Read and write a batch of pages, given by logical page id, and return once all of them have completed. The
+   * callback of every request is invoked as soon as the request completes.
    */
-  void WritePage(page_id_t logical_page_id, const char *page_data);
+  void Submit(std::vector<DiskIORequest> &requests);
 
   /**
    * Get next free page from disk
@@ -48,16 +62,32 @@ class DiskManager {
    */
   page_id_t AllocatePage();
 
+  /**
+   * Reserve run_size contiguous pages inside one extent, aligned to run_size (a power of two no larger than 64).
+   * @return logical page id of the first page of the run, INVALID_PAGE_ID if no extent has such a run free
+   */
+  page_id_t AllocateRun(uint32_t run_size);
+
   /**
    * Free this page and reset bit map
    */
   void DeAllocatePage(page_id_t logical_page_id);
 
+  /**
+   * Free count contiguous pages starting at first_page_id
+   */
+  void DeAllocateRun(page_id_t first_page_id, uint32_t count);
+
   /**
    * Return whether specific logical_page_id is free
    */
   bool IsPageFree(page_id_t logical_page_id);
 
+  /**
+   * Write back the bitmap pages modified since the last flush.
+   */
+  void FlushBitmaps();
+
   /**
    * Shut down the disk manager and close all the file resources.
    */
@@ -72,34 +102,56 @@ class DiskManager {
   static constexpr size_t BITMAP_SIZE = BitmapPage<PAGE_SIZE>::GetMaxSupportedSize();
 
  private:
-  /**
-   * Helper function to get disk file size
-   */
-  int GetFileSize(const std::string &file_name);
-
   /**
    * Read physical page from disk
+   * @return false if the read failed
    */
-  void ReadPhysicalPage(page_id_t physical_page_id, char *page_data);
+  bool ReadPhysicalPage(page_id_t physical_page_id, char *page_data);
 
   /**
    * Write data to physical page in disk
+   * @return false if the write failed
    */
-  void WritePhysicalPage(page_id_t physical_page_id, const char *page_data);
+  bool WritePhysicalPage(page_id_t physical_page_id, const char *page_data);
 
   /**
    * Map logical page id to physical page id
    */
   page_id_t MapPageId(page_id_t logical_page_id);
 
+  /**
+   * Allocate a single page (run_size 1) or an aligned run of pages.
+   */
+  page_id_t AllocatePages(uint32_t run_size);
+
+  static inline page_id_t GetBitmapPhysicalPageId(uint32_t extent_id) { return 1 + extent_id * (1 + BITMAP_SIZE); }
+
+  /**
+   * @return the cached bitmap of an extent, read from disk on first use
+   */
+  BitmapPage<PAGE_SIZE> *GetBitmap(uint32_t extent_id);
+
+  /**
+   * In-memory copy of a bitmap page, written back lazily.
+   */
+  struct CachedBitmap {
+    alignas(8) char data[PAGE_SIZE]{};
+    bool dirty{false};
+  };
+
  private:
-  // stream to write db file
-  std::fstream db_io_;
+  // db file and the backend doing its I/O
+  int db_fd_{-1};
+  std::unique_ptr<DiskIOBackend> io_backend_;
   std::string file_name_;
-  // with multiple buffer pool instances, need to protect file access
+  // protects the meta page and the bitmaps
   std::recursive_mutex db_io_latch_;
-  bool closed{false};
+  std::atomic<bool> closed{false};
   char meta_data_[PAGE_SIZE];
+  // bitmap page of every extent, loaded on first use
+  std::vector<std::unique_ptr<CachedBitmap>> bitmaps_;
+  // next fit over extents, allocation starts from the extent of the previous one
+  uint32_t next_extent_{0};
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,82 @@
+#ifndef MINISQL_FREE_SPACE_MAP_H
+#define MINISQL_FREE_SPACE_MAP_H
+
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "page/free_space_map_page.h"
+
+/**
+ * Free space map of a table heap.
+ *
+ * The map is persisted as a chain of FreeSpaceMapPage and mirrored in memory, so that looking up a page with
+ * enough room never touches the heap pages themselves. Every block of entries (one map page) also keeps an
+ * upper bound of its categories, which lets FindPage skip blocks that cannot satisfy a request.
+ */
+class FreeSpaceMap {
+ public:
+  /**
+   * @param page_run run the map pages are taken from, if any
+   */
+  explicit FreeSpaceMap(BufferPoolManager *buffer_pool_manager, PageRun *page_run = nullptr)
+      : buffer_pool_manager_(buffer_pool_manager), page_run_(page_run) {}
+
+  /**
+   * Allocate the first page of an empty map.
+   * @return false if no page can be allocated
+   */
+  bool Init();
+
+  /**
+   * Read an existing map starting from first_page_id into memory.
+   */
+  bool Load(page_id_t first_page_id);
+
+  /**
+   * Release all pages of the map.
+   */
+  void Destroy();
+
+  /**
+   * Record a newly appended table page, which becomes the last page of the heap.
+   */
+  bool AddPage(page_id_t table_page_id, uint32_t free_bytes);
+
+  /**
+   * Refresh the free space of a table page. The map page is only written if the category changes.
+   */
+  void UpdatePage(page_id_t table_page_id, uint32_t free_bytes);
+
+  /**
+   * @return whether the map guarantees that table_page_id has at least required_bytes free
+   */
+  bool HasSpace(page_id_t table_page_id, uint32_t required_bytes) const;
+
+  /**
+   * @return the first table page with at least required_bytes free, INVALID_PAGE_ID if there is none
+   */
+  page_id_t FindPage(uint32_t required_bytes);
+
+  inline page_id_t GetFirstPageId() const { return map_page_ids_.empty() ? INVALID_PAGE_ID : map_page_ids_.front(); }
+
+  inline page_id_t GetLastTablePageId() const {
+    return table_page_ids_.empty() ? INVALID_PAGE_ID : table_page_ids_.back();
+  }
+
+  /**
+   * @return all table pages of the heap, in chain order
+   */
+  inline const std::vector<page_id_t> &GetTablePageIds() const { return table_page_ids_; }
+
+ private:
+  BufferPoolManager *buffer_pool_manager_;
+  PageRun *page_run_;
+  std::vector<page_id_t> map_page_ids_;
+  std::vector<page_id_t> table_page_ids_;
+  std::vector<uint8_t> categories_;
+  std::vector<uint8_t> block_max_categories_;  // upper bound of categories in each map page
+  std::unordered_map<page_id_t, uint32_t> slots_;
+};
+
+#endif  // MINISQL_FREE_SPACE_MAP_H
@@ -0,0 +1,89 @@
+#ifndef MINISQL_READ_AHEAD_ENGINE_H
+#define MINISQL_READ_AHEAD_ENGINE_H
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+
+class ReadAheadEngine;
+
+/**
+ * Read-ahead state of one scan over a table. The stream knows the pages of the table in chain order, the scan
+ * reports every page it moves on to, and the engine keeps the following pages, up to the read-ahead distance, on
+ * their way into the buffer pool.
+ */
+class ReadAheadStream : public std::enable_shared_from_this<ReadAheadStream> {
+  friend class ReadAheadEngine;
+
+ public:
+  ReadAheadStream(ReadAheadEngine *engine, std::vector<page_id_t> page_ids, size_t distance,
+                  std::shared_ptr<BufferAccessStrategy> strategy)
+      : engine_(engine), page_ids_(std::move(page_ids)), distance_(distance), strategy_(std::move(strategy)) {}
+
+  /**
+   * Called by the scan when it moves on to a new page.
+   */
+  void Advance(page_id_t page_id);
+
+ private:
+  ReadAheadEngine *engine_;
+  const std::vector<page_id_t> page_ids_;           // pages of the table when the scan started, in chain order
+  const size_t distance_;                           // number of pages to read ahead of the scan
+  std::shared_ptr<BufferAccessStrategy> strategy_;  // the scan's ring, if any, prefetched pages go there too
+  // The following members are protected by the latch of the engine.
+  size_t prefetched_{0};  // position of the next page to prefetch in page_ids_
+  size_t consumed_{0};    // number of pages the scan has moved on to
+  bool queued_{false};    // whether the stream is waiting for the worker
+};
+
+/**
+ * Asynchronous read-ahead of table scans, shared by all tables of a buffer pool. A single worker thread, started on
+ * first use, serves the open streams round robin: whenever half the window of a stream has been consumed, the pages
+ * missing from its window are read as one batch through BufferPoolManager::PrefetchPages, which hands them to the
+ * disk manager at once. Every page is published in the pool as soon as its own read completes, so that the scan can
+ * go on while the rest of the batch is in flight.
+ */
+class ReadAheadEngine {
+  friend class ReadAheadStream;
+
+ public:
+  explicit ReadAheadEngine(BufferPoolManager *buffer_pool_manager) : buffer_pool_manager_(buffer_pool_manager) {}
+
+  ~ReadAheadEngine() { Stop(); }
+
+  /**
+   * @param page_ids pages of the table in chain order
+   * @param distance number of pages to read ahead of the scan
+   * @return a stream for a new scan, nullptr if read-ahead is disabled
+   */
+  std::shared_ptr<ReadAheadStream> OpenStream(std::vector<page_id_t> page_ids, size_t distance,
+                                              std::shared_ptr<BufferAccessStrategy> strategy = nullptr);
+
+  /**
+   * Stop the worker and drop all pending read-ahead. The worker is started again by the next stream that needs it.
+   */
+  void Stop();
+
+ private:
+  /**
+   * Queue the stream if half of its window is free and it is not queued yet. The latch must be held.
+   */
+  void Schedule(ReadAheadStream *stream);
+
+  void Run();
+
+ private:
+  BufferPoolManager *buffer_pool_manager_;
+  std::thread worker_;                                // prefetches pages of the queued streams
+  std::deque<std::weak_ptr<ReadAheadStream>> queue_;  // streams behind their distance
+  std::mutex latch_;                                  // to protect queue_, running_ and the streams
+  std::condition_variable cv_;                        // to wake up the worker
+  bool running_{false};
+};
+
+#endif  // MINISQL_READ_AHEAD_ENGINE_H
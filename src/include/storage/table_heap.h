@@ -1,11 +1,15 @@
 #ifndef MINISQL_TABLE_HEAP_H
 #define MINISQL_TABLE_HEAP_H
 
+#include <atomic>
+
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/lock_manager.h"
 #include "page/header_page.h"
 #include "page/table_page.h"
 #include "recovery/log_manager.h"
+#include "storage/free_space_map.h"
+#include "storage/read_ahead_engine.h"
 #include "storage/table_iterator.h"
 
 class TableHeap {
@@ -17,12 +21,18 @@ class TableHeap {
     return new TableHeap(buffer_pool_manager, schema, txn, log_manager, lock_manager);
   }
 
-  static TableHeap *Create(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id, Schema *schema,
-                           LogManager *log_manager, LockManager *lock_manager) {
-    return new TableHeap(buffer_pool_manager, first_page_id, schema, log_manager, lock_manager);
+  /**
+   * Load an existing table heap. If free_space_map_page_id is invalid, the free space map is rebuilt from the
+   * page chain.
+   */
+  static TableHeap *Create(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id,
+                           page_id_t free_space_map_page_id, Schema *schema, LogManager *log_manager,
+                           LockManager *lock_manager) {
+    return new TableHeap(buffer_pool_manager, first_page_id, free_space_map_page_id, schema, log_manager,
+                         lock_manager);
   }
 
-  ~TableHeap() {}
+  ~TableHeap() { buffer_pool_manager_->ReleasePageRun(&page_run_); }
 
   /**
    * Insert a tuple into the table. If the tuple is too large (>= page_size), return false.
@@ -71,25 +81,35 @@ class TableHeap {
    */
   bool GetTuple(Row *row, Txn *txn);
 
-  void FreeTableHeap() {
-    auto next_page_id = first_page_id_;
-    while (next_page_id != INVALID_PAGE_ID) {
-      auto old_page_id = next_page_id;
-      auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(old_page_id));
-      assert(page != nullptr);
-      next_page_id = page->GetNextPageId();
-      buffer_pool_manager_->UnpinPage(old_page_id, false);
-      buffer_pool_manager_->DeletePage(old_page_id);
-    }
-  }
+  /**
+   * Decode the tuple at rid straight into the columns of batch, which must be of the schema of the table.
+   * @return false if there is no tuple at rid
+   */
+  bool GetTuple(const RowId &rid, RowBatch *batch, Txn *txn);
+
+  /**
+   * Decode the tuples of a page from slot_num on straight into the columns of batch, see TablePage::GetTuples.
+   * Separate pages may be read by separate threads, each into its own batch.
+   * @param[out] next_rid the first tuple that did not fit, INVALID_ROWID if the page was read to the end
+   * @return false if the page can not be fetched
+   */
+  bool GetTuples(page_id_t page_id, uint32_t slot_num, RowBatch *batch, RowId *next_rid,
+                 BufferAccessStrategy *strategy = nullptr);
 
   /**
-   * Free table heap and release storage in disk file
+   * Free table heap and release storage in disk file. The pages are known from the free space map, so they are
+   * released run by run without being read.
+   */
+  void FreeTableHeap();
+
+  /**
+   * Free the page chain starting at page_id, or the whole table heap if page_id is INVALID_PAGE_ID
    */
   void DeleteTable(page_id_t page_id = INVALID_PAGE_ID);
 
   /**
-   * @return the begin iterator of this table
+   * @return the begin iterator of this table, which reads through a bulk read strategy if the table is large
+   * compared to the buffer pool
    */
   TableIterator Begin(Txn *txn);
 
@@ -103,55 +123,66 @@ class TableHeap {
    */
   inline page_id_t GetFirstPageId() const { return first_page_id_; }
 
- private:
   /**
-   * create table heap and initialize first page
+   * @return the id of the first page of the free space map of this table
    */
-  explicit TableHeap(BufferPoolManager *buffer_pool_manager, Schema *schema, Txn *txn, LogManager *log_manager,
-                      LockManager *lock_manager)
-       : buffer_pool_manager_(buffer_pool_manager),
-         schema_(schema),
-         log_manager_(log_manager),
-         lock_manager_(lock_manager),
-         first_page_id_(INVALID_PAGE_ID) {
-
-    // Allocate the first page for the table heap.
-    page_id_t first_page_id_on_disk;
-    // NewPage from BPM allocates a page on disk and provides a frame in memory.
-    Page* raw_first_page = buffer_pool_manager_->NewPage(first_page_id_on_disk);
-
-    if (raw_first_page == nullptr || first_page_id_on_disk == INVALID_PAGE_ID) {
-      // Failed to allocate a page from BPM (e.g., pool is full and no victim, or disk is full).
-      // The TableHeap will be created in an empty state (first_page_id_ remains INVALID_PAGE_ID).
-      LOG(ERROR) << "TableHeap Constructor: Failed to create the first page. Heap remains empty.";
-      // this->first_page_id_ is already INVALID_PAGE_ID due to the initializer list.
-      // For more robust error handling, consider throwing an exception:
-      // throw std::runtime_error("Failed to allocate first page for TableHeap.");
-      return; // Exit constructor; first_page_id_ remains INVALID_PAGE_ID
-    }
+  inline page_id_t GetFreeSpaceMapPageId() const { return free_space_map_.GetFirstPageId(); }
 
-    this->first_page_id_ = first_page_id_on_disk; // Set the first page ID for this heap.
-    TablePage* table_first_page = reinterpret_cast<TablePage*>(raw_first_page);
+  /**
+   * @return the number of pages in this table
+   */
+  inline size_t GetPageCount() const { return free_space_map_.GetTablePageIds().size(); }
 
-    // Initialize the header and data of the first TablePage.
-    // PrevPageId is invalid for the first page.
-    table_first_page->Init(this->first_page_id_, INVALID_PAGE_ID, log_manager_, txn);
+  /**
+   * @return the ids of the pages of this table in chain order
+   */
+  inline const std::vector<page_id_t> &GetPageIds() const { return free_space_map_.GetTablePageIds(); }
 
-    // Unpin the page. It is dirty because its header was initialized.
-    buffer_pool_manager_->UnpinPage(this->first_page_id_, true);
-  };
+  /**
+   * Set how many pages scans of this table read ahead, 0 disables read-ahead.
+   */
+  inline void SetReadAheadDistance(size_t distance) { read_ahead_distance_ = distance; }
 
-  explicit TableHeap(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id, Schema *schema,
-                     LogManager *log_manager, LockManager *lock_manager)
+ private:
+  /**
+   * create table heap and initialize first page
+   */
+  explicit TableHeap(BufferPoolManager *buffer_pool_manager, Schema *schema, Txn *txn, LogManager *log_manager,
+                     LockManager *lock_manager)
       : buffer_pool_manager_(buffer_pool_manager),
-        first_page_id_(first_page_id),
+        free_space_map_(buffer_pool_manager, &page_run_),
         schema_(schema),
         log_manager_(log_manager),
-        lock_manager_(lock_manager) {}
+        lock_manager_(lock_manager) {
+    if (!free_space_map_.Init()) {
+      LOG(ERROR) << "TableHeap Constructor: Failed to create the free space map.";
+      return;
+    }
+    // The heap stays empty if the first page can not be allocated, InsertTuple will retry.
+    auto first_page = AppendPage(txn);
+    if (first_page == nullptr) {
+      LOG(ERROR) << "TableHeap Constructor: Failed to create the first page. Heap remains empty.";
+      return;
+    }
+    buffer_pool_manager_->UnpinPage(first_page->GetTablePageId(), true);
+  };
+
+  explicit TableHeap(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id, page_id_t free_space_map_page_id,
+                     Schema *schema, LogManager *log_manager, LockManager *lock_manager);
+
+  /**
+   * Allocate a new page and link it after the last page of the heap.
+   * @return the new page, which is pinned and must be unpinned by the caller
+   */
+  TablePage *AppendPage(Txn *txn);
 
  private:
   BufferPoolManager *buffer_pool_manager_;
-  page_id_t first_page_id_;
+  page_id_t first_page_id_{INVALID_PAGE_ID};
+  page_id_t last_page_id_{INVALID_PAGE_ID};  // cached tail of the page chain
+  PageRun page_run_;                         // pages reserved for the heap and its free space map
+  FreeSpaceMap free_space_map_;
+  std::atomic<size_t> read_ahead_distance_{DEFAULT_READ_AHEAD_PAGES};  // pages scans read ahead, 0 disables it
   Schema *schema_;
   [[maybe_unused]] LogManager *log_manager_;
   [[maybe_unused]] LockManager *lock_manager_;
@@ -1,16 +1,23 @@
 #ifndef MINISQL_TABLE_ITERATOR_H
 #define MINISQL_TABLE_ITERATOR_H
 
+#include <memory>
+
+#include "buffer/buffer_access_strategy.h"
 #include "common/rowid.h"
 #include "concurrency/txn.h"
 #include "record/row.h"
+#include "record/row_batch.h"
 
 class TableHeap;
+class ReadAheadStream;
 
 class TableIterator {
 public:
  // you may define your own constructor based on your member variables
- explicit TableIterator(TableHeap *table_heap, RowId rid, Txn *txn);
+ explicit TableIterator(TableHeap *table_heap, RowId rid, Txn *txn,
+                        std::shared_ptr<BufferAccessStrategy> strategy = nullptr,
+                        std::shared_ptr<ReadAheadStream> read_ahead = nullptr);
 
  explicit TableIterator(const TableIterator &other);
 
@@ -30,12 +37,21 @@ public:
 
   TableIterator operator++(int);
 
+  /**
+   * Decode the rows from the current one on straight into the columns of batch until it is full, each page is
+   * pinned once per batch instead of twice per row. The iterator is left at the first row that did not fit.
+   * @return the number of rows appended
+   */
+  uint32_t NextBatch(RowBatch *batch);
+
 private:
   // add your own private member variables here
   TableHeap *table_heap_{nullptr};    // Pointer to the TableHeap instance being iterated.
   RowId current_rid_{INVALID_ROWID};  // Current RowId this iterator points to. INVALID_ROWID indicates end or invalid state.
   Row current_row_;                   // Buffer to hold the actual data of the current Row.
   Txn *txn_{nullptr};                 // Transaction context for operations.
+  std::shared_ptr<BufferAccessStrategy> strategy_;  // Bulk read ring of a large scan, shared by copies.
+  std::shared_ptr<ReadAheadStream> read_ahead_;     // Read-ahead of the page chain, shared by copies.
 };
 
 #endif  // MINISQL_TABLE_ITERATOR_H
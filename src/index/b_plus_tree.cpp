@@ -1,6 +1,9 @@
 #include "index/b_plus_tree.h"
 
+#include <algorithm>
+#include <cstdlib>
 #include <string>
+#include <thread>
 
 #include "glog/logging.h"
 #include "index/basic_comparator.h"
@@ -18,17 +21,56 @@ BPlusTree::BPlusTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager
       leaf_max_size_(leaf_max_size),
       internal_max_size_(internal_max_size) {
   Page* root_page = buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID);
-  if (leaf_max_size == UNDEFINED_SIZE) leaf_max_size_ = (PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / (KM.GetKeySize() + sizeof(RowId));
-  if (internal_max_size == UNDEFINED_SIZE) internal_max_size_ = (PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (KM.GetKeySize() + sizeof(page_id_t));
+  // By default pages are only limited by the bytes their keys take, the max sizes just bound the number of slots.
+  if (leaf_max_size == UNDEFINED_SIZE) leaf_max_size_ = (PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / LEAF_PAGE_SLOT_SIZE + 1;
+  if (internal_max_size == UNDEFINED_SIZE)
+    internal_max_size_ = (PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / INTERNAL_PAGE_SLOT_SIZE;
   if (leaf_max_size_ <= 0) leaf_max_size_ = 1;
   if (internal_max_size_ <= 1) internal_max_size_ = 2;
   IndexRootsPage *root = reinterpret_cast<IndexRootsPage *>(root_page->GetData());
-  root->GetRootId(index_id, &root_page_id_);
+  page_id_t root_page_id = INVALID_PAGE_ID;
+  root_page->RLatch();
+  root->GetRootId(index_id, &root_page_id);
+  root_page->RUnlatch();
+  root_page_id_ = root_page_id;
   buffer_pool_manager_->UnpinPage(INDEX_ROOTS_PAGE_ID, false);
 }
 
 void BPlusTree::Destroy(page_id_t current_page_id) {
-  buffer_pool_manager_->DeletePage(current_page_id);
+  root_latch_.WLock();
+  bool whole_tree = current_page_id == INVALID_PAGE_ID;
+  if (whole_tree) current_page_id = root_page_id_;
+  // Collect the pages level by level, so that they can be released together, run by run.
+  std::vector<page_id_t> page_ids;
+  if (current_page_id != INVALID_PAGE_ID) page_ids.push_back(current_page_id);
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    Page *page = buffer_pool_manager_->FetchPage(page_ids[i]);
+    if (page == nullptr) {
+      LOG(ERROR) << "Failed to fetch b plus tree page " << page_ids[i] << " while destroying index " << index_id_;
+      continue;
+    }
+    auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    if (!node->IsLeafPage()) {
+      auto *internal = reinterpret_cast<InternalPage *>(node);
+      for (int j = 0; j < internal->GetSize(); j++) {
+        page_ids.push_back(internal->ValueAt(j));
+      }
+    }
+    buffer_pool_manager_->UnpinPage(page_ids[i], false);
+  }
+  buffer_pool_manager_->DeletePages(page_ids);
+  if (whole_tree) {
+    buffer_pool_manager_->ReleasePageRun(&page_run_);
+    if (root_page_id_ != INVALID_PAGE_ID) {
+      root_page_id_ = INVALID_PAGE_ID;
+      Page *header = buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID);
+      header->WLatch();
+      reinterpret_cast<IndexRootsPage *>(header->GetData())->Delete(index_id_);
+      header->WUnlatch();
+      buffer_pool_manager_->UnpinPage(INDEX_ROOTS_PAGE_ID, true);
+    }
+  }
+  root_latch_.WUnlock();
 }
 
 /*
@@ -39,6 +81,63 @@ bool BPlusTree::IsEmpty() const {
   return false;
 }
 
+/*
+ * Whether node stays within its size limits after op, so that the operation cannot reach its ancestors. A root
+ * leaf may shrink down to one entry and a root internal page down to two children. A leaf knows the key it gets,
+ * an internal page must have room for any separator from below, and a page must stay at least half full whichever
+ * entry it loses.
+ */
+bool BPlusTree::IsSafe(BPlusTreePage *node, Operation op, const GenericKey *key) const {
+  if (op == Operation::kInsert) {
+    if (node->IsLeafPage()) {
+      return reinterpret_cast<LeafPage *>(node)->HasRoomFor(key);
+    }
+    auto *internal = reinterpret_cast<InternalPage *>(node);
+    return internal->GetSize() < internal->GetMaxSize() && internal->MaxInsertSpace() <= internal->GetFreeSpace();
+  }
+  if (op == Operation::kRemove) {
+    if (node->IsRootPage()) {
+      return node->GetSize() > (node->IsLeafPage() ? 1 : 2);
+    }
+    int max_entry_space = (node->IsLeafPage() ? LEAF_PAGE_SLOT_SIZE : INTERNAL_PAGE_SLOT_SIZE) + node->GetKeySize();
+    return node->GetSize() > node->GetMinSize() ||
+           2 * (node->GetUsedSpace() - max_entry_space) >= node->GetDataSize();
+  }
+  return true;
+}
+
+/*
+ * Release the latches and pins of the write set, and the root latch if it is still held. Pages still in the write
+ * set when an operation ends may have been modified.
+ */
+void BPlusTree::ReleaseWriteSet(WriteSet &write_set, bool is_dirty) {
+  if (write_set.root_locked) {
+    root_latch_.WUnlock();
+    write_set.root_locked = false;
+  }
+  for (auto page : write_set.pages) {
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), is_dirty);
+  }
+  write_set.pages.clear();
+}
+
+/*
+ * Release everything but the last page of the write set, once that page is known to be safe. The ancestors have not
+ * been modified yet.
+ */
+void BPlusTree::ReleaseAncestors(WriteSet &write_set) {
+  if (write_set.root_locked) {
+    root_latch_.WUnlock();
+    write_set.root_locked = false;
+  }
+  for (size_t i = 0; i + 1 < write_set.pages.size(); i++) {
+    write_set.pages[i]->WUnlatch();
+    buffer_pool_manager_->UnpinPage(write_set.pages[i]->GetPageId(), false);
+  }
+  write_set.pages.erase(write_set.pages.begin(), write_set.pages.end() - 1);
+}
+
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
@@ -48,12 +147,13 @@ bool BPlusTree::IsEmpty() const {
  * @return : true means key exists
  */
 bool BPlusTree::GetValue(const GenericKey *key, std::vector<RowId> &result, Txn *transaction) {
-  if (IsEmpty()) return false;
-  Page *leaf = FindLeafPage(key, root_page_id_, false);
+  Page *leaf = FindLeafPageRead(key, false);
+  if (leaf == nullptr) return false;
   LeafPage *leaf_page = reinterpret_cast<LeafPage*>(leaf->GetData());
   RowId temp;
   bool found = leaf_page->Lookup(key, temp, processor_);
-  buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), false);
+  leaf->RUnlatch();
+  buffer_pool_manager_->UnpinPage(leaf->GetPageId(), false);
   if (found) {
     result.push_back(temp);
   }
@@ -71,11 +171,17 @@ bool BPlusTree::GetValue(const GenericKey *key, std::vector<RowId> &result, Txn
  * keys return false, otherwise return true.
  */
 bool BPlusTree::Insert(GenericKey *key, const RowId &value, Txn *transaction) {
-  if (IsEmpty()) {
+  WriteSet write_set;
+  Page *leaf = FindLeafPageWrite(key, Operation::kInsert, write_set);
+  if (leaf == nullptr) {
+    // The tree is empty, the root latch is still held.
     StartNewTree(key, value);
+    ReleaseWriteSet(write_set, false);
     return true;
   }
-  return InsertIntoLeaf(key, value, transaction);
+  bool inserted = InsertIntoLeaf(reinterpret_cast<LeafPage *>(leaf->GetData()), key, value, transaction);
+  ReleaseWriteSet(write_set, inserted);
+  return inserted;
 }
 /*
  * Insert constant key & value pair into an empty tree
@@ -85,113 +191,427 @@ bool BPlusTree::Insert(GenericKey *key, const RowId &value, Txn *transaction) {
  */
 void BPlusTree::StartNewTree(GenericKey *key, const RowId &value) {
   page_id_t new_page_id;
-  Page *root = buffer_pool_manager_->NewPage(new_page_id);
+  Page *root = buffer_pool_manager_->NewPage(new_page_id, &page_run_);
   if (root == nullptr) {
     throw ("Out of memory");
   }
   LeafPage *root_leaf = reinterpret_cast<LeafPage*>(root->GetData());
   int key_size = processor_.GetKeySize();
   root_leaf->Init(new_page_id, INVALID_PAGE_ID, key_size, leaf_max_size_);
+  root_leaf->Insert(key, value, processor_);
+  // Optimistic descents read root_page_id_ without the root latch, publish the root once it is complete.
   root_page_id_ = new_page_id;
   UpdateRootPageId(1);
-  root_leaf->Insert(key, value, processor_);
-  buffer_pool_manager_->UnpinPage(new_page_id, false);
+  buffer_pool_manager_->UnpinPage(new_page_id, true);
 }
 
 /*
- * Insert constant key & value pair into leaf page
- * User needs to first find the right leaf page as insertion target, then look
- * through leaf page to see whether insert key exist or not. If exist, return
- * immediately, otherwise insert entry. Remember to deal with split if necessary.
+ * Insert constant key & value pair into the write latched leaf page. If exist,
+ * return immediately, otherwise insert entry. Remember to deal with split if
+ * necessary, the ancestors that may change are still in the write set.
  * @return: since we only support unique key, if user try to insert duplicate
  * keys return false, otherwise return true.
  */
-bool BPlusTree::InsertIntoLeaf(GenericKey *key, const RowId &value, Txn *transaction) {
-  Page *page = FindLeafPage(key, root_page_id_, false);
-  LeafPage *leaf_page = reinterpret_cast<LeafPage*>(page->GetData());
-
-  page_id_t leaf_page_id = leaf_page->GetPageId();
-  int old_key_size = leaf_page->GetKeySize();
-  int new_key_size  = leaf_page->Insert(key, value, processor_);
-  if (new_key_size == old_key_size) {
-    buffer_pool_manager_->UnpinPage(leaf_page_id, false);
+bool BPlusTree::InsertIntoLeaf(LeafPage *leaf_page, GenericKey *key, const RowId &value, Txn *transaction) {
+  int key_size = processor_.GetKeySize();
+  int index = leaf_page->KeyIndex(key, processor_);
+  if (index < leaf_page->GetSize() && leaf_page->CompareKeyAt(index, key, key_size) == 0) {
     return false;
   }
-  if (leaf_page->GetSize() > leaf_page->GetMaxSize() - 1) {
-    LeafPage *new_page = Split(leaf_page, transaction);
-    leaf_page->SetNextPageId(new_page->GetPageId());
-    InsertIntoParent(leaf_page, new_page->KeyAt(0), new_page, transaction);
-    buffer_pool_manager_->UnpinPage(new_page->GetPageId(), true);
+  if (leaf_page->HasRoomFor(key)) {
+    leaf_page->Insert(key, value, processor_);
+    return true;
   }
-  buffer_pool_manager_->UnpinPage(leaf_page_id, true);
+  // The pairs are split with the new one, a key that shrinks the prefix of the page may take more than its own size.
+  std::vector<char> keys;
+  std::vector<RowId> values;
+  leaf_page->CopyOut(0, index, keys, values);
+  keys.insert(keys.end(), reinterpret_cast<char *>(key), reinterpret_cast<char *>(key) + key_size);
+  values.push_back(value);
+  leaf_page->CopyOut(index, leaf_page->GetSize(), keys, values);
+  // Appending to the last leaf, as increasing keys do, leaves it full and starts the new sibling with the new key.
+  bool append = index == leaf_page->GetSize() && leaf_page->GetNextPageId() == INVALID_PAGE_ID;
+  // The new sibling is only reachable through the latched leaf and parent, it needs no latch of its own.
+  std::vector<char> separator(key_size);
+  LeafPage *new_page = Split(leaf_page, keys, values, append, separator.data(), transaction);
+  InsertIntoParent(leaf_page, reinterpret_cast<GenericKey *>(separator.data()), new_page, append, transaction);
+  buffer_pool_manager_->UnpinPage(new_page->GetPageId(), true);
   return true;
 }
 
 /*
  * Split input page and return newly created page.
- * Using template N to represent either internal page or leaf page.
  * User needs to first ask for new page from buffer pool manager(NOTICE: throw
- * an "out of memory" exception if returned value is nullptr), then move half
- * of key & value pairs from input page to newly created page
+ * an "out of memory" exception if returned value is nullptr), then rebuild the
+ * input page and the new one from the entries, split where both halves fit.
  */
-BPlusTreeInternalPage *BPlusTree::Split(InternalPage *node, Txn *transaction) {
+BPlusTreeInternalPage *BPlusTree::Split(InternalPage *node, const std::vector<char> &keys,
+                                        const std::vector<page_id_t> &values, bool append, char *separator,
+                                        Txn *transaction) {
   page_id_t new_page_id;
-  Page *new_page = buffer_pool_manager_->NewPage(new_page_id);
+  Page *new_page = buffer_pool_manager_->NewPage(new_page_id, &page_run_);
   if (new_page == nullptr) throw("Out of memory");
   InternalPage *new_internal_page = reinterpret_cast<InternalPage*>(new_page->GetData());
   int size = processor_.GetKeySize();
+  int count = static_cast<int>(values.size());
   new_internal_page->Init(new_page_id, node->GetParentPageId(), size, internal_max_size_);
-  node->MoveHalfTo(new_internal_page, buffer_pool_manager_);
+  int split = SplitPoint(keys.data(), count, false, append);
+  ASSERT(split > 0, "Entries of an overflowing page do not fit into two pages.");
+  // The first key of the new page moves up to the parent.
+  memcpy(separator, keys.data() + split * size, size);
+  node->Rebuild(keys.data(), values.data(), split, buffer_pool_manager_);
+  new_internal_page->Rebuild(keys.data() + split * size, values.data() + split, count - split, buffer_pool_manager_);
   return new_internal_page;
 }
 
-BPlusTreeLeafPage *BPlusTree::Split(LeafPage *node, Txn *transaction) {
+BPlusTreeLeafPage *BPlusTree::Split(LeafPage *node, const std::vector<char> &keys, const std::vector<RowId> &values,
+                                    bool append, char *separator, Txn *transaction) {
   page_id_t new_page_id;
-  Page *new_page = buffer_pool_manager_->NewPage(new_page_id);
+  Page *new_page = buffer_pool_manager_->NewPage(new_page_id, &page_run_);
   if (new_page == nullptr) throw("Out of memory");
   LeafPage *new_leaf_page = reinterpret_cast<LeafPage *>(new_page->GetData());
   int size = processor_.GetKeySize();
+  int count = static_cast<int>(values.size());
   new_leaf_page->Init(new_page_id, node->GetParentPageId(), size, leaf_max_size_);
-  node->MoveHalfTo(new_leaf_page);
+  int split = SplitPoint(keys.data(), count, true, append);
+  ASSERT(split > 0, "Entries of an overflowing page do not fit into two pages.");
+  ShortestSeparator(keys.data() + (split - 1) * size, keys.data() + split * size, separator);
+  node->Rebuild(keys.data(), values.data(), split);
+  new_leaf_page->Rebuild(keys.data() + split * size, values.data() + split, count - split);
+  new_leaf_page->SetNextPageId(node->GetNextPageId());
+  node->SetNextPageId(new_page_id);
   return new_leaf_page;
 }
 
+/*
+ * Every split that leaves both halves within their limits is a candidate, the
+ * one whose fuller half is the least full wins, ties go to the most even
+ * number of entries. An append split takes the candidate with the most entries
+ * on the left instead: the left page is never inserted into again, and the
+ * right one only by the keys after it. Internal pages keep at least two
+ * children on each side.
+ */
+int BPlusTree::SplitPoint(const char *keys, int count, bool leaf, bool append) const {
+  int key_size = processor_.GetKeySize();
+  int first = leaf ? 0 : 1;
+  // key_bytes_left[i] and key_bytes_right[i]: key bytes of the stored keys among [0, i) and [i, count)
+  std::vector<int> key_bytes_left(count + 1, 0);
+  std::vector<int> key_bytes_right(count + 1, 0);
+  KeyRun run;
+  for (int i = first; i < count; i++) {
+    const char *key = keys + i * key_size;
+    int stripped = BPlusTreePage::StrippedSize(key, key_size);
+    run.prefix_size =
+        run.count == 0 ? stripped
+                       : std::min({run.prefix_size, stripped,
+                                   BPlusTreePage::CommonPrefixSize(keys + first * key_size, key, key_size)});
+    run.stripped_size += stripped;
+    run.max_stripped_size = std::max(run.max_stripped_size, stripped);
+    run.count++;
+    key_bytes_left[i + 1] =
+        BPlusTreePage::KeySpace(run.count, run.prefix_size, run.stripped_size, run.max_stripped_size);
+  }
+  run = KeyRun();
+  for (int i = count - 1; i >= 0; i--) {
+    const char *key = keys + i * key_size;
+    int stripped = BPlusTreePage::StrippedSize(key, key_size);
+    run.prefix_size =
+        run.count == 0 ? stripped
+                       : std::min({run.prefix_size, stripped,
+                                   BPlusTreePage::CommonPrefixSize(key, keys + (count - 1) * key_size, key_size)});
+    run.stripped_size += stripped;
+    run.max_stripped_size = std::max(run.max_stripped_size, stripped);
+    run.count++;
+    key_bytes_right[i] =
+        BPlusTreePage::KeySpace(run.count, run.prefix_size, run.stripped_size, run.max_stripped_size);
+  }
+  int slot_size = leaf ? LEAF_PAGE_SLOT_SIZE : INTERNAL_PAGE_SLOT_SIZE;
+  int data_size = PAGE_SIZE - (leaf ? LEAF_PAGE_HEADER_SIZE : INTERNAL_PAGE_HEADER_SIZE);
+  int capacity = leaf ? leaf_max_size_ - 1 : internal_max_size_;
+  int min_entries = leaf || count < 4 ? 1 : 2;
+  int best = 0;
+  double best_fill = 0;
+  for (int split = min_entries; split <= count - min_entries; split++) {
+    int left_space = split * slot_size + key_bytes_left[split];
+    // The first key of the right page of an internal split moves up and is not stored.
+    int right_space = (count - split) * slot_size + (leaf ? key_bytes_right[split] : key_bytes_right[split + 1]);
+    if (split > capacity || count - split > capacity || left_space > data_size || right_space > data_size) {
+      continue;
+    }
+    double fill = std::max({static_cast<double>(split) / capacity, static_cast<double>(count - split) / capacity,
+                            static_cast<double>(left_space) / data_size, static_cast<double>(right_space) / data_size});
+    if (append) {
+      best = split;
+      continue;
+    }
+    if (best == 0 || fill < best_fill || (fill == best_fill && std::abs(count - 2 * split) < std::abs(count - 2 * best))) {
+      best = split;
+      best_fill = fill;
+    }
+  }
+  return best;
+}
+
+void BPlusTree::ShortestSeparator(const char *left, const char *right, char *separator) const {
+  int key_size = processor_.GetKeySize();
+  int size = std::min(BPlusTreePage::CommonPrefixSize(left, right, key_size) + 1, key_size);
+  memcpy(separator, right, size);
+  memset(separator + size, 0, key_size - size);
+}
+
 /*
  * Insert key & value pair into internal page after split
  * @param   old_node      input page from split() method
  * @param   key
  * @param   new_node      returned page from split() method
+ * @param   append        whether old_node was split at the right edge of the tree
  * User needs to first find the parent page of old_node, parent node must be
  * adjusted to take info of new_node into account. Remember to deal with split
- * recursively if necessary.
+ * recursively if necessary. The parent is write latched by the caller.
  */
-//有问题
-void BPlusTree::InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlusTreePage *new_node, Txn *transaction) {
+void BPlusTree::InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlusTreePage *new_node, bool append,
+                                 Txn *transaction) {
   if (old_node->IsRootPage()) {
-    Page *new_root = buffer_pool_manager_->NewPage(root_page_id_);
+    // The old root was not safe, so the root latch is still held.
+    page_id_t new_root_id;
+    Page *new_root = buffer_pool_manager_->NewPage(new_root_id, &page_run_);
     if (new_root == nullptr) throw("Out of memory");
     InternalPage *new_page = reinterpret_cast<InternalPage *>(new_root->GetData());
     int size = processor_.GetKeySize();
-    new_page->Init(root_page_id_, INVALID_PAGE_ID, size, internal_max_size_);
+    new_page->Init(new_root_id, INVALID_PAGE_ID, size, internal_max_size_);
     new_page->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
+    root_page_id_ = new_root_id;
     UpdateRootPageId(0);
-    old_node->SetParentPageId(root_page_id_);
-    new_node->SetParentPageId(root_page_id_);
-    buffer_pool_manager_->UnpinPage(root_page_id_, true);
+    old_node->SetParentPageId(new_root_id);
+    new_node->SetParentPageId(new_root_id);
+    buffer_pool_manager_->UnpinPage(new_root_id, true);
     return;
   }
   page_id_t parent_root_id = old_node->GetParentPageId();
   Page *parent_page = buffer_pool_manager_->FetchPage(parent_root_id);
   InternalPage *new_page = reinterpret_cast<InternalPage*>(parent_page->GetData());
-  int size = new_page->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
-  if (size > new_page->GetMaxSize()) {
-    InternalPage *new_parent_sibling = Split(new_page, transaction);
-    InsertIntoParent(new_page, new_parent_sibling->KeyAt(0), new_parent_sibling, transaction);
+  if (new_page->HasRoomFor(key)) {
+    new_page->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
+  } else {
+    int key_size = processor_.GetKeySize();
+    int index = new_page->ValueIndex(old_node->GetPageId()) + 1;
+    std::vector<char> keys;
+    std::vector<page_id_t> values;
+    new_page->CopyOut(0, index, keys, values);
+    keys.insert(keys.end(), reinterpret_cast<char *>(key), reinterpret_cast<char *>(key) + key_size);
+    values.push_back(new_node->GetPageId());
+    new_page->CopyOut(index, new_page->GetSize(), keys, values);
+    // The parent of a page at the right edge is at the right edge too, and gets the new child last.
+    append = append && index == new_page->GetSize();
+    std::vector<char> separator(key_size);
+    InternalPage *new_parent_sibling = Split(new_page, keys, values, append, separator.data(), transaction);
+    InsertIntoParent(new_page, reinterpret_cast<GenericKey *>(separator.data()), new_parent_sibling, append,
+                     transaction);
     buffer_pool_manager_->UnpinPage(new_parent_sibling->GetPageId(), true);
   }
   buffer_pool_manager_->UnpinPage(new_page->GetPageId(), true);
 }
 
+/*****************************************************************************
+ * BULK LOADING
+ *****************************************************************************/
+/*
+ * Leaves are written left to right as the pairs come in, and every page written
+ * adds its separator and page id to the level above, which is filled the same
+ * way. A level only writes a page once the pairs left over are enough for
+ * another page, so that at the end the last one or two pages of every level can
+ * be balanced without touching pages written before. Pages fill up by entries
+ * or by the bytes of their keys, whichever comes first.
+ */
+bool BPlusTree::BulkLoad(const std::function<bool(GenericKey *key, RowId *value)> &next, double fill_factor) {
+  root_latch_.WLock();
+  if (!IsEmpty()) {
+    root_latch_.WUnlock();
+    return false;
+  }
+  fill_factor = std::min(std::max(fill_factor, 0.0), 1.0);
+  std::deque<BulkLoadLevel> levels;
+  std::vector<page_id_t> built;
+  int key_size = processor_.GetKeySize();
+  std::vector<char> key(key_size), last_key(key_size);
+  RowId value;
+  bool ordered = true;
+  uint64_t count = 0;
+  while (next(reinterpret_cast<GenericKey *>(key.data()), &value)) {
+    if (count > 0 && processor_.CompareKeys(reinterpret_cast<GenericKey *>(last_key.data()),
+                                            reinterpret_cast<GenericKey *>(key.data())) >= 0) {
+      ordered = false;
+      break;
+    }
+    BulkLoadAppend(levels, 0, key.data(), value.Get(), fill_factor, built);
+    key.swap(last_key);
+    count++;
+  }
+  if (!ordered) {
+    LOG(ERROR) << "Bulk load of index " << index_id_ << " got duplicate or out of order keys.";
+    buffer_pool_manager_->DeletePages(built);
+    root_latch_.WUnlock();
+    return false;
+  }
+  // Write out what is left of every level, until a level consists of a single page: the root.
+  page_id_t root_id = INVALID_PAGE_ID;
+  for (size_t level = 0; level < levels.size(); level++) {
+    BulkLoadLevel &current = levels[level];
+    bool leaf = level == 0;
+    int remaining = static_cast<int>(current.values.size());
+    if (!leaf && current.num_pages == 0 && remaining == 1) {
+      root_id = static_cast<page_id_t>(current.values[0]);
+      break;
+    }
+    int space = leaf ? LeafPage::RequiredSpace(current.keys.data(), remaining, key_size)
+                     : InternalPage::RequiredSpace(current.keys.data(), remaining, key_size);
+    int capacity = leaf ? leaf_max_size_ - 1 : internal_max_size_;
+    if (remaining > capacity || space > PAGE_SIZE - (leaf ? LEAF_PAGE_HEADER_SIZE : INTERNAL_PAGE_HEADER_SIZE)) {
+      // Less than two pages worth are left, two halves of it fit and do not underflow.
+      int split = SplitPoint(current.keys.data(), remaining, leaf, false);
+      BulkLoadFlush(levels, level, split, fill_factor, built);
+      remaining -= split;
+    }
+    BulkLoadFlush(levels, level, remaining, fill_factor, built);
+  }
+  if (root_id != INVALID_PAGE_ID) {
+    // Optimistic descents read root_page_id_ without the root latch, the tree is complete now.
+    root_page_id_ = root_id;
+    UpdateRootPageId(1);
+  }
+  root_latch_.WUnlock();
+  return true;
+}
+
+/*
+ * Add a pair to a level of a bulk load, and write a page of the level once
+ * enough pairs are waiting: the head fills a page to the fill factor, and the
+ * tail behind it would not underflow a page of its own.
+ */
+void BPlusTree::BulkLoadAppend(std::deque<BulkLoadLevel> &levels, size_t level, const char *key, int64_t value,
+                               double fill_factor, std::vector<page_id_t> &built) {
+  if (levels.size() == level) {
+    levels.emplace_back();
+  }
+  BulkLoadLevel &current = levels[level];
+  int key_size = processor_.GetKeySize();
+  current.keys.insert(current.keys.end(), key, key + key_size);
+  current.values.push_back(value);
+  bool leaf = level == 0;
+  // A page is filled at least half, as it must not underflow.
+  double target = std::max(fill_factor, 0.5);
+  if (!current.head_full) {
+    KeyRun head = current.head;
+    ExtendRun(head, current, leaf);
+    if (head.count == 1 || RunFill(head, leaf) <= target) {
+      current.head = head;
+      return;
+    }
+    current.head_full = true;
+    current.tail = KeyRun();
+    current.tail.begin = static_cast<int>(current.values.size()) - 1;
+  }
+  ExtendRun(current.tail, current, leaf);
+  if (RunFill(current.tail, leaf) >= 0.5) {
+    BulkLoadFlush(levels, level, current.head.count, fill_factor, built);
+  }
+}
+
+/*
+ * Count the next key of a level into a run. The first key of an internal page
+ * is not stored, it takes a slot only.
+ */
+void BPlusTree::ExtendRun(KeyRun &run, const BulkLoadLevel &current, bool leaf) const {
+  int key_size = processor_.GetKeySize();
+  int index = run.begin + run.count;
+  run.count++;
+  if (!leaf && run.count == 1) {
+    return;
+  }
+  const char *key = current.keys.data() + index * key_size;
+  int stripped = BPlusTreePage::StrippedSize(key, key_size);
+  int first_stored = leaf ? run.begin : run.begin + 1;
+  if (index == first_stored) {
+    run.prefix_size = stripped;
+  } else {
+    int common = BPlusTreePage::CommonPrefixSize(current.keys.data() + first_stored * key_size, key, key_size);
+    run.prefix_size = std::min({run.prefix_size, stripped, common});
+  }
+  run.stripped_size += stripped;
+  run.max_stripped_size = std::max(run.max_stripped_size, stripped);
+}
+
+double BPlusTree::RunFill(const KeyRun &run, bool leaf) const {
+  int stored = leaf ? run.count : std::max(run.count - 1, 0);
+  int slot_size = leaf ? LEAF_PAGE_SLOT_SIZE : INTERNAL_PAGE_SLOT_SIZE;
+  int space = run.count * slot_size +
+              BPlusTreePage::KeySpace(stored, run.prefix_size, run.stripped_size, run.max_stripped_size);
+  int data_size = PAGE_SIZE - (leaf ? LEAF_PAGE_HEADER_SIZE : INTERNAL_PAGE_HEADER_SIZE);
+  int capacity = leaf ? leaf_max_size_ - 1 : internal_max_size_;
+  return std::max(static_cast<double>(run.count) / capacity, static_cast<double>(space) / data_size);
+}
+
+/*
+ * Write the first count waiting pairs of a level to a new page, link it to the
+ * previous leaf, adopt its children, and pass it on to the level above.
+ */
+void BPlusTree::BulkLoadFlush(std::deque<BulkLoadLevel> &levels, size_t level, int count, double fill_factor,
+                              std::vector<page_id_t> &built) {
+  if (count <= 0) return;
+  page_id_t page_id;
+  Page *page = buffer_pool_manager_->NewPage(page_id, &page_run_);
+  if (page == nullptr) throw("Out of memory");
+  built.push_back(page_id);
+  int key_size = processor_.GetKeySize();
+  BulkLoadLevel &current = levels[level];
+  // A leaf is separated from the previous one by the shortest key between them, a page above by its first key.
+  std::vector<char> separator(current.keys.begin(), current.keys.begin() + key_size);
+  if (level == 0) {
+    if (!current.last_key.empty()) {
+      ShortestSeparator(current.last_key.data(), current.keys.data(), separator.data());
+    }
+    auto *leaf = reinterpret_cast<LeafPage *>(page->GetData());
+    leaf->Init(page_id, INVALID_PAGE_ID, key_size, leaf_max_size_);
+    std::vector<RowId> values(current.values.begin(), current.values.begin() + count);
+    leaf->Rebuild(current.keys.data(), values.data(), count);
+    if (current.last_page_id != INVALID_PAGE_ID) {
+      Page *prev = buffer_pool_manager_->FetchPage(current.last_page_id);
+      reinterpret_cast<LeafPage *>(prev->GetData())->SetNextPageId(page_id);
+      buffer_pool_manager_->UnpinPage(current.last_page_id, true);
+    }
+    current.last_key.assign(current.keys.begin() + (count - 1) * key_size, current.keys.begin() + count * key_size);
+  } else {
+    auto *internal = reinterpret_cast<InternalPage *>(page->GetData());
+    internal->Init(page_id, INVALID_PAGE_ID, key_size, internal_max_size_);
+    std::vector<page_id_t> values(current.values.begin(), current.values.begin() + count);
+    internal->Rebuild(current.keys.data(), values.data(), count, buffer_pool_manager_);
+  }
+  current.last_page_id = page_id;
+  current.num_pages++;
+  current.keys.erase(current.keys.begin(), current.keys.begin() + count * key_size);
+  current.values.erase(current.values.begin(), current.values.begin() + count);
+  buffer_pool_manager_->UnpinPage(page_id, true);
+  // Count the pairs left over into a new head and tail.
+  bool leaf = level == 0;
+  double target = std::max(fill_factor, 0.5);
+  current.head = KeyRun();
+  current.tail = KeyRun();
+  current.head_full = false;
+  for (size_t i = 0; i < current.values.size(); i++) {
+    if (!current.head_full) {
+      KeyRun head = current.head;
+      ExtendRun(head, current, leaf);
+      if (head.count == 1 || RunFill(head, leaf) <= target) {
+        current.head = head;
+        continue;
+      }
+      current.head_full = true;
+      current.tail.begin = static_cast<int>(i);
+    }
+    ExtendRun(current.tail, current, leaf);
+  }
+  BulkLoadAppend(levels, level + 1, separator.data(), page_id, fill_factor, built);
+}
 
 /*****************************************************************************
  * REMOVE
@@ -203,195 +623,219 @@ void BPlusTree::InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlus
  * delete entry from leaf page. Remember to deal with redistribute or merge if
  * necessary.
  */
-void BPlusTree::Remove(const GenericKey *key, Txn *transaction) {//还要改
-  if (IsEmpty()) return;
-  Page *leaf = FindLeafPage(key, root_page_id_, false);
-  LeafPage *leaf_page = reinterpret_cast<LeafPage*>(leaf->GetData());
-  page_id_t leaf_page_id = leaf_page->GetPageId();
-
-  bool is_delete = false;
-  int index = leaf_page->KeyIndex(key, processor_);
-  int new_size = leaf_page->RemoveAndDeleteRecord(key, processor_);
-
-  if (new_size < leaf_page->GetMaxSize()) {
-    is_delete = CoalesceOrRedistribute<LeafPage>(leaf_page, transaction);
-  }
-  else if (!index) {
-    GenericKey *new_key = leaf_page->KeyAt(0); // New key to replace the old one.
-    InternalPage *parent_page = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(leaf_page->GetParentPageId())->GetData());
-    page_id_t page_id = leaf_page->GetPageId();
-
-    if(parent_page!=nullptr){
-      while (!parent_page->IsRootPage() && parent_page->ValueIndex(page_id) == 0) {
-        buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), false);
-        page_id=parent_page->GetPageId();
-        parent_page = reinterpret_cast<InternalPage *>(
-          buffer_pool_manager_->FetchPage(parent_page->GetParentPageId())->GetData()
-        );
-      }
-      int tmp = parent_page->ValueIndex(page_id);
-      if (tmp != 0 && processor_.CompareKeys(parent_page->KeyAt(tmp), new_key) != 0) {
-        parent_page->SetKeyAt(tmp, new_key);
-        buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);
-      }
-    }
+void BPlusTree::Remove(const GenericKey *key, Txn *transaction) {
+  while (!TryRemove(key, transaction)) {
+    // A scan holds the left sibling of the leaf, let it move on.
+    std::this_thread::yield();
   }
-  buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), true);
-  if(is_delete) buffer_pool_manager_->DeletePage(leaf_page->GetPageId());
 }
 
-/* todo
- * User needs to first find the sibling of input page. If sibling's size + input
- * page's size > page's max size, then redistribute. Otherwise, merge.
- * Using template N to represent either internal page or leaf page.
- * @return: true means target leaf page should be deleted, false means no
- * deletion happens
+/*
+ * One attempt of Remove.
+ * @return false if the attempt had to back off without changing anything
  */
-template <typename N>
-bool BPlusTree::CoalesceOrRedistribute(N *&node, Txn *transaction) {
-  if (node->GetSize() >= node->GetMinSize()) return false;
-  if (node->IsRootPage()) return AdjustRoot(node);
-
-  page_id_t parent_page_id = node->GetParentPageId();
-  Page* parent_page = buffer_pool_manager_->FetchPage(parent_page_id);
-  if (parent_page == nullptr) return false;
-  InternalPage* parent_node = reinterpret_cast<InternalPage*>(parent_page->GetData());
-
-  int index = parent_node->ValueIndex(node->GetPageId());
-
-  page_id_t neighbor_id;
-  if (index == 0) neighbor_id = parent_node->ValueAt(1);
-  else neighbor_id = parent_node->ValueAt(index - 1);
-  Page* neighbor_page = buffer_pool_manager_->FetchPage(neighbor_id);
-  N* neighbor = reinterpret_cast<N*>(neighbor_page->GetData());
+bool BPlusTree::TryRemove(const GenericKey *key, Txn *transaction) {
+  WriteSet write_set;
+  Page *leaf = FindLeafPageWrite(key, Operation::kRemove, write_set);
+  if (leaf == nullptr) {
+    ReleaseWriteSet(write_set, false);
+    return true;
+  }
+  auto *leaf_page = reinterpret_cast<LeafPage *>(leaf->GetData());
+  RowId value;
+  if (!leaf_page->Lookup(key, value, processor_)) {
+    ReleaseWriteSet(write_set, false);
+    return true;
+  }
 
-  bool flag = false;
-  if (neighbor->GetSize() + node->GetSize() <= neighbor->GetMaxSize()) {
-    flag = Coalesce(neighbor, node, parent_node, index, transaction);
-    buffer_pool_manager_->DeletePage(node->GetPageId());
+  // Latch the sibling of an underflowing leaf before changing anything. Scans latch leaves from left to right, so
+  // waiting for a left sibling while holding the leaf could deadlock with them: only try, and back off on failure.
+  Page *neighbor = nullptr;
+  if (!leaf_page->IsRootPage() && leaf_page->IsUnderflow(leaf_page->KeyIndex(key, processor_))) {
+    auto *parent = reinterpret_cast<InternalPage *>(write_set.pages[write_set.pages.size() - 2]->GetData());
+    int index = parent->ValueIndex(leaf_page->GetPageId());
+    neighbor = buffer_pool_manager_->FetchPage(parent->ValueAt(index == 0 ? 1 : index - 1));
+    if (index == 0) {
+      neighbor->WLatch();
+    } else if (!neighbor->TryWLatch()) {
+      buffer_pool_manager_->UnpinPage(neighbor->GetPageId(), false);
+      ReleaseWriteSet(write_set, false);
+      return false;
+    }
   }
-  else Redistribute(neighbor, node, index);
 
-  buffer_pool_manager_->UnpinPage(neighbor_id, 1);
-  buffer_pool_manager_->UnpinPage(parent_node->GetPageId(), 1);
-  if (flag) return CoalesceOrRedistribute(parent_node, transaction);
-  return 0;
+  leaf_page->RemoveAndDeleteRecord(key, processor_);
+  std::vector<page_id_t> deleted;
+  // Walk up the write set while nodes underflow. Every level but the leaf latches its sibling here: internal pages
+  // are only latched top down, under their latched parent.
+  for (size_t level = write_set.pages.size(); level-- > 0;) {
+    auto *node = reinterpret_cast<BPlusTreePage *>(write_set.pages[level]->GetData());
+    if (node->IsRootPage()) {
+      AdjustRoot(node, deleted);
+      break;
+    }
+    if (!node->IsUnderflow()) {
+      break;
+    }
+    auto *parent = reinterpret_cast<InternalPage *>(write_set.pages[level - 1]->GetData());
+    int index = parent->ValueIndex(node->GetPageId());
+    if (neighbor == nullptr) {
+      neighbor = buffer_pool_manager_->FetchPage(parent->ValueAt(index == 0 ? 1 : index - 1));
+      neighbor->WLatch();
+    }
+    bool merged;
+    if (node->IsLeafPage()) {
+      merged = CoalesceOrRedistribute(reinterpret_cast<LeafPage *>(neighbor->GetData()),
+                                      reinterpret_cast<LeafPage *>(node), parent, index, deleted);
+    } else {
+      merged = CoalesceOrRedistribute(reinterpret_cast<InternalPage *>(neighbor->GetData()),
+                                      reinterpret_cast<InternalPage *>(node), parent, index, deleted);
+    }
+    neighbor->WUnlatch();
+    buffer_pool_manager_->UnpinPage(neighbor->GetPageId(), true);
+    neighbor = nullptr;
+    if (!merged) {
+      break;
+    }
+  }
+  ReleaseWriteSet(write_set, true);
+  // Emptied pages are unreachable now, but an optimistic descent may still have one pinned until it notices.
+  std::vector<page_id_t> busy;
+  while (!buffer_pool_manager_->DeletePages(deleted, &busy)) {
+    deleted.swap(busy);
+    busy.clear();
+    std::this_thread::yield();
+  }
+  return true;
 }
 
 /*
- * Move all the key & value pairs from one page to its sibling page, and notify
- * buffer pool manager to delete this page. Parent page must be adjusted to
- * take info of deletion into account. Remember to deal with coalesce or
- * redistribute recursively if necessary.
+ * User needs to first find the sibling of input page. If the entries of both
+ * fit into one page, then merge. Otherwise, redistribute.
  * Using template N to represent either internal page or leaf page.
- * @param   neighbor_node      sibling page of input "node"
- * @param   node               input from method coalesceOrRedistribute()
- * @param   parent             parent page of input "node"
- * @return  true means parent node should be deleted, false means no deletion happened
- */
-bool BPlusTree::Coalesce(LeafPage *&neighbor_node, LeafPage *&node, InternalPage *&parent, int index,
-                         Txn *transaction) {
-  if (index != 0) {
-    node->MoveAllTo(neighbor_node);
-    neighbor_node->SetNextPageId(node->GetNextPageId());
-    parent->Remove(index);
-    if (parent->GetSize() >= parent->GetMinSize()) {
-      buffer_pool_manager_->DeletePage(node->GetPageId());
-      return false;
-    }
-    return CoalesceOrRedistribute<InternalPage>(parent, transaction);
+ * @return: true means the pages were merged and parent lost an entry
+ */
+template <typename N>
+bool BPlusTree::CoalesceOrRedistribute(N *neighbor_node, N *node, InternalPage *parent, int index,
+                                       std::vector<page_id_t> &deleted) {
+  if (index == 0) {
+    std::swap(neighbor_node, node);
+    index = 1;
   }
-  else {
-    neighbor_node->MoveAllTo(node);
-    node->SetNextPageId(neighbor_node->GetNextPageId());
-    parent->Remove(1);
-    if (parent->GetSize() >= parent->GetMinSize()) {
-      buffer_pool_manager_->DeletePage(node->GetPageId());
-      return false;
-    }
-    return CoalesceOrRedistribute<InternalPage>(parent, transaction);
+  // neighbor_node is the left page now, node the right one.
+  int key_size = processor_.GetKeySize();
+  std::vector<char> keys;
+  std::vector<decltype(node->ValueAt(0))> values;
+  neighbor_node->CopyOut(0, neighbor_node->GetSize(), keys, values);
+  int left_size = static_cast<int>(values.size());
+  node->CopyOut(0, node->GetSize(), keys, values);
+  if (!node->IsLeafPage()) {
+    // The separator in the parent comes down as the key of the first child of the right page.
+    parent->CopyKeyAt(index, reinterpret_cast<GenericKey *>(keys.data() + left_size * key_size));
+  }
+  // A leaf holds at most max size - 1 entries, an internal page max size children.
+  int count = static_cast<int>(values.size());
+  int capacity = node->IsLeafPage() ? node->GetMaxSize() - 1 : node->GetMaxSize();
+  if (count <= capacity && N::RequiredSpace(keys.data(), count, key_size) <= node->GetDataSize()) {
+    Coalesce(neighbor_node, node, keys, values, parent, index, deleted);
+    return true;
   }
+  Redistribute(neighbor_node, node, keys, values, parent, index);
+  return false;
+}
+
+/*
+ * Move all the key & value pairs of the right page into the left one, and
+ * remove the right one from the parent. The emptied page is added to deleted,
+ * it is released once unlatched.
+ * @param   keys, values       entries of both pages, in order
+ * @param   index              index of the right page in parent
+ */
+void BPlusTree::Coalesce(LeafPage *left, LeafPage *right, const std::vector<char> &keys,
+                         const std::vector<RowId> &values, InternalPage *parent, int index,
+                         std::vector<page_id_t> &deleted) {
+  left->Rebuild(keys.data(), values.data(), static_cast<int>(values.size()));
+  left->SetNextPageId(right->GetNextPageId());
+  right->SetSize(0);
+  parent->Remove(index);
+  deleted.push_back(right->GetPageId());
 }
 
-bool BPlusTree::Coalesce(InternalPage *&neighbor_node, InternalPage *&node, InternalPage *&parent, int index,
-                         Txn *transaction) {
-  node->MoveAllTo(neighbor_node, parent->KeyAt(index), buffer_pool_manager_);
+void BPlusTree::Coalesce(InternalPage *left, InternalPage *right, const std::vector<char> &keys,
+                         const std::vector<page_id_t> &values, InternalPage *parent, int index,
+                         std::vector<page_id_t> &deleted) {
+  left->Rebuild(keys.data(), values.data(), static_cast<int>(values.size()), buffer_pool_manager_);
+  right->SetSize(0);
   parent->Remove(index);
-  if (parent->GetSize() >= parent->GetMinSize()) return false;
-  return CoalesceOrRedistribute<InternalPage>(parent, transaction);
+  deleted.push_back(right->GetPageId());
 }
 
 /*
- * Redistribute key & value pairs from one page to its sibling page. If index ==
- * 0, move sibling page's first key & value pair into end of input "node",
- * otherwise move sibling page's last key & value pair into head of input
- * "node".
- * Using template N to represent either internal page or leaf page.
- * @param   neighbor_node      sibling page of input "node"
- * @param   node               input from method coalesceOrRedistribute()
+ * Redistribute key & value pairs between two sibling pages, balanced like a
+ * split. The separator in the parent changes with it, and may take more bytes
+ * than before: if no split fits or the parent has no room for the separator,
+ * the pages are left as they are and stay less than half full.
+ * @param   keys, values       entries of both pages, in order
+ * @param   index              index of the right page in parent
  */
-void BPlusTree::Redistribute(LeafPage *neighbor_node, LeafPage *node, int index) {
-  Page* parent_page = buffer_pool_manager_->FetchPage(node->GetParentPageId());
-  if(parent_page == nullptr) return;
-  InternalPage* parent_node = reinterpret_cast<InternalPage*>(parent_page->GetData());
-
-  if (index != 0) {
-    neighbor_node->MoveLastToFrontOf(node);
-    parent_node->SetKeyAt(parent_node->ValueIndex(node->GetPageId()), node->KeyAt(0));
-  }
-  else {
-    neighbor_node->MoveFirstToEndOf(node);
-    parent_node->SetKeyAt(parent_node->ValueIndex(neighbor_node->GetPageId()), neighbor_node->KeyAt(0));
-  }
+void BPlusTree::Redistribute(LeafPage *left, LeafPage *right, const std::vector<char> &keys,
+                             const std::vector<RowId> &values, InternalPage *parent, int index) {
+  int key_size = processor_.GetKeySize();
+  int count = static_cast<int>(values.size());
+  int split = SplitPoint(keys.data(), count, true, false);
+  if (split == 0) return;
+  std::vector<char> separator(key_size);
+  ShortestSeparator(keys.data() + (split - 1) * key_size, keys.data() + split * key_size, separator.data());
+  auto *separator_key = reinterpret_cast<GenericKey *>(separator.data());
+  if (!parent->CanReplaceKeyAt(index, separator_key)) return;
+  left->Rebuild(keys.data(), values.data(), split);
+  right->Rebuild(keys.data() + split * key_size, values.data() + split, count - split);
+  parent->SetKeyAt(index, separator_key);
 }
-void BPlusTree::Redistribute(InternalPage *neighbor_node, InternalPage *node, int index) {
-  Page* parent_page = buffer_pool_manager_->FetchPage(node->GetParentPageId());
-  if(parent_page == nullptr) return;
-  InternalPage* parent_node = reinterpret_cast<InternalPage*>(parent_page->GetData());
 
-  if (index != 0) {
-    GenericKey* new_key = neighbor_node->KeyAt(neighbor_node->GetSize() - 1);
-    neighbor_node->MoveLastToFrontOf(node, parent_node->KeyAt(parent_node->ValueIndex(neighbor_node->GetPageId())), buffer_pool_manager_);
-    parent_node->SetKeyAt(parent_node->ValueIndex(neighbor_node->GetPageId()), new_key);
-  }
-  else {
-    GenericKey* new_key = neighbor_node->KeyAt(1);
-    neighbor_node->MoveFirstToEndOf(node, parent_node->KeyAt(parent_node->ValueIndex(neighbor_node->GetPageId())), buffer_pool_manager_);
-    parent_node->SetKeyAt(parent_node->ValueIndex(neighbor_node->GetPageId()), new_key);
-  }
-  buffer_pool_manager_->UnpinPage(parent_node->GetPageId(), true);
+void BPlusTree::Redistribute(InternalPage *left, InternalPage *right, const std::vector<char> &keys,
+                             const std::vector<page_id_t> &values, InternalPage *parent, int index) {
+  int key_size = processor_.GetKeySize();
+  int count = static_cast<int>(values.size());
+  int split = SplitPoint(keys.data(), count, false, false);
+  if (split == 0) return;
+  // The first key of the right page moves up to the parent.
+  auto *separator_key = reinterpret_cast<const GenericKey *>(keys.data() + split * key_size);
+  if (!parent->CanReplaceKeyAt(index, separator_key)) return;
+  left->Rebuild(keys.data(), values.data(), split, buffer_pool_manager_);
+  right->Rebuild(keys.data() + split * key_size, values.data() + split, count - split, buffer_pool_manager_);
+  parent->SetKeyAt(index, separator_key);
 }
 /*
  * Update root page if necessary
  * NOTE: size of root page can be less than min size and this method is only
- * called within coalesceOrRedistribute() method
+ * called while the root latch is held
  * case 1: when you delete the last element in root page, but root page still
  * has one last child
  * case 2: when you delete the last element in whole b+ tree
  * @return : true means root page should be deleted, false means no deletion
  * happened
  */
-bool BPlusTree::AdjustRoot(BPlusTreePage *old_root_node) {
+bool BPlusTree::AdjustRoot(BPlusTreePage *old_root_node, std::vector<page_id_t> &deleted) {
   page_id_t old_root_id = old_root_node->GetPageId();
   if (!old_root_node->IsLeafPage()) {
     if (old_root_node->GetSize() == 1) {
       InternalPage* old_root=reinterpret_cast<InternalPage*>(old_root_node);
       root_page_id_=old_root->RemoveAndReturnOnlyChild();
       UpdateRootPageId();
+      // The only child underflowed too, so it is still write latched by this thread.
       Page* new_root_page=buffer_pool_manager_->FetchPage(root_page_id_);
       BPlusTreePage*new_root=reinterpret_cast<BPlusTreePage*>(new_root_page->GetData());
       new_root->SetParentPageId(INVALID_PAGE_ID);
       buffer_pool_manager_->UnpinPage(root_page_id_,true);//因为新根改了parent
-      buffer_pool_manager_->UnpinPage(old_root_id,false);
-      buffer_pool_manager_->DeletePage(old_root_id);
+      deleted.push_back(old_root_id);
       return true;
     }
   }
   else if (old_root_node->GetSize() == 0) {
     root_page_id_ = INVALID_PAGE_ID;
     UpdateRootPageId();
-    buffer_pool_manager_->UnpinPage(root_page_id_, true);
-    buffer_pool_manager_->DeletePage(old_root_id);
+    deleted.push_back(old_root_id);
     return true;
   }
   return false;
@@ -406,11 +850,9 @@ bool BPlusTree::AdjustRoot(BPlusTreePage *old_root_node) {
  * @return : index iterator
  */
 IndexIterator BPlusTree::Begin() {
-  if (IsEmpty()) return End();
-  Page *left = FindLeafPage(nullptr, INVALID_PAGE_ID, true);
-  if (left == nullptr) return IndexIterator();
-  buffer_pool_manager_->UnpinPage(left->GetPageId(), false);
-  return IndexIterator(left->GetPageId(), buffer_pool_manager_, 0);
+  Page *left = FindLeafPageRead(nullptr, true);
+  if (left == nullptr) return End();
+  return IndexIterator(left, buffer_pool_manager_, 0);
 }
 
 /*
@@ -419,12 +861,10 @@ IndexIterator BPlusTree::Begin() {
  * @return : index iterator
  */
 IndexIterator BPlusTree::Begin(const GenericKey *key) {
-  if (IsEmpty()) return End();
-  Page *left = FindLeafPage(key, INVALID_PAGE_ID, false);
-  if (left == nullptr) return IndexIterator();
+  Page *left = FindLeafPageRead(key, false);
+  if (left == nullptr) return End();
   LeafPage *leaf = reinterpret_cast<LeafPage*>(left->GetData());
-  buffer_pool_manager_->UnpinPage(left->GetPageId(), false);
-  return IndexIterator(left->GetPageId(), buffer_pool_manager_, leaf->KeyIndex(key, processor_));
+  return IndexIterator(left, buffer_pool_manager_, leaf->KeyIndex(key, processor_));
 }
 
 /*
@@ -445,44 +885,179 @@ IndexIterator BPlusTree::End() {
  * Note: the leaf page is pinned, you need to unpin it after use.
  */
 Page *BPlusTree::FindLeafPage(const GenericKey *key, page_id_t page_id, bool leftMost) {
-  if (IsEmpty()) return nullptr;
-
-  if (page_id == INVALID_PAGE_ID) page_id = root_page_id_;
-
-  Page *page = buffer_pool_manager_->FetchPage(page_id);
-  if (page == nullptr) return nullptr;
+  if (page_id != INVALID_PAGE_ID) {
+    // Descend from an arbitrary page, only meaningful when no one else uses the tree.
+    Page *page = buffer_pool_manager_->FetchPage(page_id);
+    if (page == nullptr) return nullptr;
+    auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    while (!node->IsLeafPage()) {
+      auto *internal_node = reinterpret_cast<InternalPage *>(node);
+      page_id_t next_page_id = leftMost ? internal_node->ValueAt(0) : internal_node->Lookup(key, processor_);
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+      page = buffer_pool_manager_->FetchPage(next_page_id);
+      if (page == nullptr) return nullptr;
+      node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    }
+    return page;
+  }
+  Page *page = FindLeafPageRead(key, leftMost);
+  if (page != nullptr) page->RUnlatch();
+  return page;
+}
 
-  BPlusTreePage *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+/*
+ * Descend to the leaf for key with optimistic lock coupling. Inner pages are
+ * only pinned: the version of a page is read before its content and checked
+ * again once the child is pinned, and the descent restarts from the root if a
+ * writer got in between. Only the leaf is latched, exclusively or not, and kept
+ * if its version did not move since it was reached.
+ * @param[out] leaf the latched and pinned leaf, nullptr if the tree is empty
+ * @return false if the descent kept being disturbed and was given up
+ */
+bool BPlusTree::FindLeafPageOptimistic(const GenericKey *key, bool leftMost, bool exclusive, Page **leaf) {
+  for (int attempt = 0; attempt < OPTIMISTIC_DESCENT_RETRIES; attempt++) {
+    if (attempt > 0) std::this_thread::yield();
+    page_id_t page_id = root_page_id_;
+    if (page_id == INVALID_PAGE_ID) {
+      *leaf = nullptr;
+      return true;
+    }
+    Page *page = buffer_pool_manager_->FetchPage(page_id);
+    if (page == nullptr) return false;
+    uint64_t version = page->GetVersion();
+    // The root is only replaced while it is write latched, so an unlatched version of the current root stays valid.
+    bool valid = !Page::IsWriteLatched(version) && root_page_id_ == page_id;
+    while (valid) {
+      auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+      if (node->IsLeafPage()) {
+        // Taking the write latch moves the version on by one.
+        exclusive ? page->WLatch() : page->RLatch();
+        if (page->GetVersion() == (exclusive ? version + 1 : version)) {
+          *leaf = page;
+          return true;
+        }
+        exclusive ? page->WUnlatch() : page->RUnlatch();
+        break;
+      }
+      // The content may be torn by a writer, look at it only as far as it cannot lead out of the page.
+      auto *internal_node = reinterpret_cast<InternalPage *>(node);
+      int size = internal_node->GetSize();
+      page_id_t child_id = INVALID_PAGE_ID;
+      if (size > 0 && size <= internal_max_size_) {
+        child_id = leftMost ? internal_node->ValueAt(0) : internal_node->Lookup(key, processor_);
+      }
+      if (!page->ValidateVersion(version)) break;
+      Page *child = buffer_pool_manager_->FetchPage(child_id);
+      if (child == nullptr) {
+        buffer_pool_manager_->UnpinPage(page_id, false);
+        return false;
+      }
+      uint64_t child_version = child->GetVersion();
+      // The child is still referenced by the page once pinned, so it cannot have been released and reused.
+      valid = !Page::IsWriteLatched(child_version) && page->ValidateVersion(version);
+      buffer_pool_manager_->UnpinPage(page_id, false);
+      page = child;
+      page_id = child_id;
+      version = child_version;
+    }
+    buffer_pool_manager_->UnpinPage(page_id, false);
+  }
+  return false;
+}
 
+/*
+ * Descend to the leaf for key with read latch crabbing: the latch of a page is
+ * released as soon as the latch of its child is held.
+ * @return the read latched and pinned leaf, nullptr if the tree is empty
+ */
+Page *BPlusTree::FindLeafPageRead(const GenericKey *key, bool leftMost) {
+  Page *leaf;
+  if (FindLeafPageOptimistic(key, leftMost, false, &leaf)) {
+    return leaf;
+  }
+  root_latch_.RLock();
+  if (IsEmpty()) {
+    root_latch_.RUnlock();
+    return nullptr;
+  }
+  Page *page = buffer_pool_manager_->FetchPage(root_page_id_);
+  if (page == nullptr) {
+    root_latch_.RUnlock();
+    return nullptr;
+  }
+  page->RLatch();
+  root_latch_.RUnlock();
+  auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
   while (!node->IsLeafPage()) {
-    InternalPage* internal_node = reinterpret_cast<InternalPage*>(node);
-    page_id_t next_page_id;
-    if (leftMost) next_page_id = internal_node->ValueAt(0);
-    else next_page_id = internal_node->Lookup(key, processor_);
-    buffer_pool_manager_->UnpinPage(page_id, false);
-    page_id = next_page_id;
-    page = buffer_pool_manager_->FetchPage(page_id);
-    if (page == nullptr) {
-      return nullptr;
-    }
+    auto *internal_node = reinterpret_cast<InternalPage *>(node);
+    page_id_t next_page_id = leftMost ? internal_node->ValueAt(0) : internal_node->Lookup(key, processor_);
+    Page *child = buffer_pool_manager_->FetchPage(next_page_id);
+    if (child != nullptr) child->RLatch();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    if (child == nullptr) return nullptr;
+    page = child;
     node = reinterpret_cast<BPlusTreePage *>(page->GetData());
   }
   return page;
 }
 
+/*
+ * Descend to the leaf for key with write latch crabbing. Every page on the way is
+ * write latched and added to the write set, and the ancestors of a page that is
+ * safe for op are released. The root latch counts as the topmost ancestor.
+ * @return the write latched leaf, which is the last page of the write set,
+ * nullptr if the tree is empty, in which case the root latch is kept
+ */
+Page *BPlusTree::FindLeafPageWrite(const GenericKey *key, Operation op, WriteSet &write_set) {
+  Page *leaf;
+  if (FindLeafPageOptimistic(key, false, true, &leaf) && leaf != nullptr) {
+    if (IsSafe(reinterpret_cast<BPlusTreePage *>(leaf->GetData()), op, key)) {
+      // Nothing above the leaf can change, it is all the write set needs.
+      write_set.pages.push_back(leaf);
+      return leaf;
+    }
+    leaf->WUnlatch();
+    buffer_pool_manager_->UnpinPage(leaf->GetPageId(), false);
+  }
+  root_latch_.WLock();
+  write_set.root_locked = true;
+  if (IsEmpty()) return nullptr;
+  page_id_t page_id = root_page_id_;
+  while (true) {
+    Page *page = buffer_pool_manager_->FetchPage(page_id);
+    if (page == nullptr) {
+      ReleaseWriteSet(write_set, false);
+      throw("Out of memory");
+    }
+    page->WLatch();
+    write_set.pages.push_back(page);
+    auto *node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    if (IsSafe(node, op, key)) {
+      ReleaseAncestors(write_set);
+    }
+    if (node->IsLeafPage()) {
+      return page;
+    }
+    page_id = reinterpret_cast<InternalPage *>(node)->Lookup(key, processor_);
+  }
+}
+
 /*
  * Update/Insert root page id in header page(where page_id = INDEX_ROOTS_PAGE_ID,
  * header_page isdefined under include/page/header_page.h)
  * Call this method everytime root page id is changed.
  * @parameter: insert_record      default value is false. When set to true,
  * insert a record <index_name, current_page_id> into header page instead of
- * updating it.
+ * updating it. A record left by an emptied tree is updated.
  */
 void BPlusTree::UpdateRootPageId(int insert_record) {
   Page *header = buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID);
+  // The header page is shared by all indexes.
+  header->WLatch();
   IndexRootsPage* root_page = reinterpret_cast<IndexRootsPage*>(header->GetData());
-  if (insert_record != 0) root_page->Insert(index_id_, root_page_id_);
-  else root_page ->Update(index_id_, root_page_id_);
+  if (insert_record == 0 || !root_page->Insert(index_id_, root_page_id_)) root_page->Update(index_id_, root_page_id_);
+  header->WUnlatch();
   buffer_pool_manager_->UnpinPage(INDEX_ROOTS_PAGE_ID, true);
 }
 
@@ -507,9 +1082,11 @@ void BPlusTree::ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::ofstre
         << "max_size=" << leaf->GetMaxSize() << ",min_size=" << leaf->GetMinSize() << ",size=" << leaf->GetSize()
         << "</TD></TR>\n";
     out << "<TR>";
+    std::vector<char> key(processor_.GetKeySize());
     for (int i = 0; i < leaf->GetSize(); i++) {
       Row ans;
-      processor_.DeserializeToKey(leaf->KeyAt(i), ans, schema);
+      leaf->CopyKeyAt(i, reinterpret_cast<GenericKey *>(key.data()));
+      processor_.DeserializeToKey(reinterpret_cast<GenericKey *>(key.data()), ans, schema);
       out << "<TD>" << ans.GetField(0)->toString() << "</TD>\n";
     }
     out << "</TR>";
@@ -541,11 +1118,13 @@ void BPlusTree::ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::ofstre
         << "max_size=" << inner->GetMaxSize() << ",min_size=" << inner->GetMinSize() << ",size=" << inner->GetSize()
         << "</TD></TR>\n";
     out << "<TR>";
+    std::vector<char> key(processor_.GetKeySize());
     for (int i = 0; i < inner->GetSize(); i++) {
       out << "<TD PORT=\"p" << inner->ValueAt(i) << "\">";
       if (i > 0) {
         Row ans;
-        processor_.DeserializeToKey(inner->KeyAt(i), ans, schema);
+        inner->CopyKeyAt(i, reinterpret_cast<GenericKey *>(key.data()));
+        processor_.DeserializeToKey(reinterpret_cast<GenericKey *>(key.data()), ans, schema);
         out << ans.GetField(0)->toString();
       } else {
         out << " ";
@@ -586,7 +1165,7 @@ void BPlusTree::ToString(BPlusTreePage *page, BufferPoolManager *bpm) const {
     std::cout << "Leaf Page: " << leaf->GetPageId() << " parent: " << leaf->GetParentPageId()
               << " next: " << leaf->GetNextPageId() << std::endl;
     for (int i = 0; i < leaf->GetSize(); i++) {
-      std::cout << leaf->KeyAt(i) << ",";
+      std::cout << leaf->ValueAt(i).Get() << ",";
     }
     std::cout << std::endl;
     std::cout << std::endl;
@@ -594,7 +1173,7 @@ void BPlusTree::ToString(BPlusTreePage *page, BufferPoolManager *bpm) const {
     auto *internal = reinterpret_cast<InternalPage *>(page);
     std::cout << "Internal Page: " << internal->GetPageId() << " parent: " << internal->GetParentPageId() << std::endl;
     for (int i = 0; i < internal->GetSize(); i++) {
-      std::cout << internal->KeyAt(i) << ": " << internal->ValueAt(i) << ",";
+      std::cout << internal->ValueAt(i) << ",";
     }
     std::cout << std::endl;
     std::cout << std::endl;
@@ -1,17 +1,37 @@
 #include "index/b_plus_tree_index.h"
 
+#include <cstdint>
+
+#include "index/external_sorter.h"
 #include "index/generic_key.h"
 #include "utils/tree_file_mgr.h"
+static constexpr size_t ROW_ID_SUFFIX_SIZE = sizeof(int64_t);
+
 BPlusTreeIndex::BPlusTreeIndex(index_id_t index_id, IndexSchema *key_schema, size_t key_size,
-                               BufferPoolManager *buffer_pool_manager)
-    : Index(index_id, key_schema),
-      processor_(key_schema_, key_size),
+                               BufferPoolManager *buffer_pool_manager, bool unique)
+    : Index(index_id, key_schema, unique),
+      key_size_(key_size),
+      processor_(key_schema_, unique ? key_size : key_size + ROW_ID_SUFFIX_SIZE),
       container_(index_id, buffer_pool_manager, processor_) {}
 
+uint32_t BPlusTreeIndex::SerializeFromKey(GenericKey *index_key, const Row &key, RowId row_id) const {
+  uint32_t encoded_size = processor_.SerializeFromKey(index_key, key, key_schema_);
+  if (!unique_) {
+    // Big endian with the sign bit flipped, so that the row ids of a key are in order.
+    auto value = static_cast<uint64_t>(row_id.Get()) ^ (1ull << 63);
+    char *buf = reinterpret_cast<char *>(index_key) + encoded_size;
+    for (int i = ROW_ID_SUFFIX_SIZE - 1; i >= 0; i--) {
+      buf[i] = static_cast<char>(value & 0xff);
+      value >>= 8;
+    }
+  }
+  return encoded_size;
+}
+
 dberr_t BPlusTreeIndex::InsertEntry(const Row &key, RowId row_id, Txn *txn) {
   // ASSERT(row_id.Get() != INVALID_ROWID.Get(), "Invalid row id for index insert.");
   GenericKey *index_key = processor_.InitKey();
-  processor_.SerializeFromKey(index_key, key, key_schema_);
+  SerializeFromKey(index_key, key, row_id);
 
   bool status = container_.Insert(index_key, row_id, txn);
   free(index_key);
@@ -28,7 +48,7 @@ dberr_t BPlusTreeIndex::InsertEntry(const Row &key, RowId row_id, Txn *txn) {
 
 dberr_t BPlusTreeIndex::RemoveEntry(const Row &key, RowId row_id, Txn *txn) {
   GenericKey *index_key = processor_.InitKey();
-  processor_.SerializeFromKey(index_key, key, key_schema_);
+  SerializeFromKey(index_key, key, row_id);
 
   container_.Remove(index_key, txn);
   free(index_key);
@@ -36,48 +56,60 @@ dberr_t BPlusTreeIndex::RemoveEntry(const Row &key, RowId row_id, Txn *txn) {
 }
 
 dberr_t BPlusTreeIndex::ScanKey(const Row &key, vector<RowId> &result, Txn *txn, string compare_operator) {
-  GenericKey *index_key = processor_.InitKey();
-  processor_.SerializeFromKey(index_key, key, key_schema_);
-  auto end_iter = GetEndIterator();
-  if (compare_operator == "=") {
-    container_.GetValue(index_key, result, txn);
-  } else if (compare_operator == ">") {
-    auto iter = GetBeginIterator(index_key);
-    if (container_.GetValue(index_key, result, txn)) ++iter;
-    result.clear();
-    for (; iter != end_iter; ++iter) {
-      result.emplace_back((*iter).second);
-    }
-  } else if (compare_operator == ">=") {
-    for (auto iter = GetBeginIterator(index_key); iter != end_iter; ++iter) {
-      result.emplace_back((*iter).second);
-    }
-  } else if (compare_operator == "<") {
-    auto stop_iter = GetBeginIterator(index_key);
-    for (auto iter = GetBeginIterator(); iter != stop_iter; ++iter) {
-      result.emplace_back((*iter).second);
-    }
-  } else if (compare_operator == "<=") {
-    auto stop_iter = GetBeginIterator(index_key);
-    for (auto iter = GetBeginIterator(); iter != stop_iter; ++iter) {
+  // An iterator keeps its leaf read latched, so the ranges are read one after the other.
+  auto collect = [this, &result](IndexIterator iter) {
+    for (auto end_iter = GetEndIterator(); iter != end_iter; ++iter) {
       result.emplace_back((*iter).second);
     }
+  };
+  if (compare_operator == "=" && unique_) {
+    GenericKey *index_key = processor_.InitKey();
+    SerializeFromKey(index_key, key, INVALID_ROWID);
     container_.GetValue(index_key, result, txn);
+    free(index_key);
+  } else if (compare_operator == "=") {
+    collect(GetRangeIterator(&key, true, &key, true));
+  } else if (compare_operator == ">" || compare_operator == ">=") {
+    collect(GetRangeIterator(&key, compare_operator == ">=", nullptr, false));
+  } else if (compare_operator == "<" || compare_operator == "<=") {
+    collect(GetRangeIterator(nullptr, false, &key, compare_operator == "<="));
   } else if (compare_operator == "<>") {
-    for (auto iter = GetBeginIterator(); iter != end_iter; ++iter) {
-      result.emplace_back((*iter).second);
-    }
-    vector<RowId> temp;
-    if (container_.GetValue(index_key, temp, txn))
-      result.erase(find(result.begin(), result.end(), temp[0]));
+    collect(GetRangeIterator(nullptr, false, &key, false));
+    collect(GetRangeIterator(&key, false, nullptr, false));
   }
-  free(index_key);
   if (!result.empty())
     return DB_SUCCESS;
   else
     return DB_KEY_NOT_FOUND;
 }
 
+dberr_t BPlusTreeIndex::BulkLoad(const std::function<bool(Row &key, RowId &row_id)> &next, Txn *txn) {
+  ExternalSorter sorter(processor_.GetKeySize());
+  GenericKey *index_key = processor_.InitKey();
+  Row key;
+  RowId row_id;
+  while (next(key, row_id)) {
+    SerializeFromKey(index_key, key, row_id);
+    sorter.Add(index_key, row_id);
+  }
+  sorter.Sort();
+  auto sorted = [&sorter](GenericKey *sorted_key, RowId *value) { return sorter.Next(sorted_key, value); };
+  dberr_t result = DB_SUCCESS;
+  if (container_.IsEmpty()) {
+    // Fails on duplicate keys of a unique index, the tree is left empty then.
+    if (!container_.BulkLoad(sorted)) result = DB_FAILED;
+  } else {
+    // Inserts in key order still touch every leaf only once in a row.
+    while (result == DB_SUCCESS && sorted(index_key, &row_id)) {
+      if (!container_.Insert(index_key, row_id, txn)) result = DB_FAILED;
+    }
+  }
+  // A run that could not be written or read back ends the input early, the index would miss its rows.
+  if (sorter.IsFailed()) result = DB_FAILED;
+  free(index_key);
+  return result;
+}
+
 dberr_t BPlusTreeIndex::Destroy() {
   container_.Destroy();
   return DB_SUCCESS;
@@ -93,4 +125,26 @@ IndexIterator BPlusTreeIndex::GetBeginIterator(GenericKey *key) {
 
 IndexIterator BPlusTreeIndex::GetEndIterator() {
   return container_.End();
+}
+
+IndexIterator BPlusTreeIndex::GetRangeIterator(const Row *lower, bool lower_inclusive, const Row *upper,
+                                               bool upper_inclusive) {
+  GenericKey *index_key = processor_.InitKey();
+  IndexIterator iter;
+  if (lower == nullptr) {
+    iter = GetBeginIterator();
+  } else {
+    // With a row id appended, an exclusive bound starts after the largest row id of the key.
+    uint32_t encoded_size = SerializeFromKey(index_key, *lower, RowId(lower_inclusive ? INT64_MIN : INT64_MAX));
+    iter = GetBeginIterator(index_key);
+    for (auto end_iter = GetEndIterator(); !lower_inclusive && iter != end_iter; ++iter) {
+      if (CompareIndexKeys((*iter).first, index_key, encoded_size) != 0) break;
+    }
+  }
+  if (upper != nullptr) {
+    uint32_t encoded_size = SerializeFromKey(index_key, *upper, INVALID_ROWID);
+    iter.SetUpperBound(index_key, encoded_size, upper_inclusive);
+  }
+  free(index_key);
+  return iter;
 }
\ No newline at end of file
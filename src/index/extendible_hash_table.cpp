@@ -0,0 +1,477 @@
+#include "index/extendible_hash_table.h"
+
+#include "glog/logging.h"
+#include "page/index_roots_page.h"
+
+ExtendibleHashTable::ExtendibleHashTable(index_id_t index_id, BufferPoolManager *buffer_pool_manager,
+                                         const KeyManager &km, bool unique)
+    : index_id_(index_id), buffer_pool_manager_(buffer_pool_manager), processor_(km), unique_(unique) {
+  Page *header = FetchPage(INDEX_ROOTS_PAGE_ID);
+  page_id_t directory_page_id = INVALID_PAGE_ID;
+  header->RLatch();
+  reinterpret_cast<IndexRootsPage *>(header->GetData())->GetRootId(index_id, &directory_page_id);
+  header->RUnlatch();
+  directory_page_id_ = directory_page_id;
+  buffer_pool_manager_->UnpinPage(INDEX_ROOTS_PAGE_ID, false);
+}
+
+uint32_t ExtendibleHashTable::Hash(const GenericKey *key) const {
+  // FNV-1a over the encoded key, then a murmur finalizer so that the lowest bits depend on every byte.
+  auto *bytes = reinterpret_cast<const unsigned char *>(key);
+  uint32_t hash = 2166136261u;
+  for (int i = 0; i < processor_.GetKeySize(); i++) {
+    hash = (hash ^ bytes[i]) * 16777619u;
+  }
+  hash ^= hash >> 16;
+  hash *= 0x85ebca6bu;
+  hash ^= hash >> 13;
+  hash *= 0xc2b2ae35u;
+  hash ^= hash >> 16;
+  return hash;
+}
+
+Page *ExtendibleHashTable::FetchPage(page_id_t page_id) {
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  if (page == nullptr) throw("Out of memory");
+  return page;
+}
+
+Page *ExtendibleHashTable::NewPage(page_id_t &page_id) {
+  Page *page = buffer_pool_manager_->NewPage(page_id, &page_run_);
+  if (page == nullptr) throw("Out of memory");
+  return page;
+}
+
+bool ExtendibleHashTable::Matches(BucketPage *page, int index, const GenericKey *key, const RowId &value) const {
+  if (processor_.CompareKeys(page->KeyAt(index), key) != 0) {
+    return false;
+  }
+  return unique_ || page->ValueAt(index) == value;
+}
+
+bool ExtendibleHashTable::Insert(const GenericKey *key, const RowId &value) {
+  table_latch_.RLock();
+  if (directory_page_id_ == INVALID_PAGE_ID) {
+    table_latch_.RUnlock();
+    return InsertExclusive(key, value);
+  }
+  Page *directory_page = FetchPage(directory_page_id_);
+  auto *directory = reinterpret_cast<DirectoryPage *>(directory_page->GetData());
+  page_id_t bucket_page_id = directory->GetBucketPageId(directory->HashToSlot(Hash(key)));
+  Page *page = FetchPage(bucket_page_id);
+  page->WLatch();
+  int result = InsertIntoBucket(reinterpret_cast<BucketPage *>(page->GetData()), key, value);
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(bucket_page_id, result == 1);
+  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  table_latch_.RUnlock();
+  if (result != -1) {
+    return result == 1;
+  }
+  // The bucket is full, retry with the whole table to split it.
+  return InsertExclusive(key, value);
+}
+
+int ExtendibleHashTable::InsertIntoBucket(BucketPage *bucket, const GenericKey *key, const RowId &value) {
+  bool found = false, has_room = false;
+  BucketPage *page = bucket;
+  while (true) {
+    for (int i = 0; i < page->GetSize() && !found; i++) {
+      found = Matches(page, i, key, value);
+    }
+    has_room = has_room || !page->IsFull();
+    page_id_t next_page_id = page->GetNextPageId();
+    if (page != bucket) {
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    }
+    if (found || next_page_id == INVALID_PAGE_ID) {
+      break;
+    }
+    page = reinterpret_cast<BucketPage *>(FetchPage(next_page_id)->GetData());
+  }
+  if (found) {
+    return 0;
+  }
+  if (!has_room) {
+    return -1;
+  }
+  AppendToBucket(bucket, key, value);
+  return 1;
+}
+
+void ExtendibleHashTable::AppendToBucket(BucketPage *bucket, const GenericKey *key, const RowId &value) {
+  BucketPage *page = bucket;
+  while (page->IsFull()) {
+    page_id_t next_page_id = page->GetNextPageId();
+    bool dirty = false;
+    BucketPage *next;
+    if (next_page_id == INVALID_PAGE_ID) {
+      next = reinterpret_cast<BucketPage *>(NewPage(next_page_id)->GetData());
+      next->Init(next_page_id, processor_.GetKeySize());
+      page->SetNextPageId(next_page_id);
+      dirty = true;
+    } else {
+      next = reinterpret_cast<BucketPage *>(FetchPage(next_page_id)->GetData());
+    }
+    if (page != bucket) {
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), dirty);
+    }
+    page = next;
+  }
+  page->Append(key, value);
+  if (page != bucket) {
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+  }
+}
+
+bool ExtendibleHashTable::InsertExclusive(const GenericKey *key, const RowId &value) {
+  table_latch_.WLock();
+  if (directory_page_id_ == INVALID_PAGE_ID) {
+    page_id_t bucket_page_id, directory_page_id;
+    Page *bucket_page = NewPage(bucket_page_id);
+    reinterpret_cast<BucketPage *>(bucket_page->GetData())->Init(bucket_page_id, processor_.GetKeySize());
+    buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+    Page *directory_page = NewPage(directory_page_id);
+    reinterpret_cast<DirectoryPage *>(directory_page->GetData())->Init(directory_page_id, bucket_page_id);
+    buffer_pool_manager_->UnpinPage(directory_page_id, true);
+    directory_page_id_ = directory_page_id;
+    UpdateRootPageId(1);
+  }
+  Page *directory_page = FetchPage(directory_page_id_);
+  auto *directory = reinterpret_cast<DirectoryPage *>(directory_page->GetData());
+  uint32_t hash = Hash(key);
+  bool directory_dirty = false;
+  int result;
+  while (true) {
+    uint32_t slot = directory->HashToSlot(hash);
+    page_id_t bucket_page_id = directory->GetBucketPageId(slot);
+    auto *bucket = reinterpret_cast<BucketPage *>(FetchPage(bucket_page_id)->GetData());
+    result = InsertIntoBucket(bucket, key, value);
+    if (result != -1) {
+      buffer_pool_manager_->UnpinPage(bucket_page_id, result == 1);
+      break;
+    }
+    uint32_t local_depth = directory->GetLocalDepth(slot);
+    if (local_depth < HASH_TABLE_DIRECTORY_MAX_DEPTH && SplitSeparates(bucket, hash) &&
+        (local_depth < directory->GetGlobalDepth() || directory->IncrGlobalDepth())) {
+      SplitBucket(directory, slot, bucket);
+      buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+      directory_dirty = true;
+      continue;
+    }
+    // No split can tell the keys apart, keep them together in an overflow page.
+    AppendToBucket(bucket, key, value);
+    buffer_pool_manager_->UnpinPage(bucket_page_id, true);
+    result = 1;
+    break;
+  }
+  buffer_pool_manager_->UnpinPage(directory_page_id_, directory_dirty);
+  table_latch_.WUnlock();
+  return result == 1;
+}
+
+bool ExtendibleHashTable::SplitSeparates(BucketPage *bucket, uint32_t hash) {
+  const uint32_t mask = HASH_TABLE_DIRECTORY_ARRAY_SIZE - 1;
+  bool separates = false;
+  BucketPage *page = bucket;
+  while (true) {
+    for (int i = 0; i < page->GetSize() && !separates; i++) {
+      separates = ((Hash(page->KeyAt(i)) ^ hash) & mask) != 0;
+    }
+    page_id_t next_page_id = page->GetNextPageId();
+    if (page != bucket) {
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    }
+    if (separates || next_page_id == INVALID_PAGE_ID) {
+      return separates;
+    }
+    page = reinterpret_cast<BucketPage *>(FetchPage(next_page_id)->GetData());
+  }
+}
+
+void ExtendibleHashTable::SplitBucket(DirectoryPage *directory, uint32_t slot, BucketPage *bucket) {
+  uint32_t local_depth = directory->GetLocalDepth(slot);
+  uint32_t high_bit = 1u << local_depth;
+  // Take every pair out of the bucket, dropping its overflow pages.
+  std::vector<page_id_t> page_ids;
+  CollectBucketPages(bucket->GetPageId(), page_ids);
+  size_t pair_size = processor_.GetKeySize() + sizeof(RowId);
+  std::vector<char> pairs;
+  for (page_id_t page_id : page_ids) {
+    auto *page = reinterpret_cast<BucketPage *>(FetchPage(page_id)->GetData());
+    for (int i = 0; i < page->GetSize(); i++) {
+      size_t offset = pairs.size();
+      pairs.resize(offset + pair_size);
+      memcpy(pairs.data() + offset, page->KeyAt(i), processor_.GetKeySize());
+      *reinterpret_cast<RowId *>(pairs.data() + offset + processor_.GetKeySize()) = page->ValueAt(i);
+    }
+    buffer_pool_manager_->UnpinPage(page_id, false);
+  }
+  bucket->Clear();
+  bucket->SetNextPageId(INVALID_PAGE_ID);
+  page_ids.erase(page_ids.begin());
+  buffer_pool_manager_->DeletePages(page_ids);
+  // The keys with the new bit set move to the image.
+  page_id_t image_page_id;
+  Page *image_page = NewPage(image_page_id);
+  auto *image = reinterpret_cast<BucketPage *>(image_page->GetData());
+  image->Init(image_page_id, processor_.GetKeySize());
+  for (size_t offset = 0; offset < pairs.size(); offset += pair_size) {
+    auto *key = reinterpret_cast<GenericKey *>(pairs.data() + offset);
+    auto value = *reinterpret_cast<RowId *>(pairs.data() + offset + processor_.GetKeySize());
+    AppendToBucket((Hash(key) & high_bit) ? image : bucket, key, value);
+  }
+  buffer_pool_manager_->UnpinPage(image_page_id, true);
+  for (uint32_t i = 0; i < directory->Size(); i++) {
+    if ((i & (high_bit - 1)) == (slot & (high_bit - 1))) {
+      directory->SetLocalDepth(i, local_depth + 1);
+      if (i & high_bit) {
+        directory->SetBucketPageId(i, image_page_id);
+      }
+    }
+  }
+}
+
+void ExtendibleHashTable::Remove(const GenericKey *key, const RowId &value) {
+  table_latch_.RLock();
+  if (directory_page_id_ == INVALID_PAGE_ID) {
+    table_latch_.RUnlock();
+    return;
+  }
+  Page *directory_page = FetchPage(directory_page_id_);
+  auto *directory = reinterpret_cast<DirectoryPage *>(directory_page->GetData());
+  page_id_t bucket_page_id = directory->GetBucketPageId(directory->HashToSlot(Hash(key)));
+  Page *bucket_page = FetchPage(bucket_page_id);
+  bucket_page->WLatch();
+  std::vector<page_id_t> page_ids;
+  CollectBucketPages(bucket_page_id, page_ids);
+  BucketPage *page = nullptr;
+  int index = -1;
+  for (page_id_t page_id : page_ids) {
+    page = reinterpret_cast<BucketPage *>(FetchPage(page_id)->GetData());
+    for (int i = 0; i < page->GetSize() && index < 0; i++) {
+      if (Matches(page, i, key, value)) index = i;
+    }
+    if (index >= 0) break;
+    buffer_pool_manager_->UnpinPage(page_id, false);
+  }
+  bool empty = false;
+  if (index >= 0) {
+    // Fill the hole with the last pair of the bucket, so that only its last page can become empty.
+    page_id_t last_page_id = page_ids.back();
+    auto *last = last_page_id == page->GetPageId()
+                     ? page
+                     : reinterpret_cast<BucketPage *>(FetchPage(last_page_id)->GetData());
+    page->ReplaceWithLastOf(index, last);
+    bool drop_last = last->GetSize() == 0 && page_ids.size() > 1;
+    empty = last->GetSize() == 0 && page_ids.size() == 1;
+    if (last != page) {
+      buffer_pool_manager_->UnpinPage(last_page_id, true);
+    }
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), true);
+    if (drop_last) {
+      page_id_t prev_page_id = page_ids[page_ids.size() - 2];
+      Page *prev = FetchPage(prev_page_id);
+      reinterpret_cast<BucketPage *>(prev->GetData())->SetNextPageId(INVALID_PAGE_ID);
+      buffer_pool_manager_->UnpinPage(prev_page_id, true);
+      buffer_pool_manager_->DeletePage(last_page_id);
+    }
+  }
+  bucket_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(bucket_page_id, index >= 0);
+  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  table_latch_.RUnlock();
+  if (empty) {
+    MergeEmptyBuckets(key);
+  }
+}
+
+void ExtendibleHashTable::MergeEmptyBuckets(const GenericKey *key) {
+  table_latch_.WLock();
+  if (directory_page_id_ == INVALID_PAGE_ID) {
+    table_latch_.WUnlock();
+    return;
+  }
+  Page *directory_page = FetchPage(directory_page_id_);
+  auto *directory = reinterpret_cast<DirectoryPage *>(directory_page->GetData());
+  uint32_t hash = Hash(key);
+  bool directory_dirty = false;
+  while (true) {
+    uint32_t slot = directory->HashToSlot(hash);
+    uint32_t local_depth = directory->GetLocalDepth(slot);
+    uint32_t image_slot = directory->GetSplitImageSlot(slot);
+    if (local_depth == 0 || directory->GetLocalDepth(image_slot) != local_depth) {
+      break;
+    }
+    // Merge whichever of the two buckets is empty into the other one.
+    page_id_t bucket_page_id = directory->GetBucketPageId(slot);
+    page_id_t image_page_id = directory->GetBucketPageId(image_slot);
+    auto is_empty = [this](page_id_t page_id) {
+      auto *page = reinterpret_cast<BucketPage *>(FetchPage(page_id)->GetData());
+      bool empty = page->GetSize() == 0 && page->GetNextPageId() == INVALID_PAGE_ID;
+      buffer_pool_manager_->UnpinPage(page_id, false);
+      return empty;
+    };
+    page_id_t dropped, kept;
+    if (is_empty(bucket_page_id)) {
+      dropped = bucket_page_id, kept = image_page_id;
+    } else if (is_empty(image_page_id)) {
+      dropped = image_page_id, kept = bucket_page_id;
+    } else {
+      break;
+    }
+    for (uint32_t i = 0; i < directory->Size(); i++) {
+      page_id_t page_id = directory->GetBucketPageId(i);
+      if (page_id == dropped || page_id == kept) {
+        directory->SetBucketPageId(i, kept);
+        directory->SetLocalDepth(i, local_depth - 1);
+      }
+    }
+    buffer_pool_manager_->DeletePage(dropped);
+    while (directory->TryDecrGlobalDepth()) {
+    }
+    directory_dirty = true;
+  }
+  buffer_pool_manager_->UnpinPage(directory_page_id_, directory_dirty);
+  table_latch_.WUnlock();
+}
+
+bool ExtendibleHashTable::GetValue(const GenericKey *key, std::vector<RowId> &result) {
+  table_latch_.RLock();
+  if (directory_page_id_ == INVALID_PAGE_ID) {
+    table_latch_.RUnlock();
+    return false;
+  }
+  Page *directory_page = FetchPage(directory_page_id_);
+  auto *directory = reinterpret_cast<DirectoryPage *>(directory_page->GetData());
+  page_id_t bucket_page_id = directory->GetBucketPageId(directory->HashToSlot(Hash(key)));
+  Page *bucket_page = FetchPage(bucket_page_id);
+  bucket_page->RLatch();
+  auto *bucket = reinterpret_cast<BucketPage *>(bucket_page->GetData());
+  bool found = false;
+  BucketPage *page = bucket;
+  while (true) {
+    for (int i = 0; i < page->GetSize(); i++) {
+      if (processor_.CompareKeys(page->KeyAt(i), key) == 0) {
+        result.push_back(page->ValueAt(i));
+        found = true;
+      }
+    }
+    page_id_t next_page_id = page->GetNextPageId();
+    if (page != bucket) {
+      buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+    }
+    // A unique table holds the key once.
+    if ((found && unique_) || next_page_id == INVALID_PAGE_ID) {
+      break;
+    }
+    page = reinterpret_cast<BucketPage *>(FetchPage(next_page_id)->GetData());
+  }
+  bucket_page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  table_latch_.RUnlock();
+  return found;
+}
+
+void ExtendibleHashTable::ForEach(const std::function<void(GenericKey *key, const RowId &value)> &visit) {
+  table_latch_.RLock();
+  if (directory_page_id_ == INVALID_PAGE_ID) {
+    table_latch_.RUnlock();
+    return;
+  }
+  Page *directory_page = FetchPage(directory_page_id_);
+  auto *directory = reinterpret_cast<DirectoryPage *>(directory_page->GetData());
+  for (uint32_t slot = 0; slot < directory->Size(); slot++) {
+    // A bucket is shared by the slots agreeing on its local depth bits, visit it from the lowest one.
+    if (slot >= (1u << directory->GetLocalDepth(slot))) {
+      continue;
+    }
+    page_id_t page_id = directory->GetBucketPageId(slot);
+    Page *bucket_page = FetchPage(page_id);
+    bucket_page->RLatch();
+    std::vector<page_id_t> page_ids;
+    CollectBucketPages(page_id, page_ids);
+    for (page_id_t id : page_ids) {
+      auto *page = reinterpret_cast<BucketPage *>(FetchPage(id)->GetData());
+      for (int i = 0; i < page->GetSize(); i++) {
+        visit(page->KeyAt(i), page->ValueAt(i));
+      }
+      buffer_pool_manager_->UnpinPage(id, false);
+    }
+    bucket_page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+  }
+  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  table_latch_.RUnlock();
+}
+
+void ExtendibleHashTable::CollectBucketPages(page_id_t bucket_page_id, std::vector<page_id_t> &page_ids) {
+  page_id_t page_id = bucket_page_id;
+  while (page_id != INVALID_PAGE_ID) {
+    page_ids.push_back(page_id);
+    Page *page = FetchPage(page_id);
+    page_id_t next_page_id = reinterpret_cast<BucketPage *>(page->GetData())->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+}
+
+void ExtendibleHashTable::Destroy() {
+  table_latch_.WLock();
+  if (directory_page_id_ != INVALID_PAGE_ID) {
+    std::vector<page_id_t> page_ids;
+    Page *directory_page = FetchPage(directory_page_id_);
+    auto *directory = reinterpret_cast<DirectoryPage *>(directory_page->GetData());
+    for (uint32_t slot = 0; slot < directory->Size(); slot++) {
+      if (slot < (1u << directory->GetLocalDepth(slot))) {
+        CollectBucketPages(directory->GetBucketPageId(slot), page_ids);
+      }
+    }
+    buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+    page_ids.push_back(directory_page_id_);
+    buffer_pool_manager_->DeletePages(page_ids);
+    directory_page_id_ = INVALID_PAGE_ID;
+    Page *header = FetchPage(INDEX_ROOTS_PAGE_ID);
+    header->WLatch();
+    reinterpret_cast<IndexRootsPage *>(header->GetData())->Delete(index_id_);
+    header->WUnlatch();
+    buffer_pool_manager_->UnpinPage(INDEX_ROOTS_PAGE_ID, true);
+  }
+  buffer_pool_manager_->ReleasePageRun(&page_run_);
+  table_latch_.WUnlock();
+}
+
+uint32_t ExtendibleHashTable::GetGlobalDepth() {
+  table_latch_.RLock();
+  uint32_t global_depth = 0;
+  if (directory_page_id_ != INVALID_PAGE_ID) {
+    Page *directory_page = FetchPage(directory_page_id_);
+    global_depth = reinterpret_cast<DirectoryPage *>(directory_page->GetData())->GetGlobalDepth();
+    buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  }
+  table_latch_.RUnlock();
+  return global_depth;
+}
+
+/*
+ * Insert the directory page id into the header page, the directory never moves afterwards.
+ */
+void ExtendibleHashTable::UpdateRootPageId(int insert_record) {
+  Page *header = FetchPage(INDEX_ROOTS_PAGE_ID);
+  header->WLatch();
+  auto *root_page = reinterpret_cast<IndexRootsPage *>(header->GetData());
+  if (insert_record == 0 || !root_page->Insert(index_id_, directory_page_id_)) {
+    root_page->Update(index_id_, directory_page_id_);
+  }
+  header->WUnlatch();
+  buffer_pool_manager_->UnpinPage(INDEX_ROOTS_PAGE_ID, true);
+}
+
+bool ExtendibleHashTable::Check() {
+  bool all_unpinned = buffer_pool_manager_->CheckAllUnpinned();
+  if (!all_unpinned) {
+    LOG(ERROR) << "problem in page unpin" << std::endl;
+  }
+  return all_unpinned;
+}
@@ -0,0 +1,218 @@
+#include "index/external_sorter.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <numeric>
+#include <thread>
+
+#include "glog/logging.h"
+
+ExternalSorter::ExternalSorter(size_t key_size, size_t memory_budget, size_t num_threads)
+    : key_size_(key_size),
+      record_size_(key_size + sizeof(int64_t)),
+      memory_budget_(memory_budget),
+      num_threads_(std::max<size_t>(num_threads, 1)) {
+  // Every buffered record also takes a position in order_.
+  buffer_capacity_ = std::max<size_t>(memory_budget_ / (record_size_ + sizeof(uint32_t)), 1);
+}
+
+ExternalSorter::~ExternalSorter() {
+  if (file_ != nullptr) {
+    std::fclose(file_);
+  }
+}
+
+void ExternalSorter::Add(const GenericKey *key, RowId row_id) {
+  ASSERT(!sorted_, "Pairs added after sorting.");
+  if (failed_) {
+    return;
+  }
+  if (buffer_.size() / record_size_ >= buffer_capacity_) {
+    SpillRun();
+  }
+  size_t offset = buffer_.size();
+  buffer_.resize(offset + record_size_);
+  int64_t value = row_id.Get();
+  memcpy(buffer_.data() + offset, key, key_size_);
+  memcpy(buffer_.data() + offset + key_size_, &value, sizeof(value));
+}
+
+void ExternalSorter::Sort() {
+  sorted_ = true;
+  if (failed_) {
+    return;
+  }
+  if (runs_.empty()) {
+    // Everything fit into memory, merge the sorted slices of the buffer directly.
+    sources_ = SortSlices();
+  } else {
+    if (!buffer_.empty()) {
+      SpillRun();
+    }
+    std::vector<char>().swap(buffer_);
+    std::vector<uint32_t>().swap(order_);
+    if (failed_ || std::fflush(file_) != 0) {
+      LOG(ERROR) << "Failed to write a sort run: " << strerror(errno);
+      failed_ = true;
+      return;
+    }
+    // Share the memory budget between the runs, with at least a page for each.
+    size_t run_buffer_size = std::max<size_t>(memory_budget_ / runs_.size(), PAGE_SIZE);
+    run_buffer_size = std::max<size_t>(run_buffer_size / record_size_, 1) * record_size_;
+    sources_.resize(runs_.size());
+    for (size_t i = 0; i < runs_.size(); i++) {
+      sources_[i].buffer.resize(run_buffer_size);
+      sources_[i].file_offset = runs_[i].first;
+      sources_[i].file_end = runs_[i].first + runs_[i].second;
+      Refill(sources_[i]);
+    }
+  }
+  StartMerge();
+}
+
+bool ExternalSorter::Next(GenericKey *key, RowId *row_id) {
+  ASSERT(sorted_, "Pairs read before sorting.");
+  if (failed_ || heap_.empty()) {
+    return false;
+  }
+  record_.resize(record_size_);
+  PopMin(record_.data());
+  int64_t value;
+  memcpy(key, record_.data(), key_size_);
+  memcpy(&value, record_.data() + key_size_, sizeof(value));
+  *row_id = RowId(value);
+  return true;
+}
+
+bool ExternalSorter::Less(const char *lhs, const char *rhs) const {
+  int result = memcmp(lhs, rhs, key_size_);
+  if (result != 0) {
+    return result < 0;
+  }
+  int64_t lhs_value, rhs_value;
+  memcpy(&lhs_value, lhs + key_size_, sizeof(int64_t));
+  memcpy(&rhs_value, rhs + key_size_, sizeof(int64_t));
+  return lhs_value < rhs_value;
+}
+
+std::vector<ExternalSorter::Source> ExternalSorter::SortSlices() {
+  size_t num_records = buffer_.size() / record_size_;
+  order_.resize(num_records);
+  std::iota(order_.begin(), order_.end(), 0);
+  size_t num_slices = std::max<size_t>(std::min(num_threads_, num_records), 1);
+  size_t slice_size = (num_records + num_slices - 1) / num_slices;
+  auto sort_slice = [this](size_t begin, size_t end) {
+    std::sort(order_.begin() + begin, order_.begin() + end,
+              [this](uint32_t lhs, uint32_t rhs) { return Less(RecordAt(lhs), RecordAt(rhs)); });
+  };
+  std::vector<std::thread> threads;
+  for (size_t begin = slice_size; begin < num_records; begin += slice_size) {
+    threads.emplace_back(sort_slice, begin, std::min(begin + slice_size, num_records));
+  }
+  sort_slice(0, std::min(slice_size, num_records));
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::vector<Source> slices;
+  for (size_t begin = 0; begin < num_records; begin += slice_size) {
+    Source slice;
+    slice.order = order_.data() + begin;
+    slice.order_end = order_.data() + std::min(begin + slice_size, num_records);
+    slice.current = RecordAt(*slice.order);
+    slices.push_back(std::move(slice));
+  }
+  return slices;
+}
+
+void ExternalSorter::SpillRun() {
+  if (file_ == nullptr) {
+    file_ = std::tmpfile();
+    if (file_ == nullptr) {
+      LOG(WARNING) << "Failed to create a temporary file for sorting, sorting in memory: " << strerror(errno);
+      buffer_capacity_ = SIZE_MAX;
+      return;
+    }
+  }
+  sources_ = SortSlices();
+  StartMerge();
+  size_t run_size = 0;
+  std::vector<char> out(std::max<size_t>(PAGE_SIZE / record_size_, 1) * record_size_);
+  size_t out_size = 0;
+  while (!heap_.empty()) {
+    PopMin(out.data() + out_size);
+    out_size += record_size_;
+    if (out_size == out.size() || heap_.empty()) {
+      if (!failed_ && std::fwrite(out.data(), 1, out_size, file_) != out_size) {
+        LOG(ERROR) << "Failed to write a sort run: " << strerror(errno);
+        failed_ = true;
+      }
+      run_size += out_size;
+      out_size = 0;
+    }
+  }
+  runs_.emplace_back(file_size_, run_size);
+  file_size_ += run_size;
+  sources_.clear();
+  buffer_.clear();
+}
+
+void ExternalSorter::Advance(Source &source) {
+  if (source.order != nullptr) {
+    source.order++;
+    source.current = source.order < source.order_end ? RecordAt(*source.order) : nullptr;
+    return;
+  }
+  source.current += record_size_;
+  if (source.current == source.end) {
+    Refill(source);
+  }
+}
+
+void ExternalSorter::Refill(Source &source) {
+  size_t size = std::min(source.buffer.size(), source.file_end - source.file_offset);
+  ssize_t result = 0;
+  if (size > 0) {
+    do {
+      result = pread(fileno(file_), source.buffer.data(), size, static_cast<off_t>(source.file_offset));
+    } while (result < 0 && errno == EINTR);
+  }
+  if (result <= 0 || static_cast<size_t>(result) % record_size_ != 0) {
+    if (size > 0) {
+      LOG(ERROR) << "Failed to read a sort run: " << (result < 0 ? strerror(errno) : "short read");
+      failed_ = true;
+    }
+    source.current = nullptr;
+    return;
+  }
+  source.file_offset += result;
+  source.current = source.buffer.data();
+  source.end = source.current + result;
+}
+
+void ExternalSorter::StartMerge() {
+  heap_.clear();
+  for (auto &source : sources_) {
+    if (source.current != nullptr) {
+      heap_.push_back(&source);
+    }
+  }
+  auto greater = [this](Source *lhs, Source *rhs) { return Less(rhs->current, lhs->current); };
+  std::make_heap(heap_.begin(), heap_.end(), greater);
+}
+
+void ExternalSorter::PopMin(char *record) {
+  auto greater = [this](Source *lhs, Source *rhs) { return Less(rhs->current, lhs->current); };
+  std::pop_heap(heap_.begin(), heap_.end(), greater);
+  Source *source = heap_.back();
+  // The head of a run may be overwritten when the run is refilled.
+  memcpy(record, source->current, record_size_);
+  Advance(*source);
+  if (source->current == nullptr) {
+    heap_.pop_back();
+  } else {
+    std::push_heap(heap_.begin(), heap_.end(), greater);
+  }
+}
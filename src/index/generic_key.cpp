@@ -0,0 +1,148 @@
+#include "index/generic_key.h"
+
+#include <algorithm>
+#include <string>
+
+static constexpr char KEY_NULL_MARKER = 0;
+static constexpr char KEY_NOT_NULL_MARKER = 1;
+static constexpr char KEY_CHAR_ESCAPE = static_cast<char>(0xff);
+static constexpr uint32_t KEY_CHAR_TERMINATOR_SIZE = 2;
+
+static inline void WriteBigEndian32(char *buf, uint32_t value) {
+  for (int i = 3; i >= 0; i--) {
+    buf[i] = static_cast<char>(value & 0xff);
+    value >>= 8;
+  }
+}
+
+static inline uint32_t ReadBigEndian32(const char *buf) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; i++) {
+    value = (value << 8) | static_cast<uint8_t>(buf[i]);
+  }
+  return value;
+}
+
+/**
+ * @return the largest payload of a column, excluding the null marker
+ */
+static inline uint32_t GetMaxPayloadSize(const Column *column) {
+  if (column->GetType() == TypeId::kTypeChar) {
+    // Every byte may be an escaped zero.
+    return 2 * column->GetLength() + KEY_CHAR_TERMINATOR_SIZE;
+  }
+  return Type::GetTypeSize(column->GetType());
+}
+
+uint32_t KeyManager::GetEncodedSize(const Schema *schema) {
+  uint32_t size = 0;
+  for (auto column : schema->GetColumns()) {
+    size += 1 + GetMaxPayloadSize(column);
+  }
+  return size;
+}
+
+uint32_t KeyManager::SerializeFromKey(GenericKey *key_buf, const Row &key, Schema *schema) const {
+  ASSERT(key.GetFieldCount() == schema->GetColumnCount(), "field nums not match.");
+  // The tail stays zero, so that equal keys are equal byte for byte.
+  memset(key_buf->data, 0, key_size_);
+  char *buf = key_buf->data;
+  for (uint32_t i = 0; i < schema->GetColumnCount(); i++) {
+    const Column *column = schema->GetColumn(i);
+    const Field *field = key.GetField(i);
+    ASSERT(buf + 1 + (column->GetType() == TypeId::kTypeChar ? 0 : Type::GetTypeSize(column->GetType())) <=
+               key_buf->data + key_size_,
+           "Index key size exceed max key size.");
+    *buf++ = field->IsNull() ? KEY_NULL_MARKER : KEY_NOT_NULL_MARKER;
+    if (field->IsNull()) {
+      continue;
+    }
+    switch (column->GetType()) {
+      case TypeId::kTypeInt: {
+        int32_t value;
+        field->SerializeTo(reinterpret_cast<char *>(&value));
+        WriteBigEndian32(buf, static_cast<uint32_t>(value) ^ 0x80000000u);
+        buf += sizeof(value);
+        break;
+      }
+      case TypeId::kTypeFloat: {
+        float value;
+        field->SerializeTo(reinterpret_cast<char *>(&value));
+        uint32_t bits = 0;
+        if (value != 0.0f) {  // -0.0 and 0.0 are equal
+          memcpy(&bits, &value, sizeof(bits));
+        }
+        WriteBigEndian32(buf, (bits & 0x80000000u) ? ~bits : bits | 0x80000000u);
+        buf += sizeof(value);
+        break;
+      }
+      case TypeId::kTypeChar: {
+        uint32_t length = field->GetLength();
+        ASSERT(length <= column->GetLength(), "Index key exceeds the column length.");
+        const char *data = field->GetData();
+        ASSERT(buf + length + std::count(data, data + length, 0) + KEY_CHAR_TERMINATOR_SIZE <= key_buf->data + key_size_,
+               "Index key size exceed max key size.");
+        for (uint32_t j = 0; j < length; j++) {
+          *buf++ = data[j];
+          if (data[j] == 0) {
+            *buf++ = KEY_CHAR_ESCAPE;
+          }
+        }
+        // The terminator is left by the memset, it sorts before any escaped or non zero byte.
+        buf += KEY_CHAR_TERMINATOR_SIZE;
+        break;
+      }
+      default:
+        ASSERT(false, "Unsupported index key type.");
+    }
+  }
+  return buf - key_buf->data;
+}
+
+void KeyManager::DeserializeToKey(const GenericKey *key_buf, Row &key, Schema *schema) const {
+  ASSERT(key.GetFieldCount() == 0, "Non empty field in row.");
+  const char *buf = key_buf->data;
+  auto &fields = key.GetFields();
+  for (uint32_t i = 0; i < schema->GetColumnCount(); i++) {
+    const Column *column = schema->GetColumn(i);
+    bool is_null = *buf++ == KEY_NULL_MARKER;
+    switch (column->GetType()) {
+      case TypeId::kTypeInt:
+        if (is_null) {
+          fields.push_back(new Field(TypeId::kTypeInt));
+        } else {
+          fields.push_back(new Field(TypeId::kTypeInt, static_cast<int32_t>(ReadBigEndian32(buf) ^ 0x80000000u)));
+          buf += sizeof(int32_t);
+        }
+        break;
+      case TypeId::kTypeFloat:
+        if (is_null) {
+          fields.push_back(new Field(TypeId::kTypeFloat));
+        } else {
+          uint32_t bits = ReadBigEndian32(buf);
+          bits = (bits & 0x80000000u) ? bits & ~0x80000000u : ~bits;
+          float value;
+          memcpy(&value, &bits, sizeof(value));
+          fields.push_back(new Field(TypeId::kTypeFloat, value));
+          buf += sizeof(float);
+        }
+        break;
+      case TypeId::kTypeChar:
+        if (is_null) {
+          fields.push_back(new Field(TypeId::kTypeChar, nullptr, 0, false));
+        } else {
+          std::string value;
+          while (buf[0] != 0 || buf[1] != 0) {
+            value.push_back(*buf);
+            buf += buf[0] == 0 ? 2 : 1;
+          }
+          buf += KEY_CHAR_TERMINATOR_SIZE;
+          fields.push_back(new Field(TypeId::kTypeChar, const_cast<char *>(value.data()), value.size(), true));
+        }
+        break;
+      default:
+        ASSERT(false, "Unsupported index key type.");
+    }
+  }
+  ASSERT(buf - key_buf->data <= key_size_, "Index key size exceed max key size.");
+}
@@ -0,0 +1,54 @@
+#include "index/hash_index.h"
+
+HashIndex::HashIndex(index_id_t index_id, IndexSchema *key_schema, size_t key_size,
+                     BufferPoolManager *buffer_pool_manager, bool unique)
+    : Index(index_id, key_schema, unique),
+      processor_(key_schema_, key_size),
+      container_(index_id, buffer_pool_manager, processor_, unique) {}
+
+dberr_t HashIndex::InsertEntry(const Row &key, RowId row_id, [[maybe_unused]] Txn *txn) {
+  GenericKey *index_key = processor_.InitKey();
+  processor_.SerializeFromKey(index_key, key, key_schema_);
+  bool status = container_.Insert(index_key, row_id);
+  free(index_key);
+  if (!status) {
+    return DB_FAILED;
+  }
+  return DB_SUCCESS;
+}
+
+dberr_t HashIndex::RemoveEntry(const Row &key, RowId row_id, [[maybe_unused]] Txn *txn) {
+  GenericKey *index_key = processor_.InitKey();
+  processor_.SerializeFromKey(index_key, key, key_schema_);
+  container_.Remove(index_key, row_id);
+  free(index_key);
+  return DB_SUCCESS;
+}
+
+dberr_t HashIndex::ScanKey(const Row &key, vector<RowId> &result, [[maybe_unused]] Txn *txn, string compare_operator) {
+  GenericKey *index_key = processor_.InitKey();
+  processor_.SerializeFromKey(index_key, key, key_schema_);
+  if (compare_operator == "=") {
+    container_.GetValue(index_key, result);
+  } else {
+    // The encoded keys compare like the keys, but the table has to be read in full.
+    container_.ForEach([&](GenericKey *entry_key, const RowId &value) {
+      int cmp = processor_.CompareKeys(entry_key, index_key);
+      if ((compare_operator == "<" && cmp < 0) || (compare_operator == "<=" && cmp <= 0) ||
+          (compare_operator == ">" && cmp > 0) || (compare_operator == ">=" && cmp >= 0) ||
+          (compare_operator == "<>" && cmp != 0)) {
+        result.push_back(value);
+      }
+    });
+  }
+  free(index_key);
+  if (!result.empty())
+    return DB_SUCCESS;
+  else
+    return DB_KEY_NOT_FOUND;
+}
+
+dberr_t HashIndex::Destroy() {
+  container_.Destroy();
+  return DB_SUCCESS;
+}
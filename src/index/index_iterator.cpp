@@ -5,21 +5,52 @@
 
 IndexIterator::IndexIterator() = default;
 
-IndexIterator::IndexIterator(page_id_t page_id, BufferPoolManager *bpm, int index)
-    : current_page_id(page_id), item_index(index), buffer_pool_manager(bpm) {
-  page = reinterpret_cast<LeafPage *>(buffer_pool_manager->FetchPage(current_page_id)->GetData());
+IndexIterator::IndexIterator(Page *page, BufferPoolManager *bpm, int index)
+    : current_page_id(page->GetPageId()), raw_page(page), item_index(index), buffer_pool_manager(bpm) {
+  this->page = reinterpret_cast<LeafPage *>(raw_page->GetData());
+  SkipExhaustedLeaves();
 }
 
-IndexIterator::~IndexIterator() {
-  if (current_page_id != INVALID_PAGE_ID)
+IndexIterator::IndexIterator(IndexIterator &&other) noexcept { *this = std::move(other); }
+
+IndexIterator &IndexIterator::operator=(IndexIterator &&other) noexcept {
+  if (this != &other) {
+    Release();
+    current_page_id = other.current_page_id;
+    raw_page = other.raw_page;
+    page = other.page;
+    item_index = other.item_index;
+    buffer_pool_manager = other.buffer_pool_manager;
+    key_buffer = std::move(other.key_buffer);
+    upper_bound = std::move(other.upper_bound);
+    upper_inclusive = other.upper_inclusive;
+    other.current_page_id = INVALID_PAGE_ID;
+    other.raw_page = nullptr;
+    other.page = nullptr;
+    other.item_index = 0;
+  }
+  return *this;
+}
+
+IndexIterator::~IndexIterator() { Release(); }
+
+void IndexIterator::Release() {
+  if (raw_page != nullptr) {
+    raw_page->RUnlatch();
     buffer_pool_manager->UnpinPage(current_page_id, false);
+    raw_page = nullptr;
+    page = nullptr;
+  }
 }
 
 /**
  * TODO: Student Implement
  */
 std::pair<GenericKey *, RowId> IndexIterator::operator*() {
-  return std::make_pair(page->KeyAt(item_index), page->ValueAt(item_index));
+  key_buffer.resize(page->GetKeySize());
+  auto *key = reinterpret_cast<GenericKey *>(key_buffer.data());
+  page->CopyKeyAt(item_index, key);
+  return std::make_pair(key, page->ValueAt(item_index));
 }
 
 /**
@@ -27,18 +58,41 @@ std::pair<GenericKey *, RowId> IndexIterator::operator*() {
  */
 IndexIterator &IndexIterator::operator++() {
   if (current_page_id == INVALID_PAGE_ID) return *this;
-  if (item_index + 1 < page->GetSize()) item_index++;
-  else {
+  item_index++;
+  SkipExhaustedLeaves();
+  CheckUpperBound();
+  return *this;
+}
+
+void IndexIterator::SetUpperBound(const GenericKey *key, int compare_size, bool inclusive) {
+  upper_bound.assign(reinterpret_cast<const char *>(key), reinterpret_cast<const char *>(key) + compare_size);
+  upper_inclusive = inclusive;
+  CheckUpperBound();
+}
+
+void IndexIterator::CheckUpperBound() {
+  if (raw_page == nullptr || upper_bound.empty()) return;
+  int result = page->CompareKeyAt(item_index, reinterpret_cast<const GenericKey *>(upper_bound.data()),
+                                  static_cast<int>(upper_bound.size()));
+  if (result > 0 || (result == 0 && !upper_inclusive)) {
+    Release();
+    current_page_id = INVALID_PAGE_ID;
+    item_index = 0;
+  }
+}
+
+void IndexIterator::SkipExhaustedLeaves() {
+  while (raw_page != nullptr && item_index >= page->GetSize()) {
     page_id_t next = page->GetNextPageId();
-    if (next != INVALID_PAGE_ID) {
-      buffer_pool_manager->UnpinPage(page->GetPageId(), false);
-      page = reinterpret_cast<LeafPage *>(buffer_pool_manager->FetchPage(next)->GetData());
-    }
-    else page = nullptr;
+    Page *next_page = next == INVALID_PAGE_ID ? nullptr : buffer_pool_manager->FetchPage(next);
+    // Latch coupling from left to right, removes never wait for a left sibling while holding a leaf.
+    if (next_page != nullptr) next_page->RLatch();
+    Release();
+    raw_page = next_page;
+    current_page_id = next_page == nullptr ? INVALID_PAGE_ID : next;
+    page = next_page == nullptr ? nullptr : reinterpret_cast<LeafPage *>(next_page->GetData());
     item_index = 0;
-    current_page_id = next;
   }
-  return *this;
 }
 
 bool IndexIterator::operator==(const IndexIterator &itr) const {
@@ -47,4 +101,4 @@ bool IndexIterator::operator==(const IndexIterator &itr) const {
 
 bool IndexIterator::operator!=(const IndexIterator &itr) const {
   return !(*this == itr);
-}
\ No newline at end of file
+}
@@ -1,4 +1,6 @@
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 #include "executor/execute_engine.h"
 #include "glog/logging.h"
@@ -38,6 +40,13 @@ int main(int argc, char **argv) {
   char cmd[buf_size];
   // executor engine
   ExecuteEngine engine;
+  // --scan-parallelism=N lets the sequential scans of the session use N threads
+  const char *scan_parallelism_flag = "--scan-parallelism=";
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], scan_parallelism_flag, strlen(scan_parallelism_flag)) == 0) {
+      engine.SetScanParallelism(strtoul(argv[i] + strlen(scan_parallelism_flag), nullptr, 10));
+    }
+  }
   // for print syntax tree
   TreeFileManagers syntax_tree_file_mgr("syntax_tree_");
   uint32_t syntax_tree_id = 0;
@@ -1,11 +1,9 @@
 #include "page/b_plus_tree_internal_page.h"
 
-#include "index/generic_key.h"
+#include <algorithm>
+#include <unordered_set>
 
-#define pairs_off (data_)
-#define pair_size (GetKeySize() + sizeof(page_id_t))
-#define key_off 0
-#define val_off GetKeySize()
+#include "index/generic_key.h"
 
 /**
  * TODO: Student Implement
@@ -25,25 +23,17 @@ void InternalPage::Init(page_id_t page_id, page_id_t parent_id, int key_size, in
   SetParentPageId(parent_id);
   SetKeySize(key_size);
   SetMaxSize(max_size);
-}
-/*
- * Helper method to get/set the key associated with input "index"(a.k.a
- * array offset)
- */
-GenericKey *InternalPage::KeyAt(int index) {
-  return reinterpret_cast<GenericKey *>(pairs_off + index * pair_size + key_off);
-}
-
-void InternalPage::SetKeyAt(int index, GenericKey *key) {
-  memcpy(pairs_off + index * pair_size + key_off, key, GetKeySize());
+  InitKeyStorage();
 }
 
 page_id_t InternalPage::ValueAt(int index) const {
-  return *reinterpret_cast<const page_id_t *>(pairs_off + index * pair_size + val_off);
+  page_id_t value;
+  memcpy(&value, data_ + index * INTERNAL_PAGE_SLOT_SIZE + BPLUS_TREE_SLOT_KEY_SIZE, sizeof(page_id_t));
+  return value;
 }
 
 void InternalPage::SetValueAt(int index, page_id_t value) {
-  *reinterpret_cast<page_id_t *>(pairs_off + index * pair_size + val_off) = value;
+  memcpy(data_ + index * INTERNAL_PAGE_SLOT_SIZE + BPLUS_TREE_SLOT_KEY_SIZE, &value, sizeof(page_id_t));
 }
 
 int InternalPage::ValueIndex(const page_id_t &value) const {
@@ -54,13 +44,6 @@ int InternalPage::ValueIndex(const page_id_t &value) const {
   return -1;
 }
 
-void *InternalPage::PairPtrAt(int index) {
-  return KeyAt(index);
-}
-
-void InternalPage::PairCopy(void *dest, void *src, int pair_num) {
-  memcpy(dest, src, pair_num * (GetKeySize() + sizeof(page_id_t)));
-}
 /*****************************************************************************
  * LOOKUP
  *****************************************************************************/
@@ -68,17 +51,33 @@ void InternalPage::PairCopy(void *dest, void *src, int pair_num) {
  * Find and return the child pointer(page_id) which points to the child page
  * that contains input "key"
  * Start the search from the second key(the first key should always be invalid)
- * 用了二分查找
+ * 用了二分查找, the page prefix is compared once up front, inline keys are
+ * compared as integers. Optimistic descents call this without a latch, so the
+ * prefix size is clamped to the key size.
  */
 page_id_t InternalPage::Lookup(const GenericKey *key, const KeyManager &KM) {
   if (GetSize() == 0) return INVALID_PAGE_ID;
   if (GetSize() == 1) return ValueAt(0);
+  const char *buf = reinterpret_cast<const char *>(key);
+  int key_size = KM.GetKeySize();
+  int prefix_size = std::min(GetPrefixSize(), key_size);
+  int result = memcmp(data_ + sizeof(data_) - prefix_size, buf, prefix_size);
+  if (result != 0) {
+    return ValueAt(result > 0 ? 0 : GetSize() - 1);
+  }
+  const char *suffix = buf + prefix_size;
+  int suffix_size = StrippedSize(suffix, key_size - prefix_size);
+  if (HasInlineKeys()) {
+    // The child before the first key greater than the key, an inline key with the same first bytes is not greater.
+    uint64_t inline_key = InlineKeyOf(suffix, suffix_size);
+    return ValueAt(LowerBoundInline(inline_key + 1, 1, GetSize()) - 1);
+  }
   int low = 1;
   int high = GetSize() - 1;
   int ans = 0;
   while (low <= high) {
     int mid = low + (high - low) / 2;
-    if (KM.CompareKeys(key, KeyAt(mid)) >= 0) {
+    if (CompareSuffixAt(mid, suffix, suffix_size) <= 0) {
       ans = mid;
       low = mid + 1;
     }
@@ -99,64 +98,88 @@ page_id_t InternalPage::Lookup(const GenericKey *key, const KeyManager &KM) {
  * NOTE: This method is only called within InsertIntoParent()(b_plus_tree.cpp)
  */
 void InternalPage::PopulateNewRoot(const page_id_t &old_value, GenericKey *new_key, const page_id_t &new_value) {
-  SetValueAt(0, old_value);
-  SetKeyAt(1, new_key);
-  SetValueAt(1, new_value);
-  SetSize(2);
+  std::vector<char> keys(2 * GetKeySize(), 0);
+  memcpy(keys.data() + GetKeySize(), new_key, GetKeySize());
+  page_id_t values[2] = {old_value, new_value};
+  BPlusTreePage::Rebuild(keys.data(), reinterpret_cast<const char *>(values), 2);
+}
+
+/*
+ * An internal page holds at most max size children, and as many as fit into its data area.
+ */
+bool InternalPage::HasRoomFor(const GenericKey *new_key) const {
+  return GetSize() < GetMaxSize() && InsertSpace(new_key) <= GetFreeSpace();
+}
+
+/*
+ * The key of a new child may take up to the whole key size, and cut the prefix
+ * out of the keys already there or move inline keys out of their slots.
+ */
+int InternalPage::MaxInsertSpace() const {
+  if (HasInlineKeys()) {
+    return INTERNAL_PAGE_SLOT_SIZE + GetKeySize() +
+           std::max(GetSize() - 1, 0) * (GetPrefixSize() + BPLUS_TREE_SLOT_KEY_SIZE);
+  }
+  return INTERNAL_PAGE_SLOT_SIZE + GetKeySize() + std::max(GetSize() - 2, 0) * GetPrefixSize();
 }
 
 /*
  * Insert new_key & new_value pair right after the pair with its value ==
- * old_value
+ * old_value, the page must have room for it
  * @return:  new size after insertion
  */
 int InternalPage::InsertNodeAfter(const page_id_t &old_value, GenericKey *new_key, const page_id_t &new_value) {
-  int old_value_index = ValueIndex(old_value);
-  int current_size = GetSize();
-  int insert_index = old_value_index + 1;
-  void* src_ptr = PairPtrAt(insert_index);
-  void* dst_ptr = PairPtrAt(insert_index + 1);
-  int num = current_size - insert_index;
-  if (num > 0) PairCopy(dst_ptr, src_ptr, num);
-  SetKeyAt(insert_index, new_key);
-  SetValueAt(insert_index, new_value);
-  IncreaseSize(1);
+  int insert_index = ValueIndex(old_value) + 1;
+  InsertAt(insert_index, new_key, reinterpret_cast<const char *>(&new_value));
   return GetSize();
 }
 
+bool InternalPage::CanReplaceKeyAt(int index, const GenericKey *new_key) const {
+  return ReplaceSpace(index, new_key) <= GetFreeSpace();
+}
+
+void InternalPage::SetKeyAt(int index, const GenericKey *new_key) {
+  ReplaceKeyAt(index, new_key);
+}
+
 /*****************************************************************************
  * SPLIT
  *****************************************************************************/
 /*
- * Remove half of key & value pairs from this page to "recipient" page
- * buffer_pool_manager 是干嘛的？传给CopyNFrom()用于Fetch数据页
+ * Copy the children [begin, end) out with their full keys, pages are split and
+ * merged by rebuilding them from the children. The key of the first child of
+ * the page is copied as zeros.
  */
-void InternalPage::MoveHalfTo(InternalPage *recipient, BufferPoolManager *buffer_pool_manager) {
-  int current_size = GetSize();
-  int num_to_move_start = (current_size + 1) / 2;
-  int num_to_move = current_size - num_to_move_start;
-  if (num_to_move > 0) recipient -> CopyNFrom(PairPtrAt(num_to_move_start), num_to_move, buffer_pool_manager);
-  SetSize(num_to_move_start);
+void InternalPage::CopyOut(int begin, int end, std::vector<char> &keys, std::vector<page_id_t> &values) const {
+  size_t key_count = values.size();
+  keys.resize((key_count + end - begin) * GetKeySize());
+  values.resize(key_count + end - begin);
+  CopyEntries(begin, end, keys.data() + key_count * GetKeySize(), reinterpret_cast<char *>(values.data() + key_count));
 }
 
-/* Copy entries into me, starting from {items} and copy {size} entries.
- * Since it is an internal page, for all entries (pages) moved, their parents page now changes to me.
- * So I need to 'adopt' them by changing their parent page id, which needs to be persisted with BufferPoolManger
- *
+/*
+ * Since it is an internal page, for all entries (pages) moved in, their parents
+ * page now changes to me. So I need to 'adopt' them by changing their parent
+ * page id, which needs to be persisted with BufferPoolManger
  */
-void InternalPage::CopyNFrom(void *src, int size, BufferPoolManager *buffer_pool_manager) {
-  if (size < 0) return;
-  int current_size = GetSize();
-  PairCopy(PairPtrAt(current_size), src, size);
-  for (int i = 0; i < size; i++) {
-    page_id_t child_id =  ValueAt(current_size + i);
-    Page * child_page = buffer_pool_manager->FetchPage(child_id);
-    if (child_page == nullptr) return;
-    InternalPage *child = reinterpret_cast<InternalPage *>(child_page->GetData());
-    child->SetParentPageId(GetPageId());
-    buffer_pool_manager->UnpinPage(child_id, true);
+void InternalPage::Rebuild(const char *keys, const page_id_t *values, int count,
+                           BufferPoolManager *buffer_pool_manager) {
+  std::unordered_set<page_id_t> children;
+  for (int i = 0; i < GetSize(); i++) {
+    children.insert(ValueAt(i));
+  }
+  BPlusTreePage::Rebuild(keys, reinterpret_cast<const char *>(values), count);
+  for (int i = 0; i < count; i++) {
+    if (children.count(values[i]) > 0) continue;
+    Page *child_page = buffer_pool_manager->FetchPage(values[i]);
+    if (child_page == nullptr) continue;
+    reinterpret_cast<BPlusTreePage *>(child_page->GetData())->SetParentPageId(GetPageId());
+    buffer_pool_manager->UnpinPage(values[i], true);
   }
-  IncreaseSize(size);
+}
+
+int InternalPage::RequiredSpace(const char *keys, int count, int key_size) {
+  return BPlusTreePage::RequiredSpace(keys, count, key_size, INTERNAL_PAGE_SLOT_SIZE, false);
 }
 
 /*****************************************************************************
@@ -168,11 +191,7 @@ void InternalPage::CopyNFrom(void *src, int size, BufferPoolManager *buffer_pool
  * NOTE: store key&value pair continuously after deletion
  */
 void InternalPage::Remove(int index) {
-  void* dst_ptr = PairPtrAt(index);
-  void* src_ptr = PairPtrAt(index + 1);
-  int num = GetSize() - 1 - index;
-  if (num > 0) PairCopy(dst_ptr, src_ptr, num);
-  IncreaseSize(-1);
+  RemoveAt(index);
 }
 
 /*
@@ -185,91 +204,3 @@ page_id_t InternalPage::RemoveAndReturnOnlyChild() {
   SetSize(0);
   return child;
 }
-
-/*****************************************************************************
- * MERGE
- *****************************************************************************/
-/*
- * Remove all of key & value pairs from this page to "recipient" page.
- * The middle_key is the separation key you should get from the parent. You need
- * to make sure the middle key is added to the recipient to maintain the invariant.
- * You also need to use BufferPoolManager to persist changes to the parent page id for those
- * pages that are moved to the recipient
- */
-void InternalPage::MoveAllTo(InternalPage *recipient, GenericKey *middle_key, BufferPoolManager *buffer_pool_manager) {
-  recipient->CopyLastFrom(middle_key, ValueAt(0), buffer_pool_manager);
-  if (GetSize() > 1) recipient->CopyNFrom(PairPtrAt(1), GetSize() - 1, buffer_pool_manager);
-  buffer_pool_manager->DeletePage(GetPageId());
-}
-
-/*****************************************************************************
- * REDISTRIBUTE
- *****************************************************************************/
-/*
- * Remove the first key & value pair from this page to tail of "recipient" page.
- *
- * The middle_key is the separation key you should get from the parent. You need
- * to make sure the middle key is added to the recipient to maintain the invariant.
- * You also need to use BufferPoolManager to persist changes to the parent page id for those
- * pages that are moved to the recipient
- */
-void InternalPage::MoveFirstToEndOf(InternalPage *recipient, GenericKey *middle_key,
-                                    BufferPoolManager *buffer_pool_manager) {
-  page_id_t child = ValueAt(0);
-  recipient->CopyLastFrom(middle_key, child, buffer_pool_manager);
-  Remove(0);
-}
-
-/* Append an entry at the end.
- * Since it is an internal page, the moved entry(page)'s parent needs to be updated.
- * So I need to 'adopt' it by changing its parent page id, which needs to be persisted with BufferPoolManger
- */
-void InternalPage::CopyLastFrom(GenericKey *key, const page_id_t value, BufferPoolManager *buffer_pool_manager) {
-  int index = GetSize();
-  SetKeyAt(index, key);
-  SetValueAt(index, value);
-  Page *child_page = buffer_pool_manager->FetchPage(value);
-  if (child_page == nullptr) {
-    return;
-  }
-  InternalPage *child = reinterpret_cast<InternalPage *>(child_page->GetData());
-  child->SetParentPageId(GetPageId());
-  buffer_pool_manager->UnpinPage(value, true);
-  IncreaseSize(1);
-}
-
-/*
- * Remove the last key & value pair from this page to head of "recipient" page.
- * You need to handle the original dummy key properly, e.g. updating recipient’s array to position the middle_key at the
- * right place.
- * You also need to use BufferPoolManager to persist changes to the parent page id for those pages that are
- * moved to the recipient
- */
-void InternalPage::MoveLastToFrontOf(InternalPage *recipient, GenericKey *middle_key,
-                                     BufferPoolManager *buffer_pool_manager) {
-  int last_index = GetSize() - 1;
-  page_id_t value = ValueAt(last_index);
-  recipient->CopyFirstFrom(value, buffer_pool_manager);
-  Remove(last_index);
-  recipient->SetKeyAt(1, middle_key);
-  IncreaseSize(-1);
-}
-
-/* Append an entry at the beginning.
- * Since it is an internal page, the moved entry(page)'s parent needs to be updated.
- * So I need to 'adopt' it by changing its parent page id, which needs to be persisted with BufferPoolManger
- */
-void InternalPage::CopyFirstFrom(const page_id_t value, BufferPoolManager *buffer_pool_manager) {
-  if (GetSize() > 0) {
-    PairCopy(PairPtrAt(1), PairPtrAt(0), GetSize());
-  }
-  SetValueAt(0, value);
-  Page *child_page = buffer_pool_manager->FetchPage(value);
-  if (child_page == nullptr) {
-    return;
-  }
-  InternalPage *child = reinterpret_cast<InternalPage *>(child_page->GetData());
-  child->SetParentPageId(GetPageId());
-  buffer_pool_manager->UnpinPage(value, true);
-  IncreaseSize(1);
-}
\ No newline at end of file
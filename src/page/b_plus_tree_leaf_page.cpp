@@ -1,13 +1,10 @@
 #include "page/b_plus_tree_leaf_page.h"
 
 #include <algorithm>
+#include <vector>
 
 #include "index/generic_key.h"
 
-#define pairs_off (data_)
-#define pair_size (GetKeySize() + sizeof(RowId))
-#define key_off 0
-#define val_off GetKeySize()
 /*****************************************************************************
  * HELPER METHODS AND UTILITIES
  *****************************************************************************/
@@ -29,6 +26,7 @@ void LeafPage::Init(page_id_t page_id, page_id_t parent_id, int key_size, int ma
   SetKeySize(key_size);
   SetMaxSize(max_size);
   SetNextPageId(INVALID_PAGE_ID);
+  InitKeyStorage();
 }
 
 /**
@@ -51,15 +49,29 @@ void LeafPage::SetNextPageId(page_id_t next_page_id) {
 /**
  * Helper method to find the first index i so that pairs_[i].first >= key
  * NOTE: This method is only used when generating index iterator
- * 二分查找
+ * 二分查找, the page prefix is compared once up front, inline keys are compared as integers
  */
 int LeafPage::KeyIndex(const GenericKey *key, const KeyManager &KM) {
+  const char *buf = reinterpret_cast<const char *>(key);
+  int key_size = KM.GetKeySize();
+  int prefix_size = std::min(GetPrefixSize(), key_size);
+  int result = memcmp(data_ + sizeof(data_) - prefix_size, buf, prefix_size);
+  if (result != 0) {
+    return result > 0 ? 0 : GetSize();
+  }
+  const char *suffix = buf + prefix_size;
+  int suffix_size = StrippedSize(suffix, key_size - prefix_size);
+  if (HasInlineKeys()) {
+    // A key longer than an inline key with the same first bytes is greater than it.
+    uint64_t inline_key = InlineKeyOf(suffix, suffix_size);
+    return LowerBoundInline(inline_key + (suffix_size > BPLUS_TREE_SLOT_KEY_SIZE ? 1 : 0), 0, GetSize());
+  }
   int low = 0;
   int high = GetSize() - 1;
   int ans = GetSize();
   while (low <= high) {
     int mid = (low + high) / 2;
-    if (KM.CompareKeys(KeyAt(mid), key) >= 0) {
+    if (CompareSuffixAt(mid, suffix, suffix_size) >= 0) {
       ans = mid;
       high = mid - 1;
     }
@@ -70,38 +82,22 @@ int LeafPage::KeyIndex(const GenericKey *key, const KeyManager &KM) {
   return ans;
 }
 
-/*
- * Helper method to find and return the key associated with input "index"(a.k.a
- * array offset)
- */
-GenericKey *LeafPage::KeyAt(int index) {
-  return reinterpret_cast<GenericKey *>(pairs_off + index * pair_size + key_off);
-}
-
-void LeafPage::SetKeyAt(int index, GenericKey *key) {
-  memcpy(pairs_off + index * pair_size + key_off, key, GetKeySize());
-}
-
 RowId LeafPage::ValueAt(int index) const {
-  return *reinterpret_cast<const RowId *>(pairs_off + index * pair_size + val_off);
+  RowId value;
+  memcpy(&value, data_ + index * LEAF_PAGE_SLOT_SIZE + BPLUS_TREE_SLOT_KEY_SIZE, sizeof(RowId));
+  return value;
 }
 
 void LeafPage::SetValueAt(int index, RowId value) {
-  *reinterpret_cast<RowId *>(pairs_off + index * pair_size + val_off) = value;
-}
-
-void *LeafPage::PairPtrAt(int index) {
-  return KeyAt(index);
+  memcpy(data_ + index * LEAF_PAGE_SLOT_SIZE + BPLUS_TREE_SLOT_KEY_SIZE, &value, sizeof(RowId));
 }
 
-void LeafPage::PairCopy(void *dest, void *src, int pair_num) {
-  memcpy(dest, src, pair_num * (GetKeySize() + sizeof(RowId)));
-}
 /*
- * Helper method to find and return the key & value pair associated with input
- * "index"(a.k.a. array offset)
+ * A leaf holds at most max size - 1 pairs, and as many as fit into its data area.
  */
-std::pair<GenericKey *, RowId> LeafPage::GetItem(int index) { return {KeyAt(index), ValueAt(index)}; }
+bool LeafPage::HasRoomFor(const GenericKey *key) const {
+  return GetSize() + 1 < GetMaxSize() && InsertSpace(key) <= GetFreeSpace();
+}
 
 /*****************************************************************************
  * INSERTION
@@ -111,17 +107,10 @@ std::pair<GenericKey *, RowId> LeafPage::GetItem(int index) { return {KeyAt(inde
  * @return page size after insertion
  */
 int LeafPage::Insert(GenericKey *key, const RowId &value, const KeyManager &KM) {
-  if (GetSize() >= GetMaxSize()) return GetSize();
   int index = KeyIndex(key, KM);
-  if (index < GetSize() && KM.CompareKeys(KeyAt(index), key) == 0) return 0;
-  int current_size = GetSize();
-  void* src_ptr = PairPtrAt(index);
-  void* dest_ptr = PairPtrAt(index + 1);
-  int num = current_size - index;
-  if (num > 0) PairCopy(dest_ptr, src_ptr, num);
-  SetKeyAt(index, key);
-  SetValueAt(index, value);
-  IncreaseSize(1);
+  if (index < GetSize() && CompareKeyAt(index, key, KM.GetKeySize()) == 0) return GetSize();
+  if (!HasRoomFor(key)) return GetSize();
+  InsertAt(index, key, reinterpret_cast<const char *>(&value));
   return GetSize();
 }
 
@@ -129,25 +118,22 @@ int LeafPage::Insert(GenericKey *key, const RowId &value, const KeyManager &KM)
  * SPLIT
  *****************************************************************************/
 /*
- * Remove half of key & value pairs from this page to "recipient" page
+ * Copy the pairs [begin, end) out with their full keys, pages are split and
+ * merged by rebuilding them from the pairs.
  */
-void LeafPage::MoveHalfTo(LeafPage *recipient) {
-  int current_size = GetSize();
-  int start = (current_size + 1) / 2;
-  int num = current_size - start;
-  if (num > 0) recipient->CopyNFrom(PairPtrAt(start), num);
-  SetSize(start);
-  recipient->SetNextPageId(GetNextPageId());
-  SetNextPageId(recipient->GetPageId());
+void LeafPage::CopyOut(int begin, int end, std::vector<char> &keys, std::vector<RowId> &values) const {
+  size_t key_count = values.size();
+  keys.resize((key_count + end - begin) * GetKeySize());
+  values.resize(key_count + end - begin);
+  CopyEntries(begin, end, keys.data() + key_count * GetKeySize(), reinterpret_cast<char *>(values.data() + key_count));
 }
 
-/*
- * Copy starting from items, and copy {size} number of elements into me.
- */
-void LeafPage::CopyNFrom(void *src, int size) {
-  if (size <= 0) return;
-  PairCopy(PairPtrAt(GetSize()), src, size);
-  IncreaseSize(size);
+void LeafPage::Rebuild(const char *keys, const RowId *values, int count) {
+  BPlusTreePage::Rebuild(keys, reinterpret_cast<const char *>(values), count);
+}
+
+int LeafPage::RequiredSpace(const char *keys, int count, int key_size) {
+  return BPlusTreePage::RequiredSpace(keys, count, key_size, LEAF_PAGE_SLOT_SIZE, true);
 }
 
 /*****************************************************************************
@@ -160,7 +146,7 @@ void LeafPage::CopyNFrom(void *src, int size) {
  */
 bool LeafPage::Lookup(const GenericKey *key, RowId &value, const KeyManager &KM) {
   int index = KeyIndex(key, KM);
-  if (index < GetSize() && KM.CompareKeys(KeyAt(index), key) == 0) {
+  if (index < GetSize() && CompareKeyAt(index, key, KM.GetKeySize()) == 0) {
     value = ValueAt(index);
     return true;
   }
@@ -178,78 +164,8 @@ bool LeafPage::Lookup(const GenericKey *key, RowId &value, const KeyManager &KM)
  */
 int LeafPage::RemoveAndDeleteRecord(const GenericKey *key, const KeyManager &KM) {
   int index = KeyIndex(key, KM);
-  if (index < GetSize() && KM.CompareKeys(KeyAt(index), key) == 0) {
-    void* dst_ptr = PairPtrAt(index);
-    void* src_ptr = PairPtrAt(index + 1);
-    int num = GetSize() - index - 1;
-    if (num > 0) PairCopy(dst_ptr, src_ptr, num);
-    IncreaseSize(-1);
-    return GetSize();
+  if (index < GetSize() && CompareKeyAt(index, key, KM.GetKeySize()) == 0) {
+    RemoveAt(index);
   }
   return GetSize();
 }
-
-/*****************************************************************************
- * MERGE
- *****************************************************************************/
-/*
- * Remove all key & value pairs from this page to "recipient" page. Don't forget
- * to update the next_page id in the sibling page
- */
-void LeafPage::MoveAllTo(LeafPage *recipient) {
-  if (GetSize() > 0) recipient->CopyNFrom(PairPtrAt(0), GetSize());
-  recipient->SetNextPageId(GetNextPageId());
-  SetSize(0);
-  SetNextPageId(recipient->GetPageId());
-}
-
-/*****************************************************************************
- * REDISTRIBUTE
- *****************************************************************************/
-/*
- * Remove the first key & value pair from this page to "recipient" page.
- *
- */
-void LeafPage::MoveFirstToEndOf(LeafPage *recipient) {
-  if (GetSize() == 0) return;
-  GenericKey *key = KeyAt(0);
-  RowId value = ValueAt(0);
-  recipient->CopyLastFrom(key, value);
-  void* dst_ptr = PairPtrAt(0);
-  void* src_ptr = PairPtrAt(1);
-  int num = GetSize() - 1;
-  if (num > 0) PairCopy(dst_ptr, src_ptr, num);
-  IncreaseSize(-1);
-}
-
-/*
- * Copy the item into the end of my item list. (Append item to my array)
- */
-void LeafPage::CopyLastFrom(GenericKey *key, const RowId value) {
-  int index = GetSize();
-  SetKeyAt(index, key);
-  SetValueAt(index, value);
-  IncreaseSize(1);
-}
-
-/*
- * Remove the last key & value pair from this page to "recipient" page.
- */
-void LeafPage::MoveLastToFrontOf(LeafPage *recipient) {
-  if (GetSize() == 0) return;
-  GenericKey *key = KeyAt(GetSize() - 1);
-  RowId value = ValueAt(GetSize() - 1);
-  recipient->CopyFirstFrom(key, value);
-  IncreaseSize(-1);
-}
-
-/*
- * Insert item at the front of my items. Move items accordingly.
- *
- */
-void LeafPage::CopyFirstFrom(GenericKey *key, const RowId value) {
-  if (GetSize() > 0) PairCopy(PairPtrAt(1), PairPtrAt(0), GetSize());
-  SetKeyAt(0, key);
-  SetValueAt(0, value);
-  IncreaseSize(1);
-}
\ No newline at end of file
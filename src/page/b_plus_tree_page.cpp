@@ -1,5 +1,25 @@
 #include "page/b_plus_tree_page.h"
 
+#include <algorithm>
+#include <vector>
+
+#include "page/b_plus_tree_internal_page.h"
+#include "page/b_plus_tree_leaf_page.h"
+
+static inline uint16_t ReadUint16(const char *buf) {
+  uint16_t value;
+  memcpy(&value, buf, sizeof(value));
+  return value;
+}
+
+static inline void WriteUint16(char *buf, uint16_t value) { memcpy(buf, &value, sizeof(value)); }
+
+static inline uint32_t ReadBigEndian32(const char *buf) {
+  uint32_t value;
+  memcpy(&value, buf, sizeof(value));
+  return __builtin_bswap32(value);
+}
+
 /*
  * Helper methods to get/set page type
  * Page type enum class is defined in b_plus_tree_page.h
@@ -109,4 +129,388 @@ void BPlusTreePage::SetPageId(page_id_t page_id) {
  */
 void BPlusTreePage::SetLSN(lsn_t lsn) {
   lsn_ = lsn;
-}
\ No newline at end of file
+}
+
+/*****************************************************************************
+ * SLOTTED KEY STORAGE
+ *****************************************************************************/
+/*
+ * Optimistic descents read pages a writer may be changing, every offset and
+ * length read from the page is therefore clamped to the data area before use.
+ */
+void BPlusTreePage::InitKeyStorage() {
+  prefix_size_ = 0;
+  heap_begin_ = static_cast<uint16_t>(GetDataSize());
+  garbage_size_ = 0;
+  inline_keys_ = 1;
+}
+
+int BPlusTreePage::GetHeaderSize() const {
+  return IsLeafPage() ? LEAF_PAGE_HEADER_SIZE : INTERNAL_PAGE_HEADER_SIZE;
+}
+
+int BPlusTreePage::GetDataSize() const {
+  return PAGE_SIZE - GetHeaderSize();
+}
+
+int BPlusTreePage::GetPrefixSize() const {
+  return prefix_size_;
+}
+
+int BPlusTreePage::GetSlotSize() const {
+  return BPLUS_TREE_SLOT_KEY_SIZE + (IsLeafPage() ? sizeof(RowId) : sizeof(page_id_t));
+}
+
+bool BPlusTreePage::HasInlineKeys() const {
+  return inline_keys_ != 0;
+}
+
+char *BPlusTreePage::SlotAt(int index) {
+  return reinterpret_cast<char *>(this) + GetHeaderSize() + index * GetSlotSize();
+}
+
+const char *BPlusTreePage::SlotAt(int index) const {
+  return reinterpret_cast<const char *>(this) + GetHeaderSize() + index * GetSlotSize();
+}
+
+int BPlusTreePage::GetUsedSpace() const {
+  return size_ * GetSlotSize() + GetDataSize() - heap_begin_ - garbage_size_;
+}
+
+int BPlusTreePage::GetFreeSpace() const {
+  return GetDataSize() - GetUsedSpace();
+}
+
+bool BPlusTreePage::IsUnderflow(int removed_index) const {
+  int size = size_;
+  int used = GetUsedSpace();
+  if (removed_index >= 0) {
+    size--;
+    used -= GetSlotSize() + StoredSizeAt(removed_index);
+  }
+  return size < GetMinSize() && 2 * used < GetDataSize();
+}
+
+int BPlusTreePage::StrippedSize(const char *key, int size) {
+  while (size > 0 && key[size - 1] == 0) {
+    size--;
+  }
+  return size;
+}
+
+int BPlusTreePage::CommonPrefixSize(const char *lhs, const char *rhs, int size) {
+  int i = 0;
+  while (i < size && lhs[i] == rhs[i]) {
+    i++;
+  }
+  return i;
+}
+
+int BPlusTreePage::RequiredSpace(const char *keys, int count, int key_size, int slot_size, bool first_key_stored) {
+  int first = first_key_stored ? 0 : 1;
+  if (count <= first) {
+    return count * slot_size;
+  }
+  int prefix = CommonPrefixSize(keys + first * key_size, keys + (count - 1) * key_size, key_size);
+  int stored = 0;
+  int longest = 0;
+  for (int i = first; i < count; i++) {
+    int stripped = StrippedSize(keys + i * key_size, key_size);
+    prefix = std::min(prefix, stripped);
+    stored += stripped;
+    longest = std::max(longest, stripped);
+  }
+  return count * slot_size + KeySpace(count - first, prefix, stored, longest);
+}
+
+int BPlusTreePage::KeySpace(int count, int prefix_size, int stripped_size, int max_stripped_size) {
+  if (max_stripped_size - prefix_size <= BPLUS_TREE_SLOT_KEY_SIZE) {
+    return prefix_size;
+  }
+  return prefix_size + stripped_size - count * prefix_size;
+}
+
+const char *BPlusTreePage::KeySuffixAt(int index, int *length) const {
+  // The page type is read once, so that the data area does not change in between.
+  bool is_leaf = IsLeafPage();
+  int header_size = is_leaf ? LEAF_PAGE_HEADER_SIZE : INTERNAL_PAGE_HEADER_SIZE;
+  int slot_size = BPLUS_TREE_SLOT_KEY_SIZE + (is_leaf ? sizeof(RowId) : sizeof(page_id_t));
+  int data_size = PAGE_SIZE - header_size;
+  const char *data = reinterpret_cast<const char *>(this) + header_size;
+  const char *slot = data + index * slot_size;
+  if (inline_keys_ != 0) {
+    *length = StrippedSize(slot, BPLUS_TREE_SLOT_KEY_SIZE);
+    return slot;
+  }
+  int offset = std::min<int>(ReadUint16(slot), data_size);
+  *length = std::min<int>(ReadUint16(slot + sizeof(uint16_t)), data_size - offset);
+  return data + offset;
+}
+
+int BPlusTreePage::StoredSizeAt(int index) const {
+  if (inline_keys_ != 0) {
+    return 0;
+  }
+  int length;
+  KeySuffixAt(index, &length);
+  return length;
+}
+
+uint32_t BPlusTreePage::InlineKeyOf(const char *suffix, int suffix_size) {
+  char buf[BPLUS_TREE_SLOT_KEY_SIZE] = {0};
+  memcpy(buf, suffix, std::min(suffix_size, BPLUS_TREE_SLOT_KEY_SIZE));
+  return ReadBigEndian32(buf);
+}
+
+int BPlusTreePage::LowerBoundInline(uint64_t key, int begin, int end) const {
+  const char *data = reinterpret_cast<const char *>(this) + GetHeaderSize();
+  int slot_size = GetSlotSize();
+  while (begin < end) {
+    int mid = begin + (end - begin) / 2;
+    if (ReadBigEndian32(data + mid * slot_size) < key) {
+      begin = mid + 1;
+    } else {
+      end = mid;
+    }
+  }
+  return begin;
+}
+
+void BPlusTreePage::CopyKeyAt(int index, GenericKey *key) const {
+  int key_size = GetKeySize();
+  int prefix_size = std::min<int>(prefix_size_, key_size);
+  char *buf = reinterpret_cast<char *>(key);
+  memcpy(buf, SlotAt(0) + GetDataSize() - prefix_size, prefix_size);
+  int length;
+  const char *suffix = KeySuffixAt(index, &length);
+  length = std::min(length, key_size - prefix_size);
+  memcpy(buf + prefix_size, suffix, length);
+  memset(buf + prefix_size + length, 0, key_size - prefix_size - length);
+}
+
+int BPlusTreePage::CompareSuffixAt(int index, const char *suffix, int suffix_size) const {
+  int length;
+  const char *entry = KeySuffixAt(index, &length);
+  int result = memcmp(entry, suffix, std::min(length, suffix_size));
+  if (result != 0) {
+    return result;
+  }
+  // Both are cut after their last non zero byte, the longer one is greater.
+  return length == suffix_size ? 0 : (length > suffix_size ? 1 : -1);
+}
+
+int BPlusTreePage::CompareKeyAt(int index, const GenericKey *key, int compare_size) const {
+  const char *buf = reinterpret_cast<const char *>(key);
+  int prefix_size = std::min<int>(prefix_size_, GetKeySize());
+  int result = memcmp(SlotAt(0) + GetDataSize() - prefix_size, buf, std::min(prefix_size, compare_size));
+  if (result != 0 || compare_size <= prefix_size) {
+    return result;
+  }
+  int length;
+  const char *entry = KeySuffixAt(index, &length);
+  length = std::min(length, compare_size - prefix_size);
+  int suffix_size = StrippedSize(buf + prefix_size, compare_size - prefix_size);
+  result = memcmp(entry, buf + prefix_size, std::min(length, suffix_size));
+  if (result != 0 || length == suffix_size) {
+    return result;
+  }
+  if (length < suffix_size) {
+    return -1;
+  }
+  // The entry may be cut by compare_size, it is only greater if the rest is not all zeros.
+  return StrippedSize(entry + suffix_size, length - suffix_size) > 0 ? 1 : 0;
+}
+
+int BPlusTreePage::InsertSpace(const GenericKey *key) const {
+  const char *buf = reinterpret_cast<const char *>(key);
+  int key_size = GetKeySize();
+  int stripped = StrippedSize(buf, key_size);
+  int stored = IsLeafPage() ? size_ : std::max(size_ - 1, 0);
+  int prefix_size = prefix_size_;
+  // The prefix shrinks to what the key has in common with it, and the other keys grow by as much.
+  int new_prefix_size =
+      std::min(stripped, CommonPrefixSize(SlotAt(0) + GetDataSize() - prefix_size, buf, prefix_size));
+  if (inline_keys_ != 0) {
+    if (new_prefix_size == prefix_size && stripped - prefix_size <= BPLUS_TREE_SLOT_KEY_SIZE) {
+      return GetSlotSize();
+    }
+    return GetSlotSize() + InlineRebuildSpace(stripped, new_prefix_size, -1) - prefix_size;
+  }
+  return GetSlotSize() + stripped - new_prefix_size + (stored - 1) * (prefix_size - new_prefix_size);
+}
+
+int BPlusTreePage::ReplaceSpace(int index, const GenericKey *key) const {
+  int length = StoredSizeAt(index);
+  const char *buf = reinterpret_cast<const char *>(key);
+  int prefix_size = prefix_size_;
+  int stripped = StrippedSize(buf, GetKeySize());
+  int new_prefix_size =
+      std::min(stripped, CommonPrefixSize(SlotAt(0) + GetDataSize() - prefix_size, buf, prefix_size));
+  if (inline_keys_ != 0) {
+    if (new_prefix_size == prefix_size && stripped - prefix_size <= BPLUS_TREE_SLOT_KEY_SIZE) {
+      return 0;
+    }
+    return InlineRebuildSpace(stripped, new_prefix_size, index) - prefix_size;
+  }
+  return InsertSpace(key) - GetSlotSize() - length - (prefix_size - new_prefix_size);
+}
+
+/*
+ * The prefix the page gets may be longer than prefix_size, which only makes it
+ * take less space.
+ */
+int BPlusTreePage::InlineRebuildSpace(int stripped, int prefix_size, int replaced_index) const {
+  int count = 1;
+  int stripped_size = stripped;
+  int max_stripped_size = stripped;
+  for (int i = IsLeafPage() ? 0 : 1; i < size_; i++) {
+    if (i == replaced_index) continue;
+    int length;
+    KeySuffixAt(i, &length);
+    count++;
+    stripped_size += prefix_size_ + length;
+    max_stripped_size = std::max(max_stripped_size, prefix_size_ + length);
+  }
+  return KeySpace(count, prefix_size, stripped_size, max_stripped_size);
+}
+
+void BPlusTreePage::InsertAt(int index, const GenericKey *key, const char *value) {
+  const char *buf = reinterpret_cast<const char *>(key);
+  int key_size = GetKeySize();
+  int slot_size = GetSlotSize();
+  int value_size = slot_size - BPLUS_TREE_SLOT_KEY_SIZE;
+  int prefix_size = prefix_size_;
+  int stripped = StrippedSize(buf, key_size);
+  bool stored = IsLeafPage() || index > 0;
+  int length = stored ? stripped - prefix_size : 0;
+  if ((stored && (stripped < prefix_size || memcmp(SlotAt(0) + GetDataSize() - prefix_size, buf, prefix_size) != 0 ||
+                  (inline_keys_ != 0 && length > BPLUS_TREE_SLOT_KEY_SIZE))) ||
+      (inline_keys_ == 0 && heap_begin_ - (size_ + 1) * slot_size < length)) {
+    // The key does not share the prefix or does not fit into a slot, or the page needs compacting: rewrite the page,
+    // with a shorter prefix or without inline keys if need be.
+    int size = size_;
+    std::vector<char> keys((size + 1) * key_size);
+    std::vector<char> values((size + 1) * value_size);
+    CopyEntries(0, index, keys.data(), values.data());
+    memcpy(keys.data() + index * key_size, buf, key_size);
+    memcpy(values.data() + index * value_size, value, value_size);
+    CopyEntries(index, size, keys.data() + (index + 1) * key_size, values.data() + (index + 1) * value_size);
+    Rebuild(keys.data(), values.data(), size + 1);
+    return;
+  }
+  if (inline_keys_ != 0) {
+    memmove(SlotAt(index + 1), SlotAt(index), (size_ - index) * slot_size);
+    char *slot = SlotAt(index);
+    memset(slot, 0, BPLUS_TREE_SLOT_KEY_SIZE);
+    memcpy(slot, buf + prefix_size, length);
+    memcpy(slot + BPLUS_TREE_SLOT_KEY_SIZE, value, value_size);
+    size_++;
+    return;
+  }
+  memmove(SlotAt(index + 1), SlotAt(index), (size_ - index) * slot_size);
+  heap_begin_ -= length;
+  memcpy(SlotAt(0) + heap_begin_, buf + prefix_size, length);
+  char *slot = SlotAt(index);
+  WriteUint16(slot, heap_begin_);
+  WriteUint16(slot + sizeof(uint16_t), length);
+  memcpy(slot + BPLUS_TREE_SLOT_KEY_SIZE, value, value_size);
+  size_++;
+}
+
+void BPlusTreePage::RemoveAt(int index) {
+  int slot_size = GetSlotSize();
+  garbage_size_ += StoredSizeAt(index);
+  memmove(SlotAt(index), SlotAt(index + 1), (size_ - index - 1) * slot_size);
+  size_--;
+  if (!IsLeafPage() && index == 0 && size_ > 0) {
+    // The first key of an internal page is not stored.
+    garbage_size_ += StoredSizeAt(0);
+    if (inline_keys_ != 0) {
+      memset(SlotAt(0), 0, BPLUS_TREE_SLOT_KEY_SIZE);
+    } else {
+      WriteUint16(SlotAt(0) + sizeof(uint16_t), 0);
+    }
+  }
+}
+
+void BPlusTreePage::ReplaceKeyAt(int index, const GenericKey *key) {
+  const char *buf = reinterpret_cast<const char *>(key);
+  int key_size = GetKeySize();
+  int prefix_size = prefix_size_;
+  int stripped = StrippedSize(buf, key_size);
+  int length = stripped - prefix_size;
+  if (stripped < prefix_size || memcmp(SlotAt(0) + GetDataSize() - prefix_size, buf, prefix_size) != 0 ||
+      (inline_keys_ != 0 && length > BPLUS_TREE_SLOT_KEY_SIZE) ||
+      (inline_keys_ == 0 && heap_begin_ - size_ * GetSlotSize() < length)) {
+    int value_size = GetSlotSize() - BPLUS_TREE_SLOT_KEY_SIZE;
+    std::vector<char> keys(size_ * key_size);
+    std::vector<char> values(size_ * value_size);
+    CopyEntries(0, size_, keys.data(), values.data());
+    memcpy(keys.data() + index * key_size, buf, key_size);
+    Rebuild(keys.data(), values.data(), size_);
+    return;
+  }
+  if (inline_keys_ != 0) {
+    memset(SlotAt(index), 0, BPLUS_TREE_SLOT_KEY_SIZE);
+    memcpy(SlotAt(index), buf + prefix_size, length);
+    return;
+  }
+  garbage_size_ += StoredSizeAt(index);
+  heap_begin_ -= length;
+  memcpy(SlotAt(0) + heap_begin_, buf + prefix_size, length);
+  WriteUint16(SlotAt(index), heap_begin_);
+  WriteUint16(SlotAt(index) + sizeof(uint16_t), length);
+}
+
+void BPlusTreePage::CopyEntries(int begin, int end, char *keys, char *values) const {
+  int key_size = GetKeySize();
+  int value_size = GetSlotSize() - BPLUS_TREE_SLOT_KEY_SIZE;
+  for (int i = begin; i < end; i++) {
+    CopyKeyAt(i, reinterpret_cast<GenericKey *>(keys + (i - begin) * key_size));
+    memcpy(values + (i - begin) * value_size, SlotAt(i) + BPLUS_TREE_SLOT_KEY_SIZE, value_size);
+  }
+}
+
+void BPlusTreePage::Rebuild(const char *keys, const char *values, int count) {
+  int key_size = GetKeySize();
+  int slot_size = GetSlotSize();
+  int value_size = slot_size - BPLUS_TREE_SLOT_KEY_SIZE;
+  int first = IsLeafPage() ? 0 : 1;
+  int prefix_size = 0;
+  int longest = 0;
+  if (count > first) {
+    prefix_size = CommonPrefixSize(keys + first * key_size, keys + (count - 1) * key_size, key_size);
+    for (int i = first; i < count; i++) {
+      int stripped = StrippedSize(keys + i * key_size, key_size);
+      prefix_size = std::min(prefix_size, stripped);
+      longest = std::max(longest, stripped);
+    }
+  }
+  bool inline_keys = longest - prefix_size <= BPLUS_TREE_SLOT_KEY_SIZE;
+  char *data = SlotAt(0);
+  int heap = GetDataSize() - prefix_size;
+  if (prefix_size > 0) {
+    memcpy(data + heap, keys + first * key_size, prefix_size);
+  }
+  for (int i = 0; i < count; i++) {
+    const char *key = keys + i * key_size;
+    int length = i < first ? 0 : StrippedSize(key, key_size) - prefix_size;
+    char *slot = data + i * slot_size;
+    if (inline_keys) {
+      memset(slot, 0, BPLUS_TREE_SLOT_KEY_SIZE);
+      memcpy(slot, key + prefix_size, length);
+    } else {
+      heap -= length;
+      memcpy(data + heap, key + prefix_size, length);
+      WriteUint16(slot, heap);
+      WriteUint16(slot + sizeof(uint16_t), length);
+    }
+    memcpy(slot + BPLUS_TREE_SLOT_KEY_SIZE, values + i * value_size, value_size);
+  }
+  size_ = count;
+  prefix_size_ = prefix_size;
+  heap_begin_ = heap;
+  garbage_size_ = 0;
+  inline_keys_ = inline_keys ? 1 : 0;
+}
+
@@ -1,5 +1,7 @@
 #include "page/bitmap_page.h"
 
+#include <cstring>
+
 #include "glog/logging.h"
 
 /**
@@ -11,82 +13,59 @@ bool BitmapPage<PageSize>::AllocatePage(uint32_t &page_offset) {
     return false;  // No free pages left
   }
 
-  uint32_t current_search_page = next_free_page_;
-  // Loop 1: Search from next_free_page_ to the end
-  for (; current_search_page < GetMaxSupportedSize(); ++current_search_page) {
-    if (IsPageFree(current_search_page)) {
-      uint32_t byte_index = current_search_page / 8;
-      uint8_t bit_index = current_search_page % 8;
-      bytes[byte_index] |= (1U << bit_index);
-      page_allocated_++;
-      page_offset = current_search_page;
-
-      // Update next_free_page_ to the next actual free page
-      if (page_allocated_ == GetMaxSupportedSize()) {
-        next_free_page_ = GetMaxSupportedSize();
-      } else {
-        bool found_next = false;
-        // Search from current_search_page + 1 to end
-        for (uint32_t i = current_search_page + 1; i < GetMaxSupportedSize(); ++i) {
-          if (IsPageFree(i)) {
-            next_free_page_ = i;
-            found_next = true;
-            break;
-          }
-        }
-        if (!found_next) {
-          // Search from 0 to current_search_page
-          for (uint32_t i = 0; i < current_search_page; ++i) {
-            if (IsPageFree(i)) {
-              next_free_page_ = i;
-              found_next = true;
-              break;
-            }
-          }
-        }
-        // If still not found (should not happen if page_allocated_ < GetMaxSupportedSize())
-        // If all pages are full, the initial check handles it.
-        // If there's at least one free page, one of the loops above *must* find it.
-      }
-      return true;
+  // Next fit: scan whole words from the one holding the hint, wrapping around once. The word holding the hint is
+  // visited again at the end, so that free pages before the hint in it are found too.
+  uint32_t hint = next_free_page_ < GetMaxSupportedSize() ? next_free_page_ : 0;
+  uint32_t start_word = hint / 64;
+  for (uint32_t i = 0; i <= MAX_WORDS; i++) {
+    uint32_t word_index = (start_word + i) % MAX_WORDS;
+    uint64_t word;
+    memcpy(&word, bytes + word_index * sizeof(uint64_t), sizeof(uint64_t));
+    if (i == 0) {
+      word |= (1ULL << (hint % 64)) - 1;  // pages before the hint count as used on the first visit
+    }
+    if (word == ~0ULL) {
+      continue;
     }
+    // Bit n of byte k is page 8k+n, so on a little endian machine the lowest clear bit is the first free page.
+    uint32_t offset = word_index * 64 + __builtin_ctzll(~word);
+    bytes[offset / 8] |= (1U << (offset % 8));
+    page_allocated_++;
+    next_free_page_ = offset + 1;
+    page_offset = offset;
+    return true;
   }
+  return false;  // Should not be reached if page_allocated_ < GetMaxSupportedSize()
+}
 
-  // Loop 2: Search from 0 to next_free_page_ (if not found in Loop 1)
-  for (current_search_page = 0; current_search_page < next_free_page_; ++current_search_page) {
-    if (IsPageFree(current_search_page)) {
-      uint32_t byte_index = current_search_page / 8;
-      uint8_t bit_index = current_search_page % 8;
-      bytes[byte_index] |= (1U << bit_index);
-      page_allocated_++;
-      page_offset = current_search_page;
-
-      // Update next_free_page_ to the actual free page
-      if (page_allocated_ == GetMaxSupportedSize()) {
-        next_free_page_ = GetMaxSupportedSize();
-      } else {
-        bool found_next = false;
-        for (uint32_t i = current_search_page + 1; i < GetMaxSupportedSize(); ++i) {
-          if (IsPageFree(i)) {
-            next_free_page_ = i;
-            found_next = true;
-            break;
-          }
-        }
-        if (!found_next) {
-          for (uint32_t i = 0; i < current_search_page; ++i) {
-            if (IsPageFree(i)) {
-              next_free_page_ = i;
-              found_next = true;
-              break;
-            }
-          }
-        }
+template <size_t PageSize>
+bool BitmapPage<PageSize>::AllocateRun(uint32_t run_size, uint32_t &page_offset) {
+  ASSERT(run_size > 0 && run_size <= 64 && (run_size & (run_size - 1)) == 0, "Invalid run size.");
+  if (page_allocated_ + run_size > GetMaxSupportedSize()) {
+    return false;
+  }
+  uint64_t run_mask = run_size == 64 ? ~0ULL : (1ULL << run_size) - 1;
+  uint32_t hint = next_free_page_ < GetMaxSupportedSize() ? next_free_page_ : 0;
+  uint32_t start_word = hint / 64;
+  for (uint32_t i = 0; i < MAX_WORDS; i++) {
+    uint32_t word_index = (start_word + i) % MAX_WORDS;
+    uint64_t word;
+    memcpy(&word, bytes + word_index * sizeof(uint64_t), sizeof(uint64_t));
+    if (word == ~0ULL) {
+      continue;
+    }
+    for (uint32_t shift = 0; shift < 64; shift += run_size) {
+      if ((word & (run_mask << shift)) == 0) {
+        word |= run_mask << shift;
+        memcpy(bytes + word_index * sizeof(uint64_t), &word, sizeof(uint64_t));
+        page_allocated_ += run_size;
+        page_offset = word_index * 64 + shift;
+        next_free_page_ = page_offset + run_size;
+        return true;
       }
-      return true;
     }
   }
-  return false;  // Should not be reached if page_allocated_ < GetMaxSupportedSize()
+  return false;
 }
 
 /**
@@ -107,15 +86,35 @@ bool BitmapPage<PageSize>::DeAllocatePage(uint32_t page_offset) {
   bytes[byte_index] &= ~(1U << bit_index);  // Clear the bit to mark as free
   page_allocated_--;
 
-  // A small optimization: if the deallocated page is earlier than the current hint,
-  // it becomes the new best hint.
-  if (page_offset < next_free_page_) {
+  // The hint keeps rolling forward so that allocations stay contiguous, except when the page just allocated is
+  // given back.
+  if (page_offset + 1 == next_free_page_) {
     next_free_page_ = page_offset;
   }
 
   return true;
 }
 
+template <size_t PageSize>
+bool BitmapPage<PageSize>::DeAllocateRun(uint32_t page_offset, uint32_t count) {
+  if (page_offset + count > GetMaxSupportedSize()) {
+    return false;
+  }
+  for (uint32_t i = page_offset; i < page_offset + count; i++) {
+    if (IsPageFree(i)) {
+      return false;
+    }
+  }
+  for (uint32_t i = page_offset; i < page_offset + count; i++) {
+    bytes[i / 8] &= ~(1U << (i % 8));
+  }
+  page_allocated_ -= count;
+  if (page_offset + count == next_free_page_) {
+    next_free_page_ = page_offset;
+  }
+  return true;
+}
+
 /**
  * TODO: Student Implement
  */
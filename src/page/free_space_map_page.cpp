@@ -0,0 +1,21 @@
+#include "page/free_space_map_page.h"
+
+#include <algorithm>
+
+uint8_t FreeSpaceMapPage::ToCategory(uint32_t free_bytes) {
+  return static_cast<uint8_t>(std::min<uint32_t>(free_bytes / FREE_SPACE_STEP, UINT8_MAX));
+}
+
+uint8_t FreeSpaceMapPage::ToRequiredCategory(uint32_t required_bytes) {
+  return static_cast<uint8_t>(std::min<uint32_t>((required_bytes + FREE_SPACE_STEP - 1) / FREE_SPACE_STEP, UINT8_MAX));
+}
+
+bool FreeSpaceMapPage::Append(page_id_t table_page_id, uint8_t category) {
+  if (entry_count_ >= MAX_ENTRY_COUNT) {
+    return false;
+  }
+  page_ids_[entry_count_] = table_page_id;
+  categories_[entry_count_] = category;
+  entry_count_++;
+  return true;
+}
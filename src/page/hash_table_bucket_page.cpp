@@ -0,0 +1,37 @@
+#include "page/hash_table_bucket_page.h"
+
+#include <cstring>
+
+#define pairs_off (data_)
+#define pair_size (key_size_ + sizeof(RowId))
+#define key_off 0
+#define val_off key_size_
+
+void HashTableBucketPage::Init(page_id_t page_id, int key_size) {
+  page_id_ = page_id;
+  key_size_ = key_size;
+  size_ = 0;
+  next_page_id_ = INVALID_PAGE_ID;
+}
+
+GenericKey *HashTableBucketPage::KeyAt(int index) {
+  return reinterpret_cast<GenericKey *>(pairs_off + index * pair_size + key_off);
+}
+
+RowId HashTableBucketPage::ValueAt(int index) const {
+  return *reinterpret_cast<const RowId *>(pairs_off + index * pair_size + val_off);
+}
+
+void HashTableBucketPage::Append(const GenericKey *key, const RowId &value) {
+  memcpy(pairs_off + size_ * pair_size + key_off, key, key_size_);
+  *reinterpret_cast<RowId *>(pairs_off + size_ * pair_size + val_off) = value;
+  size_++;
+}
+
+void HashTableBucketPage::ReplaceWithLastOf(int index, HashTableBucketPage *last) {
+  int last_index = last->size_ - 1;
+  if (last != this || index != last_index) {
+    memmove(pairs_off + index * pair_size, last->data_ + last_index * pair_size, pair_size);
+  }
+  last->size_--;
+}
@@ -0,0 +1,42 @@
+#include "page/hash_table_directory_page.h"
+
+void HashTableDirectoryPage::Init(page_id_t page_id, page_id_t bucket_page_id) {
+  page_id_ = page_id;
+  global_depth_ = 0;
+  local_depths_[0] = 0;
+  bucket_page_ids_[0] = bucket_page_id;
+}
+
+uint32_t HashTableDirectoryPage::GetSplitImageSlot(uint32_t slot) const {
+  uint32_t local_depth = local_depths_[slot];
+  if (local_depth == 0) {
+    return slot;
+  }
+  return slot ^ (1u << (local_depth - 1));
+}
+
+bool HashTableDirectoryPage::IncrGlobalDepth() {
+  if (global_depth_ >= HASH_TABLE_DIRECTORY_MAX_DEPTH) {
+    return false;
+  }
+  uint32_t size = Size();
+  for (uint32_t slot = 0; slot < size; slot++) {
+    local_depths_[slot + size] = local_depths_[slot];
+    bucket_page_ids_[slot + size] = bucket_page_ids_[slot];
+  }
+  global_depth_++;
+  return true;
+}
+
+bool HashTableDirectoryPage::TryDecrGlobalDepth() {
+  if (global_depth_ == 0) {
+    return false;
+  }
+  for (uint32_t slot = 0; slot < Size(); slot++) {
+    if (local_depths_[slot] >= global_depth_) {
+      return false;
+    }
+  }
+  global_depth_--;
+  return true;
+}
@@ -161,6 +161,38 @@ bool TablePage::GetTuple(Row *row, Schema *schema, Txn *txn, LockManager *lock_m
   return true;
 }
 
+bool TablePage::GetTuple(const RowId &rid, RowBatch *batch) {
+  uint32_t slot_num = rid.GetSlotNum();
+  if (slot_num >= GetTupleCount()) {
+    return false;
+  }
+  uint32_t tuple_size = GetTupleSize(slot_num);
+  if (IsDeleted(tuple_size)) {
+    return false;
+  }
+  uint32_t __attribute__((unused)) read_bytes = batch->AppendTuple(GetData() + GetTupleOffsetAtSlot(slot_num), rid);
+  ASSERT(tuple_size == read_bytes, "Unexpected behavior in tuple deserialize.");
+  return true;
+}
+
+void TablePage::GetTuples(uint32_t slot_num, RowBatch *batch, RowId *next_rid) {
+  uint32_t tuple_count = GetTupleCount();
+  for (uint32_t i = slot_num; i < tuple_count; i++) {
+    uint32_t tuple_size = GetTupleSize(i);
+    if (IsDeleted(tuple_size)) {
+      continue;
+    }
+    if (batch->IsFull()) {
+      next_rid->Set(GetTablePageId(), i);
+      return;
+    }
+    uint32_t __attribute__((unused)) read_bytes =
+        batch->AppendTuple(GetData() + GetTupleOffsetAtSlot(i), RowId(GetTablePageId(), i));
+    ASSERT(tuple_size == read_bytes, "Unexpected behavior in tuple deserialize.");
+  }
+  next_rid->Set(INVALID_PAGE_ID, 0);
+}
+
 bool TablePage::GetFirstTupleRid(RowId *first_rid) {
   // Find and return the first valid tuple.
   for (uint32_t i = 0; i < GetTupleCount(); i++) {
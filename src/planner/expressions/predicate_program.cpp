@@ -0,0 +1,378 @@
+#include "planner/expressions/predicate_program.h"
+
+#include <algorithm>
+#include <sstream>
+#include <string_view>
+#include <type_traits>
+
+#include "planner/expressions/column_value_expression.h"
+#include "planner/expressions/comparison_expression.h"
+#include "planner/expressions/constant_value_expression.h"
+#include "planner/expressions/logic_expression.h"
+
+PredicateProgram::PredicateProgram(const AbstractExpressionRef &predicate) {
+  bool folded = true;
+  if (predicate != nullptr && Compile(predicate, &folded) != kFolded) {
+    return;
+  }
+  Instruction constant{Opcode::kConst};
+  constant.operand_ = folded;
+  Emit(constant);
+}
+
+int PredicateProgram::Compile(const AbstractExpressionRef &expr, bool *folded) {
+  switch (expr->GetType()) {
+    case ExpressionType::LogicExpression:
+      return CompileLogic(expr, folded);
+    case ExpressionType::ComparisonExpression:
+      return CompileComparison(expr, folded);
+    case ExpressionType::ConstantExpression:
+      *folded = expr->Evaluate(nullptr).CompareEquals(Field(kTypeInt, 1)) == CmpBool::kTrue;
+      return kFolded;
+    default:
+      return EmitEval(expr);
+  }
+}
+
+int PredicateProgram::CompileLogic(const AbstractExpressionRef &expr, bool *folded) {
+  bool is_and = std::dynamic_pointer_cast<LogicExpression>(expr)->logic_type_ == LogicType::And;
+  size_t instruction_mark = instructions_.size();
+  uint32_t register_mark = next_register_;
+  bool lhs_folded = false;
+  bool rhs_folded = false;
+  int lhs = Compile(expr->GetChildAt(0), &lhs_folded);
+  int rhs = Compile(expr->GetChildAt(1), &rhs_folded);
+  // False decides a conjunction and true a disjunction, the instructions of the other side are dropped.
+  if ((lhs == kFolded && lhs_folded != is_and) || (rhs == kFolded && rhs_folded != is_and)) {
+    instructions_.resize(instruction_mark);
+    next_register_ = register_mark;
+    *folded = !is_and;
+    return kFolded;
+  }
+  // The other constant leaves the other side as it is.
+  if (lhs == kFolded && rhs == kFolded) {
+    *folded = is_and;
+    return kFolded;
+  }
+  if (lhs == kFolded) {
+    return rhs;
+  }
+  if (rhs == kFolded) {
+    return lhs;
+  }
+  // The right side was computed in the registers after the left one, the result goes back into the left one.
+  Instruction logic{is_and ? Opcode::kAnd : Opcode::kOr};
+  logic.dst_ = lhs;
+  logic.lhs_ = lhs;
+  logic.rhs_ = rhs;
+  instructions_.push_back(logic);
+  next_register_ = lhs + 1;
+  return lhs;
+}
+
+int PredicateProgram::CompileComparison(const AbstractExpressionRef &expr, bool *folded) {
+  std::string comp_type = std::dynamic_pointer_cast<ComparisonExpression>(expr)->GetComparisonType();
+  AbstractExpressionRef lhs = expr->GetChildAt(0);
+  AbstractExpressionRef rhs = expr->GetChildAt(1);
+  if (lhs->GetType() == ExpressionType::ConstantExpression &&
+      (rhs->GetType() == ExpressionType::ConstantExpression || comp_type == "is" || comp_type == "not")) {
+    *folded = expr->Evaluate(nullptr).CompareEquals(Field(kTypeInt, 1)) == CmpBool::kTrue;
+    return kFolded;
+  }
+  // A constant on the left is compared the other way round.
+  bool mirrored = false;
+  if (lhs->GetType() == ExpressionType::ConstantExpression && rhs->GetType() == ExpressionType::ColumnExpression) {
+    std::swap(lhs, rhs);
+    mirrored = true;
+  }
+  if (lhs->GetType() != ExpressionType::ColumnExpression) {
+    return EmitEval(expr);
+  }
+  Instruction comparison{Opcode::kConst};
+  comparison.column_ = std::dynamic_pointer_cast<ColumnValueExpression>(lhs)->GetColIdx();
+  if (comp_type == "is" || comp_type == "not") {
+    comparison.op_ = comp_type == "is" ? Opcode::kIsNull : Opcode::kIsNotNull;
+    return Emit(comparison);
+  }
+  if (rhs->GetType() != ExpressionType::ConstantExpression) {
+    return EmitEval(expr);
+  }
+  const Field &constant = std::dynamic_pointer_cast<ConstantValueExpression>(rhs)->val_;
+  if (constant.GetTypeId() != lhs->GetReturnType()) {
+    return EmitEval(expr);
+  }
+  if (constant.IsNull()) {
+    // Nothing compares to null.
+    *folded = false;
+    return kFolded;
+  }
+  if (comp_type == "=") {
+    comparison.cmp_ = CompareOp::kEqual;
+  } else if (comp_type == "<>") {
+    comparison.cmp_ = CompareOp::kNotEqual;
+  } else if (comp_type == "<") {
+    comparison.cmp_ = mirrored ? CompareOp::kGreaterThan : CompareOp::kLessThan;
+  } else if (comp_type == "<=") {
+    comparison.cmp_ = mirrored ? CompareOp::kGreaterThanEquals : CompareOp::kLessThanEquals;
+  } else if (comp_type == ">") {
+    comparison.cmp_ = mirrored ? CompareOp::kLessThan : CompareOp::kGreaterThan;
+  } else if (comp_type == ">=") {
+    comparison.cmp_ = mirrored ? CompareOp::kLessThanEquals : CompareOp::kGreaterThanEquals;
+  } else {
+    throw std::logic_error("Unsupported comparison type");
+  }
+  switch (constant.GetTypeId()) {
+    case kTypeInt:
+      comparison.op_ = Opcode::kCmpInt;
+      comparison.operand_ = ints_.size();
+      ints_.push_back(FieldTraits<kTypeInt>::Get(constant));
+      break;
+    case kTypeFloat:
+      comparison.op_ = Opcode::kCmpFloat;
+      comparison.operand_ = floats_.size();
+      floats_.push_back(FieldTraits<kTypeFloat>::Get(constant));
+      break;
+    case kTypeChar:
+      comparison.op_ = Opcode::kCmpChar;
+      comparison.operand_ = chars_.size();
+      chars_.emplace_back(FieldTraits<kTypeChar>::Get(constant));
+      break;
+    default:
+      return EmitEval(expr);
+  }
+  return Emit(comparison);
+}
+
+int PredicateProgram::Emit(Instruction instruction) {
+  instruction.dst_ = next_register_++;
+  register_count_ = std::max(register_count_, next_register_);
+  instructions_.push_back(instruction);
+  return instruction.dst_;
+}
+
+int PredicateProgram::EmitEval(const AbstractExpressionRef &expr) {
+  Instruction eval{Opcode::kEval};
+  eval.operand_ = expressions_.size();
+  expressions_.push_back(expr);
+  return Emit(eval);
+}
+
+template <TypeId kType>
+bool PredicateProgram::CompareField(CompareOp cmp, const Field &field,
+                                    const typename FieldTraits<kType>::ValueType &constant) {
+  if (field.IsNull()) {
+    return false;
+  }
+  auto value = FieldTraits<kType>::Get(field);
+  switch (cmp) {
+    case CompareOp::kEqual:
+      return ApplyCompareOp<CompareOp::kEqual>(value, constant);
+    case CompareOp::kNotEqual:
+      return ApplyCompareOp<CompareOp::kNotEqual>(value, constant);
+    case CompareOp::kLessThan:
+      return ApplyCompareOp<CompareOp::kLessThan>(value, constant);
+    case CompareOp::kLessThanEquals:
+      return ApplyCompareOp<CompareOp::kLessThanEquals>(value, constant);
+    case CompareOp::kGreaterThan:
+      return ApplyCompareOp<CompareOp::kGreaterThan>(value, constant);
+    case CompareOp::kGreaterThanEquals:
+      return ApplyCompareOp<CompareOp::kGreaterThanEquals>(value, constant);
+  }
+  return false;
+}
+
+template <typename Value, typename T>
+void PredicateProgram::CompareColumn(CompareOp cmp, const uint8_t *nulls, const Value &value, const T &constant,
+                                     const uint32_t *rows, size_t count, uint8_t *dst) {
+  auto compare_all = [&](auto op) {
+    for (size_t i = 0; i < count; i++) {
+      uint32_t row = rows[i];
+      dst[i] = (nulls[row] == 0) & ApplyCompareOp<decltype(op)::value>(value(row), constant);
+    }
+  };
+  switch (cmp) {
+    case CompareOp::kEqual:
+      compare_all(std::integral_constant<CompareOp, CompareOp::kEqual>());
+      return;
+    case CompareOp::kNotEqual:
+      compare_all(std::integral_constant<CompareOp, CompareOp::kNotEqual>());
+      return;
+    case CompareOp::kLessThan:
+      compare_all(std::integral_constant<CompareOp, CompareOp::kLessThan>());
+      return;
+    case CompareOp::kLessThanEquals:
+      compare_all(std::integral_constant<CompareOp, CompareOp::kLessThanEquals>());
+      return;
+    case CompareOp::kGreaterThan:
+      compare_all(std::integral_constant<CompareOp, CompareOp::kGreaterThan>());
+      return;
+    case CompareOp::kGreaterThanEquals:
+      compare_all(std::integral_constant<CompareOp, CompareOp::kGreaterThanEquals>());
+      return;
+  }
+}
+
+bool PredicateProgram::Evaluate(const Row &row) const {
+  if (register_count_ <= kInlineRegisters) {
+    uint8_t registers[kInlineRegisters];
+    return Run(row, registers);
+  }
+  std::vector<uint8_t> registers(register_count_);
+  return Run(row, registers.data());
+}
+
+bool PredicateProgram::Run(const Row &row, uint8_t *registers) const {
+  for (const auto &instruction : instructions_) {
+    bool result = false;
+    switch (instruction.op_) {
+      case Opcode::kConst:
+        result = instruction.operand_ != 0;
+        break;
+      case Opcode::kIsNull:
+        result = row.GetField(instruction.column_)->IsNull();
+        break;
+      case Opcode::kIsNotNull:
+        result = !row.GetField(instruction.column_)->IsNull();
+        break;
+      case Opcode::kCmpInt:
+        result = CompareField<kTypeInt>(instruction.cmp_, *row.GetField(instruction.column_),
+                                        ints_[instruction.operand_]);
+        break;
+      case Opcode::kCmpFloat:
+        result = CompareField<kTypeFloat>(instruction.cmp_, *row.GetField(instruction.column_),
+                                          floats_[instruction.operand_]);
+        break;
+      case Opcode::kCmpChar:
+        result = CompareField<kTypeChar>(instruction.cmp_, *row.GetField(instruction.column_),
+                                         std::string_view(chars_[instruction.operand_]));
+        break;
+      case Opcode::kAnd:
+        result = registers[instruction.lhs_] & registers[instruction.rhs_];
+        break;
+      case Opcode::kOr:
+        result = registers[instruction.lhs_] | registers[instruction.rhs_];
+        break;
+      case Opcode::kEval:
+        result = expressions_[instruction.operand_]->Evaluate(&row).CompareEquals(Field(kTypeInt, 1)) ==
+                 CmpBool::kTrue;
+        break;
+    }
+    registers[instruction.dst_] = result;
+  }
+  return registers[0] != 0;
+}
+
+void PredicateProgram::Filter(const RowBatch &batch, std::vector<uint32_t> *selection) const {
+  size_t count = selection->size();
+  const uint32_t *rows = selection->data();
+  std::vector<std::vector<uint8_t>> registers(register_count_, std::vector<uint8_t>(count));
+  for (const auto &instruction : instructions_) {
+    uint8_t *dst = registers[instruction.dst_].data();
+    uint32_t column = instruction.column_;
+    switch (instruction.op_) {
+      case Opcode::kConst:
+        std::fill(dst, dst + count, static_cast<uint8_t>(instruction.operand_));
+        break;
+      case Opcode::kIsNull:
+      case Opcode::kIsNotNull: {
+        const uint8_t *nulls = batch.GetNulls(column);
+        uint8_t flip = instruction.op_ == Opcode::kIsNotNull;
+        for (size_t i = 0; i < count; i++) {
+          dst[i] = nulls[rows[i]] ^ flip;
+        }
+        break;
+      }
+      case Opcode::kCmpInt: {
+        const int32_t *values = batch.GetInts(column);
+        CompareColumn(
+            instruction.cmp_, batch.GetNulls(column), [values](uint32_t row) { return values[row]; },
+            ints_[instruction.operand_], rows, count, dst);
+        break;
+      }
+      case Opcode::kCmpFloat: {
+        const float *values = batch.GetFloats(column);
+        CompareColumn(
+            instruction.cmp_, batch.GetNulls(column), [values](uint32_t row) { return values[row]; },
+            floats_[instruction.operand_], rows, count, dst);
+        break;
+      }
+      case Opcode::kCmpChar: {
+        auto value = [&batch, column](uint32_t row) {
+          return std::string_view(batch.GetChars(column, row), batch.GetCharLength(column, row));
+        };
+        CompareColumn(instruction.cmp_, batch.GetNulls(column), value, std::string_view(chars_[instruction.operand_]),
+                      rows, count, dst);
+        break;
+      }
+      case Opcode::kAnd:
+      case Opcode::kOr: {
+        const uint8_t *lhs = registers[instruction.lhs_].data();
+        const uint8_t *rhs = registers[instruction.rhs_].data();
+        if (instruction.op_ == Opcode::kAnd) {
+          for (size_t i = 0; i < count; i++) {
+            dst[i] = lhs[i] & rhs[i];
+          }
+        } else {
+          for (size_t i = 0; i < count; i++) {
+            dst[i] = lhs[i] | rhs[i];
+          }
+        }
+        break;
+      }
+      case Opcode::kEval: {
+        Row row;
+        for (size_t i = 0; i < count; i++) {
+          batch.GetRow(rows[i], &row);
+          dst[i] = expressions_[instruction.operand_]->Evaluate(&row).CompareEquals(Field(kTypeInt, 1)) ==
+                   CmpBool::kTrue;
+        }
+        break;
+      }
+    }
+  }
+  const uint8_t *result = registers[0].data();
+  size_t selected = 0;
+  for (size_t i = 0; i < count; i++) {
+    (*selection)[selected] = (*selection)[i];
+    selected += result[i];
+  }
+  selection->resize(selected);
+}
+
+std::string PredicateProgram::ToString() const {
+  static const char *opcodes[] = {"const", "isnull", "isnotnull", "cmpint", "cmpfloat",
+                                  "cmpchar", "and", "or", "eval"};
+  static const char *cmps[] = {"=", "<>", "<", "<=", ">", ">="};
+  std::stringstream ss;
+  for (const auto &instruction : instructions_) {
+    ss << "r" << instruction.dst_ << " = " << opcodes[static_cast<int>(instruction.op_)];
+    switch (instruction.op_) {
+      case Opcode::kConst:
+      case Opcode::kEval:
+        ss << " " << instruction.operand_;
+        break;
+      case Opcode::kIsNull:
+      case Opcode::kIsNotNull:
+        ss << " #" << instruction.column_;
+        break;
+      case Opcode::kAnd:
+      case Opcode::kOr:
+        ss << " r" << instruction.lhs_ << " r" << instruction.rhs_;
+        break;
+      case Opcode::kCmpInt:
+        ss << " #" << instruction.column_ << " " << cmps[static_cast<int>(instruction.cmp_)] << " "
+           << ints_[instruction.operand_];
+        break;
+      case Opcode::kCmpFloat:
+        ss << " #" << instruction.column_ << " " << cmps[static_cast<int>(instruction.cmp_)] << " "
+           << floats_[instruction.operand_];
+        break;
+      case Opcode::kCmpChar:
+        ss << " #" << instruction.column_ << " " << cmps[static_cast<int>(instruction.cmp_)] << " \""
+           << chars_[instruction.operand_] << "\"";
+        break;
+    }
+    ss << "\n";
+  }
+  return ss.str();
+}
@@ -33,21 +33,31 @@ void Planner::PlanQuery(pSyntaxNode ast) {
       throw std::logic_error("the statement is not supported in planner yet");
   }
 }
+/**
+ * @return whether the index can bound a scan for one of the conjuncts of predicate
+ */
+static bool ServesConjunct(IndexInfo *index, const AbstractExpressionRef &predicate) {
+  if (predicate->GetType() == ExpressionType::LogicExpression) {
+    return ServesConjunct(index, predicate->GetChildAt(0)) || ServesConjunct(index, predicate->GetChildAt(1));
+  }
+  return IndexScanPlanNode::CanServe(index, predicate);
+}
+
 AbstractPlanNodeRef Planner::PlanSelect(std::shared_ptr<SelectStatement> statement) {
   auto out_schema = MakeOutputSchema(statement->column_list_);
+  if (statement->where_ == nullptr || statement->has_or) {
+    return make_shared<SeqScanPlanNode>(out_schema, statement->table_name_, statement->where_);
+  }
   vector<IndexInfo *> indexes;
   vector<IndexInfo *> available_index;
   context_->GetCatalog()->GetTableIndexes(statement->table_name_, indexes);
   for (auto index : indexes) {
-    if (index->GetIndexKeySchema()->GetColumns().size() == 1) {
-      auto col_id = index->GetIndexKeySchema()->GetColumn(0)->GetTableInd();
-      if (std::find(statement->column_in_condition_.begin(), statement->column_in_condition_.end(), col_id) !=
-          statement->column_in_condition_.end()) {
-        available_index.push_back(index);
-      }
+    // An index on a column that is only compared in ways the index cannot answer would scan the whole table.
+    if (index->GetIndexKeySchema()->GetColumns().size() == 1 && ServesConjunct(index, statement->where_)) {
+      available_index.push_back(index);
     }
   }
-  if (available_index.empty() || statement->has_or) {
+  if (available_index.empty()) {
     return make_shared<SeqScanPlanNode>(out_schema, statement->table_name_, statement->where_);
   }
   return make_shared<IndexScanPlanNode>(out_schema, statement->table_name_, available_index,
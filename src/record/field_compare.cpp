@@ -0,0 +1,46 @@
+#include "record/field_compare.h"
+
+template <TypeId kType>
+static FieldTestFunc GetTest(CompareOp op) {
+  switch (op) {
+    case CompareOp::kEqual:
+      return FieldComparator<kType>::template Test<CompareOp::kEqual>;
+    case CompareOp::kNotEqual:
+      return FieldComparator<kType>::template Test<CompareOp::kNotEqual>;
+    case CompareOp::kLessThan:
+      return FieldComparator<kType>::template Test<CompareOp::kLessThan>;
+    case CompareOp::kLessThanEquals:
+      return FieldComparator<kType>::template Test<CompareOp::kLessThanEquals>;
+    case CompareOp::kGreaterThan:
+      return FieldComparator<kType>::template Test<CompareOp::kGreaterThan>;
+    case CompareOp::kGreaterThanEquals:
+      return FieldComparator<kType>::template Test<CompareOp::kGreaterThanEquals>;
+  }
+  return nullptr;
+}
+
+FieldCompareFunc GetFieldComparator(TypeId type) {
+  switch (type) {
+    case kTypeInt:
+      return FieldComparator<kTypeInt>::Compare;
+    case kTypeFloat:
+      return FieldComparator<kTypeFloat>::Compare;
+    case kTypeChar:
+      return FieldComparator<kTypeChar>::Compare;
+    default:
+      return nullptr;
+  }
+}
+
+FieldTestFunc GetFieldTest(TypeId type, CompareOp op) {
+  switch (type) {
+    case kTypeInt:
+      return GetTest<kTypeInt>(op);
+    case kTypeFloat:
+      return GetTest<kTypeFloat>(op);
+    case kTypeChar:
+      return GetTest<kTypeChar>(op);
+    default:
+      return nullptr;
+  }
+}
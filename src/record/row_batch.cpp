@@ -0,0 +1,169 @@
+#include "record/row_batch.h"
+
+#include <algorithm>
+
+RowBatch::RowBatch(const Schema *schema, uint32_t capacity) : schema_(schema), capacity_(capacity) {
+  uint32_t column_count = schema == nullptr ? 0 : schema->GetColumnCount();
+  columns_.resize(column_count);
+  for (uint32_t i = 0; i < column_count; i++) {
+    ColumnVector &column = columns_[i];
+    column.type_ = schema->GetColumn(i)->GetType();
+    column.nulls_.reserve(capacity);
+    if (column.type_ == kTypeInt) {
+      column.ints_.reserve(capacity);
+    } else if (column.type_ == kTypeFloat) {
+      column.floats_.reserve(capacity);
+    } else {
+      column.offsets_.reserve(capacity);
+      column.lengths_.reserve(capacity);
+      // The arena is never unallocated, so that an empty string is not taken for a null by Field.
+      column.chars_.reserve(std::max(capacity * schema->GetColumn(i)->GetLength(), 1u));
+    }
+  }
+  rids_.reserve(capacity);
+  selection_.reserve(capacity);
+}
+
+void RowBatch::Clear() {
+  for (auto &column : columns_) {
+    column.nulls_.clear();
+    column.ints_.clear();
+    column.floats_.clear();
+    column.offsets_.clear();
+    column.lengths_.clear();
+    column.chars_.clear();
+  }
+  rids_.clear();
+  selection_.clear();
+}
+
+void RowBatch::AppendNull(ColumnVector &column) {
+  column.nulls_.push_back(1);
+  if (column.type_ == kTypeInt) {
+    column.ints_.push_back(0);
+  } else if (column.type_ == kTypeFloat) {
+    column.floats_.push_back(0);
+  } else {
+    column.offsets_.push_back(static_cast<uint32_t>(column.chars_.size()));
+    column.lengths_.push_back(0);
+  }
+}
+
+void RowBatch::AppendChars(ColumnVector &column, const char *data, uint32_t len) {
+  column.nulls_.push_back(0);
+  column.offsets_.push_back(static_cast<uint32_t>(column.chars_.size()));
+  column.lengths_.push_back(len);
+  column.chars_.insert(column.chars_.end(), data, data + len);
+}
+
+void RowBatch::AppendRow(const Row &row) {
+  ASSERT(row.GetFieldCount() == 0 || row.GetFieldCount() == columns_.size(), "Row does not match the batch.");
+  for (uint32_t i = 0; i < columns_.size(); i++) {
+    ColumnVector &column = columns_[i];
+    const Field *field = row.GetFieldCount() == 0 ? nullptr : row.GetField(i);
+    if (field == nullptr || field->IsNull()) {
+      AppendNull(column);
+    } else if (column.type_ == kTypeInt) {
+      column.nulls_.push_back(0);
+      column.ints_.push_back(field->value_.integer_);
+    } else if (column.type_ == kTypeFloat) {
+      column.nulls_.push_back(0);
+      column.floats_.push_back(field->value_.float_);
+    } else {
+      AppendChars(column, field->value_.chars_, field->len_);
+    }
+  }
+  selection_.push_back(static_cast<uint32_t>(rids_.size()));
+  rids_.push_back(row.GetRowId());
+}
+
+uint32_t RowBatch::AppendTuple(const char *buf, RowId rid) {
+  const char *current_ptr = buf;
+  uint32_t column_count = MACH_READ_UINT32(current_ptr);
+  ASSERT(column_count == columns_.size(), "Tuple does not match the batch.");
+  current_ptr += sizeof(uint32_t);
+  const char *null_bitmap = current_ptr;
+  current_ptr += (column_count + 7) / 8;
+  for (uint32_t i = 0; i < column_count; i++) {
+    ColumnVector &column = columns_[i];
+    if (null_bitmap[i / 8] & (1 << (i % 8))) {
+      AppendNull(column);
+    } else if (column.type_ == kTypeInt) {
+      column.nulls_.push_back(0);
+      column.ints_.push_back(MACH_READ_INT32(current_ptr));
+      current_ptr += sizeof(int32_t);
+    } else if (column.type_ == kTypeFloat) {
+      column.nulls_.push_back(0);
+      column.floats_.push_back(MACH_READ_FROM(float, current_ptr));
+      current_ptr += sizeof(float);
+    } else {
+      uint32_t len = MACH_READ_UINT32(current_ptr);
+      AppendChars(column, current_ptr + sizeof(uint32_t), len);
+      current_ptr += sizeof(uint32_t) + len;
+    }
+  }
+  selection_.push_back(static_cast<uint32_t>(rids_.size()));
+  rids_.push_back(rid);
+  return static_cast<uint32_t>(current_ptr - buf);
+}
+
+void RowBatch::Project(const RowBatch &source, const std::vector<uint32_t> &columns) {
+  ASSERT(columns.size() == columns_.size(), "Projection does not match the batch.");
+  Clear();
+  for (uint32_t i = 0; i < columns_.size(); i++) {
+    ColumnVector &column = columns_[i];
+    const ColumnVector &from = source.columns_[columns[i]];
+    ASSERT(column.type_ == from.type_, "Projected column type mismatch.");
+    for (auto row : source.selection_) {
+      if (from.nulls_[row]) {
+        AppendNull(column);
+      } else if (column.type_ == kTypeInt) {
+        column.nulls_.push_back(0);
+        column.ints_.push_back(from.ints_[row]);
+      } else if (column.type_ == kTypeFloat) {
+        column.nulls_.push_back(0);
+        column.floats_.push_back(from.floats_[row]);
+      } else {
+        AppendChars(column, from.chars_.data() + from.offsets_[row], from.lengths_[row]);
+      }
+    }
+  }
+  for (auto row : source.selection_) {
+    selection_.push_back(static_cast<uint32_t>(rids_.size()));
+    rids_.push_back(source.rids_[row]);
+  }
+}
+
+Field RowBatch::GetField(uint32_t column, uint32_t row) const {
+  const ColumnVector &from = columns_[column];
+  if (from.nulls_[row]) {
+    return Field(from.type_);
+  }
+  if (from.type_ == kTypeInt) {
+    return Field(kTypeInt, from.ints_[row]);
+  }
+  if (from.type_ == kTypeFloat) {
+    return Field(kTypeFloat, from.floats_[row]);
+  }
+  return Field(kTypeChar, const_cast<char *>(from.chars_.data() + from.offsets_[row]), from.lengths_[row], true);
+}
+
+void RowBatch::GetRow(uint32_t row_index, Row *row) const {
+  row->destroy();
+  row->SetRowId(rids_[row_index]);
+  auto &fields = row->GetFields();
+  fields.reserve(columns_.size());
+  for (uint32_t i = 0; i < columns_.size(); i++) {
+    const ColumnVector &from = columns_[i];
+    if (from.nulls_[row_index]) {
+      fields.push_back(new Field(from.type_));
+    } else if (from.type_ == kTypeInt) {
+      fields.push_back(new Field(kTypeInt, from.ints_[row_index]));
+    } else if (from.type_ == kTypeFloat) {
+      fields.push_back(new Field(kTypeFloat, from.floats_[row_index]));
+    } else {
+      fields.push_back(new Field(kTypeChar, const_cast<char *>(from.chars_.data() + from.offsets_[row_index]),
+                                 from.lengths_[row_index], true));
+    }
+  }
+}
@@ -0,0 +1,315 @@
+#include "storage/disk_io_backend.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+
+#include "glog/logging.h"
+
+#ifdef MINISQL_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+std::unique_ptr<DiskIOBackend> DiskIOBackend::Create(DiskIOBackendType type, int fd) {
+  if (type == DiskIOBackendType::kIOUring) {
+    auto backend = IOUringBackend::Create(fd);
+    if (backend != nullptr) {
+      return backend;
+    }
+    LOG(WARNING) << "io_uring is not available, falling back to pread/pwrite.";
+  }
+  return std::make_unique<PosixIOBackend>(fd);
+}
+
+/**
+ * Finish a request given the number of bytes transferred, or a negative errno.
+ */
+static void CompleteRequest(DiskIORequest &request, ssize_t result) {
+  bool success;
+  if (request.is_write) {
+    success = result == PAGE_SIZE;
+    if (!success) {
+      LOG(ERROR) << "I/O error while writing page " << request.page_id << ": "
+                 << (result < 0 ? strerror(-result) : "short write");
+    }
+  } else {
+    success = result >= 0;
+    if (success && result < PAGE_SIZE) {
+      // The file ends before the page does.
+      memset(request.data + result, 0, PAGE_SIZE - result);
+    } else if (!success) {
+      LOG(ERROR) << "I/O error while reading page " << request.page_id << ": " << strerror(-result);
+    }
+  }
+  if (request.callback) {
+    request.callback(success);
+  }
+}
+
+void PosixIOBackend::Submit(std::vector<DiskIORequest> &requests) {
+  for (auto &request : requests) {
+    off_t offset = static_cast<off_t>(request.page_id) * PAGE_SIZE;
+    ssize_t result;
+    do {
+      result = request.is_write ? pwrite(fd_, request.data, PAGE_SIZE, offset)
+                                : pread(fd_, request.data, PAGE_SIZE, offset);
+    } while (result < 0 && errno == EINTR);
+    CompleteRequest(request, result < 0 ? -errno : result);
+  }
+}
+
+#ifdef MINISQL_HAVE_IO_URING
+
+/**
+ * Memory shared with the kernel for one io_uring instance.
+ */
+struct IOUringBackend::Ring {
+  int ring_fd{-1};
+  unsigned entries{0};
+  void *sq_ptr{nullptr};
+  void *cq_ptr{nullptr};
+  size_t sq_size{0};
+  size_t cq_size{0};
+  io_uring_sqe *sqes{nullptr};
+  unsigned *sq_tail{nullptr};
+  unsigned *sq_mask{nullptr};
+  unsigned *sq_array{nullptr};
+  unsigned *cq_head{nullptr};
+  unsigned *cq_tail{nullptr};
+  unsigned *cq_mask{nullptr};
+  io_uring_cqe *cqes{nullptr};
+
+  ~Ring() {
+    if (sqes != nullptr) {
+      munmap(sqes, entries * sizeof(io_uring_sqe));
+    }
+    if (cq_ptr != nullptr && cq_ptr != sq_ptr) {
+      munmap(cq_ptr, cq_size);
+    }
+    if (sq_ptr != nullptr) {
+      munmap(sq_ptr, sq_size);
+    }
+    if (ring_fd >= 0) {
+      close(ring_fd);
+    }
+  }
+
+  /**
+   * @return false if the kernel refuses to set up the ring
+   */
+  bool Init() {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, IO_URING_QUEUE_DEPTH, &params));
+    if (ring_fd < 0) {
+      return false;
+    }
+    entries = params.sq_entries;
+    sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+      sq_size = cq_size = std::max(sq_size, cq_size);
+    }
+    sq_ptr = mmap(nullptr, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    if (sq_ptr == MAP_FAILED) {
+      sq_ptr = nullptr;
+      return false;
+    }
+    if (single_mmap) {
+      cq_ptr = sq_ptr;
+    } else {
+      cq_ptr = mmap(nullptr, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+      if (cq_ptr == MAP_FAILED) {
+        cq_ptr = nullptr;
+        return false;
+      }
+    }
+    void *sqes_ptr = mmap(nullptr, entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          ring_fd, IORING_OFF_SQES);
+    if (sqes_ptr == MAP_FAILED) {
+      return false;
+    }
+    sqes = static_cast<io_uring_sqe *>(sqes_ptr);
+    auto sq_base = static_cast<char *>(sq_ptr);
+    sq_tail = reinterpret_cast<unsigned *>(sq_base + params.sq_off.tail);
+    sq_mask = reinterpret_cast<unsigned *>(sq_base + params.sq_off.ring_mask);
+    sq_array = reinterpret_cast<unsigned *>(sq_base + params.sq_off.array);
+    auto cq_base = static_cast<char *>(cq_ptr);
+    cq_head = reinterpret_cast<unsigned *>(cq_base + params.cq_off.head);
+    cq_tail = reinterpret_cast<unsigned *>(cq_base + params.cq_off.tail);
+    cq_mask = reinterpret_cast<unsigned *>(cq_base + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe *>(cq_base + params.cq_off.cqes);
+    return true;
+  }
+
+  /**
+   * @return whether the kernel supports the opcodes of page reads and writes, setting up a ring does not tell
+   */
+  bool ProbeOpcodes() {
+    const unsigned max_ops = 256;
+    std::vector<char> buffer(sizeof(io_uring_probe) + max_ops * sizeof(io_uring_probe_op), 0);
+    auto probe = reinterpret_cast<io_uring_probe *>(buffer.data());
+    if (syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PROBE, probe, max_ops) < 0) {
+      // Kernels without the probe (before 5.6) have no IORING_OP_READ or IORING_OP_WRITE either.
+      return false;
+    }
+    auto supported = [&](unsigned op) {
+      return op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED) != 0;
+    };
+    return supported(IORING_OP_READ) && supported(IORING_OP_WRITE);
+  }
+
+  /**
+   * Queue requests [begin, end), which must not exceed the ring size. The index of a request is its user data.
+   */
+  void Prepare(std::vector<DiskIORequest> &requests, size_t begin, size_t end, int fd) {
+    // Only this thread produces submissions, the kernel consumes them once io_uring_enter is called.
+    unsigned tail = *sq_tail;
+    for (size_t i = begin; i < end; i++) {
+      unsigned index = tail & *sq_mask;
+      io_uring_sqe *sqe = &sqes[index];
+      memset(sqe, 0, sizeof(*sqe));
+      sqe->opcode = requests[i].is_write ? IORING_OP_WRITE : IORING_OP_READ;
+      sqe->fd = fd;
+      sqe->addr = reinterpret_cast<uint64_t>(requests[i].data);
+      sqe->len = PAGE_SIZE;
+      sqe->off = static_cast<uint64_t>(requests[i].page_id) * PAGE_SIZE;
+      sqe->user_data = i;
+      sq_array[index] = index;
+      tail++;
+    }
+    __atomic_store_n(sq_tail, tail, __ATOMIC_RELEASE);
+  }
+
+  /**
+   * Submit the queued requests and complete all of them.
+   * @return false if the kernel rejected the submission, the requests are then left untouched
+   */
+  bool Run(std::vector<DiskIORequest> &requests, unsigned count) {
+    unsigned to_submit = count;
+    unsigned completed = 0;
+    while (completed < count) {
+      int ret = static_cast<int>(
+          syscall(__NR_io_uring_enter, ring_fd, to_submit, count - completed, IORING_ENTER_GETEVENTS, nullptr, 0));
+      if (ret < 0) {
+        if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+          continue;
+        }
+        if (to_submit == count) {
+          return false;
+        }
+        // Submitted requests are in flight and own their buffers, their completions have to be reaped anyway.
+        LOG(ERROR) << "io_uring_enter failed: " << strerror(errno);
+      } else {
+        to_submit -= std::min<unsigned>(to_submit, ret);
+      }
+      unsigned head = *cq_head;
+      unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+      for (; head != tail; head++) {
+        io_uring_cqe *cqe = &cqes[head & *cq_mask];
+        CompleteRequest(requests[cqe->user_data], cqe->res);
+        completed++;
+      }
+      __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+    }
+    return true;
+  }
+};
+
+std::unique_ptr<IOUringBackend> IOUringBackend::Create(int fd) {
+  std::unique_ptr<IOUringBackend> backend(new IOUringBackend(fd));
+  // Probe the kernel with the first ring, for the opcodes and with a test read of the first page of the file.
+  auto ring = backend->AcquireRing();
+  if (ring == nullptr) {
+    return nullptr;
+  }
+  if (!ring->ProbeOpcodes()) {
+    LOG(WARNING) << "io_uring does not support page reads and writes on this kernel.";
+    return nullptr;
+  }
+  char page[PAGE_SIZE];
+  bool success = false;
+  std::vector<DiskIORequest> requests{{false, 0, page, [&success](bool result) { success = result; }}};
+  ring->Prepare(requests, 0, requests.size(), fd);
+  if (!ring->Run(requests, requests.size()) || !success) {
+    LOG(WARNING) << "io_uring test read failed.";
+    return nullptr;
+  }
+  backend->ReleaseRing(ring);
+  return backend;
+}
+
+IOUringBackend::~IOUringBackend() {
+  for (auto ring : rings_) {
+    delete ring;
+  }
+}
+
+IOUringBackend::Ring *IOUringBackend::AcquireRing() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (!free_rings_.empty()) {
+    auto ring = free_rings_.back();
+    free_rings_.pop_back();
+    return ring;
+  }
+  auto ring = new Ring();
+  if (!ring->Init()) {
+    delete ring;
+    return nullptr;
+  }
+  rings_.push_back(ring);
+  return ring;
+}
+
+void IOUringBackend::ReleaseRing(Ring *ring) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  free_rings_.push_back(ring);
+}
+
+void IOUringBackend::Submit(std::vector<DiskIORequest> &requests) {
+  auto ring = AcquireRing();
+  if (ring == nullptr) {
+    fallback_.Submit(requests);
+    return;
+  }
+  for (size_t begin = 0; begin < requests.size(); begin += ring->entries) {
+    size_t end = std::min<size_t>(begin + ring->entries, requests.size());
+    ring->Prepare(requests, begin, end, fd_);
+    if (!ring->Run(requests, end - begin)) {
+      // The kernel did not take the batch, so it is still queued. Drop it and issue the rest synchronously.
+      LOG(WARNING) << "io_uring submission failed: " << strerror(errno);
+      {
+        std::scoped_lock<std::mutex> lock(latch_);
+        rings_.erase(std::find(rings_.begin(), rings_.end(), ring));
+      }
+      delete ring;
+      std::vector<DiskIORequest> rest(std::make_move_iterator(requests.begin() + begin),
+                                      std::make_move_iterator(requests.end()));
+      fallback_.Submit(rest);
+      return;
+    }
+  }
+  ReleaseRing(ring);
+}
+
+#else
+
+struct IOUringBackend::Ring {};
+
+std::unique_ptr<IOUringBackend> IOUringBackend::Create(__attribute__((unused)) int fd) { return nullptr; }
+
+IOUringBackend::~IOUringBackend() = default;
+
+IOUringBackend::Ring *IOUringBackend::AcquireRing() { return nullptr; }
+
+void IOUringBackend::ReleaseRing(__attribute__((unused)) Ring *ring) {}
+
+void IOUringBackend::Submit(std::vector<DiskIORequest> &requests) { fallback_.Submit(requests); }
+
+#endif
@@ -1,79 +1,104 @@
 #include "storage/disk_manager.h"
 
-#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <filesystem>
 #include <stdexcept>
 
 #include "glog/logging.h"
 #include "page/bitmap_page.h"
 
-DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
+DiskManager::DiskManager(const std::string &db_file, DiskIOBackendType backend_type) : file_name_(db_file) {
   std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
+  db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+  // directory does not exist
+  if (db_fd_ < 0) {
     std::filesystem::path p = db_file;
     if (p.has_parent_path()) std::filesystem::create_directories(p.parent_path());
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-    if (!db_io_.is_open()) {
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+    if (db_fd_ < 0) {
       throw std::exception();
     }
   }
-  ReadPhysicalPage(META_PAGE_ID, meta_data_);
+  io_backend_ = DiskIOBackend::Create(backend_type, db_fd_);
+  if (!ReadPhysicalPage(META_PAGE_ID, meta_data_)) {
+    close(db_fd_);
+    throw std::runtime_error("Failed to read the meta page of " + db_file);
+  }
 }
 
 void DiskManager::Close() {
   std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
-  WritePhysicalPage(META_PAGE_ID, meta_data_);
   if (!closed) {
-    db_io_.close();
+    FlushBitmaps();
+    WritePhysicalPage(META_PAGE_ID, meta_data_);
     closed = true;
+    close(db_fd_);
   }
 }
 
-void DiskManager::ReadPage(page_id_t logical_page_id, char *page_data) {
+bool DiskManager::ReadPage(page_id_t logical_page_id, char *page_data) {
   ASSERT(logical_page_id >= 0, "Invalid page id.");
-  ReadPhysicalPage(MapPageId(logical_page_id), page_data);
+  return ReadPhysicalPage(MapPageId(logical_page_id), page_data);
 }
 
-void DiskManager::WritePage(page_id_t logical_page_id, const char *page_data) {
+bool DiskManager::WritePage(page_id_t logical_page_id, const char *page_data) {
   ASSERT(logical_page_id >= 0, "Invalid page id.");
-  WritePhysicalPage(MapPageId(logical_page_id), page_data);
+  return WritePhysicalPage(MapPageId(logical_page_id), page_data);
+}
+
+void DiskManager::Submit(std::vector<DiskIORequest> &requests) {
+  if (closed) {
+    for (auto &request : requests) {
+      if (request.callback) {
+        request.callback(false);
+      }
+    }
+    return;
+  }
+  std::vector<DiskIORequest> physical_requests(requests);
+  for (auto &request : physical_requests) {
+    ASSERT(request.page_id >= 0, "Invalid page id.");
+    request.page_id = MapPageId(request.page_id);
+  }
+  io_backend_->Submit(physical_requests);
 }
 
 /**
  * TODO: Student Implement
  */
-page_id_t DiskManager::AllocatePage() {
+page_id_t DiskManager::AllocatePage() { return AllocatePages(1); }
+
+page_id_t DiskManager::AllocateRun(uint32_t run_size) { return AllocatePages(run_size); }
+
+page_id_t DiskManager::AllocatePages(uint32_t run_size) {
   std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
   auto meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
 
-  if (meta_page->GetAllocatedPages() >= MAX_VALID_PAGE_ID) {
+  if (meta_page->GetAllocatedPages() + run_size > MAX_VALID_PAGE_ID) {
     LOG(WARNING) << "Cannot allocate page. Database is full. Allocated pages: "
                  << meta_page->GetAllocatedPages() << ", Max valid pages: " << MAX_VALID_PAGE_ID;
     return INVALID_PAGE_ID;
   }
-
-  // Try to find a free page in existing extents
-  for (uint32_t extent_id = 0; extent_id < meta_page->GetExtentNums(); ++extent_id) {
-    if (meta_page->GetExtentUsedPage(extent_id) < BITMAP_SIZE) {
-      page_id_t bitmap_physical_page_id = 1 + extent_id * (1 + BITMAP_SIZE);
-      char page_buffer[PAGE_SIZE];
-      ReadPhysicalPage(bitmap_physical_page_id, page_buffer);
-      auto bitmap = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(page_buffer);
-
+  auto allocate = [run_size](BitmapPage<PAGE_SIZE> *bitmap, uint32_t &page_offset) {
+    return run_size == 1 ? bitmap->AllocatePage(page_offset) : bitmap->AllocateRun(run_size, page_offset);
+  };
+
+  // Try to find free pages in existing extents, starting from the extent of the last allocation. The used page
+  // counts are in the meta page, so only the bitmap of the chosen extent is touched.
+  uint32_t extent_nums = meta_page->GetExtentNums();
+  for (uint32_t i = 0; i < extent_nums; ++i) {
+    uint32_t extent_id = (next_extent_ + i) % extent_nums;
+    if (meta_page->GetExtentUsedPage(extent_id) + run_size <= BITMAP_SIZE) {
       uint32_t page_offset_in_bitmap;
-      if (bitmap->AllocatePage(page_offset_in_bitmap)) {
-        WritePhysicalPage(bitmap_physical_page_id, page_buffer);
-        meta_page->num_allocated_pages_++;
-        meta_page->extent_used_page_[extent_id]++;
-        // WritePhysicalPage(META_PAGE_ID, meta_data_); // MetaData is flushed on Close()
+      if (allocate(GetBitmap(extent_id), page_offset_in_bitmap)) {
+        bitmaps_[extent_id]->dirty = true;
+        meta_page->num_allocated_pages_ += run_size;
+        meta_page->extent_used_page_[extent_id] += run_size;
+        next_extent_ = extent_id;
+        // Bitmaps and MetaData are flushed on Close()
         return static_cast<page_id_t>(extent_id * BITMAP_SIZE + page_offset_in_bitmap);
       }
     }
@@ -85,23 +110,22 @@ page_id_t DiskManager::AllocatePage() {
   // offsetof(DiskFileMetaPage, extent_used_page_) is typically 8 bytes for the two uint32_t members before it.
   uint32_t max_extents_possible = (PAGE_SIZE - offsetof(DiskFileMetaPage, extent_used_page_)) / sizeof(uint32_t);
 
-
   if (current_num_extents < max_extents_possible) {
     uint32_t new_extent_id = current_num_extents;
-    page_id_t bitmap_physical_page_id = 1 + new_extent_id * (1 + BITMAP_SIZE);
+    // A new bitmap page is all zeros (all free), there is nothing to read.
+    if (bitmaps_.size() <= new_extent_id) {
+      bitmaps_.resize(new_extent_id + 1);
+    }
+    bitmaps_[new_extent_id] = std::make_unique<CachedBitmap>();
+    auto bitmap = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(bitmaps_[new_extent_id]->data);
 
-    char page_buffer[PAGE_SIZE];
-    std::memset(page_buffer, 0, PAGE_SIZE); // Initialize new bitmap page to all zeros (all free)
-    auto bitmap = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(page_buffer);
-    
     uint32_t page_offset_in_bitmap;
-    if (bitmap->AllocatePage(page_offset_in_bitmap)) { // Should allocate the first page (offset 0)
-      WritePhysicalPage(bitmap_physical_page_id, page_buffer);
-
+    if (allocate(bitmap, page_offset_in_bitmap)) {  // Should allocate the first pages (offset 0)
+      bitmaps_[new_extent_id]->dirty = true;
       meta_page->num_extents_++;
-      meta_page->num_allocated_pages_++;
-      meta_page->extent_used_page_[new_extent_id] = 1;
-      // WritePhysicalPage(META_PAGE_ID, meta_data_); // MetaData is flushed on Close()
+      meta_page->num_allocated_pages_ += run_size;
+      meta_page->extent_used_page_[new_extent_id] = run_size;
+      next_extent_ = new_extent_id;
       return static_cast<page_id_t>(new_extent_id * BITMAP_SIZE + page_offset_in_bitmap);
     } else {
       LOG(ERROR) << "Failed to allocate page in a brand new bitmap page. This should not happen.";
@@ -136,16 +160,10 @@ void DiskManager::DeAllocatePage(page_id_t logical_page_id) {
     return;
   }
 
-  page_id_t bitmap_physical_page_id = 1 + extent_id * (1 + BITMAP_SIZE);
-  char page_buffer[PAGE_SIZE];
-  ReadPhysicalPage(bitmap_physical_page_id, page_buffer);
-  auto bitmap = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(page_buffer);
-
-  if (bitmap->DeAllocatePage(page_offset_in_bitmap)) {
-    WritePhysicalPage(bitmap_physical_page_id, page_buffer);
+  if (GetBitmap(extent_id)->DeAllocatePage(page_offset_in_bitmap)) {
+    bitmaps_[extent_id]->dirty = true;
     meta_page->num_allocated_pages_--;
     meta_page->extent_used_page_[extent_id]--;
-    // WritePhysicalPage(META_PAGE_ID, meta_data_); // MetaData is flushed on Close()
   } else {
     LOG(ERROR) << "Failed to deallocate logical page " << logical_page_id
                << " (offset " << page_offset_in_bitmap << " in extent " << extent_id
@@ -153,11 +171,39 @@ void DiskManager::DeAllocatePage(page_id_t logical_page_id) {
   }
 }
 
+void DiskManager::DeAllocateRun(page_id_t first_page_id, uint32_t count) {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  auto meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+
+  // A range of logical pages may span several extents, release it extent by extent.
+  while (count > 0) {
+    uint32_t extent_id = first_page_id / BITMAP_SIZE;
+    uint32_t page_offset_in_bitmap = first_page_id % BITMAP_SIZE;
+    uint32_t extent_count = std::min<uint32_t>(count, BITMAP_SIZE - page_offset_in_bitmap);
+    if (first_page_id < 0 || extent_id >= meta_page->GetExtentNums()) {
+      LOG(ERROR) << "Attempting to deallocate pages from " << first_page_id << " in non-existent extent " << extent_id;
+      return;
+    }
+    if (GetBitmap(extent_id)->DeAllocateRun(page_offset_in_bitmap, extent_count)) {
+      bitmaps_[extent_id]->dirty = true;
+      meta_page->num_allocated_pages_ -= extent_count;
+      meta_page->extent_used_page_[extent_id] -= extent_count;
+    } else {
+      // Some page of the range is free already, fall back to releasing the pages one by one.
+      for (uint32_t i = 0; i < extent_count; i++) {
+        DeAllocatePage(first_page_id + i);
+      }
+    }
+    first_page_id += extent_count;
+    count -= extent_count;
+  }
+}
+
 /**
  * TODO: Student Implement
  */
 bool DiskManager::IsPageFree(page_id_t logical_page_id) {
-  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_); // Read operation, but involves disk read
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
   auto meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
 
   if (logical_page_id < 0) return false; // Invalid pages are not "free" in a usable sense
@@ -171,12 +217,39 @@ bool DiskManager::IsPageFree(page_id_t logical_page_id) {
     return true;
   }
 
-  page_id_t bitmap_physical_page_id = 1 + extent_id * (1 + BITMAP_SIZE);
-  char page_buffer[PAGE_SIZE];
-  ReadPhysicalPage(bitmap_physical_page_id, page_buffer);
-  auto bitmap = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(page_buffer);
+  return GetBitmap(extent_id)->IsPageFree(page_offset_in_bitmap);
+}
+
+BitmapPage<PAGE_SIZE> *DiskManager::GetBitmap(uint32_t extent_id) {
+  if (bitmaps_.size() <= extent_id) {
+    bitmaps_.resize(extent_id + 1);
+  }
+  if (bitmaps_[extent_id] == nullptr) {
+    auto bitmap = std::make_unique<CachedBitmap>();
+    if (!ReadPhysicalPage(GetBitmapPhysicalPageId(extent_id), bitmap->data)) {
+      throw std::runtime_error("Failed to read the bitmap page of extent " + std::to_string(extent_id));
+    }
+    bitmaps_[extent_id] = std::move(bitmap);
+  }
+  return reinterpret_cast<BitmapPage<PAGE_SIZE> *>(bitmaps_[extent_id]->data);
+}
 
-  return bitmap->IsPageFree(page_offset_in_bitmap);
+void DiskManager::FlushBitmaps() {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  std::vector<DiskIORequest> requests;
+  for (uint32_t extent_id = 0; extent_id < bitmaps_.size(); extent_id++) {
+    if (bitmaps_[extent_id] != nullptr && bitmaps_[extent_id]->dirty) {
+      CachedBitmap *bitmap = bitmaps_[extent_id].get();
+      requests.push_back({true, GetBitmapPhysicalPageId(extent_id), bitmap->data, [bitmap](bool success) {
+                            // A bitmap that did not make it to disk is written again by the next flush.
+                            bitmap->dirty = !success;
+                          }});
+      bitmap->dirty = false;
+    }
+  }
+  if (!closed) {
+    io_backend_->Submit(requests);
+  }
 }
 
 /**
@@ -198,45 +271,26 @@ page_id_t DiskManager::MapPageId(page_id_t logical_page_id) {
   return physical_page_id;
 }
 
-int DiskManager::GetFileSize(const std::string &file_name) {
-  struct stat stat_buf;
-  int rc = stat(file_name.c_str(), &stat_buf);
-  return rc == 0 ? stat_buf.st_size : -1;
-}
-
-void DiskManager::ReadPhysicalPage(page_id_t physical_page_id, char *page_data) {
-  int offset = physical_page_id * PAGE_SIZE;
-  // check if read beyond file length
-  if (offset >= GetFileSize(file_name_)) {
-#ifdef ENABLE_BPM_DEBUG
-    LOG(INFO) << "Read less than a page" << std::endl;
-#endif
+bool DiskManager::ReadPhysicalPage(page_id_t physical_page_id, char *page_data) {
+  if (closed) {
     memset(page_data, 0, PAGE_SIZE);
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
-#ifdef ENABLE_BPM_DEBUG
-      LOG(INFO) << "Read less than a page" << std::endl;
-#endif
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
-    }
+    return true;
   }
+  // Reading beyond the end of the file yields zeros.
+  bool success = false;
+  std::vector<DiskIORequest> requests{
+      {false, physical_page_id, page_data, [&success](bool result) { success = result; }}};
+  io_backend_->Submit(requests);
+  return success;
 }
 
-void DiskManager::WritePhysicalPage(page_id_t physical_page_id, const char *page_data) {
-  size_t offset = static_cast<size_t>(physical_page_id) * PAGE_SIZE;
-  // set write cursor to offset
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG(ERROR) << "I/O error while writing";
-    return;
+bool DiskManager::WritePhysicalPage(page_id_t physical_page_id, const char *page_data) {
+  if (closed) {
+    return true;  // Pages still flushed by the buffer pool after Close are dropped.
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  bool success = false;
+  std::vector<DiskIORequest> requests{
+      {true, physical_page_id, const_cast<char *>(page_data), [&success](bool result) { success = result; }}};
+  io_backend_->Submit(requests);
+  return success;
 }
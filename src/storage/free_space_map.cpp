@@ -0,0 +1,141 @@
+#include "storage/free_space_map.h"
+
+#include <algorithm>
+
+#include "glog/logging.h"
+
+bool FreeSpaceMap::Init() {
+  page_id_t page_id;
+  auto page = buffer_pool_manager_->NewPage(page_id, page_run_);
+  if (page == nullptr) {
+    return false;
+  }
+  reinterpret_cast<FreeSpaceMapPage *>(page->GetData())->Init();
+  buffer_pool_manager_->UnpinPage(page_id, true);
+  map_page_ids_.push_back(page_id);
+  block_max_categories_.push_back(0);
+  return true;
+}
+
+bool FreeSpaceMap::Load(page_id_t first_page_id) {
+  page_id_t page_id = first_page_id;
+  while (page_id != INVALID_PAGE_ID) {
+    auto page = buffer_pool_manager_->FetchPage(page_id);
+    if (page == nullptr) {
+      LOG(ERROR) << "Failed to fetch free space map page " << page_id;
+      // Leave the map empty, the caller rebuilds it from scratch.
+      map_page_ids_.clear();
+      table_page_ids_.clear();
+      categories_.clear();
+      block_max_categories_.clear();
+      slots_.clear();
+      return false;
+    }
+    auto map_page = reinterpret_cast<FreeSpaceMapPage *>(page->GetData());
+    uint8_t block_max = 0;
+    for (uint32_t i = 0; i < map_page->GetEntryCount(); i++) {
+      slots_[map_page->GetTablePageId(i)] = table_page_ids_.size();
+      table_page_ids_.push_back(map_page->GetTablePageId(i));
+      categories_.push_back(map_page->GetCategory(i));
+      block_max = std::max(block_max, map_page->GetCategory(i));
+    }
+    map_page_ids_.push_back(page_id);
+    block_max_categories_.push_back(block_max);
+    page_id_t next_page_id = map_page->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+  return !map_page_ids_.empty();
+}
+
+void FreeSpaceMap::Destroy() {
+  buffer_pool_manager_->DeletePages(map_page_ids_);
+  map_page_ids_.clear();
+  table_page_ids_.clear();
+  categories_.clear();
+  block_max_categories_.clear();
+  slots_.clear();
+}
+
+bool FreeSpaceMap::AddPage(page_id_t table_page_id, uint32_t free_bytes) {
+  ASSERT(!map_page_ids_.empty(), "Free space map is not initialized.");
+  uint8_t category = FreeSpaceMapPage::ToCategory(free_bytes);
+  page_id_t tail_id = map_page_ids_.back();
+  auto page = buffer_pool_manager_->FetchPage(tail_id);
+  if (page == nullptr) {
+    return false;
+  }
+  auto map_page = reinterpret_cast<FreeSpaceMapPage *>(page->GetData());
+  if (!map_page->Append(table_page_id, category)) {
+    // The last map page is full, chain a new one.
+    page_id_t new_page_id;
+    auto new_page = buffer_pool_manager_->NewPage(new_page_id, page_run_);
+    if (new_page == nullptr) {
+      buffer_pool_manager_->UnpinPage(tail_id, false);
+      return false;
+    }
+    map_page->SetNextPageId(new_page_id);
+    buffer_pool_manager_->UnpinPage(tail_id, true);
+    map_page = reinterpret_cast<FreeSpaceMapPage *>(new_page->GetData());
+    map_page->Init();
+    map_page->Append(table_page_id, category);
+    map_page_ids_.push_back(new_page_id);
+    block_max_categories_.push_back(0);
+    tail_id = new_page_id;
+  }
+  buffer_pool_manager_->UnpinPage(tail_id, true);
+  slots_[table_page_id] = table_page_ids_.size();
+  table_page_ids_.push_back(table_page_id);
+  categories_.push_back(category);
+  block_max_categories_.back() = std::max(block_max_categories_.back(), category);
+  return true;
+}
+
+void FreeSpaceMap::UpdatePage(page_id_t table_page_id, uint32_t free_bytes) {
+  auto iter = slots_.find(table_page_id);
+  if (iter == slots_.end()) {
+    return;
+  }
+  uint32_t slot = iter->second;
+  uint8_t category = FreeSpaceMapPage::ToCategory(free_bytes);
+  if (categories_[slot] == category) {
+    return;
+  }
+  uint32_t block = slot / FreeSpaceMapPage::MAX_ENTRY_COUNT;
+  auto page = buffer_pool_manager_->FetchPage(map_page_ids_[block]);
+  if (page == nullptr) {
+    LOG(WARNING) << "Failed to fetch free space map page " << map_page_ids_[block];
+    return;
+  }
+  auto map_page = reinterpret_cast<FreeSpaceMapPage *>(page->GetData());
+  map_page->SetCategory(slot % FreeSpaceMapPage::MAX_ENTRY_COUNT, category);
+  buffer_pool_manager_->UnpinPage(map_page_ids_[block], true);
+  categories_[slot] = category;
+  block_max_categories_[block] = std::max(block_max_categories_[block], category);
+}
+
+bool FreeSpaceMap::HasSpace(page_id_t table_page_id, uint32_t required_bytes) const {
+  auto iter = slots_.find(table_page_id);
+  return iter != slots_.end() && categories_[iter->second] >= FreeSpaceMapPage::ToRequiredCategory(required_bytes);
+}
+
+page_id_t FreeSpaceMap::FindPage(uint32_t required_bytes) {
+  uint8_t required = FreeSpaceMapPage::ToRequiredCategory(required_bytes);
+  for (uint32_t block = 0; block < block_max_categories_.size(); block++) {
+    if (block_max_categories_[block] < required) {
+      continue;
+    }
+    uint32_t begin = block * FreeSpaceMapPage::MAX_ENTRY_COUNT;
+    uint32_t end = std::min<uint32_t>(begin + FreeSpaceMapPage::MAX_ENTRY_COUNT, categories_.size());
+    uint8_t block_max = 0;
+    for (uint32_t i = begin; i < end; i++) {
+      if (categories_[i] >= required) {
+        return table_page_ids_[i];
+      }
+      block_max = std::max(block_max, categories_[i]);
+    }
+    // Nothing fits, tighten the bound so that the block is skipped next time.
+    block_max_categories_[block] = block_max;
+  }
+  return INVALID_PAGE_ID;
+}
@@ -0,0 +1,93 @@
+#include "storage/read_ahead_engine.h"
+
+#include <algorithm>
+
+void ReadAheadStream::Advance(page_id_t page_id) {
+  std::scoped_lock<std::mutex> lock(engine_->latch_);
+  if (consumed_ < page_ids_.size() && page_ids_[consumed_] != page_id) {
+    // The chain no longer matches the pages the scan started with, look for the page further down.
+    auto it = std::find(page_ids_.begin() + consumed_, page_ids_.end(), page_id);
+    consumed_ = it - page_ids_.begin();
+  }
+  consumed_ = std::min(consumed_ + 1, page_ids_.size());
+  if (prefetched_ < consumed_) {
+    // The scan caught up with the read-ahead, restart it from the scan's position.
+    prefetched_ = consumed_;
+  }
+  engine_->Schedule(this);
+}
+
+std::shared_ptr<ReadAheadStream> ReadAheadEngine::OpenStream(std::vector<page_id_t> page_ids, size_t distance,
+                                                             std::shared_ptr<BufferAccessStrategy> strategy) {
+  if (distance == 0) {
+    return nullptr;
+  }
+  return std::make_shared<ReadAheadStream>(this, std::move(page_ids), distance, std::move(strategy));
+}
+
+void ReadAheadEngine::Stop() {
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    running_ = false;
+    for (auto &weak_stream : queue_) {
+      if (auto stream = weak_stream.lock()) {
+        stream->queued_ = false;
+      }
+    }
+    queue_.clear();
+  }
+  cv_.notify_all();
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+}
+
+void ReadAheadEngine::Schedule(ReadAheadStream *stream) {
+  // Refilling the window once half of it is free keeps the batches large while the worker keeps up with the scan. The
+  // tail of the table is read as soon as the window reaches it.
+  size_t window_end = std::min(stream->consumed_ + stream->distance_, stream->page_ids_.size());
+  size_t batch_size = window_end - stream->prefetched_;
+  if (stream->queued_ || batch_size == 0 ||
+      (batch_size < (stream->distance_ + 1) / 2 && window_end < stream->page_ids_.size())) {
+    return;
+  }
+  if (!running_ && worker_.joinable()) {
+    return;  // Stop is waiting for the worker, the stream is picked up again when the scan advances.
+  }
+  stream->queued_ = true;
+  queue_.push_back(stream->weak_from_this());
+  if (!running_) {
+    running_ = true;
+    worker_ = std::thread(&ReadAheadEngine::Run, this);
+  }
+  cv_.notify_one();
+}
+
+void ReadAheadEngine::Run() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (true) {
+    cv_.wait(lock, [this] { return !running_ || !queue_.empty(); });
+    if (!running_) {
+      return;
+    }
+    auto stream = queue_.front().lock();
+    queue_.pop_front();
+    if (stream == nullptr) {
+      continue;  // The scan is gone.
+    }
+
+    // Read the free part of the window as one batch with the latch released.
+    size_t window_end = std::min(stream->consumed_ + stream->distance_, stream->page_ids_.size());
+    std::vector<page_id_t> page_ids(stream->page_ids_.begin() + stream->prefetched_,
+                                    stream->page_ids_.begin() + window_end);
+    stream->prefetched_ = window_end;
+    lock.unlock();
+    buffer_pool_manager_->PrefetchPages(page_ids, stream->strategy_.get());
+    lock.lock();
+
+    stream->queued_ = false;
+    if (running_) {
+      Schedule(stream.get());
+    }
+  }
+}
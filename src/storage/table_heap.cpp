@@ -1,112 +1,109 @@
 #include "storage/table_heap.h"
 
-/**
- * TODO: Student Implement
- */
-bool TableHeap::InsertTuple(Row &row, Txn *txn) {
-  // Check if the tuple itself is too large to fit onto any page.
-  if (row.GetSerializedSize(schema_) > TablePage::SIZE_MAX_ROW) {
-    LOG(WARNING) << "Tuple too large to fit in any page. Serialized size: " << row.GetSerializedSize(schema_);
-    return false;
+TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id,
+                     page_id_t free_space_map_page_id, Schema *schema, LogManager *log_manager,
+                     LockManager *lock_manager)
+    : buffer_pool_manager_(buffer_pool_manager),
+      first_page_id_(first_page_id),
+      free_space_map_(buffer_pool_manager),
+      schema_(schema),
+      log_manager_(log_manager),
+      lock_manager_(lock_manager) {
+  if (free_space_map_page_id != INVALID_PAGE_ID && free_space_map_.Load(free_space_map_page_id)) {
+    last_page_id_ = free_space_map_.GetLastTablePageId();
+    if (first_page_id_ == INVALID_PAGE_ID && last_page_id_ != INVALID_PAGE_ID) {
+      first_page_id_ = free_space_map_.GetTablePageIds().front();
+    }
+    return;
   }
-
-  page_id_t current_page_id = first_page_id_;
-  TablePage *table_page_obj = nullptr;
-
-  // Case 1: The heap is currently empty. Create the first page.
-  if (current_page_id == INVALID_PAGE_ID) {
-    page_id_t new_first_page_id;
-    Page* raw_page = buffer_pool_manager_->NewPage(new_first_page_id);
-    if (raw_page == nullptr || new_first_page_id == INVALID_PAGE_ID) {
-      return false; // Failed to create the first page (BPM full or disk full).
+  // No usable free space map on disk, rebuild it by walking the page chain once.
+  if (!free_space_map_.Init()) {
+    LOG(ERROR) << "TableHeap Constructor: Failed to create the free space map.";
+    return;
+  }
+  page_id_t page_id = first_page_id_;
+  while (page_id != INVALID_PAGE_ID) {
+    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    if (page == nullptr) {
+      LOG(ERROR) << "TableHeap Constructor: Failed to fetch page " << page_id << " while building free space map.";
+      break;
     }
-    first_page_id_ = new_first_page_id; // Update heap's first page ID.
-    current_page_id = first_page_id_;   // This is now the page to try.
-
-    table_page_obj = reinterpret_cast<TablePage*>(raw_page);
-    table_page_obj->Init(current_page_id, INVALID_PAGE_ID, log_manager_, txn);
-    // The page is currently pinned by NewPage. It will be unpinned after the insert attempt.
+    free_space_map_.AddPage(page_id, page->GetFreeSpaceRemaining());
+    last_page_id_ = page_id;
+    page_id_t next_page_id = page->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = next_page_id;
   }
+}
 
-  // Case 2: Heap is not empty, or first page was just created. Iterate to find space.
-  while (current_page_id != INVALID_PAGE_ID) {
-    // Fetch the current page if not already available (e.g., from the first page creation step)
-    if (table_page_obj == nullptr || table_page_obj->GetTablePageId() != current_page_id) {
-        table_page_obj = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(current_page_id));
+TablePage *TableHeap::AppendPage(Txn *txn) {
+  page_id_t new_page_id;
+  auto new_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(new_page_id, &page_run_));
+  if (new_page == nullptr) {
+    return nullptr;
+  }
+  if (last_page_id_ != INVALID_PAGE_ID) {
+    auto last_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(last_page_id_));
+    if (last_page == nullptr) {
+      buffer_pool_manager_->UnpinPage(new_page_id, false);
+      buffer_pool_manager_->DeletePage(new_page_id);
+      return nullptr;
     }
+    last_page->SetNextPageId(new_page_id);
+    buffer_pool_manager_->UnpinPage(last_page_id_, true);
+  } else {
+    first_page_id_ = new_page_id;
+  }
+  new_page->Init(new_page_id, last_page_id_, log_manager_, txn);
+  free_space_map_.AddPage(new_page_id, new_page->GetFreeSpaceRemaining());
+  last_page_id_ = new_page_id;
+  return new_page;
+}
+
+bool TableHeap::InsertTuple(Row &row, Txn *txn) {
+  // Check if the tuple itself is too large to fit onto any page.
+  uint32_t serialized_size = row.GetSerializedSize(schema_);
+  if (serialized_size > TablePage::SIZE_MAX_ROW) {
+    LOG(WARNING) << "Tuple too large to fit in any page. Serialized size: " << serialized_size;
+    return false;
+  }
+  uint32_t required_size = serialized_size + TablePage::SIZE_TUPLE;
 
-    if (table_page_obj == nullptr) {
-      LOG(ERROR) << "InsertTuple: Failed to fetch page " << current_page_id << ". Aborting insert.";
+  // Prefer the cached tail, then ask the free space map, and only append when no page has room.
+  page_id_t page_id = last_page_id_;
+  if (!free_space_map_.HasSpace(page_id, required_size)) {
+    page_id = free_space_map_.FindPage(required_size);
+  }
+  if (page_id != INVALID_PAGE_ID) {
+    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    if (page == nullptr) {
+      LOG(ERROR) << "InsertTuple: Failed to fetch page " << page_id << ". Aborting insert.";
       return false;
     }
-
-    // Try to insert the tuple into the current page.
-    // TablePage::InsertTuple will set row.rid_ if successful.
-    if (table_page_obj->InsertTuple(row, schema_, txn, lock_manager_, log_manager_)) {
-      buffer_pool_manager_->UnpinPage(current_page_id, true); // Page is dirty due to insert.
+    page->WLatch();
+    bool inserted = page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+    uint32_t free_space = page->GetFreeSpaceRemaining();
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, inserted);
+    // Categories are rounded down, so the insert only fails if the map is stale. Refresh it either way.
+    free_space_map_.UpdatePage(page_id, free_space);
+    if (inserted) {
       return true;
     }
-
-    // If insertion failed on this page (likely no space), try the next page.
-    page_id_t next_page_id_in_chain = table_page_obj->GetNextPageId();
-    buffer_pool_manager_->UnpinPage(current_page_id, false); // Unpin current page (not dirtied by failed insert).
-    current_page_id = next_page_id_in_chain;
-    table_page_obj = nullptr; // Nullify to ensure re-fetch for the next page in loop.
-  }
-
-  // Case 3: All existing pages are full. Need to allocate a new page and append it.
-  // current_page_id is now INVALID_PAGE_ID. We need the ID of the actual last page in the chain.
-  page_id_t actual_last_page_id = INVALID_PAGE_ID;
-  TablePage* actual_last_page_obj_pinned = nullptr; // Pointer to the pinned last page
-
-  // Re-traverse to find the last page (if any, first_page_id_ should be valid now).
-  // This part is crucial and needs to correctly identify the last page if the heap wasn't initially empty.
-  if (first_page_id_ == INVALID_PAGE_ID) {
-      // This state should not be reached if empty heap was handled by creating a first page and failing there.
-      // If it implies the very first page creation also failed to hold the tuple, this indicates an issue.
-      LOG(ERROR) << "InsertTuple: Heap is unexpectedly still marked empty before allocating a new page at the end.";
-      return false;
   }
 
-  page_id_t iter_pid = first_page_id_;
-  while(iter_pid != INVALID_PAGE_ID) {
-      actual_last_page_obj_pinned = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(iter_pid));
-      if (actual_last_page_obj_pinned == nullptr) {
-           LOG(ERROR) << "InsertTuple: Failed to fetch page " << iter_pid << " while finding chain end.";
-           return false; // Should not happen in a consistent heap
-      }
-      actual_last_page_id = iter_pid;
-      page_id_t next_pid_in_chain = actual_last_page_obj_pinned->GetNextPageId();
-      if (next_pid_in_chain == INVALID_PAGE_ID) { // This is the last page in the chain
-          break; // Keep actual_last_page_obj_pinned
-      }
-      buffer_pool_manager_->UnpinPage(iter_pid, false); // Unpin intermediate pages
-      iter_pid = next_pid_in_chain;
+  auto new_page = AppendPage(txn);
+  if (new_page == nullptr) {
+    return false;  // BPM full or disk full.
   }
-  ASSERT(actual_last_page_obj_pinned != nullptr && actual_last_page_id != INVALID_PAGE_ID,
-         "Failed to find the last page to append a new page.");
-
-  // Allocate a new page from BPM.
-  page_id_t new_page_disk_id;
-  Page* raw_page_bpm = buffer_pool_manager_->NewPage(new_page_disk_id);
-  if (raw_page_bpm == nullptr || new_page_disk_id == INVALID_PAGE_ID) {
-    buffer_pool_manager_->UnpinPage(actual_last_page_id, false); // Unpin the previously fetched last page.
-    return false; // BPM full or disk full.
-  }
-  TablePage* new_table_page = reinterpret_cast<TablePage*>(raw_page_bpm);
-
-  // Initialize the new page, linking its PrevPageId to the previous actual_last_page_id.
-  new_table_page->Init(new_page_disk_id, actual_last_page_id, log_manager_, txn);
-
-  // Update the NextPageId of the previous last page to point to this new page.
-  actual_last_page_obj_pinned->SetNextPageId(new_page_disk_id);
-  buffer_pool_manager_->UnpinPage(actual_last_page_id, true); // Dirtied by SetNextPageId.
-
-  // Insert the tuple into the new page. This should succeed given prior size checks.
-  bool inserted_in_new = new_table_page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
-  buffer_pool_manager_->UnpinPage(new_page_disk_id, true); // Dirtied by Init and Insert.
-
-  return inserted_in_new;
+  page_id = new_page->GetTablePageId();
+  new_page->WLatch();
+  bool inserted = new_page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+  uint32_t free_space = new_page->GetFreeSpaceRemaining();
+  new_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, true);
+  free_space_map_.UpdatePage(page_id, free_space);
+  return inserted;
 }
 
 bool TableHeap::MarkDelete(const RowId &rid, Txn *txn) {
@@ -146,7 +143,9 @@ bool TableHeap::UpdateTuple(Row &new_row, const RowId &rid, Txn *txn) {
 
   if (updated_in_place) {
     new_row.SetRowId(rid); // If updated in place, RowId remains the same.
+    uint32_t free_space = page->GetFreeSpaceRemaining();
     buffer_pool_manager_->UnpinPage(rid.GetPageId(), true); // Page is dirty.
+    free_space_map_.UpdatePage(rid.GetPageId(), free_space);
     return true;
   }
 
@@ -204,9 +203,11 @@ void TableHeap::ApplyDelete(const RowId &rid, Txn *txn) {
   // TablePage::ApplyDelete will physically remove the tuple data and update slot information.
   // It should also handle page latching.
   page->ApplyDelete(rid, txn, log_manager_);
+  uint32_t free_space = page->GetFreeSpaceRemaining();
 
   // The page structure has been modified.
   buffer_pool_manager_->UnpinPage(rid.GetPageId(), true);
+  free_space_map_.UpdatePage(rid.GetPageId(), free_space);
 }
 
 void TableHeap::RollbackDelete(const RowId &rid, Txn *txn) {
@@ -245,6 +246,32 @@ bool TableHeap::GetTuple(Row *row, Txn *txn) {
   return found;
 }
 
+bool TableHeap::GetTuple(const RowId &rid, RowBatch *batch, [[maybe_unused]] Txn *txn) {
+  if (rid.GetPageId() == INVALID_PAGE_ID) {
+    return false;
+  }
+  auto *page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  if (page == nullptr) {
+    return false;
+  }
+  bool found = page->GetTuple(rid, batch);
+  buffer_pool_manager_->UnpinPage(rid.GetPageId(), false);
+  return found;
+}
+
+bool TableHeap::GetTuples(page_id_t page_id, uint32_t slot_num, RowBatch *batch, RowId *next_rid,
+                          BufferAccessStrategy *strategy) {
+  next_rid->Set(INVALID_PAGE_ID, 0);
+  auto *page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id, strategy));
+  if (page == nullptr) {
+    LOG(ERROR) << "TableHeap::GetTuples: Failed to fetch page " << page_id << ".";
+    return false;
+  }
+  page->GetTuples(slot_num, batch, next_rid);
+  buffer_pool_manager_->UnpinPage(page_id, false);
+  return true;
+}
+
 void TableHeap::DeleteTable(page_id_t page_id) {
   if (page_id != INVALID_PAGE_ID) {
     auto temp_table_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));  // 删除table_heap
@@ -253,10 +280,17 @@ void TableHeap::DeleteTable(page_id_t page_id) {
     buffer_pool_manager_->UnpinPage(page_id, false);
     buffer_pool_manager_->DeletePage(page_id);
   } else {
-    DeleteTable(first_page_id_);
+    FreeTableHeap();
   }
 }
 
+void TableHeap::FreeTableHeap() {
+  buffer_pool_manager_->DeletePages(free_space_map_.GetTablePageIds());
+  free_space_map_.Destroy();
+  buffer_pool_manager_->ReleasePageRun(&page_run_);
+  first_page_id_ = last_page_id_ = INVALID_PAGE_ID;
+}
+
 /**
  * TODO: Student Implement
  */
@@ -268,21 +302,36 @@ TableIterator TableHeap::Begin(Txn *txn) {
     return End(); // Heap is empty.
   }
 
+  // A scan over a large part of the pool recycles a ring of frames, so that it does not flush the hot pages.
+  std::shared_ptr<BufferAccessStrategy> strategy;
+  if (buffer_pool_manager_->IsBulkRead(GetPageCount())) {
+    strategy = buffer_pool_manager_->GetBulkReadStrategy();
+  }
+  std::shared_ptr<ReadAheadStream> read_ahead;
+  if (GetPageCount() > 1) {
+    auto engine = buffer_pool_manager_->GetReadAheadEngine();
+    read_ahead = engine->OpenStream(GetPageIds(), read_ahead_distance_, strategy);
+  }
+
   // Iterate through pages starting from the first page to find the first valid tuple.
   while (current_page_id != INVALID_PAGE_ID) {
-    TablePage *page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(current_page_id));
+    TablePage *page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(current_page_id, strategy.get()));
     if (page == nullptr) {
       LOG(ERROR) << "TableHeap::Begin: Failed to fetch page " << current_page_id << ".";
       return End(); // Error fetching page, return end iterator.
     }
 
+    if (read_ahead != nullptr) {
+      read_ahead->Advance(current_page_id);
+    }
+
     // TablePage::GetFirstTupleRid should find the RID of the first non-deleted tuple on this page.
     if (page->GetFirstTupleRid(&first_valid_rid)) {
       // Found the first tuple in the heap.
       buffer_pool_manager_->UnpinPage(current_page_id, false); // Unpin; read-only for finding RID.
       // The TableIterator constructor will call GetTuple, which will re-fetch/pin this page
       // and load the row data.
-      return TableIterator(this, first_valid_rid, txn);
+      return TableIterator(this, first_valid_rid, txn, strategy, read_ahead);
     }
 
     // No valid (non-deleted) tuples on this page, try the next page in the chain.
@@ -6,8 +6,11 @@
 /**
  * TODO: Student Implement
  */
-TableIterator::TableIterator(TableHeap *table_heap, RowId rid, Txn *txn) :
-    table_heap_(table_heap), current_rid_(rid), txn_(txn) {
+TableIterator::TableIterator(TableHeap *table_heap, RowId rid, Txn *txn,
+                             std::shared_ptr<BufferAccessStrategy> strategy,
+                             std::shared_ptr<ReadAheadStream> read_ahead) :
+    table_heap_(table_heap), current_rid_(rid), txn_(txn), strategy_(std::move(strategy)),
+    read_ahead_(std::move(read_ahead)) {
   if (table_heap_ != nullptr && current_rid_.GetPageId() != INVALID_PAGE_ID) {
     current_row_.SetRowId(current_rid_); // Set the RID for the row buffer
     if (!table_heap_->GetTuple(&current_row_, txn_)) {
@@ -22,6 +25,8 @@ TableIterator::TableIterator(const TableIterator &other) {
   table_heap_ = other.table_heap_;
   current_rid_ = other.current_rid_;
   txn_ = other.txn_; // Transaction pointer is shallow copied.
+  strategy_ = other.strategy_;
+  read_ahead_ = other.read_ahead_;
   current_row_ = other.current_row_; // Row's copy constructor handles deep copy of fields.
 }
 
@@ -59,6 +64,8 @@ TableIterator &TableIterator::operator=(const TableIterator &itr) noexcept {
   table_heap_ = itr.table_heap_;
   current_rid_ = itr.current_rid_;
   txn_ = itr.txn_;
+  strategy_ = itr.strategy_;
+  read_ahead_ = itr.read_ahead_;
   current_row_ = itr.current_row_; // Row's assignment operator handles deep copy.
   return *this;
 }
@@ -75,7 +82,7 @@ TableIterator &TableIterator::operator++() {
 
   page_id_t page_id_of_curr_tuple = current_rid_.GetPageId();
   TablePage *current_page_obj = reinterpret_cast<TablePage *>(
-      table_heap_->buffer_pool_manager_->FetchPage(page_id_of_curr_tuple));
+      table_heap_->buffer_pool_manager_->FetchPage(page_id_of_curr_tuple, strategy_.get()));
 
   if (current_page_obj == nullptr) {
     LOG(ERROR) << "Iterator operator++: Failed to fetch current page " << page_id_of_curr_tuple;
@@ -88,6 +95,7 @@ TableIterator &TableIterator::operator++() {
   // TablePage::GetNextTupleRid is expected to skip logically deleted tuples.
   if (current_page_obj->GetNextTupleRid(current_rid_, &next_rid_candidate)) {
     current_rid_ = next_rid_candidate;
+    current_row_.destroy(); // GetTuple deserializes into an empty row.
     current_row_.SetRowId(current_rid_); // Prepare current_row_ for GetTuple
     if (!table_heap_->GetTuple(&current_row_, txn_)) {
       current_rid_.Set(INVALID_PAGE_ID, 0); // Simplistic: fail and become end iterator.
@@ -96,23 +104,28 @@ TableIterator &TableIterator::operator++() {
     return *this;
   }
 
-  // No more tuples on the current page. Unpin it and try to move to the next page.
-  table_heap_->buffer_pool_manager_->UnpinPage(page_id_of_curr_tuple, false);
+  // No more tuples on the current page. Unpin it and try to move to the next page, the link is read while the page is
+  // still pinned since read-ahead may reuse its frame right after.
   page_id_t next_page_id_in_chain = current_page_obj->GetNextPageId();
+  table_heap_->buffer_pool_manager_->UnpinPage(page_id_of_curr_tuple, false);
 
   while (next_page_id_in_chain != INVALID_PAGE_ID) {
     current_page_obj = reinterpret_cast<TablePage *>(
-        table_heap_->buffer_pool_manager_->FetchPage(next_page_id_in_chain));
+        table_heap_->buffer_pool_manager_->FetchPage(next_page_id_in_chain, strategy_.get()));
 
     if (current_page_obj == nullptr) {
       LOG(ERROR) << "Iterator operator++: Failed to fetch next page " << next_page_id_in_chain;
       current_rid_.Set(INVALID_PAGE_ID, 0); // Critical error.
       return *this;
     }
+    if (read_ahead_ != nullptr) {
+      read_ahead_->Advance(next_page_id_in_chain);
+    }
 
     // Try to find the first valid tuple on this new page.
     if (current_page_obj->GetFirstTupleRid(&next_rid_candidate)) {
       current_rid_ = next_rid_candidate;
+      current_row_.destroy();
       current_row_.SetRowId(current_rid_);
       if (!table_heap_->GetTuple(&current_row_, txn_)) {
         // LOG(WARNING) << "Iterator operator++: GetTuple failed for first RID on new page " << current_rid_.Get();
@@ -140,3 +153,39 @@ TableIterator TableIterator::operator++(int) {
   ++(*this);                 // Call the prefix increment operator on the original iterator.
   return TableIterator(temp);               // Return the copy (the state before it was incremented).
 }
+
+uint32_t TableIterator::NextBatch(RowBatch *batch) {
+  uint32_t row_count = batch->GetRowCount();
+  auto *buffer_pool_manager = table_heap_ == nullptr ? nullptr : table_heap_->buffer_pool_manager_;
+  bool new_page = false;  // whether the scan moved on to the page, the read-ahead is told about it then
+  while (table_heap_ != nullptr && current_rid_.GetPageId() != INVALID_PAGE_ID) {
+    page_id_t page_id = current_rid_.GetPageId();
+    auto *page = reinterpret_cast<TablePage *>(buffer_pool_manager->FetchPage(page_id, strategy_.get()));
+    if (page == nullptr) {
+      LOG(ERROR) << "Iterator NextBatch: Failed to fetch page " << page_id;
+      current_rid_.Set(INVALID_PAGE_ID, 0);
+      break;
+    }
+    if (new_page && read_ahead_ != nullptr) {
+      read_ahead_->Advance(page_id);
+    }
+    RowId next_rid;
+    page->GetTuples(current_rid_.GetSlotNum(), batch, &next_rid);
+    if (next_rid.GetPageId() != INVALID_PAGE_ID) {
+      // The batch is full, the iterator stays on the first row left out.
+      current_rid_ = next_rid;
+      current_row_.destroy();
+      current_row_.SetRowId(current_rid_);
+      page->GetTuple(&current_row_, table_heap_->schema_, txn_, table_heap_->lock_manager_);
+      buffer_pool_manager->UnpinPage(page_id, false);
+      return batch->GetRowCount() - row_count;
+    }
+    // Continue at the first slot of the next page, deleted tuples are skipped there.
+    current_rid_.Set(page->GetNextPageId(), 0);
+    new_page = true;
+    buffer_pool_manager->UnpinPage(page_id, false);
+  }
+  current_rid_.Set(INVALID_PAGE_ID, 0);
+  current_row_.destroy();
+  return batch->GetRowCount() - row_count;
+}
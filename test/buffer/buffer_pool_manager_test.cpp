@@ -3,6 +3,8 @@
 #include <cstdio>
 #include <random>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -71,4 +73,233 @@ TEST(BufferPoolManagerTest, BinaryDataTest) {
 
   delete bpm;
   delete disk_manager;
-}
\ No newline at end of file
+}
+TEST(BufferPoolManagerTest, ShardedConcurrentTest) {
+  const std::string db_name = "bpm_sharded_test.db";
+  const size_t buffer_pool_size = 64;
+  const size_t num_instances = 4;
+  const int num_threads = 4;
+  const int pages_per_thread = 100;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, num_instances);
+  ASSERT_EQ(num_instances, bpm->GetNumInstances());
+
+  // Every thread creates its own pages and stamps them with the page id, far more pages than the pool holds.
+  std::vector<std::vector<page_id_t>> page_ids(num_threads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < pages_per_thread; i++) {
+        page_id_t page_id;
+        auto page = bpm->NewPage(page_id);
+        ASSERT_NE(nullptr, page);
+        memcpy(page->GetData(), &page_id, sizeof(page_id_t));
+        page_ids[t].push_back(page_id);
+        ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  threads.clear();
+
+  // Read all pages back concurrently.
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      for (int round = 0; round < 3; round++) {
+        for (auto page_id : page_ids[(t + round) % num_threads]) {
+          auto page = bpm->FetchPage(page_id);
+          ASSERT_NE(nullptr, page);
+          page_id_t stamp;
+          memcpy(&stamp, page->GetData(), sizeof(page_id_t));
+          EXPECT_EQ(page_id, stamp);
+          ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  disk_manager->Close();
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, ConcurrentEvictionTest) {
+  const std::string db_name = "bpm_eviction_test.db";
+  const size_t buffer_pool_size = 8;
+  const int num_pages = 32;
+  const int num_threads = 8;
+  const int increments_per_thread = 2000;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(page_id));
+    page_ids.push_back(page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // The pool is much smaller than the working set, so most fetches evict a dirty page and read another one back
+  // while other threads keep hitting resident pages. No increment may get lost on the way.
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      std::default_random_engine rng(t);
+      std::uniform_int_distribution<int> dist(0, num_pages - 1);
+      for (int i = 0; i < increments_per_thread; i++) {
+        page_id_t page_id = page_ids[dist(rng)];
+        Page *page = nullptr;
+        while ((page = bpm->FetchPage(page_id)) == nullptr) {
+          std::this_thread::yield();  // all frames are pinned by other threads
+        }
+        ASSERT_EQ(page_id, page->GetPageId());
+        page->WLatch();
+        (*reinterpret_cast<uint32_t *>(page->GetData()))++;
+        page->WUnlatch();
+        ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  uint64_t total = 0;
+  for (auto page_id : page_ids) {
+    auto page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    total += *reinterpret_cast<uint32_t *>(page->GetData());
+    bpm->UnpinPage(page_id, false);
+  }
+  EXPECT_EQ(static_cast<uint64_t>(num_threads) * increments_per_thread, total);
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  disk_manager->Close();
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, PageCleanerTest) {
+  const std::string db_name = "bpm_cleaner_test.db";
+  const size_t buffer_pool_size = 64;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 2);
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    auto page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    memcpy(page->GetData(), &page_id, sizeof(page_id_t));
+    page_ids.push_back(page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  ASSERT_EQ(buffer_pool_size, bpm->GetDirtyPageCount());
+
+  // The cleaner brings the pool under the dirty ratio in the background.
+  PageCleanerOptions options;
+  options.interval_ms = 1;
+  options.dirty_ratio = 0.25;
+  bpm->StartPageCleaner(options);
+  for (int i = 0; i < 1000 && bpm->GetDirtyPageCount() > buffer_pool_size / 4; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  EXPECT_LE(bpm->GetDirtyPageCount(), buffer_pool_size / 4);
+  bpm->StopPageCleaner();
+
+  // Evicting clean pages does not write, and cleaned pages read back intact.
+  for (size_t i = 0; i < buffer_pool_size / 2; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(0, bpm->GetSyncWriteCount());
+  for (auto page_id : page_ids) {
+    auto page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(page_id, *reinterpret_cast<page_id_t *>(page->GetData()));
+    bpm->UnpinPage(page_id, false);
+  }
+
+  delete bpm;
+  disk_manager->Close();
+  delete disk_manager;
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, BulkReadStrategyTest) {
+  const std::string db_name = "bpm_bulk_read_test.db";
+  const size_t buffer_pool_size = 64;
+  const size_t hot_pages = 16;
+  const size_t scan_pages = buffer_pool_size * 4;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 2);
+  std::vector<page_id_t> scan_page_ids;
+  for (size_t i = 0; i < scan_pages; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(page_id));
+    scan_page_ids.push_back(page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  ASSERT_TRUE(bpm->IsBulkRead(scan_pages));
+
+  // Hot pages hold 1 in the pool and 2 on disk, so reading 2 back means the page was evicted and read again.
+  std::vector<page_id_t> hot_page_ids;
+  char stale_data[PAGE_SIZE] = {2};
+  for (size_t i = 0; i < hot_pages; i++) {
+    page_id_t page_id;
+    auto page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    page->GetData()[0] = 1;
+    hot_page_ids.push_back(page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    ASSERT_TRUE(bpm->FlushPage(page_id));
+    disk_manager->WritePage(page_id, stale_data);
+  }
+  auto count_resident = [&]() {
+    size_t resident = 0;
+    for (auto page_id : hot_page_ids) {
+      auto page = bpm->FetchPage(page_id);
+      EXPECT_NE(nullptr, page);
+      resident += page->GetData()[0] == 1 ? 1 : 0;
+      bpm->UnpinPage(page_id, false);
+    }
+    return resident;
+  };
+
+  // Scenario: a scan through a bulk read strategy recycles its ring and leaves the hot pages in the pool.
+  auto strategy = bpm->GetBulkReadStrategy();
+  for (auto page_id : scan_page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id, strategy.get()));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(hot_pages, count_resident());
+
+  // Scenario: the same scan without a strategy flushes the pool.
+  for (auto page_id : scan_page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(0, count_resident());
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  disk_manager->Close();
+  delete disk_manager;
+  remove(db_name.c_str());
+}
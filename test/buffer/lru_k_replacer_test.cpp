@@ -0,0 +1,147 @@
+#include "buffer/lru_k_replacer.h"
+
+#include <memory>
+#include <random>
+#include <unordered_map>
+
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "gtest/gtest.h"
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_k_replacer(7, 2, 0);
+
+  // Scenario: frames 1-5 are accessed once, frame 1 and 2 a second time.
+  for (int i = 1; i <= 5; i++) {
+    lru_k_replacer.RecordAccess(i);
+  }
+  lru_k_replacer.RecordAccess(2);
+  lru_k_replacer.RecordAccess(1);
+  for (int i = 1; i <= 5; i++) {
+    lru_k_replacer.Unpin(i);
+  }
+  EXPECT_EQ(5, lru_k_replacer.Size());
+
+  // Scenario: frames with a single access go first, in order of their access.
+  int value;
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(4, value);
+
+  // Scenario: pinned frames are not evicted, unpinning makes them evictable again.
+  lru_k_replacer.Pin(5);
+  EXPECT_EQ(2, lru_k_replacer.Size());
+  lru_k_replacer.Unpin(5);
+
+  // Scenario: frame 1 has the older second-to-last access, so it goes before frame 2.
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(5, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  EXPECT_FALSE(lru_k_replacer.Victim(&value));
+}
+
+TEST(LRUKReplacerTest, CorrelatedAccessTest) {
+  LRUKReplacer lru_k_replacer(4, 2, 4);
+
+  // Scenario: frame 0 is accessed in bursts far apart, frame 1 many times in a row like a page being scanned.
+  lru_k_replacer.RecordAccess(0);
+  for (int i = 0; i < 10; i++) {
+    lru_k_replacer.RecordAccess(1);
+  }
+  lru_k_replacer.RecordAccess(0);
+  lru_k_replacer.RecordAccess(2);
+  lru_k_replacer.RecordAccess(2);
+  for (int i = 0; i < 3; i++) {
+    lru_k_replacer.Unpin(i);
+  }
+
+  // Scenario: the burst counts as one access, so frames 1 and 2 go before frame 0, least recently accessed first.
+  int value;
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+
+  // Scenario: a frame that gets a new page forgets the accesses of the old one.
+  lru_k_replacer.RecordAccess(3);
+  for (int i = 0; i < 10; i++) {
+    lru_k_replacer.RecordAccess(2);
+  }
+  lru_k_replacer.RecordAccess(3);
+  lru_k_replacer.Unpin(3);
+  lru_k_replacer.Forget(0);
+  EXPECT_EQ(1, lru_k_replacer.Size());
+  lru_k_replacer.RecordAccess(0);
+  lru_k_replacer.Unpin(0);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(0, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+}
+
+/**
+ * Replay a mixed workload against a replacer: point lookups on a hot set smaller than the pool, running alongside
+ * sequential scans over a table ten times the pool size. A scan fetches every page several times in a row, like
+ * TableIterator does for every tuple. Returns the hit rate of the point lookups.
+ */
+static double RunMixedWorkload(Replacer *replacer, size_t num_frames) {
+  const int hot_pages = num_frames * 3 / 4;
+  const int scan_pages = num_frames * 10;
+  const int rounds = 10;
+
+  std::unordered_map<int, frame_id_t> page_table;
+  std::vector<int> frame_pages(num_frames, -1);
+  frame_id_t next_free_frame = 0;
+  auto access = [&](int page) {
+    auto it = page_table.find(page);
+    if (it != page_table.end()) {
+      replacer->Pin(it->second);
+      replacer->RecordAccess(it->second);
+      replacer->Unpin(it->second);
+      return true;
+    }
+    frame_id_t frame_id;
+    if (next_free_frame < static_cast<frame_id_t>(num_frames)) {
+      frame_id = next_free_frame++;
+    } else {
+      EXPECT_TRUE(replacer->Victim(&frame_id));
+      page_table.erase(frame_pages[frame_id]);
+    }
+    page_table[page] = frame_id;
+    frame_pages[frame_id] = page;
+    replacer->RecordAccess(frame_id);
+    replacer->Unpin(frame_id);
+    return false;
+  };
+
+  std::default_random_engine rng(0);
+  std::uniform_int_distribution<int> hot_dist(0, hot_pages - 1);
+  int hits = 0;
+  for (int round = 0; round < rounds; round++) {
+    for (int page = 0; page < scan_pages; page++) {
+      for (int tuple = 0; tuple < 4; tuple++) {
+        access(hot_pages + page);
+      }
+      hits += access(hot_dist(rng)) ? 1 : 0;
+    }
+  }
+  return static_cast<double>(hits) / (rounds * scan_pages);
+}
+
+TEST(LRUKReplacerTest, ScanResistanceTest) {
+  const size_t num_frames = 256;
+  LRUReplacer lru(num_frames);
+  CLOCKReplacer clock(num_frames);
+  LRUKReplacer lru_k(num_frames);
+  double lru_hit_rate = RunMixedWorkload(&lru, num_frames);
+  double clock_hit_rate = RunMixedWorkload(&clock, num_frames);
+  double lru_k_hit_rate = RunMixedWorkload(&lru_k, num_frames);
+  // Scans keep pushing hot pages out under LRU and CLOCK, but not under LRU-K.
+  EXPECT_GT(lru_k_hit_rate, 0.9);
+  EXPECT_GT(lru_k_hit_rate, lru_hit_rate);
+  EXPECT_GT(lru_k_hit_rate, clock_hit_rate);
+}
@@ -68,6 +68,40 @@ TEST(CatalogTest, CatalogTableTest) {
   delete db_02;
 }
 
+TEST(CatalogTest, CatalogFreeSpaceMapTest) {
+  auto db_01 = new DBStorageEngine(db_file_name, true);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  Txn txn;
+  TableInfo *table_info = nullptr;
+  ASSERT_EQ(DB_SUCCESS, db_01->catalog_mgr_->CreateTable("table-1", schema.get(), &txn, table_info));
+  // Drop the free space map from the table metadata, as if it could not be read.
+  auto bpm = db_01->bpm_;
+  CatalogMeta *catalog_meta = CatalogMeta::DeserializeFrom(bpm->FetchPage(CATALOG_META_PAGE_ID)->GetData());
+  bpm->UnpinPage(CATALOG_META_PAGE_ID, false);
+  page_id_t meta_page_id = catalog_meta->GetTableMetaPages()->begin()->second;
+  delete catalog_meta;
+  Page *meta_page = bpm->FetchPage(meta_page_id);
+  TableMetadata *table_meta = nullptr;
+  TableMetadata::DeserializeFrom(meta_page->GetData(), table_meta);
+  table_meta->SetFreeSpaceMapPageId(INVALID_PAGE_ID);
+  table_meta->SerializeTo(meta_page->GetData());
+  bpm->UnpinPage(meta_page_id, true);
+  delete table_meta;
+  delete db_01;
+  // The map rebuilt by the next open is persisted, later opens load it.
+  auto db_02 = new DBStorageEngine(db_file_name, false);
+  ASSERT_EQ(DB_SUCCESS, db_02->catalog_mgr_->GetTable("table-1", table_info));
+  page_id_t map_page_id = table_info->GetTableHeap()->GetFreeSpaceMapPageId();
+  ASSERT_NE(INVALID_PAGE_ID, map_page_id);
+  delete db_02;
+  auto db_03 = new DBStorageEngine(db_file_name, false);
+  ASSERT_EQ(DB_SUCCESS, db_03->catalog_mgr_->GetTable("table-1", table_info));
+  ASSERT_EQ(map_page_id, table_info->GetTableHeap()->GetFreeSpaceMapPageId());
+  ASSERT_EQ(1, table_info->GetTableHeap()->GetPageCount());
+  delete db_03;
+}
+
 TEST(CatalogTest, CatalogIndexTest) {
   /** Stage 1: Testing simple operation */
   auto db_01 = new DBStorageEngine(db_file_name, true);
@@ -126,4 +160,76 @@ TEST(CatalogTest, CatalogIndexTest) {
     ASSERT_EQ(rid.Get(), ret_02[i].Get());
   }
   delete db_02;
-}
\ No newline at end of file
+}
+
+TEST(CatalogTest, CatalogIndexBackfillTest) {
+  auto db = new DBStorageEngine(db_file_name, true);
+  auto &catalog = db->catalog_mgr_;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false),
+                                   new Column("code", TypeId::kTypeInt, 2, false, true)};
+  auto schema = std::make_shared<Schema>(columns);
+  Txn txn;
+  TableInfo *table_info = nullptr;
+  ASSERT_EQ(DB_SUCCESS, catalog->CreateTable("table-1", schema.get(), &txn, table_info));
+  const int n = 5000;
+  std::vector<RowId> row_ids(n);
+  for (int i = 0; i < n; i++) {
+    // Ids in a scrambled order, names with plenty of duplicates, and codes breaking their unique constraint once.
+    std::string name = "name-" + std::to_string(i % 10);
+    std::vector<Field> fields{Field(TypeId::kTypeInt, (i * 7919) % n),
+                              Field(TypeId::kTypeChar, const_cast<char *>(name.c_str()), name.size(), true),
+                              Field(TypeId::kTypeInt, i == n - 1 ? 0 : i)};
+    Row row(fields);
+    ASSERT_TRUE(table_info->GetTableHeap()->InsertTuple(row, &txn));
+    row_ids[(i * 7919) % n] = row.GetRowId();
+  }
+
+  // Scenario: an index on a populated table finds every row that was there before it.
+  IndexInfo *index_info = nullptr;
+  ASSERT_EQ(DB_SUCCESS, catalog->CreateIndex("table-1", "index-id", {"id"}, &txn, index_info, "bptree"));
+  for (int i = 0; i < n; i++) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i)};
+    Row key(fields);
+    std::vector<RowId> result;
+    ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->ScanKey(key, result, &txn));
+    ASSERT_EQ(1, result.size());
+    ASSERT_EQ(row_ids[i].Get(), result[0].Get());
+  }
+  std::vector<Field> fields{Field(TypeId::kTypeInt, n / 2)};
+  std::vector<RowId> result;
+  ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->ScanKey(Row(fields), result, &txn, ">="));
+  ASSERT_EQ(n - n / 2, result.size());
+
+  // Scenario: an index on a column with duplicates is not unique, and finds all rows of a key.
+  ASSERT_EQ(DB_SUCCESS, catalog->CreateIndex("table-1", "index-name", {"name"}, &txn, index_info, "bptree"));
+  ASSERT_FALSE(index_info->GetIndex()->IsUnique());
+  std::string name = "name-3";
+  std::vector<Field> name_fields{Field(TypeId::kTypeChar, const_cast<char *>(name.c_str()), name.size(), true)};
+  result.clear();
+  ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->ScanKey(Row(name_fields), result, &txn));
+  ASSERT_EQ(n / 10, result.size());
+
+  // Scenario: existing duplicates cannot go into a unique index, and nothing of it is left behind.
+  ASSERT_EQ(DB_FAILED, catalog->CreateIndex("table-1", "index-code", {"code"}, &txn, index_info, "bptree"));
+  ASSERT_EQ(DB_INDEX_NOT_FOUND, catalog->GetIndex("table-1", "index-code", index_info));
+
+  // Scenario: a hash index is backfilled too, and unknown index types are rejected.
+  ASSERT_EQ(DB_SUCCESS, catalog->CreateIndex("table-1", "index-hash", {"id"}, &txn, index_info, "hash"));
+  ASSERT_EQ("hash", index_info->GetIndexType());
+  ASSERT_EQ(DB_FAILED, catalog->CreateIndex("table-1", "index-bad", {"id"}, &txn, index_info, "rtree"));
+  delete db;
+
+  // Scenario: the index type survives a reopen, and the reloaded hash index finds the rows.
+  db = new DBStorageEngine(db_file_name, false);
+  ASSERT_EQ(DB_SUCCESS, db->catalog_mgr_->GetIndex("table-1", "index-hash", index_info));
+  ASSERT_EQ("hash", index_info->GetIndexType());
+  for (int i = 0; i < n; i += 7) {
+    std::vector<Field> key_fields{Field(TypeId::kTypeInt, i)};
+    result.clear();
+    ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->ScanKey(Row(key_fields), result, &txn));
+    ASSERT_EQ(1, result.size());
+    ASSERT_EQ(row_ids[i].Get(), result[0].Get());
+  }
+  delete db;
+}
@@ -1,6 +1,7 @@
 //
 // Created by njz on 2023/1/26.
 //
+#include "executor/executors/seq_scan_executor.h"
 #include "executor/plans/delete_plan.h"
 #include "executor/plans/insert_plan.h"
 #include "executor/plans/seq_scan_plan.h"
@@ -155,3 +156,64 @@ TEST_F(ExecutorTest, SimpleUpdateTest) {
     ASSERT_TRUE(row.GetField(1)->CompareEquals(Field(kTypeChar, const_cast<char *>("minisql"), 7, false)));
   }
 }
+
+// SELECT account, id FROM table-1 [WHERE account < 0], serially and on a pool of workers
+TEST(SeqScanExecutorTest, ParallelScanTest) {
+  auto db = new DBStorageEngine("seq_scan_test.db", true);
+  TableInfo *table_info = nullptr;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false),
+                                   new Column("account", TypeId::kTypeFloat, 2, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  ASSERT_EQ(DB_SUCCESS, db->catalog_mgr_->CreateTable("table-1", schema.get(), nullptr, table_info));
+  // Enough rows for several windows of morsels at every parallelism below.
+  for (int i = 0; i < 15000; i++) {
+    int32_t len = RandomUtils::RandomInt(32, 64);
+    std::vector<char> characters(len);
+    RandomUtils::RandomString(characters.data(), len);
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters.data(), len, true),
+                  Field(TypeId::kTypeFloat, RandomUtils::RandomFloat(-999.f, 999.f))};
+    Row row(fields);
+    ASSERT_TRUE(table_info->GetTableHeap()->InsertTuple(row, nullptr));
+  }
+  size_t num_morsels = (table_info->GetTableHeap()->GetPageIds().size() + SCAN_MORSEL_PAGES - 1) / SCAN_MORSEL_PAGES;
+  ASSERT_GT(num_morsels, 3 * SCAN_WINDOW_MORSELS);
+
+  auto col_account = std::make_shared<ColumnValueExpression>(0, 2, kTypeFloat);
+  auto zero = std::make_shared<ConstantValueExpression>(Field(kTypeFloat, 0.f));
+  auto predicate = std::make_shared<ComparisonExpression>(col_account, zero, "<");
+  Schema out_schema({new Column("account", kTypeFloat, 2, false, false), new Column("id", kTypeInt, 0, false, false)});
+  auto exec_ctx = db->MakeExecuteContext(nullptr);
+  auto scan = [&](const AbstractExpressionRef &filter, size_t parallelism) {
+    SeqScanPlanNode plan(&out_schema, "table-1", filter);
+    exec_ctx->SetScanParallelism(parallelism);
+    SeqScanExecutor executor(exec_ctx.get(), &plan);
+    executor.Init();
+    std::vector<Row> rows;
+    RowBatch batch(&out_schema);
+    while (executor.NextBatch(&batch)) {
+      for (auto i : batch.GetSelection()) {
+        rows.emplace_back();
+        batch.GetRow(i, &rows.back());
+      }
+    }
+    return rows;
+  };
+  for (const auto &filter : {AbstractExpressionRef(), AbstractExpressionRef(predicate)}) {
+    auto expected = scan(filter, 1);
+    if (filter == nullptr) {
+      ASSERT_EQ(15000, expected.size());
+    }
+    for (size_t parallelism : {2, 3}) {
+      auto rows = scan(filter, parallelism);
+      // Same rows in the same order as the serial scan.
+      ASSERT_EQ(expected.size(), rows.size());
+      for (size_t i = 0; i < rows.size(); i++) {
+        ASSERT_EQ(expected[i].GetRowId(), rows[i].GetRowId());
+        ASSERT_TRUE(expected[i].GetField(0)->CompareEquals(*rows[i].GetField(0)));
+        ASSERT_TRUE(expected[i].GetField(1)->CompareEquals(*rows[i].GetField(1)));
+      }
+    }
+  }
+  delete db;
+}
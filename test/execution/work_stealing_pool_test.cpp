@@ -0,0 +1,50 @@
+#include "executor/work_stealing_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+#include "gtest/gtest.h"
+
+TEST(WorkStealingPoolTest, RunTest) {
+  for (size_t num_workers : {0, 1, 4}) {
+    WorkStealingPool pool(num_workers);
+    ASSERT_EQ(std::max<size_t>(num_workers, 1), pool.GetWorkerCount());
+    for (size_t num_tasks : {0, 3, 100}) {
+      std::vector<std::atomic<int>> runs(num_tasks);
+      std::vector<std::atomic<int>> busy(pool.GetWorkerCount());
+      pool.Run(num_tasks, [&](size_t worker, size_t task) {
+        // Nothing else may run on the state of a worker while its task does.
+        ASSERT_EQ(0, busy[worker]++);
+        // The first tasks are slow, so that the other workers run out of tasks and steal them.
+        if (task < num_tasks / 4) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        runs[task]++;
+        busy[worker]--;
+      });
+      for (auto &run : runs) {
+        ASSERT_EQ(1, run.load());
+      }
+    }
+  }
+}
+
+TEST(WorkStealingPoolTest, ExceptionTest) {
+  WorkStealingPool pool(4);
+  std::atomic<int> count{0};
+  ASSERT_THROW(pool.Run(64,
+                        [&](size_t, size_t task) {
+                          count++;
+                          if (task == 10) {
+                            throw std::runtime_error("task failed");
+                          }
+                        }),
+               std::runtime_error);
+  // The other tasks still run, the pool is usable afterwards.
+  ASSERT_EQ(64, count.load());
+  count = 0;
+  pool.Run(8, [&](size_t, size_t) { count++; });
+  ASSERT_EQ(8, count.load());
+}
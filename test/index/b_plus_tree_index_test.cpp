@@ -1,5 +1,8 @@
 #include "index/b_plus_tree_index.h"
 
+#include <algorithm>
+#include <map>
+#include <random>
 #include <string>
 
 #include "common/instance.h"
@@ -27,6 +30,75 @@ TEST(BPlusTreeTests, BPlusTreeIndexGenericKeyTest) {
   ASSERT_EQ(0, KP.CompareKeys(k1, k2));
 }
 
+/**
+ * Order of two keys by comparing their fields one by one, nulls first.
+ */
+static int CompareFields(Row &lhs, Row &rhs) {
+  for (uint32_t i = 0; i < lhs.GetFieldCount(); i++) {
+    Field *l = lhs.GetField(i);
+    Field *r = rhs.GetField(i);
+    if (l->IsNull() || r->IsNull()) {
+      if (l->IsNull() != r->IsNull()) {
+        return l->IsNull() ? -1 : 1;
+      }
+      continue;
+    }
+    if (l->CompareLessThan(*r) == CmpBool::kTrue) {
+      return -1;
+    }
+    if (l->CompareGreaterThan(*r) == CmpBool::kTrue) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+TEST(BPlusTreeTests, KeyEncodingTest) {
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, true, false),
+                                   new Column("account", TypeId::kTypeFloat, 1, true, false),
+                                   new Column("name", TypeId::kTypeChar, 4, 2, true, false)};
+  Schema schema(columns);
+  KeyManager KP(&schema, KeyManager::GetEncodedSize(&schema));
+  // Small domains, so that ties on the leading columns are frequent.
+  std::default_random_engine rng(0);
+  std::uniform_int_distribution<int> int_dist(-3, 3);
+  std::vector<float> floats{-1e30f, -2.5f, -0.0f, 0.0f, 1e-30f, 2.5f, 1e30f};
+  std::vector<std::string> strings{"", std::string("\0", 1), "a", std::string("a\0", 2), "ab", "b", "abcd"};
+  std::vector<Row> rows;
+  std::vector<GenericKey *> keys;
+  for (int i = 0; i < 300; i++) {
+    std::vector<Field> fields;
+    fields.emplace_back(int_dist(rng) == 3 ? Field(TypeId::kTypeInt) : Field(TypeId::kTypeInt, int_dist(rng)));
+    fields.emplace_back(int_dist(rng) == 3 ? Field(TypeId::kTypeFloat)
+                                           : Field(TypeId::kTypeFloat, floats[rng() % floats.size()]));
+    if (int_dist(rng) == 3) {
+      fields.emplace_back(TypeId::kTypeChar, nullptr, 0, false);
+    } else {
+      auto &str = strings[rng() % strings.size()];
+      fields.emplace_back(TypeId::kTypeChar, const_cast<char *>(str.data()), str.size(), true);
+    }
+    rows.emplace_back(fields);
+    keys.push_back(KP.InitKey());
+    KP.SerializeFromKey(keys.back(), rows.back(), &schema);
+  }
+  for (size_t i = 0; i < rows.size(); i++) {
+    // The encoding decodes to the same key.
+    Row decoded(INVALID_ROWID);
+    KP.DeserializeToKey(keys[i], decoded, &schema);
+    ASSERT_EQ(0, CompareFields(rows[i], decoded));
+    // Comparing the bytes orders keys like comparing their fields.
+    for (size_t j = 0; j < rows.size(); j++) {
+      int expected = CompareFields(rows[i], rows[j]);
+      int actual = KP.CompareKeys(keys[i], keys[j]);
+      ASSERT_EQ(expected < 0, actual < 0) << i << " " << j;
+      ASSERT_EQ(expected == 0, actual == 0) << i << " " << j;
+    }
+  }
+  for (auto key : keys) {
+    free(key);
+  }
+}
+
 TEST(BPlusTreeTests, BPlusTreeIndexSimpleTest) {
   auto disk_mgr_ = new DiskManager(db_name);
   auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
@@ -78,4 +150,167 @@ TEST(BPlusTreeTests, BPlusTreeIndexSimpleTest) {
   delete index;
   delete bpm_;
   delete disk_mgr_;
-}
\ No newline at end of file
+}
+TEST(BPlusTreeTests, BPlusTreeIndexNonUniqueTest) {
+  auto disk_mgr_ = new DiskManager(db_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  page_id_t id;
+  if (bpm_->IsPageFree(CATALOG_META_PAGE_ID)) {
+    if (bpm_->NewPage(id) == nullptr || id != CATALOG_META_PAGE_ID) {
+      throw logic_error("Failed to allocate catalog meta page.");
+    }
+  }
+  if (bpm_->IsPageFree(INDEX_ROOTS_PAGE_ID)) {
+    if (bpm_->NewPage(id) == nullptr || id != INDEX_ROOTS_PAGE_ID) {
+      throw logic_error("Failed to allocate header page.");
+    }
+  }
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("status", TypeId::kTypeInt, 1, false, false)};
+  std::vector<uint32_t> index_key_map{1};
+  const TableSchema table_schema(columns);
+  auto *index_schema = Schema::ShallowCopySchema(&table_schema, index_key_map);
+  auto *index = new BPlusTreeIndex(0, index_schema, 16, bpm_, false);
+  ASSERT_FALSE(index->IsUnique());
+  auto key_of = [](int status) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, status)};
+    return Row(fields);
+  };
+  // Status 0 is a hot key spanning many leaves, the others have a few rows each. Row ids are inserted out of order.
+  const int n = 3000;
+  std::map<int, std::vector<int64_t>> expected;
+  for (int i = 0; i < n; i++) {
+    int slot = (i * 7919) % n;
+    int status = slot % 3 == 0 ? 0 : slot % 50;
+    RowId rid(1000 + slot / 100, slot % 100);
+    ASSERT_EQ(DB_SUCCESS, index->InsertEntry(key_of(status), rid, nullptr));
+    expected[status].push_back(rid.Get());
+  }
+  // The same key and row id cannot go in twice.
+  ASSERT_EQ(DB_FAILED, index->InsertEntry(key_of(0), RowId(expected[0][0]), nullptr));
+  for (auto &entry : expected) {
+    std::sort(entry.second.begin(), entry.second.end());
+  }
+
+  // Scenario: a point scan returns every row id of the key, in row id order.
+  for (auto &entry : expected) {
+    std::vector<RowId> ret;
+    ASSERT_EQ(DB_SUCCESS, index->ScanKey(key_of(entry.first), ret, nullptr));
+    ASSERT_EQ(entry.second.size(), ret.size());
+    for (size_t i = 0; i < ret.size(); i++) {
+      ASSERT_EQ(entry.second[i], ret[i].Get());
+    }
+  }
+  std::vector<RowId> ret;
+  ASSERT_EQ(DB_KEY_NOT_FOUND, index->ScanKey(key_of(50), ret, nullptr));
+
+  // Scenario: range scans count the duplicates of the bound on the right side.
+  auto count_of = [&](int from, int to) {
+    size_t count = 0;
+    for (auto &entry : expected) {
+      if (entry.first >= from && entry.first < to) count += entry.second.size();
+    }
+    return count;
+  };
+  ret.clear();
+  ASSERT_EQ(DB_SUCCESS, index->ScanKey(key_of(10), ret, nullptr, ">="));
+  ASSERT_EQ(count_of(10, 50), ret.size());
+  ret.clear();
+  ASSERT_EQ(DB_SUCCESS, index->ScanKey(key_of(10), ret, nullptr, ">"));
+  ASSERT_EQ(count_of(11, 50), ret.size());
+  ret.clear();
+  ASSERT_EQ(DB_SUCCESS, index->ScanKey(key_of(10), ret, nullptr, "<"));
+  ASSERT_EQ(count_of(0, 10), ret.size());
+  ret.clear();
+  ASSERT_EQ(DB_SUCCESS, index->ScanKey(key_of(10), ret, nullptr, "<="));
+  ASSERT_EQ(count_of(0, 11), ret.size());
+  ret.clear();
+  ASSERT_EQ(DB_SUCCESS, index->ScanKey(key_of(0), ret, nullptr, "<>"));
+  ASSERT_EQ(count_of(1, 50), ret.size());
+
+  // Scenario: the iterator visits every row id, and removing one row id of a key leaves the others.
+  size_t visited = 0;
+  for (auto iter = index->GetBeginIterator(); iter != index->GetEndIterator(); ++iter) {
+    visited++;
+  }
+  ASSERT_EQ(static_cast<size_t>(n), visited);
+  for (size_t i = 0; i < expected[0].size(); i += 2) {
+    ASSERT_EQ(DB_SUCCESS, index->RemoveEntry(key_of(0), RowId(expected[0][i]), nullptr));
+  }
+  ret.clear();
+  ASSERT_EQ(DB_SUCCESS, index->ScanKey(key_of(0), ret, nullptr));
+  ASSERT_EQ(expected[0].size() / 2, ret.size());
+  for (size_t i = 0; i < ret.size(); i++) {
+    ASSERT_EQ(expected[0][i * 2 + 1], ret[i].Get());
+  }
+  index->Destroy();
+  delete index;
+  delete bpm_;
+  delete disk_mgr_;
+}
+
+TEST(BPlusTreeTests, BPlusTreeIndexRangeIteratorTest) {
+  auto disk_mgr_ = new DiskManager(db_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  page_id_t id;
+  if (bpm_->IsPageFree(CATALOG_META_PAGE_ID)) {
+    if (bpm_->NewPage(id) == nullptr || id != CATALOG_META_PAGE_ID) {
+      throw logic_error("Failed to allocate catalog meta page.");
+    }
+  }
+  if (bpm_->IsPageFree(INDEX_ROOTS_PAGE_ID)) {
+    if (bpm_->NewPage(id) == nullptr || id != INDEX_ROOTS_PAGE_ID) {
+      throw logic_error("Failed to allocate header page.");
+    }
+  }
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false)};
+  const TableSchema table_schema(columns);
+  std::vector<uint32_t> index_key_map{0};
+  auto *index_schema = Schema::ShallowCopySchema(&table_schema, index_key_map);
+  auto key_of = [](int value) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, value)};
+    return Row(fields);
+  };
+  // Even keys from 0 to 198, once in the unique index and three times in the other one.
+  for (bool unique : {true, false}) {
+    auto *index = new BPlusTreeIndex(unique ? 1 : 2, index_schema, 16, bpm_, unique);
+    int copies = unique ? 1 : 3;
+    for (int i = 0; i < 100; i++) {
+      for (int j = 0; j < copies; j++) {
+        ASSERT_EQ(DB_SUCCESS, index->InsertEntry(key_of(i * 2), RowId(i, j), nullptr));
+      }
+    }
+    // Bounds on keys, between keys and outside of the keys, open or not, inclusive or not.
+    std::vector<int> bounds{-5, 0, 1, 50, 51, 198, 199, 300};
+    for (int lower : bounds) {
+      for (int upper : bounds) {
+        for (int flags = 0; flags < 16; flags++) {
+          bool has_lower = flags & 1, has_upper = flags & 2, lower_inclusive = flags & 4, upper_inclusive = flags & 8;
+          size_t expected = 0;
+          for (int i = 0; i < 100; i++) {
+            int key = i * 2;
+            bool above = !has_lower || key > lower || (lower_inclusive && key == lower);
+            bool below = !has_upper || key < upper || (upper_inclusive && key == upper);
+            if (above && below) expected += copies;
+          }
+          Row lower_key = key_of(lower), upper_key = key_of(upper);
+          size_t count = 0;
+          int last = INT32_MIN;
+          auto iter = index->GetRangeIterator(has_lower ? &lower_key : nullptr, lower_inclusive,
+                                              has_upper ? &upper_key : nullptr, upper_inclusive);
+          for (; iter != index->GetEndIterator(); ++iter) {
+            int key = (*iter).second.GetPageId() * 2;
+            ASSERT_LE(last, key);
+            last = key;
+            count++;
+          }
+          ASSERT_EQ(expected, count) << lower << " " << upper << " " << flags;
+        }
+      }
+    }
+    index->Destroy();
+    delete index;
+  }
+  delete bpm_;
+  delete disk_mgr_;
+}
@@ -1,5 +1,10 @@
 #include "index/b_plus_tree.h"
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+
 #include "common/instance.h"
 #include "gtest/gtest.h"
 #include "index/comparator.h"
@@ -69,4 +74,524 @@ TEST(BPlusTreeTests, SampleTest) {
     ASSERT_TRUE(tree.GetValue(delete_seq[i], ans));
     ASSERT_EQ(kv_map[delete_seq[i]], ans[ans.size() - 1]);
   }
-}
\ No newline at end of file
+}
+
+TEST(BPlusTreeTests, ConcurrentTest) {
+  DBStorageEngine engine("bp_tree_concurrent_test.db");
+  std::vector<Column *> columns = {
+      new Column("int", TypeId::kTypeInt, 0, false, false),
+  };
+  Schema *table_schema = new Schema(columns);
+  KeyManager KP(table_schema, 17);
+  // Small nodes, so that splits and merges happen all the time.
+  BPlusTree tree(0, engine.bpm_, KP, 8, 8);
+  const int num_threads = 8;
+  const int n = 16000;
+  vector<GenericKey *> keys;
+  for (int i = 0; i < 2 * n; i++) {
+    GenericKey *key = KP.InitKey();
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i)};
+    KP.SerializeFromKey(key, Row(fields), table_schema);
+    keys.push_back(key);
+  }
+  vector<int> order(n);
+  for (int i = 0; i < n; i++) {
+    order[i] = i;
+  }
+  ShuffleArray(order);
+  auto run = [&](const std::function<void(int)> &work) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+      threads.emplace_back(work, t);
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  };
+
+  // Scenario: threads insert disjoint sets of keys at the same time.
+  run([&](int t) {
+    for (int i = t; i < n; i += num_threads) {
+      ASSERT_TRUE(tree.Insert(keys[order[i]], RowId(order[i])));
+    }
+  });
+  ASSERT_TRUE(tree.Check());
+  int expected = 0;
+  for (auto iter = tree.Begin(); iter != tree.End(); ++iter, ++expected) {
+    ASSERT_EQ(RowId(expected), (*iter).second);
+  }
+  ASSERT_EQ(n, expected);
+
+  // Scenario: half of the threads remove odd keys and insert new ones, the others look up even keys and scan.
+  run([&](int t) {
+    vector<RowId> result;
+    if (t % 2 == 0) {
+      for (int i = t / 2; i < n; i += num_threads / 2) {
+        if (order[i] % 2 == 1) {
+          tree.Remove(keys[order[i]]);
+        }
+        ASSERT_TRUE(tree.Insert(keys[n + order[i]], RowId(n + order[i])));
+      }
+    } else {
+      for (int i = t / 2; i < n; i += num_threads / 2) {
+        if (order[i] % 2 == 0) {
+          result.clear();
+          ASSERT_TRUE(tree.GetValue(keys[order[i]], result));
+          ASSERT_EQ(RowId(order[i]), result[0]);
+        }
+        if (i % 1000 == t) {
+          // Scans see keys in order, and every even key, no matter what is removed or inserted meanwhile.
+          int64_t last = -1;
+          int even = 0;
+          for (auto iter = tree.Begin(); iter != tree.End(); ++iter) {
+            int64_t value = (*iter).second.Get();
+            ASSERT_LT(last, value);
+            even += value < n && value % 2 == 0 ? 1 : 0;
+            last = value;
+          }
+          ASSERT_EQ(n / 2, even);
+        }
+      }
+    }
+  });
+  ASSERT_TRUE(tree.Check());
+  vector<RowId> result;
+  for (int i = 0; i < 2 * n; i++) {
+    result.clear();
+    bool present = i >= n || i % 2 == 0;
+    ASSERT_EQ(present, tree.GetValue(keys[i], result));
+    if (present) {
+      ASSERT_EQ(RowId(i), result[0]);
+    }
+  }
+  expected = 0;
+  for (auto iter = tree.Begin(); iter != tree.End(); ++iter) {
+    expected++;
+  }
+  ASSERT_EQ(n / 2 + n, expected);
+  for (auto key : keys) {
+    free(key);
+  }
+}
+
+TEST(BPlusTreeTests, OptimisticLookupTest) {
+  DBStorageEngine engine("bp_tree_optimistic_test.db");
+  std::vector<Column *> columns = {
+      new Column("int", TypeId::kTypeInt, 0, false, false),
+  };
+  Schema *table_schema = new Schema(columns);
+  KeyManager KP(table_schema, 17);
+  BPlusTree tree(0, engine.bpm_, KP);
+  const int num_readers = 8;
+  const int n = 50000;
+  const int lookups = 50000;
+  vector<GenericKey *> keys;
+  for (int i = 0; i < 2 * n; i++) {
+    GenericKey *key = KP.InitKey();
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i)};
+    KP.SerializeFromKey(key, Row(fields), table_schema);
+    keys.push_back(key);
+  }
+  for (int i = 0; i < n; i++) {
+    ASSERT_TRUE(tree.Insert(keys[i], RowId(i)));
+  }
+
+  // Scenario: point lookups of existing keys while a writer keeps growing the tree, splitting leaves and inner pages.
+  std::atomic<bool> done{false};
+  std::thread writer([&]() {
+    for (int i = n; i < 2 * n && !done; i++) {
+      ASSERT_TRUE(tree.Insert(keys[i], RowId(i)));
+    }
+  });
+  std::vector<std::thread> readers;
+  for (int t = 0; t < num_readers; t++) {
+    readers.emplace_back([&, t]() {
+      std::mt19937 rng(t);
+      std::uniform_int_distribution<int> dist(0, n - 1);
+      vector<RowId> result;
+      for (int i = 0; i < lookups; i++) {
+        int k = dist(rng);
+        result.clear();
+        ASSERT_TRUE(tree.GetValue(keys[k], result));
+        ASSERT_EQ(RowId(k), result[0]);
+      }
+    });
+  }
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  done = true;
+  writer.join();
+  ASSERT_TRUE(tree.Check());
+  for (auto key : keys) {
+    free(key);
+  }
+}
+
+/**
+ * Count the leaves of a tree by following the sibling links.
+ */
+static int CountLeaves(BPlusTree &tree, BufferPoolManager *bpm) {
+  Page *page = tree.FindLeafPage(nullptr, INVALID_PAGE_ID, true);
+  int leaves = 0;
+  while (page != nullptr) {
+    leaves++;
+    page_id_t next = reinterpret_cast<BPlusTreeLeafPage *>(page->GetData())->GetNextPageId();
+    bpm->UnpinPage(page->GetPageId(), false);
+    page = next == INVALID_PAGE_ID ? nullptr : bpm->FetchPage(next);
+  }
+  return leaves;
+}
+
+TEST(BPlusTreeTests, BulkLoadTest) {
+  DBStorageEngine engine("bp_tree_bulk_load_test.db");
+  std::vector<Column *> columns = {
+      new Column("int", TypeId::kTypeInt, 0, false, false),
+  };
+  Schema *table_schema = new Schema(columns);
+  KeyManager KP(table_schema, 17);
+  const int n = 20000;
+  vector<GenericKey *> keys;
+  for (int i = 0; i < n; i++) {
+    GenericKey *key = KP.InitKey();
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i)};
+    KP.SerializeFromKey(key, Row(fields), table_schema);
+    keys.push_back(key);
+  }
+  auto sorted_input = [&](int count) {
+    auto i = std::make_shared<int>(0);
+    return [&, i, count](GenericKey *key, RowId *value) {
+      if (*i == count) return false;
+      memcpy(key, keys[*i], KP.GetKeySize());
+      *value = RowId(*i);
+      (*i)++;
+      return true;
+    };
+  };
+
+  // Scenario: small inputs, including an empty one and ones filling a single leaf, and a range of fill factors.
+  index_id_t index_id = 0;
+  for (int count : {0, 1, 7, 8, 9, 100, 1000}) {
+    for (double fill_factor : {0.0, 0.5, 1.0}) {
+      BPlusTree tree(index_id++, engine.bpm_, KP, 8, 8);
+      ASSERT_TRUE(tree.BulkLoad(sorted_input(count), fill_factor));
+      ASSERT_EQ(count == 0, tree.IsEmpty());
+      int expected = 0;
+      for (auto iter = tree.Begin(); iter != tree.End(); ++iter, ++expected) {
+        ASSERT_EQ(RowId(expected), (*iter).second);
+      }
+      ASSERT_EQ(count, expected);
+      // The tree keeps working as usual, removes must not find an underflowing page they cannot fix.
+      for (int i = 0; i < count; i += 2) {
+        tree.Remove(keys[i]);
+      }
+      vector<RowId> result;
+      for (int i = 0; i < count; i++) {
+        result.clear();
+        ASSERT_EQ(i % 2 == 1, tree.GetValue(keys[i], result));
+      }
+      ASSERT_TRUE(tree.Check());
+      tree.Destroy();
+    }
+  }
+
+  // Scenario: a large input packs leaves much tighter than inserting the keys one by one in random order.
+  BPlusTree inserted(index_id++, engine.bpm_, KP);
+  vector<int> order(n);
+  for (int i = 0; i < n; i++) {
+    order[i] = i;
+  }
+  ShuffleArray(order);
+  for (int i : order) {
+    ASSERT_TRUE(inserted.Insert(keys[i], RowId(i)));
+  }
+  BPlusTree loaded(index_id++, engine.bpm_, KP);
+  ASSERT_TRUE(loaded.BulkLoad(sorted_input(n)));
+  int inserted_leaves = CountLeaves(inserted, engine.bpm_);
+  int loaded_leaves = CountLeaves(loaded, engine.bpm_);
+  ASSERT_LT(loaded_leaves * 10, inserted_leaves * 9);
+  vector<RowId> result;
+  for (int i = 0; i < n; i++) {
+    result.clear();
+    ASSERT_TRUE(loaded.GetValue(keys[i], result));
+    ASSERT_EQ(RowId(i), result[0]);
+  }
+  ASSERT_TRUE(loaded.Check());
+
+  // Scenario: input out of order is refused, and so is a tree that is not empty.
+  BPlusTree unordered(index_id++, engine.bpm_, KP);
+  int calls = 0;
+  ASSERT_FALSE(unordered.BulkLoad([&](GenericKey *key, RowId *value) {
+    memcpy(key, keys[calls < 100 ? calls : 50], KP.GetKeySize());
+    *value = RowId(calls);
+    return ++calls <= 200;
+  }));
+  ASSERT_TRUE(unordered.IsEmpty());
+  ASSERT_FALSE(loaded.BulkLoad(sorted_input(n)));
+  ASSERT_TRUE(unordered.Check());
+  for (auto key : keys) {
+    free(key);
+  }
+}
+
+TEST(BPlusTreeTests, AppendSplitTest) {
+  DBStorageEngine engine("bp_tree_append_split_test.db");
+  std::vector<Column *> columns = {
+      new Column("int", TypeId::kTypeInt, 0, false, false),
+  };
+  Schema *table_schema = new Schema(columns);
+  KeyManager KP(table_schema, 17);
+  const int n = 20000;
+  vector<GenericKey *> keys;
+  for (int i = 0; i < n; i++) {
+    GenericKey *key = KP.InitKey();
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i)};
+    KP.SerializeFromKey(key, Row(fields), table_schema);
+    keys.push_back(key);
+  }
+  index_id_t index_id = 0;
+  BPlusTree packed(index_id++, engine.bpm_, KP);
+  int loaded = 0;
+  ASSERT_TRUE(packed.BulkLoad(
+      [&](GenericKey *key, RowId *value) {
+        if (loaded == n) return false;
+        memcpy(key, keys[loaded], KP.GetKeySize());
+        *value = RowId(loaded++);
+        return true;
+      },
+      1.0));
+  int packed_leaves = CountLeaves(packed, engine.bpm_);
+
+  // Scenario: increasing keys fill their leaves as tightly as a packed bulk load, not half of them.
+  BPlusTree ascending(index_id++, engine.bpm_, KP);
+  for (int i = 0; i < n; i++) {
+    ASSERT_TRUE(ascending.Insert(keys[i], RowId(i)));
+  }
+  int ascending_leaves = CountLeaves(ascending, engine.bpm_);
+  ASSERT_LE(ascending_leaves, packed_leaves + 1);
+  ASSERT_TRUE(ascending.Check());
+
+  // Scenario: inserts in between the appended keys still find room, and removes rebalance the full pages.
+  for (int i = 1; i < n; i += 2) {
+    ascending.Remove(keys[i]);
+  }
+  for (int i = 1; i < n; i += 2) {
+    ASSERT_TRUE(ascending.Insert(keys[i], RowId(i)));
+  }
+  vector<RowId> result;
+  for (int i = 0; i < n; i++) {
+    result.clear();
+    ASSERT_TRUE(ascending.GetValue(keys[i], result));
+    ASSERT_EQ(RowId(i), result[0]);
+  }
+  ASSERT_TRUE(ascending.Check());
+
+  // Scenario: small pages split internal pages at the right edge too, decreasing keys split evenly as before.
+  BPlusTree small(index_id++, engine.bpm_, KP, 8, 8);
+  BPlusTree descending(index_id++, engine.bpm_, KP, 8, 8);
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_TRUE(small.Insert(keys[i], RowId(i)));
+    ASSERT_TRUE(descending.Insert(keys[999 - i], RowId(999 - i)));
+  }
+  ASSERT_TRUE(small.Check());
+  ASSERT_TRUE(descending.Check());
+  ASSERT_LT(CountLeaves(small, engine.bpm_), CountLeaves(descending, engine.bpm_) * 2 / 3);
+  int expected = 0;
+  for (auto iter = small.Begin(); iter != small.End(); ++iter, ++expected) {
+    ASSERT_EQ(RowId(expected), (*iter).second);
+  }
+  ASSERT_EQ(1000, expected);
+  for (auto key : keys) {
+    free(key);
+  }
+}
+
+TEST(BPlusTreeTests, VariableLengthKeyTest) {
+  DBStorageEngine engine("bp_tree_variable_length_test.db");
+  std::vector<Column *> columns = {
+      new Column("name", TypeId::kTypeChar, 64, 0, false, false),
+  };
+  Schema *table_schema = new Schema(columns);
+  KeyManager KP(table_schema, KeyManager::GetEncodedSize(table_schema));
+  BPlusTree tree(0, engine.bpm_, KP);
+  // Short strings with a long common prefix, and a few that only differ by zero bytes.
+  const int n = 20000;
+  vector<std::string> names{"", std::string("\0", 1), std::string("\0\0", 2), "user", std::string("user\0", 5)};
+  for (int i = 0; i < n; i++) {
+    names.push_back("user_" + std::to_string(i * 7919 % 100003));
+  }
+  vector<GenericKey *> keys;
+  for (auto &name : names) {
+    GenericKey *key = KP.InitKey();
+    std::vector<Field> fields{Field(TypeId::kTypeChar, const_cast<char *>(name.data()), name.size(), true)};
+    KP.SerializeFromKey(key, Row(fields), table_schema);
+    keys.push_back(key);
+  }
+  vector<int> order(names.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    order[i] = static_cast<int>(i);
+  }
+  ShuffleArray(order);
+  for (int i : order) {
+    ASSERT_TRUE(tree.Insert(keys[i], RowId(i)));
+  }
+  ASSERT_FALSE(tree.Insert(keys[order[0]], RowId(order[0])));
+  ASSERT_TRUE(tree.Check());
+
+  // Scenario: keys come back in order and decode to the strings they were made of.
+  vector<int> sorted(order);
+  std::sort(sorted.begin(), sorted.end(), [&](int a, int b) { return names[a] < names[b]; });
+  size_t position = 0;
+  for (auto iter = tree.Begin(); iter != tree.End(); ++iter, ++position) {
+    ASSERT_EQ(RowId(sorted[position]), (*iter).second);
+    Row decoded;
+    KP.DeserializeToKey((*iter).first, decoded, table_schema);
+    ASSERT_EQ(names[sorted[position]],
+              std::string(decoded.GetField(0)->GetData(), decoded.GetField(0)->GetLength()));
+  }
+  ASSERT_EQ(names.size(), position);
+
+  // Scenario: leaves hold many more keys than fit at the full encoded size of 131 bytes.
+  int fixed_size_per_leaf = (PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / (KP.GetKeySize() + sizeof(RowId));
+  int leaves = CountLeaves(tree, engine.bpm_);
+  ASSERT_LT(leaves * fixed_size_per_leaf * 4, static_cast<int>(names.size()));
+
+  // Scenario: removing half of the keys merges pages, and the other half is still found.
+  for (size_t i = 0; i < order.size(); i += 2) {
+    tree.Remove(keys[order[i]]);
+  }
+  vector<RowId> result;
+  for (size_t i = 0; i < order.size(); i++) {
+    result.clear();
+    ASSERT_EQ(i % 2 == 1, tree.GetValue(keys[order[i]], result));
+    if (i % 2 == 1) {
+      ASSERT_EQ(RowId(order[i]), result[0]);
+    }
+  }
+  ASSERT_LT(CountLeaves(tree, engine.bpm_), leaves * 3 / 4);
+  for (size_t i = 1; i < order.size(); i += 2) {
+    tree.Remove(keys[order[i]]);
+  }
+  ASSERT_TRUE(tree.IsEmpty());
+  ASSERT_TRUE(tree.Check());
+  for (auto key : keys) {
+    free(key);
+  }
+}
+
+TEST(BPlusTreeTests, InlineKeyTest) {
+  DBStorageEngine engine("bp_tree_inline_key_test.db");
+  std::vector<Column *> int_columns = {
+      new Column("int", TypeId::kTypeInt, 0, false, false),
+  };
+  Schema *int_schema = new Schema(int_columns);
+  KeyManager int_KP(int_schema, 17);
+  const int n = 200000;
+  vector<GenericKey *> keys;
+  for (int i = 0; i < n; i++) {
+    GenericKey *key = int_KP.InitKey();
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i * 3 - n)};
+    int_KP.SerializeFromKey(key, Row(fields), int_schema);
+    keys.push_back(key);
+  }
+  index_id_t index_id = 0;
+  BPlusTree tree(index_id++, engine.bpm_, int_KP);
+  int loaded = 0;
+  ASSERT_TRUE(tree.BulkLoad(
+      [&](GenericKey *key, RowId *value) {
+        if (loaded == n) return false;
+        memcpy(key, keys[loaded], int_KP.GetKeySize());
+        *value = RowId(loaded++);
+        return true;
+      },
+      1.0));
+
+  // Scenario: int keys are kept in their slots, leaves take less than a byte per key besides the slots.
+  int leaves = CountLeaves(tree, engine.bpm_);
+  ASSERT_GT(n / leaves, (PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / (LEAF_PAGE_SLOT_SIZE + 1));
+
+  // Scenario: point lookups in random order, absent keys in between are not found.
+  vector<int> order(n);
+  for (int i = 0; i < n; i++) {
+    order[i] = i;
+  }
+  ShuffleArray(order);
+  vector<RowId> result;
+  for (int i : order) {
+    result.clear();
+    ASSERT_TRUE(tree.GetValue(keys[i], result));
+    ASSERT_EQ(RowId(i), result[0]);
+  }
+  GenericKey *absent = int_KP.InitKey();
+  for (int i = 0; i < 1000; i++) {
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i * 3 - n + 1)};
+    int_KP.SerializeFromKey(absent, Row(fields), int_schema);
+    result.clear();
+    ASSERT_FALSE(tree.GetValue(absent, result));
+  }
+  free(absent);
+  ASSERT_TRUE(tree.Check());
+  for (auto key : keys) {
+    free(key);
+  }
+
+  // Scenario: short strings move pages between inline keys and key bytes out of the slots as keys come and go.
+  std::vector<Column *> char_columns = {
+      new Column("name", TypeId::kTypeChar, 12, 0, false, false),
+  };
+  Schema *char_schema = new Schema(char_columns);
+  KeyManager char_KP(char_schema, KeyManager::GetEncodedSize(char_schema));
+  BPlusTree names_tree(index_id++, engine.bpm_, char_KP, 16, 16);
+  vector<std::string> names;
+  for (int length = 0; length <= 8; length++) {
+    for (int bits = 0; bits < (1 << length); bits++) {
+      std::string name;
+      for (int i = 0; i < length; i++) {
+        name.push_back((bits >> i) & 1 ? 'b' : 'a');
+      }
+      names.push_back(name);
+    }
+  }
+  vector<GenericKey *> name_keys;
+  for (auto &name : names) {
+    GenericKey *key = char_KP.InitKey();
+    std::vector<Field> fields{Field(TypeId::kTypeChar, const_cast<char *>(name.data()), name.size(), true)};
+    char_KP.SerializeFromKey(key, Row(fields), char_schema);
+    name_keys.push_back(key);
+  }
+  vector<int> name_order(names.size());
+  for (size_t i = 0; i < name_order.size(); i++) {
+    name_order[i] = static_cast<int>(i);
+  }
+  ShuffleArray(name_order);
+  for (int i : name_order) {
+    ASSERT_TRUE(names_tree.Insert(name_keys[i], RowId(i)));
+  }
+  ShuffleArray(name_order);
+  for (size_t i = 0; i < name_order.size(); i += 3) {
+    names_tree.Remove(name_keys[name_order[i]]);
+  }
+  for (size_t i = 0; i < name_order.size(); i += 6) {
+    ASSERT_TRUE(names_tree.Insert(name_keys[name_order[i]], RowId(name_order[i])));
+  }
+  ASSERT_TRUE(names_tree.Check());
+  vector<int> expected;
+  for (size_t i = 0; i < name_order.size(); i++) {
+    if (i % 3 != 0 || i % 6 == 0) {
+      expected.push_back(name_order[i]);
+    }
+  }
+  std::sort(expected.begin(), expected.end(), [&](int a, int b) { return names[a] < names[b]; });
+  size_t position = 0;
+  for (auto iter = names_tree.Begin(); iter != names_tree.End(); ++iter, ++position) {
+    ASSERT_EQ(RowId(expected[position]), (*iter).second);
+  }
+  ASSERT_EQ(expected.size(), position);
+  for (size_t i = 0; i < name_order.size(); i++) {
+    result.clear();
+    ASSERT_EQ(i % 3 != 0 || i % 6 == 0, names_tree.GetValue(name_keys[name_order[i]], result));
+  }
+  for (auto key : name_keys) {
+    free(key);
+  }
+}
@@ -0,0 +1,79 @@
+#include "index/external_sorter.h"
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <csignal>
+#include <random>
+
+#include "gtest/gtest.h"
+
+/**
+ * Sort count random keys with the given budget, and check the output against std::sort.
+ */
+static void SortAndCheck(size_t count, size_t memory_budget, size_t num_threads, size_t expected_runs) {
+  const size_t key_size = 12;
+  std::mt19937 rng(static_cast<unsigned>(count));
+  std::vector<std::pair<std::string, int64_t>> pairs;
+  ExternalSorter sorter(key_size, memory_budget, num_threads);
+  std::string key(key_size, 0);
+  for (size_t i = 0; i < count; i++) {
+    for (auto &c : key) {
+      // Few distinct bytes, so that keys share prefixes and some repeat.
+      c = static_cast<char>(rng() % 4);
+    }
+    pairs.emplace_back(key, static_cast<int64_t>(i));
+    sorter.Add(reinterpret_cast<const GenericKey *>(key.data()), RowId(static_cast<int64_t>(i)));
+  }
+  sorter.Sort();
+  ASSERT_EQ(expected_runs, sorter.GetNumRuns());
+  std::sort(pairs.begin(), pairs.end());
+  std::string out(key_size, 0);
+  RowId row_id;
+  for (auto &pair : pairs) {
+    ASSERT_TRUE(sorter.Next(reinterpret_cast<GenericKey *>(out.data()), &row_id));
+    ASSERT_EQ(pair.first, out);
+    ASSERT_EQ(pair.second, row_id.Get());
+  }
+  ASSERT_FALSE(sorter.Next(reinterpret_cast<GenericKey *>(out.data()), &row_id));
+  ASSERT_FALSE(sorter.IsFailed());
+}
+
+TEST(ExternalSorterTest, InMemoryTest) {
+  SortAndCheck(0, 1 << 20, 4, 0);
+  SortAndCheck(1, 1 << 20, 4, 0);
+  SortAndCheck(3, 1 << 20, 4, 0);
+  SortAndCheck(10000, 1 << 20, 4, 0);
+  SortAndCheck(10000, 1 << 20, 1, 0);
+}
+
+TEST(ExternalSorterTest, SpillTest) {
+  // Records take 20 bytes and a position of 4 bytes, 24000 bytes hold 1000 of them.
+  SortAndCheck(10000, 24000, 4, 10);
+  SortAndCheck(10500, 24000, 3, 11);
+  // A budget below a record still makes progress, one record per run.
+  SortAndCheck(50, 1, 2, 50);
+}
+
+TEST(ExternalSorterTest, WriteErrorTest) {
+  // Runs cannot grow the temporary file past 64 KB, writes beyond fail with EFBIG instead of raising SIGXFSZ.
+  rlimit old_limit;
+  ASSERT_EQ(0, getrlimit(RLIMIT_FSIZE, &old_limit));
+  rlimit limit = old_limit;
+  limit.rlim_cur = 64 << 10;
+  auto old_handler = std::signal(SIGXFSZ, SIG_IGN);
+  ASSERT_EQ(0, setrlimit(RLIMIT_FSIZE, &limit));
+  ExternalSorter sorter(12, 24000, 2);
+  std::string key(12, 0);
+  for (int64_t i = 0; i < 10000; i++) {
+    memcpy(key.data(), &i, sizeof(i));
+    sorter.Add(reinterpret_cast<const GenericKey *>(key.data()), RowId(i));
+  }
+  sorter.Sort();
+  setrlimit(RLIMIT_FSIZE, &old_limit);
+  std::signal(SIGXFSZ, old_handler);
+  // The failure is reported instead of returning the pairs that made it to disk.
+  RowId row_id;
+  ASSERT_TRUE(sorter.IsFailed());
+  ASSERT_FALSE(sorter.Next(reinterpret_cast<GenericKey *>(key.data()), &row_id));
+}
@@ -0,0 +1,147 @@
+#include "index/hash_index.h"
+
+#include <algorithm>
+#include <map>
+#include <string>
+
+#include "common/instance.h"
+#include "gtest/gtest.h"
+#include "index/generic_key.h"
+
+static const std::string db_name = "hash_index_test.db";
+
+static BufferPoolManager *InitBufferPool(DiskManager *disk_mgr) {
+  auto bpm = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr);
+  page_id_t id;
+  if (bpm->IsPageFree(CATALOG_META_PAGE_ID)) {
+    if (bpm->NewPage(id) == nullptr || id != CATALOG_META_PAGE_ID) {
+      throw logic_error("Failed to allocate catalog meta page.");
+    }
+    bpm->UnpinPage(id, true);
+  }
+  if (bpm->IsPageFree(INDEX_ROOTS_PAGE_ID)) {
+    if (bpm->NewPage(id) == nullptr || id != INDEX_ROOTS_PAGE_ID) {
+      throw logic_error("Failed to allocate header page.");
+    }
+    bpm->UnpinPage(id, true);
+  }
+  return bpm;
+}
+
+static Row KeyOf(int value) {
+  std::vector<Field> fields{Field(TypeId::kTypeInt, value)};
+  return Row(fields);
+}
+
+TEST(HashIndexTests, HashIndexUniqueTest) {
+  remove(db_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_name);
+  auto bpm_ = InitBufferPool(disk_mgr_);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, true),
+                                   new Column("account", TypeId::kTypeFloat, 1, true, false)};
+  std::vector<uint32_t> index_key_map{0};
+  const TableSchema table_schema(columns);
+  auto *index_schema = Schema::ShallowCopySchema(&table_schema, index_key_map);
+  auto *index = new HashIndex(0, index_schema, 16, bpm_);
+  const int n = 20000;
+  for (int i = 0; i < n; i++) {
+    int key = (i * 7919) % n;
+    ASSERT_EQ(DB_SUCCESS, index->InsertEntry(KeyOf(key), RowId(1000 + key / 100, key % 100), nullptr));
+  }
+  ASSERT_EQ(DB_FAILED, index->InsertEntry(KeyOf(42), RowId(1, 1), nullptr));
+
+  // Scenario: every key is found after the buckets were split.
+  for (int i = 0; i < n; i++) {
+    std::vector<RowId> ret;
+    ASSERT_EQ(DB_SUCCESS, index->ScanKey(KeyOf(i), ret, nullptr));
+    ASSERT_EQ(1, ret.size());
+    ASSERT_EQ(RowId(1000 + i / 100, i % 100).Get(), ret[0].Get());
+  }
+  std::vector<RowId> ret;
+  ASSERT_EQ(DB_KEY_NOT_FOUND, index->ScanKey(KeyOf(n), ret, nullptr));
+
+  // Scenario: comparisons other than equality read the whole table.
+  ASSERT_EQ(DB_SUCCESS, index->ScanKey(KeyOf(n / 4), ret, nullptr, "<"));
+  ASSERT_EQ(n / 4, ret.size());
+  ret.clear();
+  ASSERT_EQ(DB_SUCCESS, index->ScanKey(KeyOf(n / 4), ret, nullptr, ">="));
+  ASSERT_EQ(n - n / 4, ret.size());
+  ret.clear();
+  ASSERT_EQ(DB_SUCCESS, index->ScanKey(KeyOf(0), ret, nullptr, "<>"));
+  ASSERT_EQ(n - 1, ret.size());
+
+  // Scenario: removed keys are gone and the others stay, emptied buckets are merged back.
+  for (int i = 0; i < n; i += 2) {
+    ASSERT_EQ(DB_SUCCESS, index->RemoveEntry(KeyOf(i), RowId(), nullptr));
+  }
+  for (int i = 0; i < n; i++) {
+    ret.clear();
+    ASSERT_EQ(i % 2 == 0 ? DB_KEY_NOT_FOUND : DB_SUCCESS, index->ScanKey(KeyOf(i), ret, nullptr));
+  }
+  for (int i = 1; i < n; i += 2) {
+    ASSERT_EQ(DB_SUCCESS, index->RemoveEntry(KeyOf(i), RowId(), nullptr));
+  }
+  ret.clear();
+  ASSERT_EQ(DB_KEY_NOT_FOUND, index->ScanKey(KeyOf(0), ret, nullptr, ">="));
+  ASSERT_TRUE(bpm_->CheckAllUnpinned());
+  index->Destroy();
+  delete index;
+  delete bpm_;
+  delete disk_mgr_;
+}
+
+TEST(HashIndexTests, HashIndexNonUniqueTest) {
+  remove(db_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_name);
+  auto bpm_ = InitBufferPool(disk_mgr_);
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("status", TypeId::kTypeInt, 1, false, false)};
+  std::vector<uint32_t> index_key_map{1};
+  const TableSchema table_schema(columns);
+  auto *index_schema = Schema::ShallowCopySchema(&table_schema, index_key_map);
+  auto *index = new HashIndex(0, index_schema, 16, bpm_, false);
+  ASSERT_FALSE(index->IsUnique());
+  // Status 0 is a hot key filling many overflow pages, the others have a few rows each.
+  const int n = 6000;
+  std::map<int, std::vector<int64_t>> expected;
+  for (int i = 0; i < n; i++) {
+    int status = i % 3 == 0 ? 0 : i % 50;
+    RowId rid(1000 + i / 100, i % 100);
+    ASSERT_EQ(DB_SUCCESS, index->InsertEntry(KeyOf(status), rid, nullptr));
+    expected[status].push_back(rid.Get());
+  }
+  // The same key and row id cannot go in twice.
+  ASSERT_EQ(DB_FAILED, index->InsertEntry(KeyOf(0), RowId(expected[0][0]), nullptr));
+
+  // Scenario: a lookup returns every row id of the key.
+  for (auto &entry : expected) {
+    std::vector<RowId> ret;
+    ASSERT_EQ(DB_SUCCESS, index->ScanKey(KeyOf(entry.first), ret, nullptr));
+    std::vector<int64_t> found;
+    for (auto &rid : ret) found.push_back(rid.Get());
+    std::sort(found.begin(), found.end());
+    ASSERT_EQ(entry.second, found);
+  }
+
+  // Scenario: removing some row ids of the hot key leaves the others.
+  for (size_t i = 0; i < expected[0].size(); i += 2) {
+    ASSERT_EQ(DB_SUCCESS, index->RemoveEntry(KeyOf(0), RowId(expected[0][i]), nullptr));
+  }
+  std::vector<RowId> ret;
+  ASSERT_EQ(DB_SUCCESS, index->ScanKey(KeyOf(0), ret, nullptr));
+  std::vector<int64_t> found;
+  for (auto &rid : ret) found.push_back(rid.Get());
+  std::sort(found.begin(), found.end());
+  ASSERT_EQ(expected[0].size() / 2, found.size());
+  for (size_t i = 0; i < found.size(); i++) {
+    ASSERT_EQ(expected[0][i * 2 + 1], found[i]);
+  }
+  ret.clear();
+  ASSERT_EQ(DB_SUCCESS, index->ScanKey(KeyOf(7), ret, nullptr));
+  ASSERT_EQ(expected[7].size(), ret.size());
+  ASSERT_TRUE(bpm_->CheckAllUnpinned());
+  index->Destroy();
+  delete index;
+  delete bpm_;
+  delete disk_mgr_;
+}
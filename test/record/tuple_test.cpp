@@ -4,6 +4,7 @@
 #include "gtest/gtest.h"
 #include "page/table_page.h"
 #include "record/field.h"
+#include "record/field_compare.h"
 #include "record/row.h"
 #include "record/schema.h"
 
@@ -100,4 +101,37 @@ TEST(TupleTest, RowTest) {
   }
   ASSERT_TRUE(table_page.MarkDelete(row.GetRowId(), nullptr, nullptr, nullptr));
   table_page.ApplyDelete(row.GetRowId(), nullptr, nullptr);
-}
\ No newline at end of file
+}
+TEST(TupleTest, FieldCompareKernelTest) {
+  // The kernels of a type agree with Field::CompareXxx and order nulls first.
+  std::vector<std::vector<Field>> columns(3);
+  columns[0].assign(std::begin(int_fields), std::end(int_fields));
+  columns[1].assign(std::begin(float_fields), std::end(float_fields));
+  columns[1].emplace_back(TypeId::kTypeFloat, 0.0f);
+  columns[1].emplace_back(TypeId::kTypeFloat, -0.0f);
+  columns[2].assign(std::begin(char_fields), std::end(char_fields));
+  columns[2].emplace_back(TypeId::kTypeChar, const_cast<char *>("hell"), 4, false);
+  for (int i = 0; i < 3; i++) {
+    columns[i].push_back(null_fields[i]);
+    TypeId type = columns[i][0].GetTypeId();
+    FieldCompareFunc compare = GetFieldComparator(type);
+    for (const auto &lhs : columns[i]) {
+      for (const auto &rhs : columns[i]) {
+        EXPECT_EQ(lhs.CompareEquals(rhs), GetFieldTest(type, CompareOp::kEqual)(lhs, rhs));
+        EXPECT_EQ(lhs.CompareNotEquals(rhs), GetFieldTest(type, CompareOp::kNotEqual)(lhs, rhs));
+        EXPECT_EQ(lhs.CompareLessThan(rhs), GetFieldTest(type, CompareOp::kLessThan)(lhs, rhs));
+        EXPECT_EQ(lhs.CompareLessThanEquals(rhs), GetFieldTest(type, CompareOp::kLessThanEquals)(lhs, rhs));
+        EXPECT_EQ(lhs.CompareGreaterThan(rhs), GetFieldTest(type, CompareOp::kGreaterThan)(lhs, rhs));
+        EXPECT_EQ(lhs.CompareGreaterThanEquals(rhs), GetFieldTest(type, CompareOp::kGreaterThanEquals)(lhs, rhs));
+        int order = compare(lhs, rhs);
+        if (lhs.IsNull() || rhs.IsNull()) {
+          EXPECT_EQ(static_cast<int>(rhs.IsNull()) - static_cast<int>(lhs.IsNull()), order);
+          continue;
+        }
+        EXPECT_EQ(lhs.CompareLessThan(rhs) == CmpBool::kTrue, order < 0);
+        EXPECT_EQ(lhs.CompareEquals(rhs) == CmpBool::kTrue, order == 0);
+      }
+    }
+  }
+  EXPECT_EQ(nullptr, GetFieldComparator(TypeId::kTypeInvalid));
+}
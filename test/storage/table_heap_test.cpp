@@ -1,11 +1,19 @@
 #include "storage/table_heap.h"
 
+#include <chrono>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
 #include "common/instance.h"
 #include "gtest/gtest.h"
+#include "planner/expressions/column_value_expression.h"
+#include "planner/expressions/comparison_expression.h"
+#include "planner/expressions/constant_value_expression.h"
+#include "planner/expressions/logic_expression.h"
+#include "planner/expressions/predicate_program.h"
 #include "record/field.h"
+#include "record/row_batch.h"
 #include "record/schema.h"
 #include "utils/utils.h"
 
@@ -61,3 +69,293 @@ TEST(TableHeapTest, TableHeapSampleTest) {
   }
   ASSERT_EQ(size, 0);
 }
+
+TEST(TableHeapTest, FreeSpaceMapTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  const int row_nums = 2000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  char characters[64];
+  memset(characters, 'a', sizeof(characters));
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  std::vector<RowId> rids;
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 64, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    rids.push_back(row.GetRowId());
+  }
+  size_t page_count = table_heap->GetPageCount();
+  ASSERT_GT(page_count, 1);
+  // free the first half of the table, new rows should reuse that space instead of growing the heap
+  for (int i = 0; i < row_nums / 2; i++) {
+    table_heap->ApplyDelete(rids[i], nullptr);
+  }
+  for (int i = 0; i < row_nums / 2; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 64, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  }
+  ASSERT_EQ(page_count, table_heap->GetPageCount());
+  // reload the heap from its persisted free space map
+  TableHeap *reloaded = TableHeap::Create(bpm_, table_heap->GetFirstPageId(), table_heap->GetFreeSpaceMapPageId(),
+                                          schema.get(), nullptr, nullptr);
+  ASSERT_EQ(page_count, reloaded->GetPageCount());
+  int count = 0;
+  for (auto iter = reloaded->Begin(nullptr); iter != reloaded->End(); iter++) {
+    count++;
+  }
+  ASSERT_EQ(row_nums, count);
+  delete reloaded;
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+}
+
+TEST(TableHeapTest, ReadAheadTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(64, disk_mgr_);
+  const int row_nums = 5000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  char characters[64];
+  memset(characters, 'a', sizeof(characters));
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 64, true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  }
+  ASSERT_GT(table_heap->GetPageCount(), 64);
+  ASSERT_EQ(0, bpm_->GetPrefetchHitCount());
+
+  // Most of the heap has been evicted, the scan finds pages read ahead of it in the pool.
+  auto iter = table_heap->Begin(nullptr);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  int count = 0;
+  for (; iter != table_heap->End(); iter++) {
+    ASSERT_EQ(CmpBool::kTrue, iter->GetField(0)->CompareEquals(Field(TypeId::kTypeInt, count)));
+    count++;
+  }
+  ASSERT_EQ(row_nums, count);
+  // At least the first window was read before the scan went on.
+  EXPECT_GE(bpm_->GetPrefetchHitCount(), DEFAULT_READ_AHEAD_PAGES);
+  EXPECT_LE(bpm_->GetPrefetchHitCount() + bpm_->GetWastedPrefetchCount(), table_heap->GetPageCount());
+
+  // Without read-ahead nothing is prefetched.
+  size_t hits = bpm_->GetPrefetchHitCount();
+  table_heap->SetReadAheadDistance(0);
+  count = 0;
+  for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); it++) {
+    count++;
+  }
+  ASSERT_EQ(row_nums, count);
+  EXPECT_EQ(hits, bpm_->GetPrefetchHitCount());
+
+  // A batch skips the pages that are resident already.
+  std::vector<page_id_t> page_ids(table_heap->GetPageIds().begin(), table_heap->GetPageIds().begin() + 8);
+  EXPECT_EQ(8, bpm_->PrefetchPages(page_ids));
+  EXPECT_EQ(0, bpm_->PrefetchPages(page_ids));
+  for (auto page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm_->FetchPage(page_id));
+    bpm_->UnpinPage(page_id, false);
+  }
+  EXPECT_EQ(hits + 8, bpm_->GetPrefetchHitCount());
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+}
+
+TEST(TableHeapTest, PageRunTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  const int row_nums = 4000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  char characters[64];
+  memset(characters, 'a', sizeof(characters));
+  TableHeap *heap_a = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  TableHeap *heap_b = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  // Grow both heaps at the same time, so that single page allocation would interleave their pages.
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, characters, 64, true)};
+    Row row_a(fields);
+    Row row_b(fields);
+    ASSERT_TRUE(heap_a->InsertTuple(row_a, nullptr));
+    ASSERT_TRUE(heap_b->InsertTuple(row_b, nullptr));
+  }
+  ASSERT_GT(heap_a->GetPageCount(), PAGE_RUN_SIZE);
+
+  // Every heap owns whole aligned runs, and its pages fill them in order.
+  std::unordered_map<page_id_t, TableHeap *> run_owners;
+  for (auto heap : {heap_a, heap_b}) {
+    std::vector<page_id_t> page_ids;
+    for (auto it = heap->Begin(nullptr); it != heap->End(); it++) {
+      if (page_ids.empty() || page_ids.back() != it->GetRowId().GetPageId()) {
+        page_ids.push_back(it->GetRowId().GetPageId());
+      }
+    }
+    size_t runs = 0;
+    for (size_t i = 0; i < page_ids.size(); i++) {
+      auto owner = run_owners.emplace(page_ids[i] / PAGE_RUN_SIZE, heap);
+      ASSERT_EQ(heap, owner.first->second);
+      if (owner.second) {
+        runs++;
+      } else {
+        ASSERT_LT(page_ids[i - 1], page_ids[i]);
+      }
+    }
+    EXPECT_LE(runs, page_ids.size() / PAGE_RUN_SIZE + 1);
+  }
+
+  // Dropping a heap gives all of its runs back, the other heap keeps its pages.
+  page_id_t first_page_id_a = heap_a->GetFirstPageId();
+  page_id_t first_page_id_b = heap_b->GetFirstPageId();
+  heap_a->FreeTableHeap();
+  for (auto &owner : run_owners) {
+    if (owner.second != heap_a) {
+      continue;
+    }
+    auto run_size = static_cast<page_id_t>(PAGE_RUN_SIZE);
+    for (page_id_t page_id = owner.first * run_size; page_id < (owner.first + 1) * run_size; page_id++) {
+      ASSERT_TRUE(bpm_->IsPageFree(page_id));
+    }
+  }
+  ASSERT_TRUE(bpm_->IsPageFree(first_page_id_a));
+  ASSERT_FALSE(bpm_->IsPageFree(first_page_id_b));
+  delete heap_a;
+  delete heap_b;
+  delete bpm_;
+  delete disk_mgr_;
+}
+
+TEST(TableHeapTest, BatchScanTest) {
+  remove(db_file_name.c_str());
+  auto disk_mgr_ = new DiskManager(db_file_name);
+  auto bpm_ = new BufferPoolManager(DEFAULT_BUFFER_POOL_SIZE, disk_mgr_);
+  const int row_nums = 3000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 16, 1, true, false),
+                                   new Column("account", TypeId::kTypeFloat, 2, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableHeap *table_heap = TableHeap::Create(bpm_, schema.get(), nullptr, nullptr, nullptr);
+  std::vector<RowId> rids;
+  for (int i = 0; i < row_nums; i++) {
+    std::string name = "name" + std::to_string(i % 7);
+    // Every fifth row has null names, names of other rows may be empty.
+    Fields fields{Field(TypeId::kTypeInt, i),
+                  i % 5 == 0 ? Field(TypeId::kTypeChar)
+                             : Field(TypeId::kTypeChar, const_cast<char *>(name.c_str()), i % 3 == 0 ? 0 : 5, true),
+                  Field(TypeId::kTypeFloat, i * 0.5f)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    rids.push_back(row.GetRowId());
+  }
+  for (int i = 0; i < row_nums; i += 11) {
+    ASSERT_TRUE(table_heap->MarkDelete(rids[i], nullptr));
+  }
+  std::vector<Row> expected;
+  for (auto it = table_heap->Begin(nullptr); it != table_heap->End(); ++it) {
+    expected.push_back(*it);
+  }
+
+  // Batches of any size decode the same rows as the row iterator.
+  for (uint32_t capacity : {ROW_BATCH_SIZE, 7u}) {
+    RowBatch batch(schema.get(), capacity);
+    size_t count = 0;
+    auto it = table_heap->Begin(nullptr);
+    while (it != table_heap->End()) {
+      batch.Clear();
+      uint32_t appended = it.NextBatch(&batch);
+      ASSERT_EQ(appended, batch.GetRowCount());
+      ASSERT_LE(batch.GetRowCount(), capacity);
+      for (uint32_t i = 0; i < batch.GetRowCount(); i++) {
+        Row row;
+        batch.GetRow(i, &row);
+        ASSERT_LT(count, expected.size());
+        ASSERT_EQ(expected[count].GetRowId(), row.GetRowId());
+        for (uint32_t j = 0; j < schema->GetColumnCount(); j++) {
+          ASSERT_EQ(expected[count].GetField(j)->IsNull(), row.GetField(j)->IsNull());
+          if (!row.GetField(j)->IsNull()) {
+            ASSERT_EQ(CmpBool::kTrue, row.GetField(j)->CompareEquals(*expected[count].GetField(j)));
+          }
+        }
+        count++;
+      }
+    }
+    ASSERT_EQ(expected.size(), count);
+  }
+
+  // The compiled predicate selects the rows evaluating the predicate selects, on rows and on the columns of a batch.
+  char name3[] = "name3";
+  auto id = std::make_shared<ColumnValueExpression>(0, 0, kTypeInt);
+  auto name = std::make_shared<ColumnValueExpression>(0, 1, kTypeChar);
+  auto account = std::make_shared<ColumnValueExpression>(0, 2, kTypeFloat);
+  auto id_less = std::make_shared<ComparisonExpression>(
+      id, std::make_shared<ConstantValueExpression>(Field(kTypeInt, 2000)), "<");
+  auto name_equal = std::make_shared<ComparisonExpression>(
+      name, std::make_shared<ConstantValueExpression>(Field(kTypeChar, name3, 5, true)), "=");
+  auto name_null = std::make_shared<ComparisonExpression>(
+      name, std::make_shared<ConstantValueExpression>(Field(kTypeChar)), "is");
+  auto account_greater = std::make_shared<ComparisonExpression>(
+      account, std::make_shared<ConstantValueExpression>(Field(kTypeFloat, 1200.f)), ">=");
+  auto either = std::make_shared<LogicExpression>(name_equal, account_greater, LogicType::Or);
+  // Constants on the left side are compared the other way round, and comparisons of constants are folded.
+  auto less_id = std::make_shared<ComparisonExpression>(
+      std::make_shared<ConstantValueExpression>(Field(kTypeInt, 2000)), id, ">");
+  auto always = std::make_shared<ComparisonExpression>(
+      std::make_shared<ConstantValueExpression>(Field(kTypeInt, 1)),
+      std::make_shared<ConstantValueExpression>(Field(kTypeInt, 1)), "=");
+  auto never = std::make_shared<ComparisonExpression>(
+      account, std::make_shared<ConstantValueExpression>(Field(kTypeFloat)), "=");
+  std::vector<AbstractExpressionRef> predicates{
+      id_less,
+      name_equal,
+      name_null,
+      std::make_shared<LogicExpression>(id_less, either, LogicType::And),
+      std::make_shared<LogicExpression>(name_null, either, LogicType::Or),
+      std::make_shared<LogicExpression>(less_id, always, LogicType::And),
+      std::make_shared<LogicExpression>(never, std::make_shared<LogicExpression>(name_null, either, LogicType::Or),
+                                        LogicType::Or)};
+  for (const auto &predicate : predicates) {
+    PredicateProgram program(predicate);
+    std::vector<RowId> selected;
+    for (const auto &row : expected) {
+      bool passes = predicate->Evaluate(&row).CompareEquals(Field(kTypeInt, 1)) == CmpBool::kTrue;
+      ASSERT_EQ(passes, program.Evaluate(row));
+      if (passes) {
+        selected.push_back(row.GetRowId());
+      }
+    }
+    std::vector<RowId> filtered;
+    RowBatch batch(schema.get());
+    auto it = table_heap->Begin(nullptr);
+    while (it != table_heap->End()) {
+      batch.Clear();
+      it.NextBatch(&batch);
+      program.Filter(batch, &batch.GetSelection());
+      for (auto i : batch.GetSelection()) {
+        filtered.push_back(batch.GetRowId(i));
+      }
+    }
+    ASSERT_FALSE(selected.empty());
+    ASSERT_EQ(selected, filtered);
+  }
+  ASSERT_EQ(1u, PredicateProgram(always).GetInstructionCount());
+  ASSERT_EQ(1u, PredicateProgram(never).GetInstructionCount());
+  auto folded_and = std::make_shared<LogicExpression>(less_id, always, LogicType::And);
+  ASSERT_EQ(1u, PredicateProgram(folded_and).GetInstructionCount());
+  auto folded_or = std::make_shared<LogicExpression>(either, always, LogicType::Or);
+  ASSERT_EQ(1u, PredicateProgram(folded_or).GetInstructionCount());
+  ASSERT_EQ(2u, PredicateProgram(either).GetRegisterCount());
+  delete table_heap;
+  delete bpm_;
+  delete disk_mgr_;
+}